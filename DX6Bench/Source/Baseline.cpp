@@ -0,0 +1,376 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Baseline.h"
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		/* JSON */
+
+		// Just enough JSON to walk our own output: every value can be skipped, strings and numbers read.
+		// Malformed input makes Fail stick, so callers only check it once at the end.
+		class JsonReader
+		{
+		private:
+			const char* p;
+			bool failed;
+		public:
+			JsonReader(const char* text)
+			{
+				p = text;
+				failed = false;
+			}
+
+			bool HasFailed()
+			{
+				return failed;
+			}
+
+			void Fail()
+			{
+				failed = true;
+			}
+
+			void SkipSpace()
+			{
+				while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+					p++;
+			}
+
+			// Consumes c if it's the next token
+			bool Accept(char c)
+			{
+				SkipSpace();
+
+				if (failed || *p != c)
+					return false;
+
+				p++;
+				return true;
+			}
+
+			void Expect(char c)
+			{
+				if (!Accept(c))
+					Fail();
+			}
+
+			char Peek()
+			{
+				SkipSpace();
+				return failed ? 0 : *p;
+			}
+
+			// Escapes other than \" and \\ never appear in our files, they are copied as is
+			void ReadString(char* buffer, int size)
+			{
+				int length = 0;
+
+				Expect('"');
+
+				while (!failed && *p != '"')
+				{
+					if (!*p)
+					{
+						Fail();
+						break;
+					}
+
+					if (*p == '\\' && p[1])
+						p++;
+
+					if (length < size - 1)
+						buffer[length++] = *p;
+
+					p++;
+				}
+
+				if (!failed)
+					p++;
+
+				if (size > 0)
+					buffer[length] = 0;
+			}
+
+			double ReadNumber()
+			{
+				SkipSpace();
+
+				char* end;
+				double ret = strtod(p, &end);
+
+				if (end == p)
+					Fail();
+
+				p = end;
+				return ret;
+			}
+
+			void SkipValue()
+			{
+				char c = Peek();
+
+				if (c == '{' || c == '[')
+				{
+					char close = c == '{' ? '}' : ']';
+					p++;
+
+					if (Accept(close))
+						return;
+
+					do
+					{
+						if (c == '{')
+						{
+							char key[8];
+							ReadString(key, sizeof(key));
+							Expect(':');
+						}
+
+						SkipValue();
+					} while (!failed && Accept(','));
+
+					Expect(close);
+				}
+				else if (c == '"')
+				{
+					char ignored[1];
+					ReadString(ignored, 0);
+				}
+				else if (c == 't' || c == 'f' || c == 'n')
+				{
+					while (*p >= 'a' && *p <= 'z')
+						p++;
+				}
+				else
+				{
+					ReadNumber();
+				}
+			}
+		};
+
+		/* Baseline */
+
+		Baseline::Baseline()
+		{
+			entryCount = 0;
+			overrideCount = 0;
+			defaultPercent = 10;
+			allocTolerance = 0;
+		}
+
+		bool Baseline::Load(const char* fileName)
+		{
+			FILE* file = fopen(fileName, "rb");
+
+			if (!file)
+				return false;
+
+			fseek(file, 0, SEEK_END);
+			long size = ftell(file);
+			fseek(file, 0, SEEK_SET);
+
+			char* text = (char*)malloc(size + 1);
+			bool ret = size >= 0 && fread(text, 1, size, file) == (size_t)size;
+			fclose(file);
+
+			if (ret)
+			{
+				text[size] = 0;
+				ret = Parse(text);
+			}
+
+			free(text);
+
+			return ret;
+		}
+
+		bool Baseline::Parse(const char* json)
+		{
+			JsonReader reader(json);
+			entryCount = 0;
+
+			reader.Expect('{');
+
+			do
+			{
+				char key[32];
+				reader.ReadString(key, sizeof(key));
+				reader.Expect(':');
+
+				if (strcmp(key, "results") != 0)
+				{
+					reader.SkipValue();
+					continue;
+				}
+
+				reader.Expect('[');
+
+				if (reader.Accept(']'))
+					continue;
+
+				do
+				{
+					Entry entry;
+					entry.Name[0] = 0;
+					entry.P50 = -1;
+					entry.AllocsPerRun = -1;
+
+					reader.Expect('{');
+
+					do
+					{
+						char field[32];
+						reader.ReadString(field, sizeof(field));
+						reader.Expect(':');
+
+						if (strcmp(field, "name") == 0)
+						{
+							reader.ReadString(entry.Name, MaxName);
+						}
+						else if (strcmp(field, "allocsPerRun") == 0)
+						{
+							entry.AllocsPerRun = reader.ReadNumber();
+						}
+						else if (strcmp(field, "ns") == 0)
+						{
+							reader.Expect('{');
+
+							do
+							{
+								char stat[16];
+								reader.ReadString(stat, sizeof(stat));
+								reader.Expect(':');
+
+								if (strcmp(stat, "p50") == 0)
+									entry.P50 = reader.ReadNumber();
+								else
+									reader.SkipValue();
+							} while (!reader.HasFailed() && reader.Accept(','));
+
+							reader.Expect('}');
+						}
+						else
+						{
+							reader.SkipValue();
+						}
+					} while (!reader.HasFailed() && reader.Accept(','));
+
+					reader.Expect('}');
+
+					if (entry.Name[0] && entry.P50 > 0 && entryCount < MaxEntries)
+						entries[entryCount++] = entry;
+				} while (!reader.HasFailed() && reader.Accept(','));
+
+				reader.Expect(']');
+			} while (!reader.HasFailed() && reader.Accept(','));
+
+			reader.Expect('}');
+
+			return !reader.HasFailed();
+		}
+
+		const Baseline::Entry* Baseline::Find(const char* name)
+		{
+			for (int i = 0; i < entryCount; i++)
+			{
+				if (strcmp(entries[i].Name, name) == 0)
+					return &entries[i];
+			}
+
+			return 0;
+		}
+
+		int Baseline::GetEntryCount()
+		{
+			return entryCount;
+		}
+
+		void Baseline::SetThreshold(double percent)
+		{
+			defaultPercent = percent;
+		}
+
+		bool Baseline::AddThreshold(const char* pattern, double percent)
+		{
+			if (overrideCount == MaxOverrides || strlen(pattern) >= MaxName)
+				return false;
+
+			strcpy(overrides[overrideCount].Pattern, pattern);
+			overrides[overrideCount].Percent = percent;
+			overrideCount++;
+
+			return true;
+		}
+
+		double Baseline::GetThreshold(const char* name)
+		{
+			// Later overrides win, so a specific name can follow a broader prefix on the command line
+			for (int i = overrideCount - 1; i >= 0; i--)
+			{
+				const char* pattern = overrides[i].Pattern;
+				int length = (int)strlen(pattern);
+
+				if (length > 0 && pattern[length - 1] == '*' ? strncmp(name, pattern, length - 1) == 0 : strcmp(name, pattern) == 0)
+					return overrides[i].Percent;
+			}
+
+			return defaultPercent;
+		}
+
+		void Baseline::SetAllocTolerance(double allocs)
+		{
+			allocTolerance = allocs;
+		}
+
+		int Baseline::Compare(Runner& runner)
+		{
+			int regressions = 0;
+
+			printf("\n%-32s %12s %12s %9s %8s  %s\n", "Benchmark", "Baseline", "Current", "Change", "Limit", "Status");
+
+			for (int i = 0; i < runner.GetResultCount(); i++)
+			{
+				const Result& r = runner.GetResult(i);
+				const Entry* base = Find(r.Name);
+
+				if (!base)
+				{
+					printf("%-32s %12s %10.1fns %9s %8s  new\n", r.Name, "-", r.P50, "-", "-");
+					continue;
+				}
+
+				double change = (r.P50 / base->P50 - 1) * 100;
+				double limit = GetThreshold(r.Name);
+				const char* status = "ok";
+
+				if (change > limit)
+				{
+					status = "SLOWER";
+					regressions++;
+				}
+				else if (base->AllocsPerRun >= 0 && r.AllocsPerRun >= 0 && r.AllocsPerRun > base->AllocsPerRun + allocTolerance)
+				{
+					status = "MORE ALLOCATIONS";
+					regressions++;
+				}
+				else if (change < -limit)
+				{
+					status = "faster";
+				}
+
+				printf("%-32s %10.1fns %10.1fns %+8.1f%% %7.0f%%  %s", r.Name, base->P50, r.P50, change, limit, status);
+
+				if (base->AllocsPerRun >= 0 && r.AllocsPerRun >= 0 && r.AllocsPerRun != base->AllocsPerRun)
+					printf(" (allocs %.2f -> %.2f)", base->AllocsPerRun, r.AllocsPerRun);
+
+				printf("\n");
+			}
+
+			return regressions;
+		}
+	}
+}
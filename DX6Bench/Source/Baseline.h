@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Bench.h"
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		// Results of an earlier run, read back from the JSON Runner::WriteJson produces
+		class Baseline
+		{
+		public:
+			static const int MaxEntries = Runner::MaxBenchmarks * 2;
+			static const int MaxName = 64;
+			static const int MaxOverrides = 32;
+
+			struct Entry
+			{
+				char Name[MaxName];
+				double P50;
+				double AllocsPerRun; // -1 if not counted
+			};
+		private:
+			struct Override
+			{
+				char Pattern[MaxName]; // Exact name, or prefix ending with '*'
+				double Percent;
+			};
+
+			Entry entries[MaxEntries];
+			int entryCount;
+
+			Override overrides[MaxOverrides];
+			int overrideCount;
+			double defaultPercent;
+			double allocTolerance;
+
+			Baseline(const Baseline&);
+			Baseline& operator=(const Baseline&);
+
+			bool Parse(const char* json);
+		public:
+			Baseline();
+
+			bool Load(const char* fileName);
+			const Entry* Find(const char* name);
+			int GetEntryCount();
+
+			// p50 may grow by this many percent before it counts as a regression, 10 by default
+			void SetThreshold(double percent);
+			bool AddThreshold(const char* pattern, double percent);
+			double GetThreshold(const char* name);
+
+			// Extra allocations per run tolerated, 0 by default - allocation counts don't suffer from noise
+			void SetAllocTolerance(double allocs);
+
+			// Prints a comparison table and returns the number of regressions
+			int Compare(Runner& runner);
+		};
+	}
+}
@@ -0,0 +1,408 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "Bench.h"
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define snprintf _snprintf
+#endif
+
+// glibc lets the executable interpose malloc and still reach the real one, so allocations of everything
+// linked in (engine cores included) are counted. Elsewhere allocations are reported as unknown.
+#if defined(__GLIBC__) && !defined(BENCH_NO_ALLOC_COUNT)
+#define BENCH_ALLOC_COUNT
+
+static volatile long allocationCount = 0;
+
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t count, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+
+	void* malloc(size_t size)
+	{
+		DXSharp::Platform::AtomicIncrement(&allocationCount);
+		return __libc_malloc(size);
+	}
+
+	void* calloc(size_t count, size_t size)
+	{
+		DXSharp::Platform::AtomicIncrement(&allocationCount);
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* ptr, size_t size)
+	{
+		DXSharp::Platform::AtomicIncrement(&allocationCount);
+		return __libc_realloc(ptr, size);
+	}
+}
+#endif
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		long GetAllocationCount()
+		{
+#ifdef BENCH_ALLOC_COUNT
+			return allocationCount;
+#else
+			return -1;
+#endif
+		}
+
+		/* Random */
+
+		Random::Random(unsigned int seed)
+		{
+			state = seed ? seed : 1;
+		}
+
+		unsigned int Random::Next()
+		{
+			// xorshift32
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			return state;
+		}
+
+		float Random::NextFloat()
+		{
+			return (Next() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		int Random::Next(int min, int max)
+		{
+			return min + (int)(Next() % (unsigned int)(max - min));
+		}
+
+		static volatile unsigned int sink;
+
+		void Consume(unsigned int value)
+		{
+			sink += value;
+		}
+
+		/* Runner */
+
+		static int CompareDoubles(const void* a, const void* b)
+		{
+			double x = *(const double*)a;
+			double y = *(const double*)b;
+
+			return x < y ? -1 : (x > y ? 1 : 0);
+		}
+
+		// Nearest rank on sorted samples
+		static double Percentile(const double* sorted, int count, int percent)
+		{
+			int rank = (percent * count + 99) / 100;
+
+			if (rank < 1)
+				rank = 1;
+
+			return sorted[rank - 1];
+		}
+
+		Runner::Runner(const RunnerConfig& config)
+		{
+			this->config = config;
+			benchmarkCount = 0;
+			resultCount = 0;
+		}
+
+		Runner::~Runner()
+		{
+			for (int i = 0; i < benchmarkCount; i++)
+				delete benchmarks[i];
+		}
+
+		void Runner::Add(Benchmark* benchmark)
+		{
+			if (benchmarkCount == MaxBenchmarks)
+			{
+				fprintf(stderr, "Too many benchmarks, %s is left out\n", benchmark->GetName());
+				delete benchmark;
+				return;
+			}
+
+			benchmarks[benchmarkCount++] = benchmark;
+		}
+
+		bool Runner::Measure(Benchmark* benchmark, Result* result)
+		{
+			double ticksToNs = 1e9 / (double)Platform::GetPerformanceFrequency();
+			double minSampleNs = config.MinSampleMs * 1e6;
+
+			// Find how many runs make a sample long enough for the timer, first run doubles as a warmup
+			int runs = 1;
+
+			for (;;)
+			{
+				Platform::UInt64 start = Platform::GetPerformanceCounter();
+
+				for (int i = 0; i < runs; i++)
+					benchmark->Run();
+
+				double elapsed = (Platform::GetPerformanceCounter() - start) * ticksToNs;
+
+				if (elapsed >= minSampleNs || runs >= (1 << 24))
+					break;
+
+				// Aim a bit past the target, but never grow more than 10x at once
+				double scale = elapsed > 0 ? minSampleNs * 1.2 / elapsed : 10;
+				runs = (int)(runs * (scale < 2 ? 2 : (scale > 10 ? 10 : scale)));
+			}
+
+			for (int s = 0; s < config.WarmupSamples; s++)
+			{
+				for (int i = 0; i < runs; i++)
+					benchmark->Run();
+			}
+
+			double* samples = (double*)malloc(sizeof(double) * config.Samples);
+			long allocsBefore = GetAllocationCount();
+
+			for (int s = 0; s < config.Samples; s++)
+			{
+				Platform::UInt64 start = Platform::GetPerformanceCounter();
+
+				for (int i = 0; i < runs; i++)
+					benchmark->Run();
+
+				samples[s] = (Platform::GetPerformanceCounter() - start) * ticksToNs / runs;
+			}
+
+			long allocsAfter = GetAllocationCount();
+
+			double sum = 0;
+
+			for (int s = 0; s < config.Samples; s++)
+				sum += samples[s];
+
+			double mean = sum / config.Samples;
+			double variance = 0;
+
+			for (int s = 0; s < config.Samples; s++)
+				variance += (samples[s] - mean) * (samples[s] - mean);
+
+			qsort(samples, config.Samples, sizeof(double), CompareDoubles);
+
+			result->Name = benchmark->GetName();
+			result->ItemUnit = benchmark->GetItemUnit();
+			result->Samples = config.Samples;
+			result->RunsPerSample = runs;
+			result->Mean = mean;
+			result->StdDev = sqrt(variance / config.Samples);
+			result->Min = samples[0];
+			result->P50 = Percentile(samples, config.Samples, 50);
+			result->P90 = Percentile(samples, config.Samples, 90);
+			result->P99 = Percentile(samples, config.Samples, 99);
+			result->Max = samples[config.Samples - 1];
+			result->ItemsPerSecond = benchmark->GetItems() > 0 ? benchmark->GetItems() * 1e9 / result->P50 : 0;
+			result->BytesPerSecond = benchmark->GetBytes() > 0 ? benchmark->GetBytes() * 1e9 / result->P50 : 0;
+
+			// The samples buffer was allocated before counting started, nothing of the runner's own is in here
+			result->AllocsPerRun = allocsBefore >= 0 ? (double)(allocsAfter - allocsBefore) / ((double)config.Samples * runs) : -1;
+
+			free(samples);
+
+			return true;
+		}
+
+		int Runner::Run()
+		{
+			resultCount = 0;
+
+			for (int i = 0; i < benchmarkCount; i++)
+			{
+				Benchmark* benchmark = benchmarks[i];
+
+				if (config.Filter && !strstr(benchmark->GetName(), config.Filter))
+					continue;
+
+				fprintf(stderr, "%s...\n", benchmark->GetName());
+
+				if (!benchmark->Setup())
+				{
+					fprintf(stderr, "  setup failed, skipped\n");
+					continue;
+				}
+
+				if (Measure(benchmark, &results[resultCount]))
+					resultCount++;
+
+				benchmark->Teardown();
+			}
+
+			return resultCount;
+		}
+
+		void Runner::List()
+		{
+			for (int i = 0; i < benchmarkCount; i++)
+			{
+				if (!config.Filter || strstr(benchmarks[i]->GetName(), config.Filter))
+					printf("%s\n", benchmarks[i]->GetName());
+			}
+		}
+
+		int Runner::GetResultCount()
+		{
+			return resultCount;
+		}
+
+		const Result& Runner::GetResult(int index)
+		{
+			return results[index];
+		}
+
+		const Result* Runner::FindResult(const char* name)
+		{
+			for (int i = 0; i < resultCount; i++)
+			{
+				if (strcmp(results[i].Name, name) == 0)
+					return &results[i];
+			}
+
+			return 0;
+		}
+
+		// Picks a readable unit for a nanosecond figure
+		static void FormatTime(double ns, char* buffer, int size)
+		{
+			if (ns < 1e3)
+				snprintf(buffer, size, "%.1fns", ns);
+			else if (ns < 1e6)
+				snprintf(buffer, size, "%.2fus", ns / 1e3);
+			else
+				snprintf(buffer, size, "%.2fms", ns / 1e6);
+		}
+
+		static void FormatRate(double perSecond, const char* unit, char* buffer, int size)
+		{
+			if (perSecond < 1e3)
+				snprintf(buffer, size, "%.1f %s/s", perSecond, unit);
+			else if (perSecond < 1e6)
+				snprintf(buffer, size, "%.1fK %s/s", perSecond / 1e3, unit);
+			else if (perSecond < 1e9)
+				snprintf(buffer, size, "%.1fM %s/s", perSecond / 1e6, unit);
+			else
+				snprintf(buffer, size, "%.2fG %s/s", perSecond / 1e9, unit);
+		}
+
+		void Runner::Print()
+		{
+			printf("%-32s %10s %10s %10s %10s %16s %10s\n", "Benchmark", "p50", "p90", "p99", "+/-", "Throughput", "Allocs");
+
+			for (int i = 0; i < resultCount; i++)
+			{
+				const Result& r = results[i];
+				char p50[32], p90[32], p99[32], throughput[48], allocs[32];
+
+				FormatTime(r.P50, p50, sizeof(p50));
+				FormatTime(r.P90, p90, sizeof(p90));
+				FormatTime(r.P99, p99, sizeof(p99));
+
+				if (r.BytesPerSecond > 0)
+					snprintf(throughput, sizeof(throughput), "%.1f MB/s", r.BytesPerSecond / (1024 * 1024));
+				else if (r.ItemsPerSecond > 0)
+					FormatRate(r.ItemsPerSecond, r.ItemUnit ? r.ItemUnit : "items", throughput, sizeof(throughput));
+				else
+					snprintf(throughput, sizeof(throughput), "-");
+
+				if (r.AllocsPerRun >= 0)
+					snprintf(allocs, sizeof(allocs), "%.2f", r.AllocsPerRun);
+				else
+					snprintf(allocs, sizeof(allocs), "?");
+
+				printf("%-32s %10s %10s %10s %9.1f%% %16s %10s\n", r.Name, p50, p90, p99, r.Mean > 0 ? r.StdDev * 100 / r.Mean : 0, throughput, allocs);
+			}
+		}
+
+		static void WriteJsonString(FILE* file, const char* value)
+		{
+			fputc('"', file);
+
+			for (const char* p = value; *p; p++)
+			{
+				if (*p == '"' || *p == '\\')
+					fputc('\\', file);
+
+				fputc(*p, file);
+			}
+
+			fputc('"', file);
+		}
+
+		static const char* GetCompilerName()
+		{
+#if defined(_MSC_VER)
+			static char name[32];
+			snprintf(name, sizeof(name), "MSVC %d", _MSC_VER);
+			return name;
+#elif defined(__VERSION__)
+			return __VERSION__;
+#else
+			return "unknown";
+#endif
+		}
+
+		bool Runner::WriteJson(const char* fileName)
+		{
+			FILE* file = fopen(fileName, "w");
+
+			if (!file)
+				return false;
+
+			fprintf(file, "{\n");
+			fprintf(file, "  \"version\": 1,\n");
+			fprintf(file, "  \"timestamp\": %ld,\n", (long)time(0));
+
+			fprintf(file, "  \"machine\": { \"processors\": %d, \"cpuFeatures\": %d, \"pointerBits\": %d, \"compiler\": ",
+				Platform::GetProcessorCount(), Platform::GetCpuFeatures(), (int)sizeof(void*) * 8);
+			WriteJsonString(file, GetCompilerName());
+			fprintf(file, " },\n");
+
+			fprintf(file, "  \"config\": { \"samples\": %d, \"warmupSamples\": %d, \"minSampleMs\": %g },\n",
+				config.Samples, config.WarmupSamples, config.MinSampleMs);
+
+			fprintf(file, "  \"results\": [\n");
+
+			for (int i = 0; i < resultCount; i++)
+			{
+				const Result& r = results[i];
+
+				fprintf(file, "    { \"name\": ");
+				WriteJsonString(file, r.Name);
+				fprintf(file, ", \"samples\": %d, \"runsPerSample\": %d,\n", r.Samples, r.RunsPerSample);
+				fprintf(file, "      \"ns\": { \"mean\": %.1f, \"stddev\": %.1f, \"min\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f },\n",
+					r.Mean, r.StdDev, r.Min, r.P50, r.P90, r.P99, r.Max);
+				fprintf(file, "      \"itemUnit\": ");
+
+				if (r.ItemUnit)
+					WriteJsonString(file, r.ItemUnit);
+				else
+					fprintf(file, "null");
+
+				fprintf(file, ", \"itemsPerSecond\": %.1f, \"bytesPerSecond\": %.1f, \"allocsPerRun\": %.3f }%s\n",
+					r.ItemsPerSecond, r.BytesPerSecond, r.AllocsPerRun, i + 1 < resultCount ? "," : "");
+			}
+
+			fprintf(file, "  ]\n");
+			fprintf(file, "}\n");
+
+			bool ret = !ferror(file);
+			fclose(file);
+
+			return ret;
+		}
+	}
+}
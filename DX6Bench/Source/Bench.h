@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		// One measured operation, e.g. recording a frame or mixing a block. Setup and Teardown run outside of
+		// the timed region, Run is called as many times as the runner needs.
+		class Benchmark
+		{
+		protected:
+			const char* name;
+			const char* itemUnit; // What Items counts ("vertices", "frames"...), null if only time is interesting
+			int items; // Per Run
+			Platform::Int64 bytes; // Per Run, 0 if throughput in bytes makes no sense
+		public:
+			Benchmark(const char* name)
+			{
+				this->name = name;
+				itemUnit = 0;
+				items = 0;
+				bytes = 0;
+			}
+
+			virtual ~Benchmark() { }
+
+			const char* GetName() { return name; }
+			const char* GetItemUnit() { return itemUnit; }
+			int GetItems() { return items; }
+			Platform::Int64 GetBytes() { return bytes; }
+
+			virtual bool Setup() { return true; } // False skips the benchmark
+			virtual void Run() = 0;
+			virtual void Teardown() { }
+		};
+
+		struct Result
+		{
+			const char* Name;
+			const char* ItemUnit;
+			int Samples;
+			int RunsPerSample;
+
+			// Nanoseconds per Run over the samples
+			double Mean;
+			double StdDev;
+			double Min;
+			double P50;
+			double P90;
+			double P99;
+			double Max;
+
+			double ItemsPerSecond; // From P50, 0 without items
+			double BytesPerSecond;
+			double AllocsPerRun; // -1 where allocations can't be counted
+		};
+
+		struct RunnerConfig
+		{
+			int Samples;
+			int WarmupSamples;
+			double MinSampleMs; // Runs per sample are raised until a sample takes at least this long
+			const char* Filter; // Substring of names to run, null for all
+
+			RunnerConfig()
+			{
+				Samples = 30;
+				WarmupSamples = 3;
+				MinSampleMs = 2;
+				Filter = 0;
+			}
+		};
+
+		class Runner
+		{
+		public:
+			static const int MaxBenchmarks = 64;
+		private:
+			Benchmark* benchmarks[MaxBenchmarks];
+			int benchmarkCount;
+
+			Result results[MaxBenchmarks];
+			int resultCount;
+
+			RunnerConfig config;
+
+			Runner(const Runner&);
+			Runner& operator=(const Runner&);
+
+			bool Measure(Benchmark* benchmark, Result* result);
+		public:
+			Runner(const RunnerConfig& config);
+			~Runner(); // Deletes the benchmarks
+
+			void Add(Benchmark* benchmark); // Takes ownership
+			int Run(); // Returns how many benchmarks ran
+
+			int GetResultCount();
+			const Result& GetResult(int index);
+			const Result* FindResult(const char* name);
+
+			void List(); // Names that would run with the current filter
+			void Print();
+			bool WriteJson(const char* fileName);
+		};
+
+		// Allocations made by any thread since start, -1 if this build can't count them (see Bench.cpp)
+		long GetAllocationCount();
+
+		// Deterministic pseudo-random numbers, so every run measures the same data
+		class Random
+		{
+		private:
+			unsigned int state;
+		public:
+			Random(unsigned int seed);
+
+			unsigned int Next();
+			float NextFloat(); // [0, 1)
+			int Next(int min, int max); // [min, max)
+		};
+
+		// Keeps the compiler from dropping work whose result is otherwise unused
+		void Consume(unsigned int value);
+	}
+}
@@ -0,0 +1,443 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Benchmarks.h"
+#include "PackFile.h"
+#include "Lz4.h"
+#include "ResourceCache.h"
+#include "PackWriter.h"
+#include "SceneAssets.h"
+
+using namespace DXSharp::Assets;
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		const char* const PackFileName = "dx6bench.tmp.pak";
+		const int TextureCount = 32;
+		const int TextureSize = 256;
+
+		/* Test data */
+
+		// .tex as TexTool writes it: header, then every mip level down to 1x1 as RGB565
+		static unsigned char* MakeTexture(int size, unsigned int seed, unsigned int* fileSize)
+		{
+			int mipCount = 0;
+			unsigned int dataSize = 4 + 4 + 1 + 1 + 4;
+
+			for (int s = size; s > 0; s /= 2)
+			{
+				dataSize += 8 + s * s * 2;
+				mipCount++;
+			}
+
+			unsigned char* ret = (unsigned char*)malloc(dataSize);
+			unsigned char* p = ret;
+			Random random(seed);
+
+			memcpy(p, &size, 4);
+			memcpy(p + 4, &size, 4);
+			p[8] = 0; // RGB565
+			p[9] = 0; // Not deflated
+			memcpy(p + 10, &mipCount, 4);
+			p += 14;
+
+			for (int s = size; s > 0; s /= 2)
+			{
+				unsigned short width = (unsigned short)s;
+				unsigned int linearSize = s * s * 2;
+
+				memcpy(p, &width, 2);
+				memcpy(p + 2, &width, 2);
+				memcpy(p + 4, &linearSize, 4);
+				p += 8;
+
+				// Smooth gradients with a little noise compress about as well as the game's textures
+				unsigned short* texels = (unsigned short*)p;
+
+				for (int y = 0; y < s; y++)
+				{
+					for (int x = 0; x < s; x++)
+						texels[y * s + x] = (unsigned short)((((x * 32 / s) << 11) | ((y * 64 / s) << 5) | (random.Next() & 3)));
+				}
+
+				p += linearSize;
+			}
+
+			*fileSize = dataSize;
+
+			return ret;
+		}
+
+		// Pack with TextureCount textures, each stored and LZ4 compressed, shared by the asset benchmarks
+		class TestPack
+		{
+		public:
+			PackFile Pack;
+			char Names[TextureCount * 2][64];
+
+			bool Create()
+			{
+				PackItem items[TextureCount * 2];
+
+				for (int i = 0; i < TextureCount * 2; i++)
+				{
+					PackItem& item = items[i];
+					bool compress = i >= TextureCount;
+
+					sprintf(item.Name, "data/textures/%s%02d.tex", compress ? "packed" : "stored", i % TextureCount);
+					strcpy(Names[i], item.Name);
+
+					item.Hash = HashPath(item.Name);
+					item.Data = MakeTexture(TextureSize, i % TextureCount + 1, &item.Size);
+					item.Compress = compress;
+				}
+
+				bool ret = WritePack(PackFileName, items, TextureCount * 2);
+
+				for (int i = 0; i < TextureCount * 2; i++)
+					free(items[i].Data);
+
+				return ret && Pack.Open(PackFileName, false);
+			}
+
+			void Destroy()
+			{
+				Pack.Close();
+				remove(PackFileName);
+			}
+		};
+
+		/* Pack lookups */
+
+		class PackFindBenchmark : public Benchmark
+		{
+		private:
+			TestPack pack;
+			char upperNames[TextureCount * 2][64]; // Spelled differently, so normalization is not a no-op
+		public:
+			PackFindBenchmark()
+				: Benchmark("assets.pack_find")
+			{
+				itemUnit = "lookups";
+				items = TextureCount * 2;
+			}
+
+			virtual bool Setup()
+			{
+				if (!pack.Create())
+					return false;
+
+				for (int i = 0; i < TextureCount * 2; i++)
+				{
+					strcpy(upperNames[i], "./");
+					strcat(upperNames[i], pack.Names[i]);
+
+					for (char* p = upperNames[i]; *p; p++)
+					{
+						if (*p == '/')
+							*p = '\\';
+						else if (*p >= 'a' && *p <= 'z' && (p - upperNames[i]) % 3 == 0)
+							*p -= 'a' - 'A';
+					}
+				}
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				int found = 0;
+
+				for (int i = 0; i < TextureCount * 2; i++)
+					found += pack.Pack.Find(upperNames[i]);
+
+				Consume(found);
+			}
+
+			virtual void Teardown()
+			{
+				pack.Destroy();
+			}
+		};
+
+		/* Texture loading */
+
+		// TextureLoader.LoadFromStream followed by FromPixelArray: every mip level is read from the pack and copied
+		// into a surface. Without a GPU the surface is system memory, which is what the driver copies through anyway.
+		class TextureLoadBenchmark : public Benchmark
+		{
+		private:
+			TestPack pack;
+			bool isCompressed;
+			unsigned char* buffer; // Decompression target, TextureLoader gets an ExtractedStream over it
+			unsigned char* surface;
+			int next;
+		public:
+			TextureLoadBenchmark(const char* name, bool isCompressed)
+				: Benchmark(name)
+			{
+				this->isCompressed = isCompressed;
+				itemUnit = "textures";
+				items = 1;
+			}
+
+			virtual bool Setup()
+			{
+				if (!pack.Create())
+					return false;
+
+				unsigned int fileSize = pack.Pack.GetSize(pack.Pack.Find(pack.Names[0]));
+
+				buffer = (unsigned char*)malloc(fileSize);
+				surface = (unsigned char*)malloc(TextureSize * TextureSize * 2);
+				next = 0;
+
+				bytes = fileSize;
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				int index = pack.Pack.Find(pack.Names[(isCompressed ? TextureCount : 0) + next]);
+				next = (next + 1) % TextureCount;
+
+				const unsigned char* data;
+				PackSpan span;
+
+				if (isCompressed)
+				{
+					pack.Pack.Read(index, buffer, pack.Pack.GetSize(index));
+					data = buffer;
+				}
+				else
+				{
+					pack.Pack.GetSpan(index, &span);
+					data = (const unsigned char*)span.Data;
+				}
+
+				int mipCount;
+				memcpy(&mipCount, data + 10, 4);
+				data += 14;
+
+				for (int i = 0; i < mipCount; i++)
+				{
+					unsigned int linearSize;
+					memcpy(&linearSize, data + 4, 4);
+					data += 8;
+
+					memcpy(surface, data, linearSize);
+					data += linearSize;
+				}
+
+				Consume(surface[0]);
+			}
+
+			virtual void Teardown()
+			{
+				free(surface);
+				free(buffer);
+				pack.Destroy();
+			}
+		};
+
+		class Crc32Benchmark : public Benchmark
+		{
+		private:
+			unsigned char* data;
+		public:
+			Crc32Benchmark()
+				: Benchmark("assets.crc32")
+			{
+				bytes = 1 << 20;
+			}
+
+			virtual bool Setup()
+			{
+				data = (unsigned char*)malloc((size_t)bytes);
+				Random random(5);
+
+				for (int i = 0; i < bytes; i++)
+					data[i] = (unsigned char)random.Next();
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				Consume(Crc32(data, (unsigned int)bytes));
+			}
+
+			virtual void Teardown()
+			{
+				free(data);
+			}
+		};
+
+		/* Mesh loading */
+
+		// Mesh.FromStream on FW_190.smd with the text already read, what every Resources.LoadMesh of it costs
+		class SmdLoadBenchmark : public Benchmark
+		{
+		private:
+			char* text;
+			int length;
+		public:
+			SmdLoadBenchmark()
+				: Benchmark("assets.smd_load_fw190")
+			{
+				itemUnit = "triangles";
+			}
+
+			virtual bool Setup()
+			{
+				SmdMesh mesh;
+
+				text = LoadSmdText("FW_190.smd", AircraftVertexCount / 3, AircraftSpan, AircraftHeight, 2, &length);
+
+				if (!ParseSmd(text, length, &mesh))
+				{
+					free(text);
+					return false;
+				}
+
+				items = mesh.VertexCount / 3;
+				bytes = length;
+				FreeSmd(&mesh);
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				SmdMesh mesh;
+
+				ParseSmd(text, length, &mesh);
+				Consume(mesh.VertexCount);
+				FreeSmd(&mesh);
+			}
+
+			virtual void Teardown()
+			{
+				free(text);
+			}
+		};
+
+		/* Resource cache */
+
+		const int ResourceKeys = 256;
+
+		// Acquire and release of a resource that is already loaded, what every Enemy spawn does three times
+		class ResourceHitBenchmark : public Benchmark
+		{
+		private:
+			ResourceCache* cache;
+			char paths[ResourceKeys][48];
+			int next;
+		public:
+			ResourceHitBenchmark()
+				: Benchmark("assets.resource_hit")
+			{
+				itemUnit = "acquires";
+				items = 1;
+			}
+
+			virtual bool Setup()
+			{
+				cache = new ResourceCache(ResourceKeys * 2);
+
+				for (int i = 0; i < ResourceKeys; i++)
+				{
+					sprintf(paths[i], "data/geometry/Mesh%03d.smd", i);
+
+					bool mustLoad;
+					ResourceHandle handle = cache->Acquire(0, paths[i], 0, &mustLoad);
+					cache->Complete(handle, paths[i], 1024);
+					cache->Release(handle);
+				}
+
+				next = 0;
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				bool mustLoad;
+				ResourceHandle handle = cache->Acquire(0, paths[next], 0, &mustLoad);
+				Consume((unsigned int)(size_t)cache->GetResource(handle));
+				cache->Release(handle);
+
+				next = (next + 1) % ResourceKeys;
+			}
+
+			virtual void Teardown()
+			{
+				delete cache;
+			}
+		};
+
+		// Loading a level's worth of entries and unloading them again, e.g. between missions
+		class ResourceChurnBenchmark : public Benchmark
+		{
+		private:
+			ResourceCache* cache;
+			char paths[ResourceKeys][48];
+			ResourceHandle handles[ResourceKeys];
+		public:
+			ResourceChurnBenchmark()
+				: Benchmark("assets.resource_churn")
+			{
+				itemUnit = "resources";
+				items = ResourceKeys;
+			}
+
+			virtual bool Setup()
+			{
+				cache = new ResourceCache(ResourceKeys);
+
+				for (int i = 0; i < ResourceKeys; i++)
+					sprintf(paths[i], "data/textures/Texture%03d.tex", i);
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				for (int i = 0; i < ResourceKeys; i++)
+				{
+					bool mustLoad;
+					handles[i] = cache->Acquire(i % ResourceCache::MaxTypes, paths[i], 0, &mustLoad);
+					cache->Complete(handles[i], paths[i], 4096);
+				}
+
+				for (int i = 0; i < ResourceKeys; i++)
+					cache->Release(handles[i]);
+
+				UnloadedResource unloaded[64];
+
+				while (cache->Unload(-1, unloaded, 64) == 64)
+					;
+			}
+
+			virtual void Teardown()
+			{
+				delete cache;
+			}
+		};
+
+		void AddAssetBenchmarks(Runner& runner)
+		{
+			runner.Add(new PackFindBenchmark());
+			runner.Add(new TextureLoadBenchmark("assets.tex_load_256", false));
+			runner.Add(new TextureLoadBenchmark("assets.tex_load_256_lz4", true));
+			runner.Add(new Crc32Benchmark());
+			runner.Add(new SmdLoadBenchmark());
+			runner.Add(new ResourceHitBenchmark());
+			runner.Add(new ResourceChurnBenchmark());
+		}
+	}
+}
@@ -0,0 +1,250 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Benchmarks.h"
+#include "AudioMixer.h"
+#include "AudioSink.h"
+#include "SpatialAudio.h"
+#include "ImaAdpcm.h"
+
+using namespace DXSharp::Audio;
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		const int OutputRate = 44100; // SoundDevice.OutputRate
+		const int VoiceCount = 32; // SoundDevice.VoiceCount
+		const int RealEmitters = 12; // SoundDevice.RealEmitters
+		const int MixFrames = 1024; // ~23ms, about what the mixer thread renders per wakeup
+
+		// Sine stand-in for the clips the game plays, e.g. propeller.wav is mono 22kHz
+		static SoundClip* MakeClip(int channels, int sampleRate, float seconds)
+		{
+			int frames = (int)(sampleRate * seconds);
+			short* pcm = (short*)malloc(sizeof(short) * frames * channels);
+
+			for (int i = 0; i < frames; i++)
+			{
+				for (int c = 0; c < channels; c++)
+					pcm[i * channels + c] = (short)(8000 * sin(i * (0.05 + c * 0.01)));
+			}
+
+			SoundClip* ret = SoundClip::Create(pcm, sizeof(short) * frames * channels, channels, sampleRate, 16, false);
+			free(pcm);
+
+			return ret;
+		}
+
+		/* Mixing */
+
+		// Sound buffer fill: every voice resampled and mixed into one block, as the mixer thread does
+		class MixBenchmark : public Benchmark
+		{
+		private:
+			bool allowSimd;
+			NullAudioSink* sink;
+			AudioMixer* mixer;
+			SoundClip* mono;
+			SoundClip* stereo;
+			short* output;
+		public:
+			MixBenchmark(const char* name, bool allowSimd)
+				: Benchmark(name)
+			{
+				this->allowSimd = allowSimd;
+				itemUnit = "frames";
+				items = MixFrames;
+				bytes = MixFrames * 4;
+			}
+
+			virtual bool Setup()
+			{
+				sink = new NullAudioSink(OutputRate, MixFrames);
+				mixer = new AudioMixer(sink, VoiceCount, allowSimd);
+				mono = MakeClip(1, 22050, 2);
+				stereo = MakeClip(2, 44100, 2);
+				output = (short*)malloc(sizeof(short) * MixFrames * 2);
+
+				// Full pool, half of it pitched so the resampler is busy
+				VoiceParams params;
+				params.Loop = true;
+				params.Gain = 0.5f;
+
+				for (int i = 0; i < VoiceCount; i++)
+				{
+					params.Pitch = i % 2 ? 1.0f : 0.8f + i * 0.02f;
+					params.Pan = (i % 5) * 0.4f - 0.8f;
+					mixer->Play(i % 4 ? mono : stereo, params);
+				}
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				mixer->Render(output, MixFrames);
+			}
+
+			virtual void Teardown()
+			{
+				free(output);
+				delete mixer;
+				delete sink;
+				mono->Release();
+				stereo->Release();
+			}
+		};
+
+		/* ADPCM */
+
+		class AdpcmBenchmark : public Benchmark
+		{
+		private:
+			static const int BlockAlign = 512;
+			static const int BlockCount = 64;
+
+			unsigned char* blocks;
+			short* output;
+			int framesPerBlock;
+		public:
+			AdpcmBenchmark()
+				: Benchmark("audio.ima_adpcm_decode")
+			{
+				itemUnit = "frames";
+			}
+
+			virtual bool Setup()
+			{
+				Random random(6);
+
+				blocks = (unsigned char*)malloc(BlockAlign * BlockCount);
+
+				for (int i = 0; i < BlockAlign * BlockCount; i++)
+					blocks[i] = (unsigned char)random.Next();
+
+				// Headers must be valid: predictor, step index 0-88, reserved byte
+				for (int i = 0; i < BlockCount; i++)
+				{
+					blocks[i * BlockAlign + 2] = (unsigned char)random.Next(0, 89);
+					blocks[i * BlockAlign + 3] = 0;
+				}
+
+				framesPerBlock = (BlockAlign - 4) * 2 + 1;
+				output = (short*)malloc(sizeof(short) * framesPerBlock);
+
+				items = framesPerBlock * BlockCount;
+				bytes = BlockAlign * BlockCount;
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				int frames = 0;
+
+				for (int i = 0; i < BlockCount; i++)
+					frames += DecodeImaAdpcmBlock(blocks + i * BlockAlign, BlockAlign, 1, output, framesPerBlock);
+
+				Consume(frames);
+			}
+
+			virtual void Teardown()
+			{
+				free(output);
+				free(blocks);
+			}
+		};
+
+		/* Spatial */
+
+		// One SoundDevice.Update: emitters moved by their objects, then ranked and pushed to the mixer
+		class SpatialBenchmark : public Benchmark
+		{
+		private:
+			int emitterCount;
+			NullAudioSink* sink;
+			AudioMixer* mixer;
+			SpatialAudio* scene;
+			SoundClip* clip;
+			EmitterHandle* emitters;
+			float* angles;
+			float time;
+		public:
+			SpatialBenchmark(const char* name, int emitterCount)
+				: Benchmark(name)
+			{
+				this->emitterCount = emitterCount;
+				itemUnit = "emitters";
+				items = emitterCount;
+			}
+
+			virtual bool Setup()
+			{
+				sink = new NullAudioSink(OutputRate, MixFrames);
+				mixer = new AudioMixer(sink, VoiceCount, true);
+				scene = new SpatialAudio(mixer, RealEmitters, true);
+				clip = MakeClip(1, 22050, 1);
+
+				emitters = (EmitterHandle*)malloc(sizeof(EmitterHandle) * emitterCount);
+				angles = (float*)malloc(sizeof(float) * emitterCount);
+
+				EmitterParams params;
+				params.MinDistance = 8;
+				params.MaxDistance = 250; // EngineHearingDistance
+
+				Random random(7);
+
+				for (int i = 0; i < emitterCount; i++)
+				{
+					emitters[i] = scene->AddEmitter(clip, params);
+					angles[i] = random.NextFloat() * 6.2832f;
+				}
+
+				time = 0;
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				time += SimulationStep;
+
+				// Circling at different radii, so some drift in and out of hearing range
+				for (int i = 0; i < emitterCount; i++)
+				{
+					float radius = 20.0f + (i % 16) * 20.0f;
+					float angle = angles[i] + time * 0.5f;
+					float x = (float)cos(angle) * radius;
+					float z = (float)sin(angle) * radius;
+
+					scene->SetEmitterPosition(emitters[i], x, 15, z, -z * 0.5f, 0, x * 0.5f);
+				}
+
+				scene->SetListener(0, 15, 0, 0, 0, 35, 0, 0, 1, 0, 1, 0);
+				scene->Update(SimulationStep);
+			}
+
+			virtual void Teardown()
+			{
+				delete scene;
+				delete mixer;
+				delete sink;
+				clip->Release();
+
+				free(angles);
+				free(emitters);
+			}
+		};
+
+		void AddAudioBenchmarks(Runner& runner)
+		{
+			runner.Add(new MixBenchmark("audio.mix_32_voices", true));
+			runner.Add(new MixBenchmark("audio.mix_32_voices_scalar", false));
+			runner.Add(new AdpcmBenchmark());
+			runner.Add(new SpatialBenchmark("audio.spatial_update_64", 64));
+			runner.Add(new SpatialBenchmark("audio.spatial_update_512", 512));
+		}
+	}
+}
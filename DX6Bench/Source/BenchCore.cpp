@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Benchmarks.h"
+#include "JobSystem.h"
+#include "Logger.h"
+
+using namespace DXSharp::Jobs;
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		/* Jobs */
+
+		static void SumRange(void* data, int start, int end)
+		{
+			float* values = (float*)data;
+			float sum = 0;
+
+			for (int i = start; i < end; i++)
+				sum += values[i];
+
+			Consume((unsigned int)sum);
+		}
+
+		// Scene.Update fanning parallel objects out: many small ranges, so this is mostly scheduling overhead
+		class ParallelForBenchmark : public Benchmark
+		{
+		private:
+			static const int Count = 1024;
+
+			JobSystem* jobs;
+			float* values;
+		public:
+			ParallelForBenchmark()
+				: Benchmark("jobs.parallel_for_1024")
+			{
+				itemUnit = "items";
+				items = Count;
+			}
+
+			virtual bool Setup()
+			{
+				int workers = Platform::GetProcessorCount() - 1;
+				jobs = new JobSystem(workers > 0 ? workers : 0, false);
+
+				values = (float*)malloc(sizeof(float) * Count);
+
+				for (int i = 0; i < Count; i++)
+					values[i] = (float)i;
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				JobCounter counter;
+				counter.Value = 0;
+
+				jobs->ParallelFor(SumRange, values, Count, 16, &counter, 0);
+				jobs->Wait(&counter);
+			}
+
+			virtual void Teardown()
+			{
+				free(values);
+				delete jobs;
+			}
+		};
+
+		/* Logging */
+
+		class NullLogOutput : public Logging::LogOutput
+		{
+		public:
+			virtual void Write(const char* line, int length) { Consume(length); }
+			virtual void Flush() { }
+		};
+
+		// Writes a burst and waits for the logger thread to format it, so records dropped on a full ring can't
+		// make it look faster than it is
+		class LoggerBenchmark : public Benchmark
+		{
+		private:
+			static const int Burst = 256;
+
+			bool ownsLogger;
+		public:
+			LoggerBenchmark()
+				: Benchmark("log.write_flush")
+			{
+				itemUnit = "records";
+				items = Burst;
+			}
+
+			virtual bool Setup()
+			{
+				ownsLogger = Logging::Logger::Initialize(new NullLogOutput(), Logging::Logger::DefaultCapacity);
+
+				return ownsLogger;
+			}
+
+			virtual void Run()
+			{
+				LOG_SITE(benchSite, "Bench", LogInfo, "Frame {0}: {1} draw calls, {2} triangles, {3}ms");
+
+				for (int i = 0; i < Burst; i++)
+					Logging::Logger::Write(benchSite, i, 120, 45000, 16.7f);
+
+				Logging::Logger::Flush();
+			}
+
+			virtual void Teardown()
+			{
+				Logging::Logger::Shutdown();
+			}
+		};
+
+		// Debug sites left in release builds: the level compare is all a call may cost
+		class LoggerDisabledBenchmark : public Benchmark
+		{
+		private:
+			static const int Calls = 4096;
+
+			bool ownsLogger;
+		public:
+			LoggerDisabledBenchmark()
+				: Benchmark("log.disabled_site")
+			{
+				itemUnit = "calls";
+				items = Calls;
+			}
+
+			virtual bool Setup()
+			{
+				ownsLogger = Logging::Logger::Initialize(new NullLogOutput(), Logging::Logger::DefaultCapacity);
+
+				return ownsLogger;
+			}
+
+			virtual void Run()
+			{
+				LOG_SITE(disabledSite, "Bench", LogTrace, "Visible objects {0}, culled {1}");
+
+				for (int i = 0; i < Calls; i++)
+					Logging::Logger::Write(disabledSite, i, Calls - i);
+			}
+
+			virtual void Teardown()
+			{
+				Logging::Logger::Shutdown();
+			}
+		};
+
+		void AddCoreBenchmarks(Runner& runner)
+		{
+			runner.Add(new ParallelForBenchmark());
+			runner.Add(new LoggerBenchmark());
+			runner.Add(new LoggerDisabledBenchmark());
+		}
+	}
+}
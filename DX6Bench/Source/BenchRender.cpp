@@ -0,0 +1,787 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Benchmarks.h"
+#include "RenderCommands.h"
+#include "TransientVertexRing.h"
+#include "VertexFormats.h"
+#include "JobSystem.h"
+#include "SceneAssets.h"
+
+using namespace DXSharp::Rendering;
+using namespace DXSharp::Jobs;
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		// D3DPT_TRIANGLELIST, D3DTS_WORLD, D3DRENDERSTATE_ZENABLE and D3DDP_DONOTLIGHT without pulling in d3d.h
+		const int TriangleList = 4;
+		const int WorldTransform = 1;
+		const int ZEnableState = 7;
+		const int DoNotLight = 0x10;
+
+		const int TransientVertexCount = 32768; // Same as Device::TransientVertexCount
+
+		// Stands in for D3DCommandSink: copies vertices of every draw the way the driver would and counts the rest
+		class RecordingSink : public CommandSink
+		{
+		private:
+			unsigned char* vertexBuffer;
+			int vertexCapacity;
+		public:
+			long Draws;
+			Platform::Int64 Vertices;
+			long StateChanges;
+			long Frames;
+
+			RecordingSink()
+			{
+				vertexBuffer = 0;
+				vertexCapacity = 0;
+				Draws = 0;
+				Vertices = 0;
+				StateChanges = 0;
+				Frames = 0;
+			}
+
+			~RecordingSink()
+			{
+				free(vertexBuffer);
+			}
+
+			virtual void Clear(const ClearDesc& desc) { StateChanges++; }
+			virtual void BeginScene() { }
+			virtual void EndScene() { }
+			virtual void SetTransform(int type, const float* matrix) { StateChanges++; }
+			virtual void SetTexture(int stage, void* texture) { StateChanges++; }
+			virtual void SetRenderState(int state, unsigned int value) { StateChanges++; }
+			virtual void SetTextureStageState(int stage, int state, int value) { StateChanges++; }
+			virtual void SetMaterial(const MaterialDesc& material) { StateChanges++; }
+
+			virtual void DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount)
+			{
+				int size = vertexSize * vertexCount;
+
+				// Grows during warmup only
+				if (size > vertexCapacity)
+				{
+					free(vertexBuffer);
+					vertexBuffer = (unsigned char*)malloc(size);
+					vertexCapacity = size;
+				}
+
+				memcpy(vertexBuffer, vertices, size);
+
+				Draws++;
+				Vertices += vertexCount;
+			}
+
+			virtual void Present()
+			{
+				Frames++;
+			}
+		};
+
+		/* Geometry */
+
+		const int FoliageKinds = 3; // Terrain loads bush08, tree04 and bush08 again with another texture
+
+		// Mesh.FromStream on an .smd, the game's file when there is one
+		static bool LoadMesh(const char* fileName, int vertexCount, float width, float height, unsigned int seed, SmdMesh* mesh)
+		{
+			int length;
+			char* text = LoadSmdText(fileName, vertexCount / 3, width, height, seed, &length);
+			bool ret = ParseSmd(text, length, mesh);
+
+			free(text);
+
+			return ret;
+		}
+
+		// Terrain.Build on a heightmap of the given size
+		static void MakeTerrain(int size, TerrainMesh* terrain)
+		{
+			Heightmap map;
+
+			MakeHeightmap(size, 1, &map);
+			BuildTerrain(map, FoliageKinds, 4, terrain);
+			FreeHeightmap(&map);
+		}
+
+		// Full layout vertices of the terrain, or of FW_190.smd for terrainSize 0. Null if the mesh doesn't parse.
+		static VertexPNCT* LoadSource(int terrainSize, int* vertexCount)
+		{
+			if (terrainSize)
+			{
+				TerrainMesh terrain;
+				MakeTerrain(terrainSize, &terrain);
+
+				VertexPNCT* ret = terrain.Vertices;
+				*vertexCount = terrain.VertexCount;
+				free(terrain.Placements);
+
+				return ret;
+			}
+
+			SmdMesh mesh;
+
+			if (!LoadMesh("FW_190.smd", AircraftVertexCount, AircraftSpan, AircraftHeight, 2, &mesh))
+				return 0;
+
+			*vertexCount = mesh.VertexCount;
+
+			return mesh.Vertices;
+		}
+
+		template<typename Dest>
+		static Dest* Convert(const VertexPNCT* source, int count)
+		{
+			Dest* ret = (Dest*)malloc(sizeof(Dest) * count);
+			ConvertVertices(source, ret, count, VertexDefaults());
+
+			return ret;
+		}
+
+		static void SetDrawState(CommandList* list, void* texture, bool zTest)
+		{
+			static const float world[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+			static MaterialDesc material = { { 1, 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 }, { 0, 0, 0 }, 50 };
+
+			// What Graphics.DrawMesh records per mesh
+			list->SetTransform(WorldTransform, world);
+			list->SetTexture(0, texture);
+			list->SetTextureStageState(0, 1, 4);
+			list->SetTextureStageState(0, 2, 2);
+			list->SetMaterial(material);
+			list->SetRenderState(ZEnableState, zTest ? 1 : 0);
+		}
+
+		/* Mesh submission */
+
+		// Records one mesh draw and replays it, the way every DrawMesh goes with the render thread enabled
+		template<typename Vertex>
+		class SubmitMeshBenchmark : public Benchmark
+		{
+		private:
+			int terrainSize; // 0 for the aircraft
+			VertexPNCT* source;
+			Vertex* vertices;
+			int vertexCount;
+			CommandList* list;
+			RecordingSink* sink;
+		public:
+			SubmitMeshBenchmark(const char* name, int terrainSize)
+				: Benchmark(name)
+			{
+				this->terrainSize = terrainSize;
+				itemUnit = "vertices";
+			}
+
+			virtual bool Setup()
+			{
+				source = LoadSource(terrainSize, &vertexCount);
+
+				if (!source)
+					return false;
+
+				vertices = Convert<Vertex>(source, vertexCount);
+
+				list = new CommandList();
+				sink = new RecordingSink();
+
+				items = vertexCount;
+				bytes = (Platform::Int64)vertexCount * sizeof(Vertex);
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				SetDrawState(list, 0, true);
+				list->DrawPrimitive(TriangleList, Vertex::Format, terrainSize ? DoNotLight : 0, vertices, sizeof(Vertex), vertexCount);
+				list->Execute(sink);
+				list->Reset();
+			}
+
+			virtual void Teardown()
+			{
+				delete sink;
+				delete list;
+				free(vertices);
+				free(source);
+			}
+		};
+
+		/* Vertex conversion */
+
+		// Mesh construction converts the full SMD layout once per mesh (and Terrain.Build once per heightmap)
+		template<typename Dest>
+		class ConvertBenchmark : public Benchmark
+		{
+		private:
+			int terrainSize;
+			VertexPNCT* source;
+			Dest* dest;
+			int vertexCount;
+		public:
+			ConvertBenchmark(const char* name, int terrainSize)
+				: Benchmark(name)
+			{
+				this->terrainSize = terrainSize;
+				itemUnit = "vertices";
+			}
+
+			virtual bool Setup()
+			{
+				source = LoadSource(terrainSize, &vertexCount);
+
+				if (!source)
+					return false;
+
+				dest = (Dest*)malloc(sizeof(Dest) * vertexCount);
+
+				items = vertexCount;
+				bytes = (Platform::Int64)vertexCount * sizeof(VertexPNCT);
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				ConvertVertices(source, dest, vertexCount, VertexDefaults());
+			}
+
+			virtual void Teardown()
+			{
+				free(dest);
+				free(source);
+			}
+		};
+
+		/* Water */
+
+		struct WaterState
+		{
+			VertexPNCT* Vertices;
+			float Time;
+		};
+
+		// Water.AnimateRows as it is, Math.Sin for every vertex and nothing hoisted. Time is read through a volatile so the
+		// compiler can't fold the six calls into one either; the JIT doesn't.
+		static void AnimateWaterRows(void* data, int start, int end)
+		{
+			WaterState* water = (WaterState*)data;
+			volatile float* time = &water->Time;
+
+			for (int i = start; i < end; i++)
+			{
+				VertexPNCT* v = &water->Vertices[i * WaterGridSize * 6];
+
+				for (int j = 0; j < WaterGridSize; j++)
+				{
+					v[0].V += (float)sin(*time * 0.001f);
+					v[1].V += (float)sin(*time * 0.001f);
+					v[2].V += (float)sin(*time * 0.001f);
+					v[3].V += (float)sin(*time * 0.001f);
+					v[4].V += (float)sin(*time * 0.001f);
+					v[5].V += (float)sin(*time * 0.001f);
+
+					v += 6;
+				}
+			}
+		}
+
+		// Animates the grid on the job system and hands it to the transient ring, like Water.Update and Water.Draw
+		static void UpdateWater(JobSystem* jobs, WaterState* water, TransientVertexRing* ring, long fence, CommandList* list)
+		{
+			int vertexCount = WaterGridSize * WaterGridSize * 6;
+
+			water->Time += 0.1f;
+
+			JobCounter counter;
+			counter.Value = 0;
+			jobs->ParallelFor(AnimateWaterRows, water, WaterGridSize, 8, &counter, 0);
+			jobs->Wait(&counter);
+
+			SetDrawState(list, 0, true);
+
+			TransientVertexRing::Allocation allocation;
+
+			if (!ring->Allocate(vertexCount, fence, &allocation))
+			{
+				// Device falls back to a regular (copied) draw when the ring is full
+				list->DrawPrimitive(TriangleList, VertexPNCT::Format, 0, water->Vertices, sizeof(VertexPNCT), vertexCount);
+				return;
+			}
+
+			memcpy(allocation.Data, water->Vertices, sizeof(VertexPNCT) * vertexCount);
+			ring->Commit();
+
+			list->DrawExternal(TriangleList, VertexPNCT::Format, 0, allocation.Data, sizeof(VertexPNCT), vertexCount);
+		}
+
+		static JobSystem* CreateJobSystem()
+		{
+			// Main thread helps in Wait, like Engine leaves a core for it
+			int workers = Platform::GetProcessorCount() - 1;
+
+			return new JobSystem(workers > 0 ? workers : 0, false);
+		}
+
+		// The grid Water's constructor builds
+		static VertexPNCT* MakeWater()
+		{
+			const float Scale = 2;
+			const unsigned int Color = 0x6EFFFFFF; // White at AlphaLevel 110
+
+			static const int cornerX[6] = { 0, 1, 0, 0, 1, 1 };
+			static const int cornerZ[6] = { 0, 1, 1, 0, 0, 1 };
+
+			VertexPNCT* ret = (VertexPNCT*)calloc(WaterGridSize * WaterGridSize * 6, sizeof(VertexPNCT));
+			VertexPNCT* v = ret;
+
+			for (int i = 0; i < WaterGridSize; i++)
+			{
+				for (int j = 0; j < WaterGridSize; j++)
+				{
+					for (int k = 0; k < 6; k++)
+					{
+						v[k].X = (i + cornerX[k]) * Scale;
+						v[k].Z = (j + cornerZ[k]) * Scale;
+						v[k].NY = 1;
+						v[k].Diffuse = Color;
+						v[k].U = (float)cornerX[k];
+						v[k].V = (float)(1 - cornerZ[k]);
+					}
+
+					v += 6;
+				}
+			}
+
+			return ret;
+		}
+
+		class WaterBenchmark : public Benchmark
+		{
+		private:
+			JobSystem* jobs;
+			WaterState water;
+			TransientVertexRing* ring;
+			CommandList* list;
+			RecordingSink* sink;
+			long frame;
+		public:
+			WaterBenchmark()
+				: Benchmark("water.update")
+			{
+				itemUnit = "vertices";
+			}
+
+			virtual bool Setup()
+			{
+				jobs = CreateJobSystem();
+				water.Vertices = MakeWater();
+				water.Time = 0;
+				ring = new TransientVertexRing(new MemoryVertexRingStorage(sizeof(VertexPNCT), TransientVertexCount), sizeof(VertexPNCT), TransientVertexCount);
+				list = new CommandList();
+				sink = new RecordingSink();
+				frame = 0;
+
+				items = WaterGridSize * WaterGridSize * 6;
+				bytes = (Platform::Int64)items * sizeof(VertexPNCT);
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				frame++;
+
+				UpdateWater(jobs, &water, ring, frame, list);
+				list->Execute(sink);
+				list->Reset();
+
+				ring->Retire(frame);
+			}
+
+			virtual void Teardown()
+			{
+				delete sink;
+				delete list;
+				delete ring;
+				free(water.Vertices);
+				delete jobs;
+			}
+		};
+
+		/* Terrain */
+
+		// bush08 for kinds 0 and 2, tree04 for 1. Without the files both get bush08's triangle count, tree04's isn't known.
+		static bool LoadFoliage(SmdMesh* bush, SmdMesh* tree)
+		{
+			if (!LoadMesh("bush08.smd", FoliageVertexCount, 3, 2.5f, 10, bush))
+				return false;
+
+			if (!LoadMesh("tree04.smd", FoliageVertexCount, 5, 9, 11, tree))
+			{
+				FreeSmd(bush);
+				return false;
+			}
+
+			return true;
+		}
+
+		static int GetFoliageMesh(int kind)
+		{
+			return kind == 1 ? 1 : 0;
+		}
+
+		// Camera where PlayerAirplane leaves it on the first frame, 12 behind and 4 above the player, level and facing +Z
+		static const float CameraPosition[3] = { 0, 19, -12 };
+		static const float CameraRotation[3] = { 0, 0, 0 };
+
+		struct FoliageCull
+		{
+			Frustum View;
+			const FoliagePlacement* Placements;
+			float Radius[FoliageKinds];
+			bool* Visible;
+		};
+
+		// Terrain.CullFoliage, terrain drawn at the origin like Game.Draw does
+		static void CullFoliage(void* data, int start, int end)
+		{
+			FoliageCull* cull = (FoliageCull*)data;
+
+			for (int i = start; i < end; i++)
+			{
+				const FoliagePlacement& p = cull->Placements[i];
+				float radius = cull->Radius[p.Kind];
+
+				cull->Visible[i] = radius <= 0 || cull->View.IsSphereInFrustum(p.X, p.Y, p.Z, radius);
+			}
+		}
+
+		// Terrain.BeginCulling after Camera.Interpolate rebuilt the matrices
+		static void BeginCulling(JobSystem* jobs, FoliageCull* cull, int count, JobCounter* counter)
+		{
+			float viewProj[16];
+
+			BuildViewProjection(CameraPosition, CameraRotation, viewProj);
+			cull->View.Calculate(viewProj);
+
+			counter->Value = 0;
+			jobs->ParallelFor(CullFoliage, cull, count, 64, counter, 0);
+		}
+
+		class TerrainBuildBenchmark : public Benchmark
+		{
+		private:
+			int size;
+			Heightmap map;
+		public:
+			TerrainBuildBenchmark(const char* name, int size)
+				: Benchmark(name)
+			{
+				this->size = size;
+				itemUnit = "vertices";
+			}
+
+			virtual bool Setup()
+			{
+				MakeHeightmap(size, 1, &map);
+
+				items = size * size * 6;
+				bytes = (Platform::Int64)items * sizeof(VertexPNCT);
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				TerrainMesh terrain;
+
+				BuildTerrain(map, FoliageKinds, 4, &terrain);
+				Consume(terrain.PlacementCount);
+				FreeTerrain(&terrain);
+			}
+
+			virtual void Teardown()
+			{
+				FreeHeightmap(&map);
+			}
+		};
+
+		class FoliageCullBenchmark : public Benchmark
+		{
+		private:
+			int size;
+			TerrainMesh terrain;
+			FoliageCull cull;
+			JobSystem* jobs;
+		public:
+			FoliageCullBenchmark(const char* name, int size)
+				: Benchmark(name)
+			{
+				this->size = size;
+				itemUnit = "placements";
+			}
+
+			virtual bool Setup()
+			{
+				SmdMesh meshes[2];
+
+				if (!LoadFoliage(&meshes[0], &meshes[1]))
+					return false;
+
+				for (int i = 0; i < FoliageKinds; i++)
+					cull.Radius[i] = meshes[GetFoliageMesh(i)].Radius;
+
+				FreeSmd(&meshes[0]);
+				FreeSmd(&meshes[1]);
+
+				MakeTerrain(size, &terrain);
+				cull.Placements = terrain.Placements;
+				cull.Visible = (bool*)malloc(sizeof(bool) * (terrain.PlacementCount + 1));
+				jobs = CreateJobSystem();
+
+				items = terrain.PlacementCount;
+				bytes = 0;
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				JobCounter counter;
+
+				BeginCulling(jobs, &cull, terrain.PlacementCount, &counter);
+				jobs->Wait(&counter);
+			}
+
+			virtual void Teardown()
+			{
+				delete jobs;
+				free(cull.Visible);
+				FreeTerrain(&terrain);
+			}
+		};
+
+		/* Whole frame */
+
+		// Everything Game.Draw puts on screen: both aircraft, water, terrain and the foliage that survives culling
+		class FrameBenchmark : public Benchmark
+		{
+		private:
+			static const int TerrainSize = 64; // Without data/heightmap.bmp
+
+			bool isThreaded;
+
+			VertexPCT* terrain;
+			int terrainVertexCount;
+			VertexPNT* aircraft;
+			int aircraftVertexCount;
+			float aircraftRadius;
+			VertexPNT* foliage[2];
+			int foliageVertexCount[2];
+			FoliagePlacement* placements;
+			int placementCount;
+			FoliageCull cull;
+
+			JobSystem* jobs;
+			WaterState water;
+			TransientVertexRing* ring;
+			RecordingSink* sink;
+
+			CommandList* list; // Inline mode
+			RenderThread* thread; // Threaded mode
+			long frame;
+
+			void Record(CommandList* list, long fence)
+			{
+				// Player where Airplane starts and the enemy Game.Start adds
+				static const float aircraftPositions[2][3] = { { 0, 15, 0 }, { 25, 15, 35 } };
+
+				ClearDesc clear;
+				memset(&clear, 0, sizeof(clear));
+				clear.Flags = 3;
+				clear.Z = 1;
+
+				list->Clear(clear);
+				list->BeginScene();
+
+				JobCounter culled;
+				BeginCulling(jobs, &cull, placementCount, &culled);
+
+				// Scene, Graphics.DrawMesh tests each aircraft against the same frustum
+				for (int i = 0; i < 2; i++)
+				{
+					if (!cull.View.IsSphereInFrustum(aircraftPositions[i][0], aircraftPositions[i][1], aircraftPositions[i][2], aircraftRadius))
+						continue;
+
+					SetDrawState(list, 0, true);
+					list->DrawPrimitive(TriangleList, VertexPNT::Format, 0, aircraft, sizeof(VertexPNT), aircraftVertexCount);
+				}
+
+				UpdateWater(jobs, &water, ring, fence, list);
+
+				SetDrawState(list, 0, true);
+				list->DrawPrimitive(TriangleList, VertexPCT::Format, DoNotLight, terrain, sizeof(VertexPCT), terrainVertexCount);
+
+				jobs->Wait(&culled);
+
+				for (int i = 0; i < placementCount; i++)
+				{
+					if (!cull.Visible[i])
+						continue;
+
+					int mesh = GetFoliageMesh(placements[i].Kind);
+
+					SetDrawState(list, 0, true);
+					list->DrawPrimitive(TriangleList, VertexPNT::Format, 0, foliage[mesh], sizeof(VertexPNT), foliageVertexCount[mesh]);
+				}
+
+				list->EndScene();
+				list->Present();
+			}
+		public:
+			FrameBenchmark(const char* name, bool isThreaded)
+				: Benchmark(name)
+			{
+				this->isThreaded = isThreaded;
+				itemUnit = "frames";
+			}
+
+			virtual bool Setup()
+			{
+				SmdMesh meshes[2];
+				SmdMesh mesh;
+
+				if (!LoadFoliage(&meshes[0], &meshes[1]))
+					return false;
+
+				if (!LoadMesh("FW_190.smd", AircraftVertexCount, AircraftSpan, AircraftHeight, 2, &mesh))
+				{
+					FreeSmd(&meshes[0]);
+					FreeSmd(&meshes[1]);
+					return false;
+				}
+
+				aircraftVertexCount = mesh.VertexCount;
+				aircraftRadius = mesh.Radius;
+				aircraft = Convert<VertexPNT>(mesh.Vertices, aircraftVertexCount);
+				FreeSmd(&mesh);
+
+				for (int i = 0; i < 2; i++)
+				{
+					foliageVertexCount[i] = meshes[i].VertexCount;
+					foliage[i] = Convert<VertexPNT>(meshes[i].Vertices, foliageVertexCount[i]);
+				}
+
+				for (int i = 0; i < FoliageKinds; i++)
+					cull.Radius[i] = meshes[GetFoliageMesh(i)].Radius;
+
+				FreeSmd(&meshes[0]);
+				FreeSmd(&meshes[1]);
+
+				Heightmap map;
+				TerrainMesh built;
+
+				if (!LoadHeightmap("heightmap.bmp", &map))
+					MakeHeightmap(TerrainSize, 1, &map);
+
+				BuildTerrain(map, FoliageKinds, 4, &built);
+				FreeHeightmap(&map);
+
+				terrainVertexCount = built.VertexCount;
+				terrain = Convert<VertexPCT>(built.Vertices, terrainVertexCount);
+				placements = built.Placements;
+				placementCount = built.PlacementCount;
+				free(built.Vertices);
+
+				cull.Placements = placements;
+				cull.Visible = (bool*)malloc(sizeof(bool) * (placementCount + 1));
+
+				jobs = CreateJobSystem();
+				water.Vertices = MakeWater();
+				water.Time = 0;
+				ring = new TransientVertexRing(new MemoryVertexRingStorage(sizeof(VertexPNCT), TransientVertexCount), sizeof(VertexPNCT), TransientVertexCount);
+				sink = new RecordingSink();
+
+				list = isThreaded ? 0 : new CommandList();
+				thread = isThreaded ? new RenderThread(sink, 2) : 0;
+				frame = 0;
+
+				items = 1;
+				bytes = 0;
+
+				return true;
+			}
+
+			virtual void Run()
+			{
+				if (isThreaded)
+				{
+					// Same fencing Device.AllocateTransient does with the render thread running
+					long fence = thread->GetFramesSubmitted() + 1;
+					ring->Retire(thread->GetFramesExecuted());
+
+					Record(thread->GetCurrentList(), fence);
+					thread->SubmitFrame();
+				}
+				else
+				{
+					frame++;
+
+					Record(list, frame);
+					list->Execute(sink);
+					list->Reset();
+
+					ring->Retire(frame);
+				}
+			}
+
+			virtual void Teardown()
+			{
+				delete thread; // Finishes frames still queued
+				delete list;
+				delete sink;
+				delete ring;
+				free(water.Vertices);
+				delete jobs;
+
+				free(cull.Visible);
+				free(placements);
+
+				for (int i = 0; i < 2; i++)
+					free(foliage[i]);
+
+				free(aircraft);
+				free(terrain);
+			}
+		};
+
+		void AddRenderBenchmarks(Runner& runner)
+		{
+			runner.Add(new SubmitMeshBenchmark<VertexPNT>("render.submit_fw190", 0));
+			runner.Add(new SubmitMeshBenchmark<VertexPCT>("render.submit_terrain_64", 64));
+			runner.Add(new SubmitMeshBenchmark<VertexPCT>("render.submit_terrain_128", 128));
+			runner.Add(new SubmitMeshBenchmark<VertexPCT>("render.submit_terrain_256", 256));
+			runner.Add(new FrameBenchmark("render.frame", false));
+			runner.Add(new FrameBenchmark("render.frame_threaded", true));
+
+			runner.Add(new ConvertBenchmark<VertexPNT>("vertex.convert_fw190", 0));
+			runner.Add(new ConvertBenchmark<VertexPCT>("vertex.convert_terrain_64", 64));
+			runner.Add(new ConvertBenchmark<VertexPCT>("vertex.convert_terrain_128", 128));
+			runner.Add(new ConvertBenchmark<VertexPCT>("vertex.convert_terrain_256", 256));
+
+			runner.Add(new TerrainBuildBenchmark("terrain.build_128", 128));
+			runner.Add(new TerrainBuildBenchmark("terrain.build_256", 256));
+			runner.Add(new FoliageCullBenchmark("terrain.cull_foliage_256", 256));
+
+			runner.Add(new WaterBenchmark());
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Bench.h"
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		// Sizes of what Planes3D actually draws, so results translate to the game
+		const int AircraftVertexCount = 3600; // FW_190.smd, ~1200 triangles
+		const float AircraftSpan = 10.5f; // Meters, so generated stand-ins cull like the real mesh
+		const float AircraftHeight = 4;
+		const int FoliageVertexCount = 288; // bush08.smd
+		const int WaterGridSize = 64; // Water.Size, cells per side
+		const float SimulationStep = 1.0f / 60;
+
+		void AddRenderBenchmarks(Runner& runner);
+		void AddAssetBenchmarks(Runner& runner);
+		void AddAudioBenchmarks(Runner& runner);
+		void AddCoreBenchmarks(Runner& runner);
+	}
+}
@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Benchmarks.h"
+#include "Baseline.h"
+
+using namespace DXSharp::Bench;
+
+// Hot paths of the native engine cores, measured without a GPU or sound card: draws go to a recording
+// sink, audio to a null sink, assets come from a pack generated on startup.
+//
+//   DX6Bench --json current.json --baseline baseline.json --threshold 10 --threshold "render.*=15"
+//
+// Exit code is 1 if anything regressed against the baseline, 2 on bad arguments or unreadable files.
+
+static void PrintUsage()
+{
+	fprintf(stderr,
+		"Usage: DX6Bench [options]\n"
+		"  --list                    Print benchmark names and exit\n"
+		"  --filter <text>           Run only benchmarks whose name contains text\n"
+		"  --samples <n>             Samples per benchmark (30)\n"
+		"  --warmup <n>              Warmup samples, not measured (3)\n"
+		"  --min-sample-ms <ms>      Minimum length of a sample (2)\n"
+		"  --json <file>             Write results as JSON\n"
+		"  --baseline <file>         Compare p50 and allocations with an earlier JSON\n"
+		"  --threshold <percent>     Slowdown counted as a regression (10)\n"
+		"  --threshold <name>=<pct>  Same for one benchmark, name may end with '*'\n"
+		"  --alloc-tolerance <n>     Extra allocations per run allowed (0)\n");
+}
+
+int main(int argc, char** argv)
+{
+	RunnerConfig config;
+	Baseline baseline;
+	const char* jsonFile = 0;
+	const char* baselineFile = 0;
+	bool listOnly = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : 0;
+
+		if (strcmp(arg, "--list") == 0)
+		{
+			listOnly = true;
+			continue;
+		}
+
+		if (!value || strncmp(arg, "--", 2) != 0)
+		{
+			PrintUsage();
+			return 2;
+		}
+
+		i++;
+
+		if (strcmp(arg, "--filter") == 0)
+			config.Filter = value;
+		else if (strcmp(arg, "--samples") == 0)
+			config.Samples = atoi(value);
+		else if (strcmp(arg, "--warmup") == 0)
+			config.WarmupSamples = atoi(value);
+		else if (strcmp(arg, "--min-sample-ms") == 0)
+			config.MinSampleMs = atof(value);
+		else if (strcmp(arg, "--json") == 0)
+			jsonFile = value;
+		else if (strcmp(arg, "--baseline") == 0)
+			baselineFile = value;
+		else if (strcmp(arg, "--alloc-tolerance") == 0)
+			baseline.SetAllocTolerance(atof(value));
+		else if (strcmp(arg, "--threshold") == 0)
+		{
+			const char* separator = strrchr(value, '=');
+
+			if (!separator)
+			{
+				baseline.SetThreshold(atof(value));
+			}
+			else
+			{
+				char pattern[Baseline::MaxName];
+				int length = (int)(separator - value);
+
+				if (length <= 0 || length >= Baseline::MaxName)
+				{
+					PrintUsage();
+					return 2;
+				}
+
+				memcpy(pattern, value, length);
+				pattern[length] = 0;
+
+				if (!baseline.AddThreshold(pattern, atof(separator + 1)))
+				{
+					fprintf(stderr, "Too many thresholds\n");
+					return 2;
+				}
+			}
+		}
+		else
+		{
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if (config.Samples < 1 || config.WarmupSamples < 0 || config.MinSampleMs < 0)
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	// Read first, so a typo in the path doesn't cost a whole run
+	if (baselineFile && !baseline.Load(baselineFile))
+	{
+		fprintf(stderr, "Can't read baseline %s\n", baselineFile);
+		return 2;
+	}
+
+	Runner runner(config);
+
+	AddRenderBenchmarks(runner);
+	AddAssetBenchmarks(runner);
+	AddAudioBenchmarks(runner);
+	AddCoreBenchmarks(runner);
+
+	if (listOnly)
+	{
+		runner.List();
+		return 0;
+	}
+
+	runner.Run();
+	runner.Print();
+
+	if (jsonFile && !runner.WriteJson(jsonFile))
+	{
+		fprintf(stderr, "Can't write %s\n", jsonFile);
+		return 2;
+	}
+
+	if (baselineFile)
+	{
+		int regressions = baseline.Compare(runner);
+
+		if (regressions > 0)
+		{
+			printf("\n%d regression(s) against %s\n", regressions, baselineFile);
+			return 1;
+		}
+
+		printf("\nNo regressions against %s\n", baselineFile);
+	}
+
+	return 0;
+}
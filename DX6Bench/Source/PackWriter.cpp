@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "PackWriter.h"
+#include "PackFile.h"
+
+using namespace DXSharp::Assets;
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		int Lz4Compress(const unsigned char* src, int size, unsigned char* dst)
+		{
+			const int MinMatch = 4;
+			const int LastLiterals = 5;
+			const int MatchLimit = 12;
+			const int MaxOffset = 65535;
+			const int HashBits = 16;
+
+			int* table = (int*)malloc(sizeof(int) * (1 << HashBits));
+
+			for (int i = 0; i < (1 << HashBits); i++)
+				table[i] = -1;
+
+			unsigned char* out = dst;
+			int anchor = 0;
+			int ip = 0;
+
+			for (;;)
+			{
+				int literals;
+				int offset = 0;
+				int length = 0;
+
+				while (ip <= size - MatchLimit)
+				{
+					unsigned int seq;
+					memcpy(&seq, src + ip, 4);
+
+					int h = (int)((seq * 2654435761u) >> (32 - HashBits));
+					int candidate = table[h];
+					table[h] = ip;
+
+					unsigned int candidateSeq;
+
+					if (candidate >= 0 && ip - candidate <= MaxOffset && (memcpy(&candidateSeq, src + candidate, 4), candidateSeq == seq))
+					{
+						length = MinMatch;
+
+						while (ip + length < size - LastLiterals && src[candidate + length] == src[ip + length])
+							length++;
+
+						offset = ip - candidate;
+						break;
+					}
+
+					ip++;
+				}
+
+				literals = (length ? ip : size) - anchor;
+
+				int matchLength = length ? length - MinMatch : 0;
+				*out++ = (unsigned char)(((literals < 15 ? literals : 15) << 4) | (matchLength < 15 ? matchLength : 15));
+
+				if (literals >= 15)
+				{
+					int rest = literals - 15;
+
+					for (; rest >= 255; rest -= 255)
+						*out++ = 255;
+
+					*out++ = (unsigned char)rest;
+				}
+
+				memcpy(out, src + anchor, literals);
+				out += literals;
+
+				if (!length)
+					break;
+
+				*out++ = (unsigned char)offset;
+				*out++ = (unsigned char)(offset >> 8);
+
+				if (matchLength >= 15)
+				{
+					int rest = matchLength - 15;
+
+					for (; rest >= 255; rest -= 255)
+						*out++ = 255;
+
+					*out++ = (unsigned char)rest;
+				}
+
+				ip += length;
+				anchor = ip;
+			}
+
+			free(table);
+
+			return (int)(out - dst);
+		}
+
+		static int ComparePackItems(const void* a, const void* b)
+		{
+			const PackItem* x = (const PackItem*)a;
+			const PackItem* y = (const PackItem*)b;
+
+			if (x->Hash != y->Hash)
+				return x->Hash < y->Hash ? -1 : 1;
+
+			return strcmp(x->Name, y->Name);
+		}
+
+		static unsigned int AlignPack(unsigned int value)
+		{
+			return (value + PackAlignment - 1) & ~(unsigned int)(PackAlignment - 1);
+		}
+
+		bool WritePack(const char* fileName, PackItem* items, int count)
+		{
+			qsort(items, count, sizeof(PackItem), ComparePackItems);
+
+			PackEntry* entries = (PackEntry*)malloc(sizeof(PackEntry) * count);
+			unsigned char** payloads = (unsigned char**)malloc(sizeof(unsigned char*) * count);
+
+			unsigned int namesSize = 0;
+
+			for (int i = 0; i < count; i++)
+				namesSize += (unsigned int)strlen(items[i].Name) + 1;
+
+			unsigned int directorySize = sizeof(PackEntry) * count + namesSize;
+			unsigned char* directory = (unsigned char*)malloc(directorySize);
+			char* names = (char*)directory + sizeof(PackEntry) * count;
+
+			unsigned int nameOffset = 0;
+			unsigned int offset = AlignPack(sizeof(PackHeader) + directorySize);
+
+			for (int i = 0; i < count; i++)
+			{
+				PackItem& item = items[i];
+				PackEntry& e = entries[i];
+
+				memset(&e, 0, sizeof(e));
+				e.Hash = item.Hash;
+				e.NameOffset = nameOffset;
+				e.Size = item.Size;
+				e.Crc = Crc32(item.Data, item.Size);
+
+				strcpy(names + nameOffset, item.Name);
+				nameOffset += (unsigned int)strlen(item.Name) + 1;
+
+				payloads[i] = item.Data;
+				e.StoredSize = item.Size;
+
+				if (item.Compress)
+				{
+					unsigned char* packed = (unsigned char*)malloc(item.Size + item.Size / 255 + 16);
+					e.StoredSize = Lz4Compress(item.Data, item.Size, packed);
+					e.Flags = PackEntryLz4;
+					payloads[i] = packed;
+				}
+
+				e.Offset = offset;
+				offset = AlignPack(offset + e.StoredSize);
+			}
+
+			memcpy(directory, entries, sizeof(PackEntry) * count);
+
+			PackHeader header;
+			header.Magic = PackMagic;
+			header.Version = PackVersion;
+			header.EntryCount = count;
+			header.Alignment = PackAlignment;
+			header.NamesOffset = sizeof(PackHeader) + sizeof(PackEntry) * count;
+			header.NamesSize = namesSize;
+			header.DirectoryCrc = Crc32(directory, directorySize);
+			header.Reserved = 0;
+
+			FILE* file = fopen(fileName, "wb");
+			bool ret = file != 0;
+
+			if (file)
+			{
+				static const unsigned char padding[PackAlignment] = { 0 };
+				unsigned int position = sizeof(PackHeader) + directorySize;
+
+				fwrite(&header, sizeof(header), 1, file);
+				fwrite(directory, directorySize, 1, file);
+
+				for (int i = 0; i < count; i++)
+				{
+					fwrite(padding, entries[i].Offset - position, 1, file);
+					fwrite(payloads[i], entries[i].StoredSize, 1, file);
+					position = entries[i].Offset + entries[i].StoredSize;
+				}
+
+				ret = !ferror(file);
+				fclose(file);
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				if (payloads[i] != items[i].Data)
+					free(payloads[i]);
+			}
+
+			free(directory);
+			free(payloads);
+			free(entries);
+
+			return ret;
+		}
+
+	}
+}
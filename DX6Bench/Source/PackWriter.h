@@ -0,0 +1,24 @@
+#pragma once
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		const int PackAlignment = 16;
+
+		struct PackItem
+		{
+			char Name[64];
+			unsigned int Hash; // HashPath of Name
+			unsigned char* Data;
+			unsigned int Size;
+			bool Compress;
+		};
+
+		// Greedy LZ4 block compressor, same as TexTool's. dst needs size + size / 255 + 16 bytes.
+		int Lz4Compress(const unsigned char* src, int size, unsigned char* dst);
+
+		// Same layout PackBuilder writes. Sorts items.
+		bool WritePack(const char* fileName, PackItem* items, int count);
+	}
+}
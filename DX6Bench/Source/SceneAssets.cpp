@@ -0,0 +1,595 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "Bench.h"
+#include "SceneAssets.h"
+
+using namespace DXSharp::Rendering;
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		// Working directory is data's parent when run like the game, DX6Bench/ when run from the Makefile
+		static const char* const DataDirectories[] = { "data/", "../Planes3D/data/" };
+		const int DataDirectoryCount = sizeof(DataDirectories) / sizeof(DataDirectories[0]);
+
+		static unsigned char* ReadDataFile(const char* fileName, int* length)
+		{
+			for (int i = 0; i < DataDirectoryCount; i++)
+			{
+				char path[256];
+				sprintf(path, "%s%s", DataDirectories[i], fileName);
+
+				FILE* file = fopen(path, "rb");
+
+				if (!file)
+					continue;
+
+				fseek(file, 0, SEEK_END);
+				long size = ftell(file);
+				fseek(file, 0, SEEK_SET);
+
+				// Terminated, so text can be handed to the parsers as is
+				unsigned char* ret = size >= 0 ? (unsigned char*)malloc(size + 1) : 0;
+
+				if (ret && fread(ret, 1, size, file) != (size_t)size)
+				{
+					free(ret);
+					ret = 0;
+				}
+
+				fclose(file);
+
+				if (!ret)
+					return 0;
+
+				ret[size] = 0;
+				*length = (int)size;
+
+				return ret;
+			}
+
+			return 0;
+		}
+
+		/* Meshes */
+
+		enum SmdSection
+		{
+			SmdHeader,
+			SmdNodes,
+			SmdSkeleton,
+			SmdTriangles
+		};
+
+		const int MaxSmdTokens = 9;
+		const int MaxTokenLength = 32;
+
+		static bool IsBlank(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		}
+
+		static bool LineIs(const char* line, int length, const char* keyword)
+		{
+			return (int)strlen(keyword) == length && memcmp(line, keyword, length) == 0;
+		}
+
+		// Splits on blanks like String.Split with RemoveEmptyEntries, copying each token out so it can be parsed alone
+		static int SplitLine(const char* line, const char* end, char tokens[MaxSmdTokens][MaxTokenLength])
+		{
+			int count = 0;
+
+			while (line < end)
+			{
+				while (line < end && IsBlank(*line))
+					line++;
+
+				if (line == end)
+					break;
+
+				const char* start = line;
+
+				while (line < end && !IsBlank(*line))
+					line++;
+
+				if (count < MaxSmdTokens)
+				{
+					int length = (int)(line - start) < MaxTokenLength - 1 ? (int)(line - start) : MaxTokenLength - 1;
+
+					memcpy(tokens[count], start, length);
+					tokens[count][length] = 0;
+				}
+
+				count++;
+			}
+
+			return count;
+		}
+
+		static float ParseFloat(const char* token)
+		{
+			return (float)strtod(token, 0);
+		}
+
+		bool ParseSmd(const char* text, int length, SmdMesh* mesh)
+		{
+			const char* end = text + length;
+			SmdSection section = SmdHeader;
+			char tokens[MaxSmdTokens][MaxTokenLength];
+			int capacity = 0;
+			int corner = 0;
+			int time = 0;
+			bool isMalformed = false;
+
+			memset(mesh, 0, sizeof(*mesh));
+
+			while (text < end)
+			{
+				const char* lineEnd = (const char*)memchr(text, '\n', end - text);
+				const char* next = lineEnd ? lineEnd + 1 : end;
+
+				if (!lineEnd)
+					lineEnd = end;
+
+				while (text < lineEnd && IsBlank(*text))
+					text++;
+
+				while (lineEnd > text && IsBlank(lineEnd[-1]))
+					lineEnd--;
+
+				int lineLength = (int)(lineEnd - text);
+				const char* line = text;
+				text = next;
+
+				if (LineIs(line, lineLength, "nodes"))
+				{
+					section = SmdNodes;
+					continue;
+				}
+
+				if (LineIs(line, lineLength, "skeleton"))
+				{
+					section = SmdSkeleton;
+					continue;
+				}
+
+				if (LineIs(line, lineLength, "triangles"))
+				{
+					section = SmdTriangles;
+					continue;
+				}
+
+				if (LineIs(line, lineLength, "end") || lineLength == 0)
+					continue;
+
+				int count = SplitLine(line, lineEnd, tokens);
+
+				if (section == SmdNodes)
+				{
+					// id "name" parent, only the count matters to the mesh
+					if (count < 3)
+					{
+						isMalformed = true;
+						break;
+					}
+
+					mesh->BoneCount++;
+				}
+				else if (section == SmdSkeleton)
+				{
+					if (strcmp(tokens[0], "time") == 0)
+					{
+						time = count > 1 ? atoi(tokens[1]) : 0;
+						continue;
+					}
+
+					// Bind pose is read from frame 1 like SmdMesh does, and dropped since nothing is skinned
+					if (time == 1)
+					{
+						int id = atoi(tokens[0]);
+
+						if (count < 7 || id < 0 || id >= mesh->BoneCount)
+						{
+							isMalformed = true;
+							break;
+						}
+
+						float pose = 0;
+
+						for (int i = 1; i < 7; i++)
+							pose += ParseFloat(tokens[i]);
+
+						Consume((unsigned int)pose);
+					}
+				}
+				else if (section == SmdTriangles)
+				{
+					// Material name starts every triangle
+					if (count == 1)
+						continue;
+
+					if (count < 9)
+					{
+						isMalformed = true;
+						break;
+					}
+
+					if (mesh->VertexCount + corner >= capacity)
+					{
+						capacity = capacity ? capacity * 2 : 96;
+						mesh->Vertices = (VertexPNCT*)realloc(mesh->Vertices, sizeof(VertexPNCT) * capacity);
+					}
+
+					VertexPNCT& v = mesh->Vertices[mesh->VertexCount + corner];
+
+					// SMD is Z up
+					v.X = ParseFloat(tokens[1]);
+					v.Z = ParseFloat(tokens[2]);
+					v.Y = ParseFloat(tokens[3]);
+					v.NX = ParseFloat(tokens[4]);
+					v.NZ = ParseFloat(tokens[5]);
+					v.NY = ParseFloat(tokens[6]);
+					v.Diffuse = 0xFFFFFFFF;
+					v.U = ParseFloat(tokens[7]);
+					v.V = 1 - ParseFloat(tokens[8]);
+
+					if (++corner == 3)
+					{
+						mesh->VertexCount += 3;
+						corner = 0;
+					}
+				}
+			}
+
+			if (isMalformed || mesh->VertexCount == 0)
+			{
+				FreeSmd(mesh);
+				return false;
+			}
+
+			float max = -FLT_MAX;
+
+			for (int i = 0; i < mesh->VertexCount; i++)
+			{
+				const VertexPNCT& v = mesh->Vertices[i];
+				max = v.X > max ? v.X : max;
+				max = v.Y > max ? v.Y : max;
+				max = v.Z > max ? v.Z : max;
+			}
+
+			mesh->Radius = fabsf(max);
+
+			return true;
+		}
+
+		void FreeSmd(SmdMesh* mesh)
+		{
+			free(mesh->Vertices);
+			memset(mesh, 0, sizeof(*mesh));
+		}
+
+		char* MakeSmdText(int triangleCount, float width, float height, unsigned int seed, int* length)
+		{
+			const int MaxHeaderLength = 256;
+			const int MaxTriangleLength = 16 + 3 * 128;
+
+			char* ret = (char*)malloc(MaxHeaderLength + triangleCount * MaxTriangleLength);
+			char* p = ret;
+			Random random(seed);
+
+			p += sprintf(p, "version 1\nnodes\n  0 \"joint1\" -1\nend\nskeleton\ntime 0\n  0 0.000000 0.000000 0.000000 0.000000 0.000000 0.000000\nend\ntriangles\n");
+
+			for (int i = 0; i < triangleCount; i++)
+			{
+				p += sprintf(p, "skin\n");
+
+				for (int k = 0; k < 3; k++)
+				{
+					float x = (random.NextFloat() - 0.5f) * width;
+					float y = (random.NextFloat() - 0.5f) * width;
+					float z = random.NextFloat() * height;
+					float nx = random.NextFloat() - 0.5f;
+					float ny = random.NextFloat() - 0.5f;
+					float nz = random.NextFloat() - 0.5f;
+					float scale = 1 / sqrtf(nx * nx + ny * ny + nz * nz + 1e-6f);
+
+					p += sprintf(p, "  0 %f %f %f %f %f %f %f %f\n", x, y, z, nx * scale, ny * scale, nz * scale, random.NextFloat(), random.NextFloat());
+				}
+			}
+
+			p += sprintf(p, "end\n");
+			*length = (int)(p - ret);
+
+			return ret;
+		}
+
+		char* LoadSmdText(const char* fileName, int triangleCount, float width, float height, unsigned int seed, int* length)
+		{
+			char path[128];
+			sprintf(path, "geometry/%s", fileName);
+
+			char* ret = (char*)ReadDataFile(path, length);
+
+			return ret ? ret : MakeSmdText(triangleCount, width, height, seed, length);
+		}
+
+		/* Terrain */
+
+		static unsigned int ReadU32(const unsigned char* p)
+		{
+			return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+		}
+
+		bool LoadHeightmap(const char* fileName, Heightmap* map)
+		{
+			int length;
+			unsigned char* file = ReadDataFile(fileName, &length);
+
+			memset(map, 0, sizeof(*map));
+
+			if (!file)
+				return false;
+
+			bool ok = false;
+
+			if (length >= 54 && file[0] == 'B' && file[1] == 'M')
+			{
+				unsigned int dataOffset = ReadU32(file + 10);
+				int width = (int)ReadU32(file + 18);
+				int height = (int)ReadU32(file + 22);
+				int bitsPerPixel = file[28] | (file[29] << 8);
+				bool isTopDown = height < 0;
+
+				height = isTopDown ? -height : height;
+
+				int pixelSize = bitsPerPixel / 8;
+				int stride = (width * pixelSize + 3) & ~3;
+
+				ok = ReadU32(file + 30) == 0 && (bitsPerPixel == 24 || bitsPerPixel == 32) && width > 0 && height > 0 &&
+					width <= 4096 && height <= 4096 && dataOffset <= (unsigned int)length &&
+					(unsigned int)length - dataOffset >= (unsigned int)(stride * height);
+
+				if (ok)
+				{
+					map->Width = width;
+					map->Height = height;
+					map->Heights = (unsigned char*)malloc(width * height);
+
+					for (int y = 0; y < height; y++)
+					{
+						const unsigned char* row = file + dataOffset + (isTopDown ? y : height - 1 - y) * stride;
+
+						for (int x = 0; x < width; x++)
+							map->Heights[y * width + x] = row[x * pixelSize + 2]; // BGR
+					}
+				}
+			}
+
+			free(file);
+
+			return ok;
+		}
+
+		void MakeHeightmap(int size, unsigned int seed, Heightmap* map)
+		{
+			Random random(seed);
+
+			map->Width = size;
+			map->Height = size;
+			map->Heights = (unsigned char*)malloc(size * size);
+
+			for (int y = 0; y < size; y++)
+			{
+				for (int x = 0; x < size; x++)
+				{
+					float height = 110 + 70 * sinf(x * 0.09f) * cosf(y * 0.07f) + 45 * sinf((x + y) * 0.031f) + random.Next(-6, 7);
+
+					map->Heights[y * size + x] = (unsigned char)(height < 0 ? 0 : height > 255 ? 255 : height);
+				}
+			}
+		}
+
+		void FreeHeightmap(Heightmap* map)
+		{
+			free(map->Heights);
+			memset(map, 0, sizeof(*map));
+		}
+
+		void BuildTerrain(const Heightmap& map, int foliageKinds, unsigned int seed, TerrainMesh* terrain)
+		{
+			const float XZScale = 8.0f;
+			const float YScale = 35.0f;
+			const float MinTextureThreshold = 0.4f;
+			const float TextureScale = 0.2f;
+
+			static const int cornerX[6] = { 0, 1, 0, 0, 1, 1 };
+			static const int cornerZ[6] = { 0, 1, 1, 0, 0, 1 };
+
+			int width = map.Width;
+
+			terrain->VertexCount = map.Width * map.Height * 6;
+			terrain->Vertices = (VertexPNCT*)calloc(terrain->VertexCount, sizeof(VertexPNCT));
+			terrain->Placements = (FoliagePlacement*)malloc(sizeof(FoliagePlacement) * map.Width * map.Height);
+			terrain->PlacementCount = 0;
+
+			VertexPNCT* v = terrain->Vertices;
+			unsigned int nextSeed = 0;
+
+			for (int i = 1; i < map.Width - 1; i++)
+			{
+				for (int j = 1; j < map.Height - 1; j++)
+				{
+					// Every cell draws from its own Random, each seeded from the last
+					Random random(nextSeed);
+
+					float baseX = i * XZScale;
+					float baseZ = j * XZScale;
+
+					if (random.Next(0, 32) % 8 == 0)
+					{
+						FoliagePlacement& p = terrain->Placements[terrain->PlacementCount++];
+						p.Kind = random.Next(0, foliageKinds);
+						p.X = baseX;
+						p.Y = map.Heights[j * width + i] / 255.0f * YScale;
+						p.Z = baseZ;
+					}
+
+					nextSeed = Random(nextSeed ? nextSeed : seed).Next();
+
+					for (int k = 0; k < 6; k++)
+					{
+						v[k].X = baseX + cornerX[k] * XZScale;
+						v[k].Y = map.Heights[(j + cornerZ[k]) * width + i + cornerX[k]] / 255.0f * YScale;
+						v[k].Z = baseZ + cornerZ[k] * XZScale;
+						v[k].NY = 1;
+						v[k].U = cornerX[k] * TextureScale;
+						v[k].V = (1 - cornerZ[k]) * TextureScale;
+					}
+
+					v += 6;
+				}
+			}
+
+			// Rock shows through on tall points, blend weight goes to every channel
+			float point = -FLT_MAX;
+
+			for (int i = 0; i < terrain->VertexCount; i++)
+				point = terrain->Vertices[i].Y > point ? terrain->Vertices[i].Y : point;
+
+			for (int i = 0; i < terrain->VertexCount; i++)
+			{
+				float ratio = point > 0 ? terrain->Vertices[i].Y / point : 0;
+				unsigned int value = ratio < MinTextureThreshold ? 0 : (unsigned char)(ratio * 255.0f);
+
+				terrain->Vertices[i].Diffuse = value * 0x01010101;
+			}
+		}
+
+		void FreeTerrain(TerrainMesh* terrain)
+		{
+			free(terrain->Placements);
+			free(terrain->Vertices);
+			memset(terrain, 0, sizeof(*terrain));
+		}
+
+		/* Culling */
+
+		// Matrix keeps Items[y * 4 + x] and multiplies as ret(j, i) = sum m1(j, k) * m2(k, i), see Math.cs
+		static void Identity(float* m)
+		{
+			memset(m, 0, sizeof(float) * 16);
+			m[0] = m[5] = m[10] = m[15] = 1;
+		}
+
+		static void Multiply(const float* m1, const float* m2, float* ret)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				for (int i = 0; i < 4; i++)
+					ret[i * 4 + j] = m1[j] * m2[i * 4] + m1[4 + j] * m2[i * 4 + 1] + m1[8 + j] * m2[i * 4 + 2] + m1[12 + j] * m2[i * 4 + 3];
+			}
+		}
+
+		static void MultiplyInto(float* m1, const float* m2)
+		{
+			float ret[16];
+
+			Multiply(m1, m2, ret);
+			memcpy(m1, ret, sizeof(ret));
+		}
+
+		void BuildViewProjection(const float* position, const float* rotation, float* viewProj)
+		{
+			const float DegToRad = 3.14159265f / 180;
+			const float FOV = 60;
+			const float Aspect = 4.0f / 3.0f;
+			const float Near = 0.1f;
+			const float Far = 300;
+
+			float view[16];
+			float m[16];
+			float s, c;
+
+			// RotationZ * RotationX * RotationY * Translation, all negated
+			s = sinf(-rotation[2] * DegToRad);
+			c = cosf(-rotation[2] * DegToRad);
+			Identity(view);
+			view[0] = c;
+			view[1] = s;
+			view[4] = -s;
+			view[5] = c;
+
+			s = sinf(-rotation[0] * DegToRad);
+			c = cosf(-rotation[0] * DegToRad);
+			Identity(m);
+			m[5] = c;
+			m[6] = s;
+			m[9] = -s;
+			m[10] = c;
+			MultiplyInto(view, m);
+
+			s = sinf(-rotation[1] * DegToRad);
+			c = cosf(-rotation[1] * DegToRad);
+			Identity(m);
+			m[0] = c;
+			m[2] = -s;
+			m[8] = s;
+			m[10] = c;
+			MultiplyInto(view, m);
+
+			Identity(m);
+			m[12] = -position[0];
+			m[13] = -position[1];
+			m[14] = -position[2];
+			MultiplyInto(view, m);
+
+			// Matrix.Perspective, left-handed
+			float yScale = 1.0f / tanf(FOV * DegToRad / 2);
+
+			Identity(m);
+			m[0] = yScale / Aspect;
+			m[5] = yScale;
+			m[10] = Far / (Far - Near);
+			m[14] = -Near * Far / (Far - Near);
+			m[15] = 0;
+			m[11] = 1;
+
+			Multiply(m, view, viewProj);
+		}
+
+		void Frustum::Calculate(const float* m)
+		{
+			// Left, right, bottom, top, near, far as rows 3 -/+ 0, 1 and 2 of viewProj
+			for (int p = 0; p < 6; p++)
+			{
+				int axis = p / 2;
+				float sign = p == 0 || p == 3 || p == 4 ? -1.0f : 1.0f;
+				float* plane = planes[p];
+
+				for (int k = 0; k < 4; k++)
+					plane[k] = m[k * 4 + 3] + sign * m[k * 4 + axis];
+
+				float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+				for (int k = 0; k < 4; k++)
+					plane[k] /= length;
+			}
+		}
+
+		bool Frustum::IsSphereInFrustum(float x, float y, float z, float radius) const
+		{
+			for (int p = 0; p < 6; p++)
+			{
+				if (planes[p][0] * x + planes[p][1] * y + planes[p][2] * z + planes[p][3] <= -radius)
+					return false;
+			}
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "VertexFormats.h"
+
+namespace DXSharp
+{
+	namespace Bench
+	{
+		// Native ports of what Planes3D builds its scene with, so the render benchmarks submit and cull the game's own
+		// geometry. Assets are read from data/ or ../Planes3D/data/ when they're there, otherwise generated in the same
+		// format and at the same size.
+
+		/* Meshes */
+
+		struct SmdMesh
+		{
+			Rendering::VertexPNCT* Vertices; // Three per triangle, as Mesh.FromStream lays them out
+			int VertexCount;
+			int BoneCount;
+			float Radius; // Mesh.CalculateRadius, largest coordinate on any axis
+		};
+
+		// SmdMesh and Mesh.FromStream: Y and Z swapped, V flipped, white diffuse. False on a malformed line or no triangles.
+		bool ParseSmd(const char* text, int length, SmdMesh* mesh);
+		void FreeSmd(SmdMesh* mesh);
+
+		// .smd text with one bone and triangleCount triangles inside width x width x height, written like Milkshape does
+		char* MakeSmdText(int triangleCount, float width, float height, unsigned int seed, int* length);
+
+		// data/geometry/<fileName> as text if it exists, otherwise MakeSmdText with the rest. Free with free().
+		char* LoadSmdText(const char* fileName, int triangleCount, float width, float height, unsigned int seed, int* length);
+
+		/* Terrain */
+
+		struct Heightmap
+		{
+			unsigned char* Heights; // Red channel, top row first like Bitmap.GetPixel
+			int Width;
+			int Height;
+		};
+
+		// Uncompressed 24 or 32 bit .bmp from the data directories
+		bool LoadHeightmap(const char* fileName, Heightmap* map);
+
+		// Rolling hills with a little noise, roughly what the game's heightmap looks like
+		void MakeHeightmap(int size, unsigned int seed, Heightmap* map);
+		void FreeHeightmap(Heightmap* map);
+
+		struct FoliagePlacement
+		{
+			int Kind;
+			float X, Y, Z;
+		};
+
+		struct TerrainMesh
+		{
+			Rendering::VertexPNCT* Vertices; // Width * Height * 6, the border cells stay zero like in the game
+			int VertexCount;
+			FoliagePlacement* Placements;
+			int PlacementCount;
+		};
+
+		// Terrain.Build: two triangles per inner pixel, diffuse blend weight from the tallest point and foliage on
+		// about every 8th pixel. seed stands in for the time seeded Random the game starts the chain with.
+		void BuildTerrain(const Heightmap& map, int foliageKinds, unsigned int seed, TerrainMesh* terrain);
+		void FreeTerrain(TerrainMesh* terrain);
+
+		/* Culling */
+
+		// Camera.BuildMatrices, Projection * View with the game's field of view and clip planes. Rotation in degrees.
+		void BuildViewProjection(const float* position, const float* rotation, float* viewProj);
+
+		class Frustum
+		{
+		private:
+			float planes[6][4];
+		public:
+			void Calculate(const float* viewProj);
+			bool IsSphereInFrustum(float x, float y, float z, float radius) const;
+		};
+	}
+}
@@ -0,0 +1,382 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Test.h"
+#include "AudioMixer.h"
+#include "AudioSink.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Audio;
+
+// Voice pool bookkeeping of the mixer, and the SIMD kernels against the scalar reference
+
+/* Helpers */
+
+static const int OutputRate = 44100;
+
+static unsigned int NextRandom(unsigned int* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+
+	return *seed >> 8;
+}
+
+static float RandomFloat(unsigned int* seed, float range)
+{
+	return ((NextRandom(seed) & 0xFFFF) / 32768.0f - 1.0f) * range;
+}
+
+static SoundClip* MakeClip(int channels, int sampleRate, int frames)
+{
+	short* pcm = (short*)malloc(sizeof(short) * frames * channels);
+
+	for (int i = 0; i < frames; i++)
+	{
+		for (int c = 0; c < channels; c++)
+			pcm[i * channels + c] = (short)(8000 * sin(i * (0.05 + c * 0.01)));
+	}
+
+	SoundClip* clip = SoundClip::Create(pcm, sizeof(short) * frames * channels, channels, sampleRate, 16, false);
+	free(pcm);
+
+	return clip;
+}
+
+static VoiceParams MakeParams(int priority, float gain)
+{
+	VoiceParams params;
+	params.Priority = priority;
+	params.Gain = gain;
+	params.Loop = true;
+
+	return params;
+}
+
+/* Voice pool */
+
+TEST(AudioMixer, StealsLowestPriorityThenQuietestThenOldest)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 4, false);
+	SoundClip* clip = MakeClip(1, OutputRate, 1000);
+	VoiceHandle handles[4];
+
+	handles[0] = mixer.Play(clip, MakeParams(1, 1.0f));
+	handles[1] = mixer.Play(clip, MakeParams(0, 1.0f)); // Lowest priority
+	handles[2] = mixer.Play(clip, MakeParams(1, 0.2f));
+	handles[3] = mixer.Play(clip, MakeParams(2, 1.0f));
+
+	CHECK(mixer.GetActiveVoiceCount() == 4);
+	CHECK(mixer.GetStolenVoiceCount() == 0);
+
+	VoiceHandle first = mixer.Play(clip, MakeParams(1, 1.0f));
+
+	CHECK(first != 0);
+	CHECK(!mixer.IsPlaying(handles[1]));
+	CHECK(mixer.GetStolenVoiceCount() == 1);
+
+	// Priority 0 is gone, the quiet one of priority 1 goes next
+	VoiceHandle second = mixer.Play(clip, MakeParams(1, 1.0f));
+
+	CHECK(second != 0);
+	CHECK(!mixer.IsPlaying(handles[2]));
+	CHECK(mixer.IsPlaying(handles[0]));
+
+	// Same priority and gain, the oldest one
+	VoiceHandle third = mixer.Play(clip, MakeParams(1, 1.0f));
+
+	CHECK(third != 0);
+	CHECK(!mixer.IsPlaying(handles[0]));
+	CHECK(mixer.IsPlaying(first));
+	CHECK(mixer.IsPlaying(second));
+	CHECK(mixer.IsPlaying(handles[3]));
+	CHECK(mixer.GetActiveVoiceCount() == 4);
+	CHECK(mixer.GetStolenVoiceCount() == 3);
+
+	clip->Release();
+}
+
+TEST(AudioMixer, LowerPriorityCantStealHigher)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 2, false);
+	SoundClip* clip = MakeClip(1, OutputRate, 1000);
+
+	VoiceHandle a = mixer.Play(clip, MakeParams(5, 0.1f));
+	VoiceHandle b = mixer.Play(clip, MakeParams(5, 0.1f));
+
+	CHECK(mixer.Play(clip, MakeParams(4, 1.0f)) == 0);
+	CHECK(mixer.IsPlaying(a));
+	CHECK(mixer.IsPlaying(b));
+	CHECK(mixer.GetStolenVoiceCount() == 0);
+
+	// Equal priority may steal
+	CHECK(mixer.Play(clip, MakeParams(5, 1.0f)) != 0);
+	CHECK(mixer.GetStolenVoiceCount() == 1);
+
+	clip->Release();
+}
+
+TEST(AudioMixer, StaleHandleDoesNotReachNewVoice)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 1, false);
+	SoundClip* clip = MakeClip(1, OutputRate, 1000);
+
+	VoiceHandle old = mixer.Play(clip, MakeParams(0, 1.0f));
+	mixer.Stop(old);
+
+	CHECK(!mixer.IsPlaying(old));
+	CHECK(mixer.GetActiveVoiceCount() == 0);
+
+	VoiceHandle current = mixer.Play(clip, MakeParams(0, 1.0f));
+
+	CHECK(current != old);
+	CHECK(!mixer.IsPlaying(old));
+
+	// Everything through the old handle is ignored
+	mixer.SetGain(old, 0);
+	mixer.Stop(old);
+	CHECK(!mixer.SetParams(old, 0, 0, 1, 0));
+	CHECK(mixer.IsPlaying(current));
+
+	int frame = -1;
+	CHECK(mixer.SetParams(current, 1, 0, 1, &frame));
+	CHECK(frame == 0);
+
+	// Handles out of the pool's range
+	CHECK(!mixer.IsPlaying(0));
+	CHECK(!mixer.IsPlaying(current + 1));
+
+	clip->Release();
+}
+
+TEST(AudioMixer, GenerationWrapSkipsZeroHandle)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 1, false);
+	SoundClip* clip = MakeClip(1, OutputRate, 100);
+	VoiceHandle previous = 0;
+	int zeroHandles = 0;
+	int repeats = 0;
+
+	// 22 bits of generation, so this goes around once
+	for (int i = 0; i < (1 << 22) + 16; i++)
+	{
+		VoiceHandle handle = mixer.Play(clip, MakeParams(0, 1.0f));
+
+		if (handle == 0)
+			zeroHandles++;
+
+		if (handle == previous)
+			repeats++;
+
+		mixer.Stop(handle);
+		previous = handle;
+	}
+
+	CHECK(zeroHandles == 0);
+	CHECK(repeats == 0);
+	CHECK(mixer.GetActiveVoiceCount() == 0);
+
+	clip->Release();
+}
+
+TEST(AudioMixer, FinishedVoiceFreesItsSlot)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 4, false);
+	SoundClip* clip = MakeClip(2, OutputRate, 300);
+	short* out = (short*)malloc(sizeof(short) * 2 * 1024);
+	VoiceParams params = MakeParams(0, 1.0f);
+
+	params.Loop = false;
+	VoiceHandle handle = mixer.Play(clip, params);
+
+	mixer.Render(out, 256);
+	CHECK(mixer.IsPlaying(handle));
+
+	mixer.Render(out, 256);
+	CHECK(!mixer.IsPlaying(handle));
+	CHECK(mixer.GetActiveVoiceCount() == 0);
+	CHECK(mixer.GetStolenVoiceCount() == 0);
+
+	// Tail after the clip ended is silence
+	for (int i = 44 * 2; i < 256 * 2; i++)
+		CHECK(out[i] == 0);
+
+	free(out);
+	clip->Release();
+}
+
+TEST(AudioMixer, UpdateWritesWhatSinkAccepts)
+{
+	NullAudioSink sink(OutputRate, 700);
+	AudioMixer mixer(&sink, 4, true);
+	SoundClip* clip = MakeClip(1, 22050, 500);
+
+	mixer.Play(clip, MakeParams(0, 1.0f));
+
+	CHECK(mixer.Update() == 700);
+	CHECK(mixer.Update() == 700);
+	CHECK(sink.GetFramesWritten() == 1400);
+	CHECK(mixer.GetFramesMixed() == 1400);
+
+	clip->Release();
+}
+
+/* Kernels */
+
+TEST(MixKernels, ConversionsMatchScalar)
+{
+	MixKernels scalar = MixKernels::GetScalar();
+	MixKernels best = MixKernels::GetBest();
+	unsigned int seed = 1;
+	short shorts[67];
+	short expectedShorts[67];
+	float floats[67];
+	float expectedFloats[67];
+
+	// Every remainder of the 8-wide loops
+	for (int count = 0; count <= 67; count++)
+	{
+		for (int i = 0; i < count; i++)
+			shorts[i] = (short)NextRandom(&seed);
+
+		shorts[0] = -32768;
+
+		scalar.Int16ToFloat(expectedFloats, shorts, count);
+		best.Int16ToFloat(floats, shorts, count);
+
+		for (int i = 0; i < count; i++)
+			CHECK(floats[i] == expectedFloats[i]);
+
+		// Out of range on purpose, clamping has to agree too
+		for (int i = 0; i < count; i++)
+			floats[i] = RandomFloat(&seed, 1.5f);
+
+		scalar.FloatToInt16(expectedShorts, floats, count);
+		best.FloatToInt16(shorts, floats, count);
+
+		// SSE2 rounds halves to even, scalar away from zero
+		for (int i = 0; i < count; i++)
+			CHECK(abs(shorts[i] - expectedShorts[i]) <= 1);
+	}
+
+	float limits[8] = { 2.0f, -2.0f, 1.0f, -1.0f, 0.0f, 1e9f, -1e9f, 0.5f };
+
+	best.FloatToInt16(shorts, limits, 8);
+
+	CHECK(shorts[0] == 32767);
+	CHECK(shorts[1] == -32767);
+	CHECK(shorts[2] == 32767);
+	CHECK(shorts[3] == -32767);
+	CHECK(shorts[4] == 0);
+	CHECK(shorts[5] == 32767);
+	CHECK(shorts[6] == -32767);
+	CHECK(abs(shorts[7] - 16384) <= 1);
+}
+
+TEST(MixKernels, MixingMatchesScalar)
+{
+	MixKernels scalar = MixKernels::GetScalar();
+	MixKernels best = MixKernels::GetBest();
+	unsigned int seed = 7;
+	float src[256 * 2];
+	float bus[256 * 2];
+	float expected[256 * 2];
+	float worst = 0;
+
+	for (int frames = 1; frames <= 256; frames += frames < 16 ? 1 : 37)
+	{
+		for (int stereo = 0; stereo < 2; stereo++)
+		{
+			for (int i = 0; i < frames * 2; i++)
+			{
+				src[i] = RandomFloat(&seed, 1.0f);
+				bus[i] = expected[i] = RandomFloat(&seed, 0.5f);
+			}
+
+			// Ramps in both directions, like a voice fading in on one side and out on the other
+			float l0 = RandomFloat(&seed, 1.0f);
+			float r0 = RandomFloat(&seed, 1.0f);
+			float l1 = RandomFloat(&seed, 1.0f);
+			float r1 = RandomFloat(&seed, 1.0f);
+
+			if (stereo)
+			{
+				scalar.MixStereo(expected, src, frames, l0, r0, l1, r1);
+				best.MixStereo(bus, src, frames, l0, r0, l1, r1);
+			}
+			else
+			{
+				scalar.MixMono(expected, src, frames, l0, r0, l1, r1);
+				best.MixMono(bus, src, frames, l0, r0, l1, r1);
+			}
+
+			// SIMD steps the gain by adding, scalar multiplies, so allow rounding that adds up over a block
+			for (int i = 0; i < frames * 2; i++)
+			{
+				float diff = (float)fabs(bus[i] - expected[i]);
+
+				if (diff > worst)
+					worst = diff;
+			}
+		}
+	}
+
+	CHECK(worst < 1e-5f);
+}
+
+TEST(MixKernels, MixerOutputMatchesScalar)
+{
+	const int Frames = 8192;
+
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer simd(&sink, 16, true);
+	AudioMixer reference(&sink, 16, false);
+	SoundClip* mono = MakeClip(1, 22050, 5000);
+	SoundClip* stereo = MakeClip(2, OutputRate, 3000);
+	short* a = (short*)malloc(sizeof(short) * 2 * Frames);
+	short* b = (short*)malloc(sizeof(short) * 2 * Frames);
+
+	CHECK(!reference.IsSimdEnabled());
+
+	for (int i = 0; i < 16; i++)
+	{
+		VoiceParams params = MakeParams(0, 0.1f + i * 0.03f);
+		params.Pan = (i % 5) * 0.4f - 0.8f;
+		params.Pitch = i % 3 ? 1.0f : 0.75f + i * 0.05f; // Unity pitch takes the plain conversion path
+
+		simd.Play(i % 2 ? mono : stereo, params);
+		reference.Play(i % 2 ? mono : stereo, params);
+	}
+
+	simd.Render(a, Frames / 2);
+	reference.Render(b, Frames / 2);
+
+	// Parameter changes mid-stream, so gain ramps are compared as well
+	simd.SetMasterGain(0.6f);
+	reference.SetMasterGain(0.6f);
+
+	simd.Render(a + Frames, Frames / 2);
+	reference.Render(b + Frames, Frames / 2);
+
+	int worst = 0;
+
+	for (int i = 0; i < Frames * 2; i++)
+	{
+		int diff = abs(a[i] - b[i]);
+
+		if (diff > worst)
+			worst = diff;
+	}
+
+	CHECK(worst <= 1);
+
+	free(a);
+	free(b);
+	mono->Release();
+	stereo->Release();
+}
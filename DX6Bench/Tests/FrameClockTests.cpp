@@ -0,0 +1,305 @@
+#include <math.h>
+
+#include "Test.h"
+#include "FrameClock.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Timing;
+
+// Fixed steps, hitch handling, interpolation, the frame rate limiter and frame time statistics, all on a manual clock
+
+/* Helpers */
+
+const Platform::UInt64 Frequency = 1000000; // Microsecond ticks
+
+// Manual clock that remembers which phase of the limiter asked for time
+class RecordingClock : public ManualClockSource
+{
+public:
+	int Sleeps;
+	int Yields;
+	int Spins;
+
+	RecordingClock()
+		: ManualClockSource(Frequency)
+	{
+		Sleeps = 0;
+		Yields = 0;
+		Spins = 0;
+	}
+
+	virtual void Sleep(int ms)
+	{
+		if (ms > 0)
+			Sleeps++;
+		else
+			Yields++;
+
+		ManualClockSource::Sleep(ms);
+	}
+
+	virtual void Spin()
+	{
+		Spins++;
+		ManualClockSource::Spin();
+	}
+};
+
+static bool Near(double value, double expected, double tolerance)
+{
+	return fabs(value - expected) <= tolerance;
+}
+
+static int RunSteps(FrameClock& clock)
+{
+	int steps = 0;
+
+	while (clock.Step())
+		steps++;
+
+	return steps;
+}
+
+static double SecondsSince(ManualClockSource& source, Platform::UInt64 ticks)
+{
+	return (double)(Platform::Int64)(source.GetTicks() - ticks) / (double)(Platform::Int64)Frequency;
+}
+
+/* Stepping */
+
+TEST(FrameClock, FirstFrameRunsOneStep)
+{
+	ManualClockSource source(Frequency);
+	FrameClock clock(&source, false, 0.01);
+
+	clock.BeginFrame();
+	CHECK(RunSteps(clock) == 1);
+	CHECK(clock.GetFrameIndex() == 1);
+	CHECK(clock.GetHistogram().GetCount() == 0); // Nothing measured yet
+}
+
+TEST(FrameClock, AccumulatesFixedSteps)
+{
+	ManualClockSource source(Frequency);
+	FrameClock clock(&source, false, 0.01);
+
+	clock.BeginFrame();
+	RunSteps(clock);
+
+	source.Advance(0.035);
+	clock.BeginFrame();
+	CHECK(Near(clock.GetFrameTime(), 0.035, 1e-9));
+	CHECK(RunSteps(clock) == 3);
+	CHECK(clock.GetStepsThisFrame() == 3);
+	CHECK(Near(clock.GetAlpha(), 0.5, 1e-6));
+
+	// Leftover carries into the next frame
+	source.Advance(0.006);
+	clock.BeginFrame();
+	CHECK(RunSteps(clock) == 1);
+	CHECK(Near(clock.GetAlpha(), 0.1, 1e-6));
+
+	// Too short for a step, only the interpolation moves
+	source.Advance(0.004);
+	clock.BeginFrame();
+	CHECK(RunSteps(clock) == 0);
+	CHECK(Near(clock.GetAlpha(), 0.5, 1e-6));
+
+	CHECK(Near(clock.GetSimulationTime(), 0.05, 1e-9));
+	CHECK(Near(clock.GetRealTime(), 0.01 + 0.035 + 0.006 + 0.004, 1e-9));
+}
+
+TEST(FrameClock, AlphaStaysWithinAStep)
+{
+	ManualClockSource source(Frequency);
+	FrameClock clock(&source, false, 1.0 / 60);
+	unsigned int seed = 7;
+	bool inRange = true;
+
+	clock.BeginFrame();
+	RunSteps(clock);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		source.Advance(0.001 + (seed >> 8) % 40000 / 1000000.0); // 1 to 41ms
+
+		clock.BeginFrame();
+		RunSteps(clock);
+
+		inRange = inRange && clock.GetAlpha() >= 0 && clock.GetAlpha() < 1;
+	}
+
+	CHECK(inRange);
+
+	// Simulation never runs ahead of real time, and trails it by less than a step
+	double lag = clock.GetRealTime() - clock.GetSimulationTime();
+	CHECK(lag >= -1e-9 && lag < clock.GetFixedStep());
+}
+
+TEST(FrameClock, DropsStepsBeyondMaxStepsPerFrame)
+{
+	ManualClockSource source(Frequency);
+	FrameClock clock(&source, false, 0.01);
+
+	clock.SetMaxStepsPerFrame(4);
+	clock.BeginFrame();
+	RunSteps(clock);
+
+	source.Advance(0.105);
+	clock.BeginFrame();
+	CHECK(RunSteps(clock) == 4);
+	CHECK(clock.GetAlpha() >= 0 && clock.GetAlpha() < 1); // The other six steps are gone, not queued
+	CHECK(Near(clock.GetSimulationTime(), 0.05, 1e-9));
+
+	source.Advance(0.01);
+	clock.BeginFrame();
+	CHECK(RunSteps(clock) == 1);
+}
+
+TEST(FrameClock, ClampsLongFramesAtMaxFrameTime)
+{
+	ManualClockSource source(Frequency);
+	FrameClock clock(&source, false, 0.01);
+
+	clock.SetMaxStepsPerFrame(1000);
+	clock.SetMaxFrameTime(0.055);
+	clock.BeginFrame();
+	RunSteps(clock);
+
+	// A one second hitch only simulates up to the clamp, but still counts as real time
+	source.Advance(1.0);
+	clock.BeginFrame();
+	CHECK(Near(clock.GetFrameTime(), 1.0, 1e-9));
+	CHECK(RunSteps(clock) == 5);
+	CHECK(Near(clock.GetAlpha(), 0.5, 1e-6));
+	CHECK(Near(clock.GetRealTime(), 1.01, 1e-9));
+	CHECK(Near(clock.GetSimulationTime(), 0.06, 1e-9));
+}
+
+/* Frame rate limit */
+
+TEST(FrameClock, EndFrameHoldsTheCapThroughSleepAndSpin)
+{
+	RecordingClock source;
+	FrameClock clock(&source, false, 0.01);
+
+	clock.SetFrameRateLimit(100);
+	CHECK(Near(clock.GetFrameRateLimit(), 100, 1e-9));
+
+	clock.BeginFrame();
+	RunSteps(clock);
+
+	for (int i = 0; i < 10; i++)
+	{
+		Platform::UInt64 start = source.GetTicks();
+
+		source.Advance(0.001 + i * 0.0005); // Work, always shorter than the 10ms cap
+		clock.EndFrame();
+
+		// Ends no earlier than the cap and at most one spin after it
+		double length = SecondsSince(source, start);
+		CHECK(length >= 0.01 - 1e-9);
+		CHECK(length <= 0.01 + 0.000001 + 1e-9);
+
+		clock.BeginFrame();
+		RunSteps(clock);
+	}
+
+	// Every frame went through all three phases
+	CHECK(source.Sleeps >= 10);
+	CHECK(source.Yields >= 10);
+	CHECK(source.Spins >= 10);
+
+	// What's busy-waited is only the tail
+	CHECK(source.Spins <= 10 * (int)(FrameClock::SpinTime * 1000000) + 10);
+
+	CHECK(Near(clock.GetHistogram().GetMin(), 0.01, 0.000002));
+	CHECK(Near(clock.GetHistogram().GetMax(), 0.01, 0.000002));
+}
+
+TEST(FrameClock, EndFrameDoesNothingWhenLateOrUnlimited)
+{
+	RecordingClock source;
+	FrameClock clock(&source, false, 0.01);
+
+	clock.BeginFrame();
+	source.Advance(0.002);
+	clock.EndFrame(); // No limit set
+
+	clock.SetFrameRateLimit(100);
+	clock.BeginFrame();
+	source.Advance(0.02); // Slower than the cap already
+	clock.EndFrame();
+
+	CHECK(source.Sleeps == 0 && source.Yields == 0 && source.Spins == 0);
+
+	clock.SetFrameRateLimit(0);
+	CHECK(clock.GetFrameRateLimit() == 0);
+}
+
+/* Statistics */
+
+TEST(FrameClock, HistogramPercentilesAreBucketBounds)
+{
+	FrameHistogram histogram;
+
+	// Middle of 0.25ms buckets, so rounding can't move them
+	for (int i = 0; i < 90; i++)
+		histogram.Add(0.0011);
+
+	for (int i = 0; i < 9; i++)
+		histogram.Add(0.0051);
+
+	histogram.Add(0.0301);
+
+	CHECK(histogram.GetCount() == 100);
+	CHECK(Near(histogram.GetMin(), 0.0011, 1e-12));
+	CHECK(Near(histogram.GetMax(), 0.0301, 1e-12));
+	CHECK(Near(histogram.GetAverage(), (90 * 0.0011 + 9 * 0.0051 + 0.0301) / 100, 1e-12));
+
+	CHECK(Near(histogram.GetPercentile(50), 0.00125, 1e-12));
+	CHECK(Near(histogram.GetPercentile(90), 0.00125, 1e-12));
+	CHECK(Near(histogram.GetPercentile(99), 0.00525, 1e-12));
+	CHECK(Near(histogram.GetPercentile(100), 0.0301, 1e-12)); // Bound past the slowest frame is capped to it
+
+	histogram.Reset();
+	CHECK(histogram.GetCount() == 0);
+	CHECK(histogram.GetPercentile(99) == 0);
+}
+
+TEST(FrameClock, HistogramKeepsFramesPastTheLastBucket)
+{
+	FrameHistogram histogram;
+
+	for (int i = 0; i < 98; i++)
+		histogram.Add(0.0161);
+
+	histogram.Add(0.2);
+	histogram.Add(0.5);
+
+	// 64ms and up share the last bucket, which reports the real maximum
+	CHECK(Near(histogram.GetPercentile(50), 0.01625, 1e-12));
+	CHECK(Near(histogram.GetPercentile(99), 0.5, 1e-12));
+	CHECK(Near(histogram.GetMax(), 0.5, 1e-12));
+}
+
+TEST(FrameClock, RecordsEveryMeasuredFrame)
+{
+	ManualClockSource source(Frequency);
+	FrameClock clock(&source, false, 0.01);
+
+	clock.BeginFrame();
+
+	for (int i = 0; i < 20; i++)
+	{
+		source.Advance(i == 19 ? 0.040 : 0.016);
+		clock.BeginFrame();
+	}
+
+	FrameHistogram& histogram = clock.GetHistogram();
+	CHECK(histogram.GetCount() == 20);
+	CHECK(Near(histogram.GetPercentile(50), 0.01625, 1e-9));
+	CHECK(Near(histogram.GetMax(), 0.040, 1e-9));
+	CHECK(Near(histogram.GetPercentile(100), 0.040, 1e-9));
+}
@@ -0,0 +1,291 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "HResultCheck.h"
+#include "Logger.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Checks;
+
+// Error classification and the check site registry, driven by stub calls instead of a DirectX device
+
+/* Helpers */
+
+// Error codes as ddraw.h, d3d.h and dsound.h define them
+static const HRESULT SurfaceLost = (HRESULT)0x887601C2;
+static const HRESULT OutOfVideoMemory = (HRESULT)0x8876017C;
+static const HRESULT WasStillDrawing = (HRESULT)0x8876021C;
+static const HRESULT SceneInScene = (HRESULT)0x88760302;
+static const HRESULT BufferLost = (HRESULT)0x88780096;
+static const HRESULT BadFormat = (HRESULT)0x88780064;
+static const HRESULT OutOfMemory = (HRESULT)0x8007000E;
+static const HRESULT InvalidArg = (HRESULT)0x80070057;
+static const HRESULT NotImplemented = (HRESULT)0x80004001;
+static const HRESULT UnknownGraphics = (HRESULT)0x8876ABCD;
+static const HRESULT NoVirtualization = (HRESULT)0x0878000A; // DS_NO_VIRTUALIZATION, a success code
+
+// Plays back a script of results, like a surface whose Blt starts failing after a mode switch
+class StubSurface
+{
+private:
+	const HRESULT* results;
+	int count;
+	int next;
+public:
+	StubSurface(const HRESULT* results, int count)
+	{
+		this->results = results;
+		this->count = count;
+		next = 0;
+	}
+
+	HRESULT Blt()
+	{
+		return next < count ? results[next++] : S_OK;
+	}
+};
+
+// One site per call, the way D3D.cpp wraps device calls
+static bool BltChecked(StubSurface& surface)
+{
+	CHECK_SITE(bltSite, "surface->Blt()");
+
+	return !Checks::Check(bltSite, surface.Blt());
+}
+
+static bool LockChecked(StubSurface& surface)
+{
+	CHECK_SITE(lockSite, "surface->Lock()");
+
+	return !Checks::Check(lockSite, surface.Blt());
+}
+
+static CheckSite* FindSite(const char* expression)
+{
+	for (CheckSite* site = GetFirstSite(); site; site = site->Next)
+	{
+		if (strcmp(site->Expression, expression) == 0)
+			return site;
+	}
+
+	return 0;
+}
+
+class LineOutput : public Logging::LogOutput
+{
+private:
+	char* text;
+	int capacity;
+	int used;
+public:
+	LineOutput(char* text, int capacity)
+	{
+		this->text = text;
+		this->capacity = capacity;
+		used = 0;
+		text[0] = 0;
+	}
+
+	virtual void Write(const char* line, int length)
+	{
+		if (used + length >= capacity)
+			return;
+
+		memcpy(text + used, line, length);
+		used += length;
+		text[used] = 0;
+	}
+
+	virtual void Flush() { }
+};
+
+/* Classification */
+
+TEST(HResultCheck, ClassifiesKnownErrors)
+{
+	CHECK(Classify(SurfaceLost) == ErrorSurfaceLost);
+	CHECK(Classify(BufferLost) == ErrorBufferLost);
+	CHECK(Classify(OutOfVideoMemory) == ErrorOutOfVideoMemory);
+	CHECK(Classify(OutOfMemory) == ErrorOutOfMemory);
+	CHECK(Classify(WasStillDrawing) == ErrorStillDrawing);
+	CHECK(Classify(SceneInScene) == ErrorInvalidCall);
+	CHECK(Classify(InvalidArg) == ErrorInvalidCall);
+	CHECK(Classify(BadFormat) == ErrorUnsupported);
+	CHECK(Classify(NotImplemented) == ErrorUnsupported);
+	CHECK(Classify(E_FAIL) == ErrorGeneric);
+
+	// Anything not in the table is a generic failure
+	CHECK(Classify(UnknownGraphics) == ErrorGeneric);
+	CHECK(Classify((HRESULT)0x80001234) == ErrorGeneric);
+}
+
+TEST(HResultCheck, FacilityComesFromTheCodeNotTheTable)
+{
+	CHECK(GetFacility(SurfaceLost) == FacilityGraphics);
+	CHECK(GetFacility(SceneInScene) == FacilityGraphics); // D3D shares DirectDraw's facility
+	CHECK(GetFacility(UnknownGraphics) == FacilityGraphics);
+	CHECK(GetFacility(BufferLost) == FacilitySound);
+	CHECK(GetFacility(NoVirtualization) == FacilitySound);
+	CHECK(GetFacility(OutOfMemory) == FacilitySystem);
+	CHECK(GetFacility(E_FAIL) == FacilitySystem);
+	CHECK(GetFacility(S_OK) == FacilitySystem);
+}
+
+TEST(HResultCheck, NamesKnownErrors)
+{
+	REQUIRE(GetErrorName(SurfaceLost));
+	CHECK(strcmp(GetErrorName(SurfaceLost), "DDERR_SURFACELOST") == 0);
+	CHECK(strcmp(GetErrorName(BufferLost), "DSERR_BUFFERLOST") == 0);
+	CHECK(strcmp(GetErrorName(OutOfMemory), "E_OUTOFMEMORY") == 0);
+	CHECK(GetErrorName(UnknownGraphics) == 0);
+	CHECK(GetErrorName(S_OK) == 0);
+}
+
+TEST(HResultCheck, SuccessCodesAreNotFailures)
+{
+	CHECK_SITE(site, "stub");
+
+	CHECK(!Checks::Check(site, S_OK));
+	CHECK(!Checks::Check(site, NoVirtualization)); // Positive, so SUCCEEDED even with a facility set
+	CHECK(Checks::Check(site, E_FAIL));
+
+	CHECK(site.Calls == 3);
+	CHECK(site.Failures == 1);
+	CHECK(site.LastResult == (long)E_FAIL);
+}
+
+/* Sites */
+
+TEST(HResultCheck, SitesRegisterOnFirstCall)
+{
+	HRESULT script[] = { S_OK, S_OK, SurfaceLost, S_OK, WasStillDrawing };
+	StubSurface surface(script, 5);
+	int sites = GetSiteCount();
+	long failures = GetTotalFailures();
+
+	CHECK(FindSite("surface->Blt()") == 0); // Declaring a site costs nothing until it's hit
+
+	CHECK(BltChecked(surface));
+
+	CheckSite* site = FindSite("surface->Blt()");
+	REQUIRE(site);
+	CHECK(GetFirstSite() == site); // Newest first
+	CHECK(GetSiteCount() == sites + 1);
+	CHECK(site->Calls == 1);
+	CHECK(site->Failures == 0);
+	CHECK(strstr(site->File, "HResultCheckTests.cpp") != 0);
+
+	CHECK(BltChecked(surface));
+	CHECK(!BltChecked(surface));
+	CHECK(BltChecked(surface));
+	CHECK(!BltChecked(surface));
+
+	CHECK(site->Calls == 5);
+	CHECK(site->Failures == 2);
+	CHECK(site->LastResult == (long)WasStillDrawing);
+	CHECK(GetSiteCount() == sites + 1); // Still one entry however often it's called
+	CHECK(GetTotalFailures() == failures + 2);
+
+	// A second site links in front of the first
+	CHECK(LockChecked(surface));
+	CHECK(GetSiteCount() == sites + 2);
+	CHECK(GetFirstSite() == FindSite("surface->Lock()"));
+	CHECK(GetFirstSite()->Next == site);
+}
+
+static void CheckFromWorker(void* arg)
+{
+	CheckSite* site = (CheckSite*)arg;
+
+	for (int i = 0; i < 20000; i++)
+		Checks::Check(*site, i % 1000 == 0 ? E_FAIL : S_OK);
+}
+
+TEST(HResultCheck, SharedSiteCountsEveryCall)
+{
+	const int Threads = 4;
+
+	CHECK_SITE(site, "shared->Present()");
+	Platform::Thread threads[Threads];
+
+	for (int i = 0; i < Threads; i++)
+		threads[i].Start(CheckFromWorker, &site);
+
+	for (int i = 0; i < Threads; i++)
+		threads[i].Join();
+
+	// Game and render thread going through the same site mustn't lose calls or register it twice
+	CHECK(site.Calls == Threads * 20000);
+	CHECK(site.Failures == Threads * 20);
+
+	int registered = 0;
+
+	for (CheckSite* s = GetFirstSite(); s; s = s->Next)
+		registered += s == &site ? 1 : 0;
+
+	CHECK(registered == 1);
+}
+
+TEST(HResultCheck, ResetCountersKeepsSitesRegistered)
+{
+	HRESULT script[] = { E_FAIL, E_FAIL, S_OK };
+	StubSurface surface(script, 3);
+
+	BltChecked(surface);
+	BltChecked(surface);
+	BltChecked(surface);
+
+	int sites = GetSiteCount();
+	CheckSite* site = FindSite("surface->Blt()");
+	REQUIRE(site);
+	CHECK(GetTotalFailures() > 0);
+
+	ResetCounters();
+
+	CHECK(GetTotalFailures() == 0);
+	CHECK(site->Calls == 0);
+	CHECK(site->Failures == 0);
+	CHECK(site->LastResult == 0);
+	CHECK(GetSiteCount() == sites);
+
+	// First call after a reset goes through Register again, which must not link the site twice
+	BltChecked(surface);
+	CHECK(site->Calls == 1);
+	CHECK(GetSiteCount() == sites);
+
+	int walked = 0;
+
+	for (CheckSite* s = GetFirstSite(); s; s = s->Next)
+		walked++;
+
+	CHECK(walked == sites);
+}
+
+TEST(HResultCheck, FailuresAreLoggedWithNameAndExpression)
+{
+	static char text[4096];
+	HRESULT script[] = { SurfaceLost, UnknownGraphics };
+	StubSurface surface(script, 2);
+
+	REQUIRE(Logging::Logger::Initialize(new LineOutput(text, sizeof(text)), 64));
+
+	CHECK(!BltChecked(surface));
+	CHECK(!LockChecked(surface));
+
+	Logging::Logger::Shutdown();
+
+	CHECK(strstr(text, "ERROR Checks") != 0);
+	CHECK(strstr(text, "DDERR_SURFACELOST at line") != 0);
+	CHECK(strstr(text, ": surface->Blt()\n") != 0);
+	CHECK(strstr(text, "0x8876ABCD at line") != 0); // Unknown codes are logged in hex
+	CHECK(strstr(text, ": surface->Lock()\n") != 0);
+
+	// Without a logger failures are still counted, just not written anywhere
+	HRESULT more[] = { BufferLost };
+	StubSurface again(more, 1);
+	long failures = GetTotalFailures();
+
+	CHECK(!BltChecked(again));
+	CHECK(GetTotalFailures() == failures + 1);
+}
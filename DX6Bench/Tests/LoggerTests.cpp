@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "Logger.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Logging;
+
+// Formatting, levels, and the ring under several producers, including producers that keep writing through Shutdown
+
+/* Helpers */
+
+// Filled by the logger thread, read by the test once Shutdown has joined it
+struct Capture
+{
+	char* Text;
+	int Used;
+	int Capacity;
+	int Lines;
+
+	Capture()
+	{
+		Text = 0;
+		Used = 0;
+		Capacity = 0;
+		Lines = 0;
+	}
+
+	~Capture()
+	{
+		free(Text);
+	}
+};
+
+class CaptureOutput : public LogOutput
+{
+private:
+	Capture* capture;
+public:
+	CaptureOutput(Capture* capture)
+	{
+		this->capture = capture;
+	}
+
+	virtual void Write(const char* line, int length)
+	{
+		if (capture->Used + length + 1 > capture->Capacity)
+		{
+			capture->Capacity = (capture->Used + length + 1) * 2;
+			capture->Text = (char*)realloc(capture->Text, capture->Capacity);
+		}
+
+		memcpy(capture->Text + capture->Used, line, length);
+		capture->Used += length;
+		capture->Text[capture->Used] = 0;
+		capture->Lines++;
+	}
+
+	virtual void Flush() { }
+};
+
+LOG_SITE(loadSite, "Tests", LogInfo, "load {0} {1}");
+
+struct LoadProducer
+{
+	int Index;
+	int Count; // Records to write, or 0 to write until Stop is set
+	volatile long* Stop;
+	Platform::Thread Thread;
+};
+
+static void ProduceRecords(void* arg)
+{
+	LoadProducer* producer = (LoadProducer*)arg;
+
+	for (int i = 0; producer->Count == 0 || i < producer->Count; i++)
+	{
+		if (producer->Count == 0 && Platform::AtomicRead(producer->Stop))
+			break;
+
+		Logger::Write(loadSite, producer->Index, i);
+	}
+}
+
+static void FlushUntilStopped(void* arg)
+{
+	LoadProducer* producer = (LoadProducer*)arg;
+
+	while (!Platform::AtomicRead(producer->Stop))
+		Logger::Flush();
+}
+
+// Checks every "load" line is intact and each producer's records came out in the order it wrote them.
+// Returns the number of load lines.
+static int CheckLoadLines(const char* text, int producers, int* errors)
+{
+	int last[8];
+	int lines = 0;
+
+	for (int i = 0; i < 8; i++)
+		last[i] = -1;
+
+	for (const char* line = text; line && *line; )
+	{
+		const char* end = strchr(line, '\n');
+		const char* message = strstr(line, "load ");
+
+		if (message && (!end || message < end))
+		{
+			int index = -1;
+			int sequence = -1;
+
+			if (sscanf(message, "load %d %d", &index, &sequence) != 2 || index < 0 || index >= producers || sequence <= last[index])
+				(*errors)++;
+			else
+				last[index] = sequence;
+
+			lines++;
+		}
+
+		line = end ? end + 1 : 0;
+	}
+
+	return lines;
+}
+
+/* Formatting */
+
+TEST(Logger, FormatsEveryArgumentType)
+{
+	LOG_SITE(site, "Tests", LogInfo, "int {0} uint {1} double {2} bool {3} str {4} {{x}} {5} {1:X}");
+	LOG_SITE(longSite, "Tests", LogWarning, "{0}|{1}");
+
+	Capture capture;
+	CaptureOutput spare(&capture);
+
+	REQUIRE(Logger::Initialize(new CaptureOutput(&capture), 64));
+	CHECK(!Logger::Initialize(&spare, 64)); // Refused, so the output isn't taken over either
+
+	Logger::Write(site, -5, 7u, 2.5, true, "hello");
+
+	// String arguments share 40 bytes of text, the rest is cut off
+	Logger::Write(longSite, "0123456789012345678901234567890123456789abcdef", "lost");
+
+	Logger::Shutdown();
+
+	REQUIRE(capture.Text);
+	CHECK(capture.Lines == 2);
+	CHECK(strstr(capture.Text, "INFO  Tests    int -5 uint 7 double 2.5 bool True str hello {x} {?} 7\n") != 0);
+	CHECK(strstr(capture.Text, "WARN  Tests    0123456789012345678901234567890123456789|\n") != 0);
+	CHECK(!Logger::IsInitialized());
+}
+
+TEST(Logger, LevelsFilterPerCategory)
+{
+	LOG_SITE(debugSite, "TestsLevel", LogDebug, "debug {0}");
+	LOG_SITE(errorSite, "TestsLevel", LogError, "error {0}");
+
+	Capture capture;
+
+	REQUIRE(Logger::Initialize(new CaptureOutput(&capture), 64));
+
+	CHECK(Logger::GetLevel("TestsLevel") == LogInfo);
+	CHECK(!Logger::IsEnabled(debugSite));
+	CHECK(Logger::IsEnabled(errorSite));
+
+	Logger::Write(debugSite, 1);
+	Logger::SetLevel("TestsLevel", LogDebug);
+	Logger::Write(debugSite, 2);
+	Logger::SetLevel("TestsLevel", LogOff);
+	Logger::Write(errorSite, 3);
+	Logger::SetLevel("TestsLevel", LogInfo);
+	Logger::Write(errorSite, 4);
+
+	Logger::Flush();
+	Logger::Shutdown();
+
+	REQUIRE(capture.Text);
+	CHECK(capture.Lines == 2);
+	CHECK(strstr(capture.Text, "debug 2\n") != 0);
+	CHECK(strstr(capture.Text, "error 4\n") != 0);
+}
+
+/* Load */
+
+TEST(Logger, ConcurrentProducersLoseNothingUncounted)
+{
+	// Four threads push 800k records into a small ring: each one is either written or counted as dropped
+	const int Producers = 4;
+	const int PerProducer = 200000;
+
+	Capture capture;
+	LoadProducer producers[Producers];
+	volatile long stop = 0;
+
+	REQUIRE(Logger::Initialize(new CaptureOutput(&capture), 1024));
+	Logger::IsEnabled(loadSite); // Registers before the threads race for it
+
+	long written = Logger::GetWrittenCount();
+	long dropped = Logger::GetDroppedCount();
+
+	for (int i = 0; i < Producers; i++)
+	{
+		producers[i].Index = i;
+		producers[i].Count = PerProducer;
+		producers[i].Stop = &stop;
+		producers[i].Thread.Start(ProduceRecords, &producers[i]);
+	}
+
+	for (int i = 0; i < Producers; i++)
+		producers[i].Thread.Join();
+
+	Logger::Shutdown();
+
+	written = Logger::GetWrittenCount() - written;
+	dropped = Logger::GetDroppedCount() - dropped;
+
+	int errors = 0;
+	int lines = CheckLoadLines(capture.Text, Producers, &errors);
+
+	CHECK(written + dropped == Producers * PerProducer);
+	CHECK(lines == written);
+	CHECK(errors == 0);
+
+	// Drops are reported in the log itself
+	if (dropped > 0)
+		CHECK(strstr(capture.Text, "messages dropped, ring is full") != 0);
+}
+
+TEST(Logger, ShutdownWhileProducersAreWriting)
+{
+	const int Producers = 3;
+	const int Rounds = 20;
+
+	for (int round = 0; round < Rounds; round++)
+	{
+		Capture capture;
+		LoadProducer producers[Producers + 1];
+		volatile long stop = 0;
+
+		REQUIRE(Logger::Initialize(new CaptureOutput(&capture), 256));
+		Logger::IsEnabled(loadSite);
+
+		long written = Logger::GetWrittenCount();
+
+		for (int i = 0; i <= Producers; i++)
+		{
+			producers[i].Index = i;
+			producers[i].Count = 0;
+			producers[i].Stop = &stop;
+			producers[i].Thread.Start(i < Producers ? ProduceRecords : FlushUntilStopped, &producers[i]);
+		}
+
+		Platform::SleepMs(2);
+
+		// Ring is freed here while the threads keep calling Write and Flush
+		Logger::Shutdown();
+
+		CHECK(!Logger::IsInitialized());
+		Platform::SleepMs(1);
+
+		Platform::AtomicExchange(&stop, 1);
+
+		for (int i = 0; i <= Producers; i++)
+			producers[i].Thread.Join();
+
+		int errors = 0;
+		int lines = CheckLoadLines(capture.Text, Producers, &errors);
+
+		CHECK(lines == Logger::GetWrittenCount() - written);
+		CHECK(errors == 0);
+	}
+}
@@ -0,0 +1,511 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "PackFile.h"
+#include "Lz4.h"
+#include "../Source/PackWriter.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Assets;
+using namespace DXSharp::Bench;
+
+// Packs written the way PackBuilder writes them, read back intact, damaged, and with random bytes changed
+
+/* Helpers */
+
+static unsigned int NextRandom(unsigned int* seed)
+{
+	*seed = *seed * 1664525 + 1013904223;
+	return *seed >> 8;
+}
+
+// Runs with a period, then noise - about what textures and sounds compress like
+static unsigned char* MakeData(unsigned int size, unsigned int seed)
+{
+	unsigned char* data = (unsigned char*)malloc(size > 0 ? size : 1);
+
+	for (unsigned int i = 0; i < size; i++)
+		data[i] = i < size / 2 ? (unsigned char)(i % 23) : (unsigned char)NextRandom(&seed);
+
+	return data;
+}
+
+static int Compress(const unsigned char* data, int size, unsigned char** packed)
+{
+	*packed = (unsigned char*)malloc(size + size / 255 + 16);
+	return Lz4Compress(data, size, *packed);
+}
+
+static unsigned char* LoadFile(const char* fileName, unsigned int* size)
+{
+	FILE* file = fopen(fileName, "rb");
+
+	if (!file)
+		return 0;
+
+	fseek(file, 0, SEEK_END);
+	*size = (unsigned int)ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	unsigned char* data = (unsigned char*)malloc(*size);
+
+	if (fread(data, 1, *size, file) != *size)
+	{
+		free(data);
+		data = 0;
+	}
+
+	fclose(file);
+
+	return data;
+}
+
+static bool SaveFile(const char* fileName, const unsigned char* data, unsigned int size)
+{
+	FILE* file = fopen(fileName, "wb");
+
+	if (!file)
+		return false;
+
+	bool ret = fwrite(data, 1, size, file) == size;
+	fclose(file);
+
+	return ret;
+}
+
+const int ItemCount = 6;
+
+// Stored and compressed versions of the same kinds of data, plus the empty and all-zero edge cases
+struct TestPack
+{
+	char FileName[256];
+	PackItem Items[ItemCount];
+
+	TestPack(const char* suffix)
+	{
+		strcpy(FileName, Tests::GetScratchPath(suffix));
+
+		static const char* const names[ItemCount] =
+		{
+			"data/textures/grass.tex", "data/textures/grass_packed.tex", "sounds/engine.wav",
+			"sounds/engine_packed.wav", "models/empty.smd", "models/zeros.bin"
+		};
+
+		static const unsigned int sizes[ItemCount] = { 4000, 4000, 3000, 3000, 0, 20000 };
+
+		for (int i = 0; i < ItemCount; i++)
+		{
+			PackItem& item = Items[i];
+
+			strcpy(item.Name, names[i]);
+			item.Hash = HashPath(item.Name);
+			item.Size = sizes[i];
+			item.Data = MakeData(item.Size, i / 2 + 1);
+			item.Compress = i % 2 == 1;
+		}
+
+		memset(Items[5].Data, 0, Items[5].Size);
+	}
+
+	~TestPack()
+	{
+		for (int i = 0; i < ItemCount; i++)
+			free(Items[i].Data);
+
+		remove(FileName);
+	}
+
+	bool Write()
+	{
+		// WritePack sorts, so hand it a copy and keep Items in declaration order
+		PackItem sorted[ItemCount];
+		memcpy(sorted, Items, sizeof(sorted));
+
+		return WritePack(FileName, sorted, ItemCount);
+	}
+};
+
+// Points every length and count in the header at the real directory again, so damage reaches the entry checks
+static void FixDirectoryCrc(unsigned char* data, unsigned int size, unsigned int directorySize)
+{
+	if (size < sizeof(PackHeader) + directorySize)
+		return;
+
+	PackHeader* header = (PackHeader*)data;
+	header->DirectoryCrc = Crc32(data + sizeof(PackHeader), directorySize);
+}
+
+/* Lz4 */
+
+TEST(PackFile, Lz4RoundTripsCompressorOutput)
+{
+	// Short, long literal runs (length bytes past 15 and 270), overlapping matches, and incompressible data
+	static const unsigned int sizes[] = { 0, 1, 12, 13, 300, 4096, 70000 };
+	unsigned int seed = 7;
+
+	for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		for (int kind = 0; kind < 3; kind++)
+		{
+			unsigned int size = sizes[s];
+			unsigned char* data = (unsigned char*)malloc(size + 1);
+
+			for (unsigned int i = 0; i < size; i++)
+				data[i] = kind == 0 ? 0 : kind == 1 ? (unsigned char)(i % 5) : (unsigned char)NextRandom(&seed);
+
+			unsigned char* packed;
+			int packedSize = Compress(data, size, &packed);
+			unsigned char* unpacked = (unsigned char*)malloc(size + 1);
+
+			CHECK(Lz4Decompress(packed, packedSize, unpacked, size) == (int)size);
+			CHECK(memcmp(data, unpacked, size) == 0);
+
+			// One byte short of room is an error, not a truncated result
+			if (size > 0)
+				CHECK(Lz4Decompress(packed, packedSize, unpacked, size - 1) == -1);
+
+			free(unpacked);
+			free(packed);
+			free(data);
+		}
+	}
+}
+
+TEST(PackFile, Lz4RejectsMalformedBlocks)
+{
+	unsigned char out[64];
+
+	static const unsigned char literalsPastEnd[] = { 0x50, 'a', 'b' }; // Promises 5 literals
+	static const unsigned char zeroOffset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+	static const unsigned char offsetBeforeStart[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+	static const unsigned char matchPastDest[] = { 0x1F, 'a', 0x01, 0x00, 0xFF, 0x00 }; // 1 + 4 + 15 + 255 bytes
+	static const unsigned char lengthCutOff[] = { 0xF0, 0xFF }; // Continuation byte missing
+	static const unsigned char offsetCutOff[] = { 0x10, 'a', 0x01 };
+	static const unsigned char endsOnMatch[] = { 0x10, 'a', 0x01, 0x00 }; // Last sequence must be literals
+
+	CHECK(Lz4Decompress(literalsPastEnd, 0, out, sizeof(out)) == -1);
+	CHECK(Lz4Decompress(literalsPastEnd, sizeof(literalsPastEnd), out, sizeof(out)) == -1);
+	CHECK(Lz4Decompress(zeroOffset, sizeof(zeroOffset), out, sizeof(out)) == -1);
+	CHECK(Lz4Decompress(offsetBeforeStart, sizeof(offsetBeforeStart), out, sizeof(out)) == -1);
+	CHECK(Lz4Decompress(matchPastDest, sizeof(matchPastDest), out, sizeof(out)) == -1);
+	CHECK(Lz4Decompress(lengthCutOff, sizeof(lengthCutOff), out, sizeof(out)) == -1);
+	CHECK(Lz4Decompress(offsetCutOff, sizeof(offsetCutOff), out, sizeof(out)) == -1);
+	CHECK(Lz4Decompress(endsOnMatch, sizeof(endsOnMatch), out, sizeof(out)) == -1);
+
+	// A run that overlaps itself is fine: 'a' then 7 more copies of it
+	static const unsigned char run[] = { 0x13, 'a', 0x01, 0x00, 0x00 };
+
+	CHECK(Lz4Decompress(run, sizeof(run), out, 8) == 8);
+	CHECK(memcmp(out, "aaaaaaaa", 8) == 0);
+}
+
+TEST(PackFile, Lz4SurvivesRandomDamage)
+{
+	const int Iterations = 20000;
+	const unsigned int Size = 2000;
+
+	unsigned int seed = 12345;
+	unsigned char* data = MakeData(Size, 3);
+	unsigned char* packed;
+	int packedSize = Compress(data, Size, &packed);
+	unsigned char* damaged = (unsigned char*)malloc(packedSize);
+	int rejected = 0;
+
+	for (int i = 0; i < Iterations; i++)
+	{
+		memcpy(damaged, packed, packedSize);
+
+		int changes = 1 + NextRandom(&seed) % 4;
+
+		for (int c = 0; c < changes; c++)
+			damaged[NextRandom(&seed) % packedSize] = (unsigned char)NextRandom(&seed);
+
+		int length = i % 8 == 0 ? (int)(NextRandom(&seed) % packedSize) : packedSize;
+
+		// Exactly sized heap block, so the sanitizer builds see a write even one byte past the end
+		unsigned int destSize = NextRandom(&seed) % 2 ? Size : NextRandom(&seed) % (Size * 2);
+		unsigned char* dest = (unsigned char*)malloc(destSize > 0 ? destSize : 1);
+		int result = Lz4Decompress(damaged, length, dest, destSize);
+
+		CHECK(result >= -1 && result <= (int)destSize);
+		rejected += result == -1 ? 1 : 0;
+
+		free(dest);
+	}
+
+	// Damage in literals decodes fine, elsewhere it mostly doesn't - both have to come up for this to mean anything
+	CHECK(rejected > Iterations / 10 && rejected < Iterations);
+
+	free(damaged);
+	free(packed);
+	free(data);
+}
+
+/* Packs */
+
+TEST(PackFile, RoundTripsStoredAndCompressedEntries)
+{
+	TestPack source("pak");
+	PackFile pack;
+
+	REQUIRE(source.Write());
+	REQUIRE(pack.Open(source.FileName, true));
+	REQUIRE(pack.GetEntryCount() == ItemCount);
+
+	for (int i = 0; i < ItemCount; i++)
+	{
+		PackItem& item = source.Items[i];
+		int index = pack.Find(item.Name);
+
+		REQUIRE(index >= 0);
+		CHECK(strcmp(pack.GetName(index), item.Name) == 0);
+		CHECK(pack.GetSize(index) == item.Size);
+		CHECK(pack.IsCompressed(index) == item.Compress);
+		CHECK(pack.Verify(index));
+
+		unsigned char* read = (unsigned char*)malloc(item.Size + 1);
+
+		CHECK(pack.Read(index, read, item.Size));
+		CHECK(memcmp(read, item.Data, item.Size) == 0);
+		CHECK(item.Size == 0 || !pack.Read(index, read, item.Size - 1)); // Too small a buffer
+
+		free(read);
+
+		PackSpan span;
+
+		if (item.Compress)
+		{
+			CHECK(!pack.GetSpan(index, &span));
+		}
+		else
+		{
+			REQUIRE(pack.GetSpan(index, &span));
+			CHECK(span.Size == item.Size);
+			CHECK(memcmp(span.Data, item.Data, item.Size) == 0);
+			CHECK(((size_t)span.Data & (PackAlignment - 1)) == 0);
+		}
+	}
+
+	// Lookups normalize the path
+	CHECK(pack.Find("./Data\\Textures//GRASS.tex") == pack.Find("data/textures/grass.tex"));
+	CHECK(pack.Find("/sounds/engine.wav") >= 0);
+	CHECK(pack.Find("sounds/engine") == -1);
+	CHECK(pack.Find("") == -1);
+
+	CHECK(pack.GetFailedCount() == 0);
+}
+
+TEST(PackFile, DamagedPayloadsFailTheirCrc)
+{
+	TestPack source("pak");
+	REQUIRE(source.Write());
+
+	// Flip one byte in the middle of a stored and of a compressed payload
+	PackFile pack;
+	REQUIRE(pack.Open(source.FileName, false));
+
+	int stored = pack.Find("data/textures/grass.tex");
+	int compressed = pack.Find("sounds/engine_packed.wav");
+	int intact = pack.Find("models/zeros.bin");
+	PackSpan span;
+
+	REQUIRE(stored >= 0 && compressed >= 0 && intact >= 0);
+	pack.Close();
+
+	unsigned int size;
+	unsigned char* data = LoadFile(source.FileName, &size);
+	REQUIRE(data);
+
+	const PackEntry* entries = (const PackEntry*)(data + sizeof(PackHeader)); // Same order as the indices
+
+	data[entries[stored].Offset + entries[stored].StoredSize / 2] ^= 0x40;
+	data[entries[compressed].Offset + entries[compressed].StoredSize - 1] ^= 0x01; // Last literal, still decodes
+	REQUIRE(SaveFile(source.FileName, data, size));
+	free(data);
+
+	// Without verify a stored entry is handed out as is, Verify still finds it
+	REQUIRE(pack.Open(source.FileName, false));
+	CHECK(pack.GetSpan(stored, &span));
+	CHECK(!pack.Verify(stored));
+	CHECK(!pack.Verify(compressed));
+	CHECK(pack.Verify(intact));
+	pack.Close();
+
+	// With verify neither gets through, and every refused read is counted
+	REQUIRE(pack.Open(source.FileName, true));
+
+	unsigned char buffer[20000];
+
+	CHECK(!pack.GetSpan(stored, &span));
+	CHECK(!pack.GetSpan(stored, &span));
+	CHECK(!pack.Read(stored, buffer, sizeof(buffer)));
+	CHECK(!pack.Read(compressed, buffer, sizeof(buffer)));
+	CHECK(pack.GetFailedCount() == 4);
+
+	CHECK(pack.Read(intact, buffer, sizeof(buffer)));
+	CHECK(pack.GetFailedCount() == 4);
+}
+
+TEST(PackFile, DamagedDirectoriesAreRejected)
+{
+	TestPack source("pak");
+	REQUIRE(source.Write());
+
+	unsigned int size;
+	unsigned char* original = LoadFile(source.FileName, &size);
+	REQUIRE(original);
+
+	PackHeader header;
+	memcpy(&header, original, sizeof(header));
+
+	unsigned int directorySize = sizeof(PackEntry) * header.EntryCount + header.NamesSize;
+	unsigned char* data = (unsigned char*)malloc(size);
+	PackHeader* h = (PackHeader*)data;
+	PackEntry* entries = (PackEntry*)(data + sizeof(PackHeader));
+	PackFile pack;
+
+	char fileName[256];
+	strcpy(fileName, Tests::GetScratchPath("damaged.pak"));
+
+	// Each case damages a fresh copy, the valid pack has to open at the end
+	for (int test = 0; test <= 10; test++)
+	{
+		memcpy(data, original, size);
+		unsigned int length = size;
+		bool fixCrc = true;
+
+		switch (test)
+		{
+		case 0: data[sizeof(PackHeader) + 5] ^= 1; fixCrc = false; break; // Directory no longer matches its CRC
+		case 1: h->Magic = 0x4B505845; break;
+		case 2: h->Version = 2; break;
+		case 3: h->Alignment = 12; break;
+		case 4: h->EntryCount = 1000; break;
+		case 5: h->NamesSize++; break;
+		case 6: entries[0].Offset += 1; break; // Misaligned
+		case 7: entries[1].NameOffset = h->NamesSize; break;
+		case 8: entries[2].Hash = 0; entries[0].Hash = 0xFFFFFFFF; break; // Out of order
+		case 9: length = size - 1; break; // Last payload cut short
+		case 10: break;
+		}
+
+		if (fixCrc)
+			FixDirectoryCrc(data, length, directorySize);
+
+		REQUIRE(SaveFile(fileName, data, length));
+		CHECK(pack.Open(fileName, true) == (test == 10));
+	}
+
+	// A stored entry whose sizes disagree, and an LZ4 entry claiming more than it could ever expand to
+	for (int test = 0; test < 2; test++)
+	{
+		memcpy(data, original, size);
+
+		for (int i = 0; i < ItemCount; i++)
+		{
+			bool compressed = (entries[i].Flags & PackEntryLz4) != 0;
+
+			if (compressed == (test == 1))
+			{
+				entries[i].Size = compressed ? 0xFFFFFFF0 : entries[i].Size + 1;
+				break;
+			}
+		}
+
+		FixDirectoryCrc(data, size, directorySize);
+		REQUIRE(SaveFile(fileName, data, size));
+		CHECK(!pack.Open(fileName, true));
+	}
+
+	CHECK(!pack.IsOpen());
+	remove(fileName);
+	free(data);
+	free(original);
+}
+
+TEST(PackFile, SurvivesRandomDamage)
+{
+	const int Iterations = 5000; // Each one writes and maps a file, the decoder alone gets 20000 above
+
+	TestPack source("pak");
+	REQUIRE(source.Write());
+
+	unsigned int size;
+	unsigned char* original = LoadFile(source.FileName, &size);
+	REQUIRE(original);
+
+	PackHeader header;
+	memcpy(&header, original, sizeof(header));
+
+	unsigned int directorySize = sizeof(PackEntry) * header.EntryCount + header.NamesSize;
+	unsigned int frontSize = sizeof(PackHeader) + directorySize;
+	unsigned char* data = (unsigned char*)malloc(size);
+	unsigned int seed = 99;
+	PackFile pack;
+	int opened = 0;
+	int reads = 0;
+
+	char fileName[256];
+	strcpy(fileName, Tests::GetScratchPath("damaged.pak"));
+
+	for (int i = 0; i < Iterations; i++)
+	{
+		memcpy(data, original, size);
+
+		// Half the damage lands in header and directory, which is where a bad value does the most harm
+		int changes = 1 + NextRandom(&seed) % 6;
+
+		for (int c = 0; c < changes; c++)
+		{
+			unsigned int at = NextRandom(&seed) % (c % 2 ? size : frontSize);
+			data[at] = (unsigned char)NextRandom(&seed);
+		}
+
+		unsigned int length = i % 16 == 0 ? NextRandom(&seed) % size : size;
+
+		// Most of the time make the CRC agree again, or nothing past it would ever run
+		if (i % 4 != 0)
+			FixDirectoryCrc(data, length, directorySize);
+
+		REQUIRE(SaveFile(fileName, data, length));
+
+		bool verify = i % 2 == 0;
+
+		if (!pack.Open(fileName, verify))
+			continue;
+
+		opened++;
+
+		for (int e = 0; e < pack.GetEntryCount(); e++)
+		{
+			pack.Find(pack.GetName(e));
+
+			PackSpan span;
+
+			if (pack.GetSpan(e, &span))
+				Crc32(span.Data, span.Size); // Touches every byte the span claims
+
+			unsigned int entrySize = pack.GetSize(e);
+			unsigned char* buffer = (unsigned char*)malloc(entrySize > 0 ? entrySize : 1);
+
+			if (pack.Read(e, buffer, entrySize))
+			{
+				reads++;
+				CHECK(!verify || pack.Verify(e)); // Verified reads only ever hand out good data
+			}
+
+			free(buffer);
+		}
+
+		pack.Close();
+	}
+
+	CHECK(opened > Iterations / 4);
+	CHECK(reads > 0);
+
+	remove(fileName);
+	free(data);
+	free(original);
+}
@@ -0,0 +1,491 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "RenderCommands.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Rendering;
+
+// Recording and replay of command lists, and the ring that hands them to the render thread.
+// Run under "make test CXXFLAGS=-fsanitize=thread" after touching RenderCommands.cpp.
+
+/* Helpers */
+
+static const int FrameVertices = 300; // Enough that a few frames don't fit the initial vertex storage twice
+static const int VertexFloats = 6;
+
+// Checks what a frame produced by RecordFrame() replays to, from whichever thread executes it
+class FrameCheckSink : public CommandSink
+{
+public:
+	long frames;
+	long errors;
+	long presents;
+	unsigned int expectedFrame;
+	unsigned int currentFrame;
+	int drawsInFrame;
+
+	FrameCheckSink()
+	{
+		frames = 0;
+		errors = 0;
+		presents = 0;
+		expectedFrame = 0;
+		currentFrame = 0;
+		drawsInFrame = 0;
+	}
+
+	void Clear(const ClearDesc& desc) { }
+	void BeginScene() { drawsInFrame = 0; }
+	void EndScene() { }
+	void SetTransform(int type, const float* matrix) { }
+	void SetTexture(int stage, void* texture) { }
+	void SetTextureStageState(int stage, int state, int value) { }
+	void SetMaterial(const MaterialDesc& material) { }
+
+	void SetRenderState(int state, unsigned int value)
+	{
+		// Frames have to come out in the order they were submitted, none skipped or repeated
+		currentFrame = value;
+
+		if (value != expectedFrame)
+			errors++;
+
+		expectedFrame = value + 1;
+	}
+
+	void DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount)
+	{
+		const float* data = (const float*)vertices;
+
+		if (vertexSize != VertexFloats * (int)sizeof(float) || vertexCount != FrameVertices)
+		{
+			errors++;
+			return;
+		}
+
+		// A list overwritten by the game thread while it's replayed shows up as vertices of another frame
+		for (int i = 0; i < vertexCount * VertexFloats; i++)
+		{
+			if (data[i] != (float)(currentFrame % 1000) + (float)drawsInFrame)
+			{
+				errors++;
+				break;
+			}
+		}
+
+		drawsInFrame++;
+	}
+
+	void Present()
+	{
+		if (drawsInFrame != 3)
+			errors++;
+
+		presents++;
+		frames++;
+	}
+};
+
+// Uses every way of recording a draw so each one is replayed across the thread boundary
+static void RecordFrame(CommandList* list, unsigned int frame, float* scratch)
+{
+	for (int i = 0; i < FrameVertices * VertexFloats; i++)
+		scratch[i] = (float)(frame % 1000);
+
+	list->BeginScene();
+	list->SetRenderState(0, frame);
+	list->DrawPrimitive(4, 0, 0, scratch, VertexFloats * sizeof(float), FrameVertices);
+
+	for (int i = 0; i < FrameVertices * VertexFloats; i++)
+		scratch[i] += 1;
+
+	list->BeginDraw(4, 0, 0, VertexFloats * sizeof(float));
+
+	for (int v = 0; v < FrameVertices; v++)
+		list->AddVertex(scratch + v * VertexFloats);
+
+	list->EndDraw();
+
+	// Game thread reuses its buffer right away, the list has its own copy
+	for (int i = 0; i < FrameVertices * VertexFloats; i++)
+		scratch[i] += 1;
+
+	list->DrawPrimitive(4, 0, 0, scratch, VertexFloats * sizeof(float), FrameVertices);
+
+	list->EndScene();
+	list->Present();
+}
+
+// Counts calls and checks every payload of a single-threaded replay
+class ReplaySink : public CommandSink
+{
+public:
+	int calls;
+	int errors;
+	void* lastTexture;
+
+	ReplaySink()
+	{
+		calls = 0;
+		errors = 0;
+		lastTexture = 0;
+	}
+
+	void Clear(const ClearDesc& desc) { calls++; if (desc.Color != 0xFF102030 || desc.Z != 1.0f) errors++; }
+	void BeginScene() { calls++; }
+	void EndScene() { calls++; }
+	void SetTransform(int type, const float* matrix) { calls++; if (type != 2 || matrix[15] != 15.0f) errors++; }
+	void SetTexture(int stage, void* texture) { calls++; lastTexture = texture; }
+	void SetRenderState(int state, unsigned int value) { calls++; if (state != 7 || value != 9) errors++; }
+	void SetTextureStageState(int stage, int state, int value) { calls++; if (stage != 1 || state != 2 || value != 3) errors++; }
+	void SetMaterial(const MaterialDesc& material) { calls++; if (material.Power != 8.0f) errors++; }
+	void DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount) { calls++; }
+	void Present() { calls++; }
+};
+
+/* Command list */
+
+TEST(RenderCommands, ReplaysEveryCommandType)
+{
+	CommandList list;
+	ReplaySink sink;
+	ClearDesc clear;
+	MaterialDesc material;
+	float matrix[16];
+	float vertex[3] = { 1, 2, 3 };
+	int texture = 0;
+
+	memset(&clear, 0, sizeof(clear));
+	memset(&material, 0, sizeof(material));
+	clear.Color = 0xFF102030;
+	clear.Z = 1.0f;
+	material.Power = 8.0f;
+
+	for (int i = 0; i < 16; i++)
+		matrix[i] = (float)i;
+
+	// Odd payload sizes in between, so pointer payloads after them would be misaligned without padding
+	list.Clear(clear);
+	list.SetTextureStageState(1, 2, 3);
+	list.SetTexture(0, &texture);
+	list.BeginScene();
+	list.SetTransform(2, matrix);
+	list.SetRenderState(7, 9);
+	list.SetMaterial(material);
+	list.DrawPrimitive(4, 0, 0, vertex, sizeof(vertex), 1);
+	list.DrawExternal(4, 0, 0, vertex, sizeof(vertex), 1);
+	list.EndScene();
+	list.Present();
+
+	CHECK(list.GetCommandCount() == 11);
+	CHECK(!list.HasFailed());
+
+	list.Execute(&sink);
+
+	CHECK(sink.calls == 11);
+	CHECK(sink.errors == 0);
+	CHECK(sink.lastTexture == &texture);
+}
+
+TEST(RenderCommands, GrowsPastInitialStorage)
+{
+	CommandList list;
+	FrameCheckSink sink;
+	float* scratch = (float*)malloc(FrameVertices * VertexFloats * sizeof(float));
+	int usage = list.GetMemoryUsage();
+
+	// Several MB of vertices and thousands of commands in one list
+	for (unsigned int frame = 0; frame < 200; frame++)
+		RecordFrame(&list, frame, scratch);
+
+	CHECK(list.GetMemoryUsage() > usage);
+	CHECK(!list.HasFailed());
+
+	list.Execute(&sink);
+
+	CHECK(sink.frames == 200);
+	CHECK(sink.errors == 0);
+
+	free(scratch);
+}
+
+TEST(RenderCommands, OversizedDrawFailsTheRecord)
+{
+	CommandList list;
+	ReplaySink sink;
+	float vertex[3] = { 1, 2, 3 };
+
+	list.BeginScene();
+	list.DrawPrimitive(4, 0, 0, vertex, 64, 0x1800000); // 1.5 GB, past what the list may grow to
+	CHECK(list.HasFailed());
+
+	// Everything after is dropped too and nothing of the frame reaches the sink
+	list.EndScene();
+	list.Present();
+	list.Execute(&sink);
+
+	CHECK(list.GetCommandCount() == 1);
+	CHECK(sink.calls == 0);
+
+	// Overflowing vertexSize * vertexCount must not pass as a small draw
+	list.Reset();
+	list.DrawPrimitive(4, 0, 0, vertex, 0x10000, 0x8000);
+	CHECK(list.HasFailed());
+
+	list.Reset();
+	list.DrawPrimitive(4, 0, 0, vertex, sizeof(vertex), -1);
+	CHECK(list.HasFailed());
+
+	// Next frame records normally
+	list.Reset();
+	list.BeginScene();
+	list.DrawPrimitive(4, 0, 0, vertex, sizeof(vertex), 1);
+	list.EndScene();
+	list.Execute(&sink);
+
+	CHECK(!list.HasFailed());
+	CHECK(sink.calls == 3);
+}
+
+/* Frame ring */
+
+struct RingConsumer
+{
+	FrameRing* ring;
+	FrameCheckSink sink;
+	long maxPending;
+	int frameCount;
+	Platform::Thread thread;
+};
+
+static void ConsumeFrames(void* arg)
+{
+	RingConsumer* consumer = (RingConsumer*)arg;
+
+	while (consumer->sink.frames < consumer->frameCount)
+	{
+		CommandList* list = consumer->ring->BeginRead(1000);
+
+		if (!list)
+		{
+			consumer->sink.errors++; // Producer stalled or a frame got lost
+			return;
+		}
+
+		int pending = consumer->ring->GetPendingCount();
+
+		if (pending > consumer->maxPending)
+			consumer->maxPending = pending;
+
+		list->Execute(&consumer->sink);
+		list->Reset();
+		consumer->ring->EndRead();
+	}
+}
+
+TEST(RenderCommands, FrameRingHandsOverFramesInOrder)
+{
+	const int Frames = 3000;
+
+	float* scratch = (float*)malloc(FrameVertices * VertexFloats * sizeof(float));
+
+	for (int capacity = 1; capacity <= FrameRing::MaxFrames; capacity++)
+	{
+		FrameRing ring(capacity);
+		RingConsumer consumer;
+
+		consumer.ring = &ring;
+		consumer.maxPending = 0;
+		consumer.frameCount = Frames;
+		consumer.thread.Start(ConsumeFrames, &consumer);
+
+		for (int frame = 0; frame < Frames; frame++)
+		{
+			CommandList* list = ring.BeginWrite();
+
+			CHECK(ring.GetPendingCount() <= capacity);
+
+			list->Reset();
+			RecordFrame(list, frame, scratch);
+			ring.EndWrite();
+
+			// Uneven frame times, so the ring runs both full and empty
+			if (frame % 97 == 0)
+				Platform::SleepMs(1);
+		}
+
+		consumer.thread.Join();
+
+		CHECK(consumer.sink.frames == Frames);
+		CHECK(consumer.sink.errors == 0);
+		CHECK(consumer.maxPending <= capacity + 1); // Between EndWrite and the next BeginWrite
+		CHECK(ring.GetPendingCount() == 0);
+	}
+
+	CHECK(FrameRing(0).GetCapacity() == 1);
+	CHECK(FrameRing(10).GetCapacity() == FrameRing::MaxFrames);
+
+	free(scratch);
+}
+
+TEST(RenderCommands, FrameRingWaitsUntilDrained)
+{
+	const int Rounds = 300;
+
+	float* scratch = (float*)malloc(FrameVertices * VertexFloats * sizeof(float));
+	FrameRing ring(FrameRing::MaxFrames);
+	RingConsumer consumer;
+	unsigned int frame = 0;
+
+	consumer.ring = &ring;
+	consumer.maxPending = 0;
+	consumer.frameCount = 0;
+
+	for (int round = 0; round < Rounds; round++)
+		consumer.frameCount += 1 + round % FrameRing::MaxFrames;
+
+	consumer.thread.Start(ConsumeFrames, &consumer);
+
+	for (int round = 0; round < Rounds; round++)
+	{
+		for (int i = 0; i < 1 + round % FrameRing::MaxFrames; i++)
+		{
+			CommandList* list = ring.BeginWrite();
+
+			list->Reset();
+			RecordFrame(list, frame++, scratch);
+			ring.EndWrite();
+		}
+
+		// Sometimes the consumer is done before the wait starts, which must not block or leave a wakeup behind
+		if (round % 3 == 0)
+			Platform::SleepMs(1);
+
+		ring.WaitUntilDrained();
+
+		CHECK(ring.GetPendingCount() == 0);
+	}
+
+	consumer.thread.Join();
+
+	CHECK(consumer.sink.frames == (long)frame);
+	CHECK(consumer.sink.errors == 0);
+
+	free(scratch);
+}
+
+/* Render thread */
+
+TEST(RenderCommands, RenderThreadExecutesEverySubmittedFrame)
+{
+	const int Frames = 2000;
+
+	float* scratch = (float*)malloc(FrameVertices * VertexFloats * sizeof(float));
+
+	for (int latency = 1; latency <= FrameRing::MaxFrames; latency++)
+	{
+		FrameCheckSink sink;
+		unsigned int frame = 0;
+
+		{
+			RenderThread thread(&sink, latency);
+
+			for (int i = 0; i < Frames; i++)
+			{
+				CommandList* list = thread.GetCurrentList();
+
+				CHECK(list->GetCommandCount() == 0); // Lists come back reset
+				RecordFrame(list, frame++, scratch);
+
+				// Flush submits what is recorded, like a device reset or a resize does mid-game
+				if (i % 250 == 249)
+				{
+					thread.Flush();
+
+					CHECK(thread.GetFramesExecuted() == thread.GetFramesSubmitted());
+					CHECK(sink.frames == (long)frame);
+				}
+				else
+				{
+					thread.SubmitFrame();
+				}
+
+				// Game thread can't get further ahead than the latency allows
+				CHECK(thread.GetFramesSubmitted() - thread.GetFramesExecuted() <= latency);
+			}
+
+			RecordFrame(thread.GetCurrentList(), frame++, scratch);
+		} // Destructor flushes the last frame
+
+		CHECK(sink.frames == (long)frame);
+		CHECK(sink.presents == (long)frame);
+		CHECK(sink.errors == 0);
+	}
+
+	free(scratch);
+}
+
+// Holds the render thread inside Present until the test lets it go
+class StallingSink : public FrameCheckSink
+{
+public:
+	Platform::Semaphore entered;
+	Platform::Semaphore release;
+
+	StallingSink() : entered(0), release(0)
+	{
+	}
+
+	void Present()
+	{
+		FrameCheckSink::Present();
+
+		entered.Release(1);
+		release.Wait();
+	}
+};
+
+TEST(RenderCommands, RenderThreadOverlapsRecordingAtLatencyOne)
+{
+	float* scratch = (float*)malloc(FrameVertices * VertexFloats * sizeof(float));
+	StallingSink sink;
+
+	{
+		RenderThread thread(&sink, 1);
+
+		RecordFrame(thread.GetCurrentList(), 0, scratch);
+		thread.SubmitFrame(); // Would wait for the stalled frame if the recording list had to come back first
+
+		CHECK(sink.entered.Wait(1000));
+		CHECK(thread.GetFramesExecuted() == 0);
+
+		// Next frame is recorded while the first one is still being replayed
+		RecordFrame(thread.GetCurrentList(), 1, scratch);
+		CHECK(thread.GetCurrentList()->GetCommandCount() > 0);
+
+		sink.release.Release(3); // First, second and the empty list the destructor submits
+	}
+
+	CHECK(sink.frames == 2);
+	CHECK(sink.errors == 0);
+
+	free(scratch);
+}
+
+TEST(RenderCommands, RenderThreadStartsAndStopsIdle)
+{
+	FrameCheckSink sink;
+
+	for (int i = 0; i < 10; i++)
+	{
+		RenderThread thread(&sink, 1 + i % FrameRing::MaxFrames);
+
+		CHECK(thread.GetMaxFrameLatency() == 1 + i % FrameRing::MaxFrames);
+	}
+
+	// Every destructor submits the empty list it holds, which replays as nothing
+	CHECK(sink.frames == 0);
+	CHECK(sink.errors == 0);
+}
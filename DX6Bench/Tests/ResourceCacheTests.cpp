@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "ResourceCache.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Assets;
+
+// Sharing by key, failed and stale entries, unloading, and many threads asking for the same keys at once
+
+/* Helpers */
+
+const int TextureType = 0;
+const int SoundType = 1;
+
+// Objects are just addresses here, the cache never looks behind them
+static int objects[16];
+
+static ResourceTypeStats GetStats(ResourceCache& cache, int type)
+{
+	ResourceTypeStats stats;
+	cache.GetStats(type, &stats);
+
+	return stats;
+}
+
+const int LoadThreads = 8;
+const int LoadKeys = 20;
+
+struct LoadShared
+{
+	ResourceCache* Cache;
+	volatile long Loads[LoadKeys]; // How often each key was loaded, has to end up 1
+	volatile long Start;
+	int Objects[LoadKeys];
+};
+
+struct LoadWorker
+{
+	LoadShared* Shared;
+	int Index;
+	int Wrong; // Handles that came back in the wrong state or with somebody else's object
+	ResourceHandle Handles[LoadKeys];
+	Platform::Thread Thread;
+};
+
+static void AcquireAll(void* arg)
+{
+	LoadWorker* worker = (LoadWorker*)arg;
+	LoadShared* shared = worker->Shared;
+
+	while (!Platform::AtomicRead(&shared->Start))
+		Platform::YieldThread();
+
+	// Each thread walks the keys from a different starting point, so loads and joins interleave
+	for (int n = 0; n < LoadKeys; n++)
+	{
+		int key = (n + worker->Index * 3) % LoadKeys;
+		char path[64];
+		bool mustLoad;
+
+		sprintf(path, "data/models/model%02d.smd", key);
+
+		ResourceHandle handle = shared->Cache->Acquire(TextureType, path, 0, &mustLoad);
+		worker->Handles[key] = handle;
+
+		if (!handle)
+		{
+			worker->Wrong++;
+			continue;
+		}
+
+		if (mustLoad)
+		{
+			Platform::AtomicIncrement(&shared->Loads[key]);
+			Platform::SleepMs(1); // Long enough for others to find it loading
+
+			if (key % 5 == 4)
+				shared->Cache->Fail(handle);
+			else
+				shared->Cache->Complete(handle, &shared->Objects[key], 100);
+		}
+
+		ResourceState state = shared->Cache->Wait(handle);
+		bool good = key % 5 == 4 ? state == ResourceFailed : state == ResourceReady && shared->Cache->GetResource(handle) == &shared->Objects[key];
+
+		worker->Wrong += good ? 0 : 1;
+	}
+}
+
+/* Sharing */
+
+TEST(ResourceCache, FirstAcquireLoadsLaterOnesShare)
+{
+	ResourceCache cache(16);
+	bool mustLoad;
+
+	ResourceHandle first = cache.Acquire(TextureType, "data/textures/grass.tex", 0, &mustLoad);
+	REQUIRE(first != 0);
+	CHECK(mustLoad);
+	CHECK(cache.GetState(first) == ResourceLoading);
+	CHECK(cache.GetResource(first) == 0);
+
+	// Asked for again while loading: same entry, somebody else's job
+	ResourceHandle joined = cache.Acquire(TextureType, "./Data\\Textures\\GRASS.tex", 0, &mustLoad);
+	CHECK(joined == first);
+	CHECK(!mustLoad);
+
+	cache.Complete(first, &objects[0], 512);
+	CHECK(cache.GetState(first) == ResourceReady);
+	CHECK(cache.GetResource(first) == &objects[0]);
+	CHECK(cache.Wait(first) == ResourceReady);
+
+	ResourceHandle hit = cache.Acquire(TextureType, "data/textures/grass.tex", 0, &mustLoad);
+	CHECK(hit == first);
+	CHECK(!mustLoad);
+
+	// Parameters and type are part of the key
+	ResourceHandle other = cache.Acquire(TextureType, "data/textures/grass.tex", 1, &mustLoad);
+	CHECK(other != first && mustLoad);
+	ResourceHandle sound = cache.Acquire(SoundType, "data/textures/grass.tex", 0, &mustLoad);
+	CHECK(sound != first && sound != other && mustLoad);
+
+	ResourceTypeStats stats = GetStats(cache, TextureType);
+	CHECK(stats.Count == 2);
+	CHECK(stats.Referenced == 2);
+	CHECK(stats.Misses == 2);
+	CHECK(stats.Joins == 1);
+	CHECK(stats.Hits == 1);
+	CHECK(stats.Bytes == 512);
+
+	CHECK(GetStats(cache, SoundType).Count == 1);
+	CHECK(cache.GetCount() == 3);
+}
+
+TEST(ResourceCache, FailedLoadsAreCached)
+{
+	ResourceCache cache(16);
+	bool mustLoad;
+
+	ResourceHandle handle = cache.Acquire(SoundType, "sounds/missing.wav", 0, &mustLoad);
+	REQUIRE(mustLoad);
+	cache.Fail(handle);
+
+	CHECK(cache.GetState(handle) == ResourceFailed);
+	CHECK(cache.GetResource(handle) == 0);
+
+	// Not probed again
+	CHECK(cache.Acquire(SoundType, "sounds/missing.wav", 0, &mustLoad) == handle);
+	CHECK(!mustLoad);
+
+	// Finishing twice changes nothing
+	cache.Complete(handle, &objects[1], 10);
+	CHECK(cache.GetState(handle) == ResourceFailed);
+
+	ResourceTypeStats stats = GetStats(cache, SoundType);
+	CHECK(stats.Failures == 1);
+	CHECK(stats.Bytes == 0);
+}
+
+TEST(ResourceCache, RejectsBadTypesAndAFullCache)
+{
+	ResourceCache cache(4);
+	bool mustLoad;
+	char path[32];
+
+	CHECK(cache.Acquire(-1, "a", 0, &mustLoad) == 0);
+	CHECK(cache.Acquire(ResourceCache::MaxTypes, "a", 0, &mustLoad) == 0);
+
+	for (int i = 0; i < 4; i++)
+	{
+		sprintf(path, "file%d", i);
+		CHECK(cache.Acquire(TextureType, path, 0, &mustLoad) != 0);
+	}
+
+	CHECK(cache.Acquire(TextureType, "file4", 0, &mustLoad) == 0);
+	CHECK(!mustLoad);
+	CHECK(cache.Acquire(TextureType, "file0", 0, &mustLoad) != 0); // Existing keys still work
+}
+
+/* Unloading */
+
+TEST(ResourceCache, UnloadTakesOnlyUnreferencedFinishedEntries)
+{
+	ResourceCache cache(16);
+	UnloadedResource unloaded[4];
+	bool mustLoad;
+
+	ResourceHandle kept = cache.Acquire(TextureType, "kept.tex", 0, &mustLoad);
+	ResourceHandle released = cache.Acquire(TextureType, "released.tex", 0, &mustLoad);
+	ResourceHandle loading = cache.Acquire(TextureType, "loading.tex", 0, &mustLoad);
+	ResourceHandle sound = cache.Acquire(SoundType, "engine.wav", 0, &mustLoad);
+
+	cache.Complete(kept, &objects[0], 100);
+	cache.Complete(released, &objects[1], 200);
+	cache.Complete(sound, &objects[2], 300);
+
+	cache.Release(released);
+	cache.Release(loading); // The loader still has to finish it
+	cache.Release(sound);
+
+	CHECK(GetStats(cache, TextureType).Referenced == 1);
+
+	REQUIRE(cache.Unload(TextureType, unloaded, 4) == 1);
+	CHECK(unloaded[0].Object == &objects[1]);
+	CHECK(unloaded[0].Type == TextureType);
+	CHECK(unloaded[0].Bytes == 200);
+
+	ResourceTypeStats stats = GetStats(cache, TextureType);
+	CHECK(stats.Count == 2);
+	CHECK(stats.Bytes == 100);
+	CHECK(stats.Unloads == 1);
+
+	// Unreferenced entries stay until asked for, a reference taken in between keeps them
+	cache.AddRef(sound);
+	CHECK(cache.Unload(-1, unloaded, 4) == 0);
+	cache.Release(sound);
+
+	cache.Complete(loading, &objects[3], 50);
+	cache.Release(kept);
+
+	CHECK(cache.Unload(-1, unloaded, 4) == 3);
+	CHECK(cache.GetCount() == 0);
+	CHECK(GetStats(cache, TextureType).Bytes == 0);
+	CHECK(GetStats(cache, SoundType).Bytes == 0);
+}
+
+TEST(ResourceCache, UnloadHandsBackInBatches)
+{
+	ResourceCache cache(16);
+	UnloadedResource unloaded[2];
+	bool mustLoad;
+	char path[32];
+
+	for (int i = 0; i < 5; i++)
+	{
+		sprintf(path, "file%d", i);
+		ResourceHandle handle = cache.Acquire(TextureType, path, 0, &mustLoad);
+		cache.Complete(handle, &objects[i], 1);
+		cache.Release(handle);
+	}
+
+	CHECK(cache.Unload(TextureType, unloaded, 2) == 2);
+	CHECK(cache.Unload(TextureType, unloaded, 2) == 2);
+	CHECK(cache.Unload(TextureType, unloaded, 2) == 1);
+	CHECK(cache.Unload(TextureType, unloaded, 2) == 0);
+	CHECK(GetStats(cache, TextureType).Unloads == 5);
+}
+
+TEST(ResourceCache, StaleHandlesAreRejected)
+{
+	ResourceCache cache(1); // One slot, so the next entry has to reuse it
+	UnloadedResource unloaded[1];
+	bool mustLoad;
+
+	ResourceHandle old = cache.Acquire(TextureType, "old.tex", 0, &mustLoad);
+	cache.Complete(old, &objects[0], 10);
+	cache.Release(old);
+	REQUIRE(cache.Unload(-1, unloaded, 1) == 1);
+
+	CHECK(cache.GetState(old) == ResourceInvalid);
+	CHECK(cache.GetResource(old) == 0);
+	CHECK(cache.Wait(old) == ResourceInvalid);
+
+	ResourceHandle reused = cache.Acquire(TextureType, "new.tex", 0, &mustLoad);
+	REQUIRE(reused != 0);
+	CHECK(reused != old);
+	CHECK((reused & 0xFFFF) == (old & 0xFFFF)); // Same slot, newer generation
+
+	// None of these may reach the new entry
+	cache.Complete(old, &objects[1], 10);
+	cache.AddRef(old);
+	cache.Release(old);
+	cache.Release(old);
+
+	CHECK(cache.GetState(reused) == ResourceLoading);
+	CHECK(GetStats(cache, TextureType).Referenced == 1);
+
+	CHECK(cache.GetState(0) == ResourceInvalid);
+	CHECK(cache.GetState(0xFFFF) == ResourceInvalid); // Index past capacity
+}
+
+/* Threads */
+
+TEST(ResourceCache, ConcurrentAcquiresLoadEachKeyOnce)
+{
+	ResourceCache cache(64);
+	LoadShared shared;
+	LoadWorker workers[LoadThreads];
+
+	shared.Cache = &cache;
+	shared.Start = 0;
+
+	for (int i = 0; i < LoadKeys; i++)
+		shared.Loads[i] = 0;
+
+	for (int i = 0; i < LoadThreads; i++)
+	{
+		workers[i].Shared = &shared;
+		workers[i].Index = i;
+		workers[i].Wrong = 0;
+		workers[i].Thread.Start(AcquireAll, &workers[i]);
+	}
+
+	Platform::AtomicExchange(&shared.Start, 1);
+
+	for (int i = 0; i < LoadThreads; i++)
+		workers[i].Thread.Join();
+
+	for (int i = 0; i < LoadKeys; i++)
+		CHECK(shared.Loads[i] == 1);
+
+	for (int i = 0; i < LoadThreads; i++)
+	{
+		CHECK(workers[i].Wrong == 0);
+
+		// Everybody got the same entry for a key
+		for (int k = 0; k < LoadKeys; k++)
+			CHECK(workers[i].Handles[k] == workers[0].Handles[k]);
+	}
+
+	ResourceTypeStats stats = GetStats(cache, TextureType);
+	CHECK(stats.Count == LoadKeys);
+	CHECK(stats.Referenced == LoadKeys);
+	CHECK(stats.Misses == LoadKeys);
+	CHECK(stats.Hits + stats.Joins == (LoadThreads - 1) * LoadKeys);
+	CHECK(stats.Joins > 0);
+	CHECK(stats.Failures == LoadKeys / 5);
+}
@@ -0,0 +1,518 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Test.h"
+#include "SpatialAudio.h"
+#include "AudioSink.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Audio;
+
+// Sign conventions of the spatial kernels, SIMD against scalar, voice ranking and virtual playback, all on a null sink
+
+/* Helpers */
+
+static const int OutputRate = 44100;
+static const float SpeedOfSound = 343.0f;
+
+static unsigned int NextRandom(unsigned int* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+
+	return *seed >> 8;
+}
+
+static float RandomFloat(unsigned int* seed, float range)
+{
+	return ((NextRandom(seed) & 0xFFFF) / 32768.0f - 1.0f) * range;
+}
+
+static SoundClip* MakeClip(int frames)
+{
+	short* pcm = (short*)malloc(sizeof(short) * frames);
+
+	for (int i = 0; i < frames; i++)
+		pcm[i] = (short)(8000 * sin(i * 0.05));
+
+	SoundClip* clip = SoundClip::Create(pcm, sizeof(short) * frames, 1, OutputRate, 16, false);
+	free(pcm);
+
+	return clip;
+}
+
+static EmitterParams MakeParams(int priority, bool loop)
+{
+	EmitterParams params;
+	params.Priority = priority;
+	params.Loop = loop;
+	params.MinDistance = 1;
+	params.MaxDistance = 100;
+
+	return params;
+}
+
+static bool Near(float value, float expected, float tolerance)
+{
+	return fabs(value - expected) <= tolerance;
+}
+
+const int BatchCapacity = 64;
+const float Guard = 12345.0f;
+
+// Batch laid out like SpatialAudio's, with guard values past the end so overruns show up
+struct TestBatch
+{
+	SpatialBatch Batch;
+	float Storage[12][BatchCapacity + 4];
+
+	TestBatch()
+	{
+		float** arrays[12] = { &Batch.X, &Batch.Y, &Batch.Z, &Batch.VX, &Batch.VY, &Batch.VZ, &Batch.Gain,
+			&Batch.MinDistance, &Batch.MaxDistance, &Batch.Attenuation, &Batch.Pan, &Batch.Doppler };
+
+		for (int i = 0; i < 12; i++)
+		{
+			*arrays[i] = Storage[i];
+
+			for (int j = 0; j < BatchCapacity + 4; j++)
+				Storage[i][j] = Guard;
+		}
+
+		// Free slots as SpatialAudio keeps them
+		for (int i = 0; i < BatchCapacity; i++)
+		{
+			Batch.X[i] = Batch.Y[i] = Batch.Z[i] = 0;
+			Batch.VX[i] = Batch.VY[i] = Batch.VZ[i] = 0;
+			Batch.Gain[i] = 0;
+			Batch.MinDistance[i] = 1;
+			Batch.MaxDistance[i] = 1;
+		}
+
+		// Listener at the origin facing +Z with +Y up, so right is +X
+		Batch.ListenerX = Batch.ListenerY = Batch.ListenerZ = 0;
+		Batch.ListenerVX = Batch.ListenerVY = Batch.ListenerVZ = 0;
+		Batch.RightX = 1;
+		Batch.RightY = 0;
+		Batch.RightZ = 0;
+		Batch.SpeedOfSound = SpeedOfSound;
+		Batch.DopplerFactor = 1;
+	}
+
+	void Set(int i, float x, float y, float z, float vx, float vy, float vz, float gain, float minDistance, float maxDistance)
+	{
+		Batch.X[i] = x;
+		Batch.Y[i] = y;
+		Batch.Z[i] = z;
+		Batch.VX[i] = vx;
+		Batch.VY[i] = vy;
+		Batch.VZ[i] = vz;
+		Batch.Gain[i] = gain;
+		Batch.MinDistance[i] = minDistance;
+		Batch.MaxDistance[i] = maxDistance;
+	}
+};
+
+static SpatialKernel GetSimdKernel()
+{
+	bool isSimd;
+
+	return SpatialAudio::GetBestKernel(isSimd);
+}
+
+// Sum of absolute left and right samples over a rendered stretch
+static void RenderEnergy(AudioMixer& mixer, int frames, double* left, double* right)
+{
+	short* out = (short*)malloc(sizeof(short) * 2 * frames);
+
+	mixer.Render(out, frames);
+	*left = 0;
+	*right = 0;
+
+	for (int i = 0; i < frames; i++)
+	{
+		*left += abs(out[i * 2]);
+		*right += abs(out[i * 2 + 1]);
+	}
+
+	free(out);
+}
+
+/* Kernels */
+
+TEST(SpatialAudio, AttenuationClampsInsideMinAndCutsBeyondMax)
+{
+	SpatialKernel kernels[2] = { SpatialAudio::GetScalarKernel(), GetSimdKernel() };
+
+	for (int k = 0; k < 2; k++)
+	{
+		TestBatch t;
+
+		t.Set(0, 0, 0, 0.5f, 0, 0, 0, 0.8f, 2, 50); // Inside min distance
+		t.Set(1, 0, 0, 8, 0, 0, 0, 0.8f, 2, 50); // Inverse distance past min
+		t.Set(2, 0, 0, 49, 0, 0, 0, 1, 2, 50);
+		t.Set(3, 0, 0, 51, 0, 0, 0, 1, 2, 50); // Beyond max
+		t.Set(4, 0, 0, 0, 0, 0, 0, 1, 1, 50); // On top of the listener
+
+		kernels[k](t.Batch, 8);
+
+		CHECK(Near(t.Batch.Attenuation[0], 0.8f, 1e-6f));
+		CHECK(Near(t.Batch.Attenuation[1], 0.8f * 2 / 8, 1e-6f));
+		CHECK(Near(t.Batch.Attenuation[2], 2.0f / 49, 1e-6f));
+		CHECK(t.Batch.Attenuation[3] == 0);
+		CHECK(Near(t.Batch.Attenuation[4], 1, 1e-6f));
+		CHECK(t.Batch.Pan[4] == 0 && t.Batch.Doppler[4] == 1); // No direction, no NaN
+	}
+}
+
+TEST(SpatialAudio, PanIsPositiveToTheRight)
+{
+	SpatialKernel kernels[2] = { SpatialAudio::GetScalarKernel(), GetSimdKernel() };
+
+	for (int k = 0; k < 2; k++)
+	{
+		TestBatch t;
+
+		t.Set(0, 5, 0, 0, 0, 0, 0, 1, 1, 100);
+		t.Set(1, -5, 0, 0, 0, 0, 0, 1, 1, 100);
+		t.Set(2, 0, 0, 5, 0, 0, 0, 1, 1, 100);
+		t.Set(3, 3, 0, 3, 0, 0, 0, 1, 1, 100);
+
+		kernels[k](t.Batch, 4);
+
+		CHECK(Near(t.Batch.Pan[0], 1, 1e-6f));
+		CHECK(Near(t.Batch.Pan[1], -1, 1e-6f));
+		CHECK(Near(t.Batch.Pan[2], 0, 1e-6f));
+		CHECK(Near(t.Batch.Pan[3], 0.70710678f, 1e-5f));
+	}
+}
+
+TEST(SpatialAudio, DopplerRaisesPitchWhenClosingAndLowersWhenReceding)
+{
+	SpatialKernel kernels[2] = { SpatialAudio::GetScalarKernel(), GetSimdKernel() };
+
+	for (int k = 0; k < 2; k++)
+	{
+		TestBatch t;
+
+		// Emitters 10m ahead
+		t.Set(0, 0, 0, 10, 0, 0, -20, 1, 1, 100); // Approaching
+		t.Set(1, 0, 0, 10, 0, 0, 20, 1, 1, 100); // Receding
+		t.Set(2, 0, 0, 10, 20, 0, 0, 1, 1, 100); // Passing sideways, no radial speed
+		t.Set(3, 0, 0, 10, 0, 0, -1000, 1, 1, 100); // Faster than the clamp
+
+		kernels[k](t.Batch, 4);
+
+		CHECK(Near(t.Batch.Doppler[0], SpeedOfSound / (SpeedOfSound - 20), 1e-5f));
+		CHECK(Near(t.Batch.Doppler[1], SpeedOfSound / (SpeedOfSound + 20), 1e-5f));
+		CHECK(Near(t.Batch.Doppler[2], 1, 1e-6f));
+		CHECK(Near(t.Batch.Doppler[3], 2, 1e-5f)); // Clamped to half the speed of sound
+
+		// Listener moving instead: towards the emitter raises pitch, away lowers it
+		for (int i = 0; i < 4; i++)
+			t.Set(i, 0, 0, 10, 0, 0, 0, 1, 1, 100);
+
+		t.Batch.ListenerVZ = 20;
+		kernels[k](t.Batch, 4);
+		CHECK(Near(t.Batch.Doppler[0], (SpeedOfSound + 20) / SpeedOfSound, 1e-5f));
+
+		t.Batch.ListenerVZ = -20;
+		kernels[k](t.Batch, 4);
+		CHECK(Near(t.Batch.Doppler[0], (SpeedOfSound - 20) / SpeedOfSound, 1e-5f));
+
+		// Factor 0 turns it off
+		t.Batch.DopplerFactor = 0;
+		kernels[k](t.Batch, 4);
+		CHECK(t.Batch.Doppler[0] == 1);
+	}
+}
+
+TEST(SpatialAudio, SimdAndScalarKernelsAgreeIncludingThePaddedTail)
+{
+	SpatialKernel simd = GetSimdKernel();
+	SpatialKernel scalar = SpatialAudio::GetScalarKernel();
+	unsigned int seed = 11;
+
+	for (int count = 1; count <= 39; count += 2)
+	{
+		TestBatch a;
+		TestBatch b;
+
+		for (int i = 0; i < count; i++)
+		{
+			float x = RandomFloat(&seed, 60), y = RandomFloat(&seed, 20), z = RandomFloat(&seed, 60);
+			float vx = RandomFloat(&seed, 100), vy = RandomFloat(&seed, 10), vz = RandomFloat(&seed, 100);
+			float gain = 0.5f + RandomFloat(&seed, 0.5f);
+			float minDistance = 1 + fabs(RandomFloat(&seed, 4));
+
+			a.Set(i, x, y, z, vx, vy, vz, gain, minDistance, 50);
+			b.Set(i, x, y, z, vx, vy, vz, gain, minDistance, 50);
+		}
+
+		a.Batch.ListenerVX = b.Batch.ListenerVX = 15;
+		a.Batch.ListenerX = b.Batch.ListenerX = 2;
+
+		// Rounded up like SpatialAudio::Update does
+		int padded = (count + 3) & ~3;
+		scalar(a.Batch, count);
+		simd(b.Batch, padded);
+
+		bool agrees = true;
+
+		for (int i = 0; i < count; i++)
+		{
+			agrees = agrees && Near(a.Batch.Attenuation[i], b.Batch.Attenuation[i], 1e-5f);
+			agrees = agrees && Near(a.Batch.Pan[i], b.Batch.Pan[i], 1e-5f);
+			agrees = agrees && Near(a.Batch.Doppler[i], b.Batch.Doppler[i], 1e-5f);
+		}
+
+		CHECK(agrees);
+
+		// Free slots in the tail come out silent and finite, nothing past the padding is touched
+		for (int i = count; i < padded; i++)
+		{
+			CHECK(b.Batch.Attenuation[i] == 0);
+			CHECK(b.Batch.Doppler[i] == b.Batch.Doppler[i]);
+			CHECK(b.Batch.Pan[i] == b.Batch.Pan[i]);
+		}
+
+		bool untouched = true;
+
+		for (int i = padded; i < BatchCapacity + 4; i++)
+			untouched = untouched && b.Batch.Attenuation[i] == Guard && b.Batch.Pan[i] == Guard && b.Batch.Doppler[i] == Guard;
+
+		CHECK(untouched);
+	}
+}
+
+TEST(SpatialAudio, ListenerOrientationDecidesTheEar)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 8, false);
+	SpatialAudio spatial(&mixer, 4, true);
+	SoundClip* clip = MakeClip(OutputRate);
+	double left, right;
+
+	EmitterHandle handle = spatial.AddEmitter(clip, MakeParams(0, true));
+	spatial.SetEmitterPosition(handle, 5, 0, 0, 0, 0, 0);
+
+	// Facing +Z, +X is on the right
+	spatial.Update(0.01f);
+	RenderEnergy(mixer, 2048, &left, &right);
+	CHECK(right > left * 10);
+
+	// Turned around, the same emitter is on the left
+	spatial.SetListener(0, 0, 0, 0, 0, 0, 0, 0, -1, 0, 1, 0);
+	spatial.Update(0.01f);
+	RenderEnergy(mixer, 2048, &left, &right); // Lets the gain ramp finish
+	RenderEnergy(mixer, 2048, &left, &right);
+	CHECK(left > right * 10);
+
+	clip->Release();
+}
+
+/* Ranking */
+
+TEST(SpatialAudio, PriorityBeatsLoudness)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 8, false);
+	SpatialAudio spatial(&mixer, 2, true);
+	SoundClip* clip = MakeClip(OutputRate);
+
+	EmitterHandle loud = spatial.AddEmitter(clip, MakeParams(0, true));
+	EmitterHandle quietImportant = spatial.AddEmitter(clip, MakeParams(1, true));
+	EmitterHandle medium = spatial.AddEmitter(clip, MakeParams(0, true));
+	EmitterHandle silent = spatial.AddEmitter(clip, MakeParams(5, true));
+
+	spatial.SetEmitterPosition(loud, 0, 0, 2, 0, 0, 0);
+	spatial.SetEmitterPosition(quietImportant, 0, 0, 60, 0, 0, 0);
+	spatial.SetEmitterPosition(medium, 0, 0, 10, 0, 0, 0);
+	spatial.SetEmitterPosition(silent, 0, 0, 500, 0, 0, 0); // Out of range, priority can't make it audible
+
+	spatial.Update(0.01f);
+
+	CHECK(spatial.IsEmitterReal(quietImportant));
+	CHECK(spatial.IsEmitterReal(loud));
+	CHECK(!spatial.IsEmitterReal(medium));
+	CHECK(!spatial.IsEmitterReal(silent));
+	CHECK(spatial.GetRealCount() == 2);
+	CHECK(spatial.GetVirtualCount() == 2);
+
+	clip->Release();
+}
+
+TEST(SpatialAudio, HysteresisKeepsVoicesFromThrashing)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 8, false);
+	SpatialAudio spatial(&mixer, 1, true);
+	SoundClip* clip = MakeClip(OutputRate);
+
+	EmitterHandle first = spatial.AddEmitter(clip, MakeParams(0, true));
+	EmitterHandle second = spatial.AddEmitter(clip, MakeParams(0, true));
+
+	spatial.SetEmitterPosition(first, 0, 0, 10, 0, 0, 0);
+	spatial.SetEmitterPosition(second, 0, 0, 10.5f, 0, 0, 0);
+	spatial.Update(0.01f);
+	REQUIRE(spatial.IsEmitterReal(first));
+
+	// Second wobbles around and slightly ahead of first, within the 25% bonus the real voice gets
+	int swaps = 0;
+
+	for (int i = 0; i < 20; i++)
+	{
+		spatial.SetEmitterPosition(second, 0, 0, i % 2 ? 9 : 10.5f, 0, 0, 0);
+		spatial.Update(0.01f);
+
+		swaps += spatial.IsEmitterReal(first) ? 0 : 1;
+	}
+
+	CHECK(swaps == 0);
+
+	// Clearly louder wins
+	spatial.SetEmitterPosition(second, 0, 0, 7, 0, 0, 0);
+	spatial.Update(0.01f);
+	CHECK(spatial.IsEmitterReal(second));
+	CHECK(!spatial.IsEmitterReal(first));
+
+	// And keeps the voice when the first comes back only slightly closer
+	spatial.SetEmitterPosition(first, 0, 0, 6, 0, 0, 0);
+	spatial.Update(0.01f);
+	CHECK(spatial.IsEmitterReal(second));
+
+	clip->Release();
+}
+
+/* Virtual voices */
+
+TEST(SpatialAudio, VirtualEmitterResumesWhereItWouldBe)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 8, false);
+	SpatialAudio spatial(&mixer, 1, true);
+	SoundClip* clip = MakeClip(OutputRate * 2);
+
+	EmitterHandle blocker = spatial.AddEmitter(clip, MakeParams(5, true));
+	EmitterHandle waiting = spatial.AddEmitter(clip, MakeParams(0, true));
+
+	spatial.SetEmitterPosition(blocker, 0, 0, 5, 0, 0, 0);
+	spatial.SetEmitterPosition(waiting, 0, 0, 5, 0, 0, 0);
+
+	for (int i = 0; i < 5; i++)
+		spatial.Update(0.1f);
+
+	CHECK(!spatial.IsEmitterReal(waiting));
+	CHECK(abs(spatial.GetEmitterFrame(waiting) - OutputRate / 2) <= 2);
+
+	// Promoted on the next update, starting where half a second and one more step of playback puts it
+	spatial.RemoveEmitter(blocker);
+	spatial.Update(0.1f);
+	REQUIRE(spatial.IsEmitterReal(waiting));
+
+	int start = spatial.GetEmitterFrame(waiting);
+	CHECK(abs(start - OutputRate * 6 / 10) <= 2);
+
+	// The real voice carries on from there
+	short out[4410 * 2];
+	mixer.Render(out, 4410);
+	spatial.Update(0.1f);
+	CHECK(abs(spatial.GetEmitterFrame(waiting) - (start + 4410)) <= 2);
+
+	clip->Release();
+}
+
+TEST(SpatialAudio, VirtualCursorWrapsWhenLooping)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 8, false);
+	SpatialAudio spatial(&mixer, 1, true);
+	SoundClip* clip = MakeClip(OutputRate / 10);
+
+	EmitterHandle blocker = spatial.AddEmitter(clip, MakeParams(5, true));
+	EmitterHandle looping = spatial.AddEmitter(clip, MakeParams(0, true));
+
+	spatial.SetEmitterPosition(looping, 0, 0, 5, 0, 0, 0);
+
+	spatial.Update(0.25f); // Two and a half times the clip
+	CHECK(!spatial.IsEmitterFinished(looping));
+	CHECK(abs(spatial.GetEmitterFrame(looping) - OutputRate / 20) <= 2);
+
+	spatial.RemoveEmitter(blocker);
+	clip->Release();
+}
+
+TEST(SpatialAudio, NonLoopingEmitterFinishesWhileVirtual)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 8, false);
+	SpatialAudio spatial(&mixer, 1, true);
+	SoundClip* loop = MakeClip(OutputRate);
+	SoundClip* shot = MakeClip(OutputRate / 10);
+
+	EmitterHandle blocker = spatial.AddEmitter(loop, MakeParams(5, true));
+	EmitterHandle once = spatial.AddEmitter(shot, MakeParams(0, false));
+
+	spatial.SetEmitterPosition(once, 0, 0, 3, 0, 0, 0);
+
+	spatial.Update(0.05f);
+	CHECK(!spatial.IsEmitterFinished(once));
+	CHECK(spatial.GetVirtualCount() == 1);
+
+	spatial.Update(0.06f);
+	CHECK(spatial.IsEmitterFinished(once));
+	CHECK(spatial.GetVirtualCount() == 0);
+
+	// A free voice doesn't bring it back
+	spatial.RemoveEmitter(blocker);
+	spatial.Update(0.01f);
+	CHECK(!spatial.IsEmitterReal(once));
+	CHECK(spatial.GetRealCount() == 0);
+	CHECK(spatial.GetEmitterCount() == 1); // Finished, but still there until removed
+
+	loop->Release();
+	shot->Release();
+}
+
+/* Handles */
+
+TEST(SpatialAudio, StaleHandlesDontReachTheNextEmitter)
+{
+	NullAudioSink sink(OutputRate, 1024);
+	AudioMixer mixer(&sink, 8, false);
+	SpatialAudio spatial(&mixer, 4, true);
+	SoundClip* clip = MakeClip(OutputRate);
+
+	EmitterHandle old = spatial.AddEmitter(clip, MakeParams(0, true));
+	spatial.SetEmitterPosition(old, 0, 0, 5, 0, 0, 0);
+	spatial.Update(0.01f);
+	REQUIRE(spatial.IsEmitterReal(old));
+
+	spatial.RemoveEmitter(old);
+	CHECK(mixer.GetActiveVoiceCount() == 0); // Its voice went with it
+
+	EmitterHandle reused = spatial.AddEmitter(clip, MakeParams(0, true));
+	REQUIRE(reused != 0);
+	CHECK(reused != old);
+	CHECK((reused & 1023) == (old & 1023)); // Same slot, newer generation
+
+	spatial.SetEmitterPosition(reused, 0, 0, 5, 0, 0, 0);
+
+	// None of these may reach the new emitter
+	spatial.SetEmitterPosition(old, 0, 0, 500, 0, 0, 0);
+	spatial.SetEmitterGain(old, 0);
+	spatial.RemoveEmitter(old);
+
+	spatial.Update(0.01f);
+
+	CHECK(spatial.IsEmitterReal(reused));
+	CHECK(!spatial.IsEmitterReal(old));
+	CHECK(spatial.IsEmitterFinished(old));
+	CHECK(spatial.GetEmitterFrame(old) == -1);
+	CHECK(spatial.GetEmitterCount() == 1);
+
+	CHECK(!spatial.IsEmitterReal(0));
+	CHECK(spatial.AddEmitter(0, MakeParams(0, true)) == 0);
+
+	clip->Release();
+}
@@ -0,0 +1,426 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "StreamSource.h"
+#include "AudioMixer.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Audio;
+
+// WAVE parsing and the decode/refill ring of streamed music, fed from memory so no files are needed
+
+/* Helpers */
+
+static void WriteUInt(unsigned char* p, unsigned int value)
+{
+	p[0] = (unsigned char)value;
+	p[1] = (unsigned char)(value >> 8);
+	p[2] = (unsigned char)(value >> 16);
+	p[3] = (unsigned char)(value >> 24);
+}
+
+static void WriteUShort(unsigned char* p, unsigned int value)
+{
+	p[0] = (unsigned char)value;
+	p[1] = (unsigned char)(value >> 8);
+}
+
+// Builds a minimal RIFF WAVE in memory, fmt fields are taken as given so malformed headers can be made too
+struct WaveFile
+{
+	unsigned char* Data;
+	unsigned int Size;
+
+	WaveFile(int formatTag, int channels, int blockAlign, int bitsPerSample, const void* samples, unsigned int bytes)
+	{
+		int fmtSize = formatTag == WaveFormatImaAdpcm ? 20 : 16;
+
+		Size = 12 + 8 + fmtSize + 8 + bytes + (bytes & 1);
+		Data = (unsigned char*)calloc(Size, 1);
+
+		memcpy(Data, "RIFF", 4);
+		WriteUInt(Data + 4, Size - 8);
+		memcpy(Data + 8, "WAVE", 4);
+
+		unsigned char* fmt = Data + 12;
+		memcpy(fmt, "fmt ", 4);
+		WriteUInt(fmt + 4, fmtSize);
+		WriteUShort(fmt + 8, formatTag);
+		WriteUShort(fmt + 10, channels);
+		WriteUInt(fmt + 12, 22050);
+		WriteUInt(fmt + 16, 22050 * blockAlign);
+		WriteUShort(fmt + 20, blockAlign);
+		WriteUShort(fmt + 22, bitsPerSample);
+
+		if (formatTag == WaveFormatImaAdpcm)
+		{
+			WriteUShort(fmt + 24, 2);
+			WriteUShort(fmt + 26, 0); // Samples per block derived from block size
+		}
+
+		unsigned char* data = fmt + 8 + fmtSize;
+		memcpy(data, "data", 4);
+		WriteUInt(data + 4, bytes);
+		memcpy(data + 8, samples, bytes);
+	}
+
+	~WaveFile()
+	{
+		free(Data);
+	}
+};
+
+// Every sample differs from its neighbours, so a dropped, repeated or shifted frame changes the sequence
+static short* MakeRamp(int frames, int channels)
+{
+	short* samples = (short*)malloc(sizeof(short) * frames * channels);
+
+	for (int i = 0; i < frames; i++)
+	{
+		for (int c = 0; c < channels; c++)
+			samples[i * channels + c] = (short)(i * 7 + c * 3001);
+	}
+
+	return samples;
+}
+
+// Reads the whole stream in uneven chunks, refilling by hand like a mixer without decoder thread
+static int ReadAll(StreamSource* stream, short* dst, int maxFrames)
+{
+	int total = 0;
+	int chunk = 1;
+
+	stream->Refill();
+
+	while (!stream->IsFinished() && total < maxFrames)
+	{
+		int frames = maxFrames - total < chunk ? maxFrames - total : chunk;
+		int count = stream->Read(dst + total * stream->GetChannels(), frames);
+
+		total += count;
+
+		if (count < frames)
+			stream->Refill();
+
+		chunk = chunk * 3 % 1531 + 1;
+	}
+
+	return total;
+}
+
+/* Parsing */
+
+TEST(StreamSource, ParsesPcmHeader)
+{
+	short* samples = MakeRamp(1000, 2);
+	WaveFile wave(WaveFormatPcm, 2, 4, 16, samples, 1000 * 4);
+	WaveInfo info;
+
+	REQUIRE(ParseWave(wave.Data, wave.Size, info));
+
+	CHECK(info.FormatTag == WaveFormatPcm);
+	CHECK(info.Channels == 2);
+	CHECK(info.SampleRate == 22050);
+	CHECK(info.FrameCount == 1000);
+	CHECK(info.DataBytes == 4000);
+
+	// Truncated file, data chunk is clamped to what's there
+	REQUIRE(ParseWave(wave.Data, wave.Size - 400, info));
+	CHECK(info.FrameCount == 900);
+
+	free(samples);
+}
+
+TEST(StreamSource, RejectsBlockAlignThatDisagreesWithFrameSize)
+{
+	short* samples = MakeRamp(1000, 2);
+	WaveInfo info;
+
+	// Claimed 1 byte frames of 16-bit stereo would make the decoder read four times the data
+	WaveFile narrow(WaveFormatPcm, 2, 1, 16, samples, 1000 * 4);
+	CHECK(!ParseWave(narrow.Data, narrow.Size, info));
+	CHECK(StreamSource::OpenMemory(narrow.Data, narrow.Size, false, 4096, false) == 0);
+
+	WaveFile wide(WaveFormatPcm, 2, 8, 16, samples, 1000 * 4);
+	CHECK(!ParseWave(wide.Data, wide.Size, info));
+
+	WaveFile monoAsStereo(WaveFormatPcm, 2, 2, 16, samples, 1000 * 4);
+	CHECK(!ParseWave(monoAsStereo.Data, monoAsStereo.Size, info));
+
+	WaveFile floatNarrow(WaveFormatFloat, 2, 4, 32, samples, 1000 * 4);
+	CHECK(!ParseWave(floatNarrow.Data, floatNarrow.Size, info));
+	CHECK(StreamSource::OpenMemory(floatNarrow.Data, floatNarrow.Size, false, 4096, false) == 0);
+
+	WaveFile noBits(WaveFormatPcm, 1, 2, 0, samples, 1000 * 4);
+	CHECK(!ParseWave(noBits.Data, noBits.Size, info));
+
+	// Too small to hold the per-channel headers of an ADPCM block
+	WaveFile imaMono(WaveFormatImaAdpcm, 1, 4, 4, samples, 1000 * 4);
+	CHECK(!ParseWave(imaMono.Data, imaMono.Size, info));
+
+	WaveFile imaStereo(WaveFormatImaAdpcm, 2, 8, 4, samples, 1000 * 4);
+	CHECK(!ParseWave(imaStereo.Data, imaStereo.Size, info));
+	CHECK(StreamSource::OpenMemory(imaStereo.Data, imaStereo.Size, false, 4096, false) == 0);
+
+	WaveFile imaSmallest(WaveFormatImaAdpcm, 1, 5, 4, samples, 1000 * 4);
+	CHECK(ParseWave(imaSmallest.Data, imaSmallest.Size, info));
+
+	// Still accepted: the well formed versions of the same data
+	WaveFile good(WaveFormatPcm, 2, 4, 16, samples, 1000 * 4);
+	CHECK(ParseWave(good.Data, good.Size, info));
+
+	WaveFile goodFloat(WaveFormatFloat, 2, 8, 32, samples, 1000 * 4);
+	CHECK(ParseWave(goodFloat.Data, goodFloat.Size, info));
+
+	free(samples);
+}
+
+TEST(StreamSource, RejectsNonWaveData)
+{
+	WaveInfo info;
+	unsigned char junk[64];
+
+	memset(junk, 0x41, sizeof(junk));
+
+	CHECK(!ParseWave(junk, sizeof(junk), info));
+	CHECK(!ParseWave(0, 0, info));
+	CHECK(StreamSource::OpenMemory(junk, sizeof(junk), false, 4096, false) == 0);
+}
+
+/* Decoding */
+
+TEST(StreamSource, DecodesPcm16ThroughWrappingRing)
+{
+	const int Frames = 20000; // Several times the ring
+
+	short* samples = MakeRamp(Frames, 2);
+	short* out = (short*)malloc(sizeof(short) * Frames * 2);
+	WaveFile wave(WaveFormatPcm, 2, 4, 16, samples, Frames * 4);
+
+	StreamSource* stream = StreamSource::OpenMemory(wave.Data, wave.Size, false, 4096, false);
+	REQUIRE(stream);
+
+	CHECK(stream->GetBufferedFrames() == 0); // Nothing until Refill without thread
+	CHECK(ReadAll(stream, out, Frames) == Frames);
+	CHECK(stream->IsFinished());
+	CHECK(memcmp(out, samples, sizeof(short) * Frames * 2) == 0);
+
+	// Nothing more after the end
+	CHECK(stream->Read(out, 100) == 0);
+
+	stream->Release();
+	free(samples);
+	free(out);
+}
+
+TEST(StreamSource, Decodes8BitAndFloat)
+{
+	const int Frames = 3000;
+
+	unsigned char* bytes = (unsigned char*)malloc(Frames);
+	float* floats = (float*)malloc(sizeof(float) * Frames);
+	short* out = (short*)malloc(sizeof(short) * Frames);
+
+	for (int i = 0; i < Frames; i++)
+	{
+		bytes[i] = (unsigned char)i;
+		floats[i] = (i % 5 - 2) * 0.6f; // Past full scale at the ends
+	}
+
+	WaveFile pcm8(WaveFormatPcm, 1, 1, 8, bytes, Frames);
+	StreamSource* stream = StreamSource::OpenMemory(pcm8.Data, pcm8.Size, false, 4096, false);
+	REQUIRE(stream);
+
+	CHECK(ReadAll(stream, out, Frames) == Frames);
+
+	for (int i = 0; i < Frames; i++)
+		CHECK(out[i] == (short)((bytes[i] - 128) << 8));
+
+	stream->Release();
+
+	WaveFile pcmFloat(WaveFormatFloat, 1, 4, 32, floats, Frames * 4);
+	stream = StreamSource::OpenMemory(pcmFloat.Data, pcmFloat.Size, false, 4096, false);
+	REQUIRE(stream);
+
+	CHECK(ReadAll(stream, out, Frames) == Frames);
+	CHECK(out[0] == -32768);
+	CHECK(out[1] == (short)(int)(-0.6f * 32767.0f));
+	CHECK(out[2] == 0);
+	CHECK(out[4] == 32767);
+
+	stream->Release();
+	free(bytes);
+	free(floats);
+	free(out);
+}
+
+TEST(StreamSource, TrailingPartialFrameIsIgnored)
+{
+	short* samples = MakeRamp(1001, 2);
+	short* out = (short*)malloc(sizeof(short) * 1001 * 2);
+	WaveFile wave(WaveFormatPcm, 2, 4, 16, samples, 1000 * 4 + 3);
+
+	StreamSource* stream = StreamSource::OpenMemory(wave.Data, wave.Size, false, 4096, false);
+	REQUIRE(stream);
+
+	CHECK(stream->GetFrameCount() == 1000);
+	CHECK(ReadAll(stream, out, 1001) == 1000);
+	CHECK(memcmp(out, samples, sizeof(short) * 1000 * 2) == 0);
+
+	stream->Release();
+	free(samples);
+	free(out);
+}
+
+TEST(StreamSource, LoopingStreamRestartsSeamlessly)
+{
+	const int Frames = 1500; // Not a multiple of the decode block
+	const int Loops = 5;
+
+	short* samples = MakeRamp(Frames, 1);
+	short* out = (short*)malloc(sizeof(short) * Frames * Loops);
+	WaveFile wave(WaveFormatPcm, 1, 2, 16, samples, Frames * 2);
+
+	StreamSource* stream = StreamSource::OpenMemory(wave.Data, wave.Size, true, 4096, false);
+	REQUIRE(stream);
+
+	CHECK(ReadAll(stream, out, Frames * Loops) == Frames * Loops);
+	CHECK(!stream->IsFinished());
+
+	int wrong = 0;
+
+	for (int i = 0; i < Frames * Loops; i++)
+	{
+		if (out[i] != samples[i % Frames])
+			wrong++;
+	}
+
+	CHECK(wrong == 0);
+
+	stream->Release();
+	free(samples);
+	free(out);
+}
+
+TEST(StreamSource, ImaAdpcmMatchesClipDecoder)
+{
+	const int BlockAlign = 256;
+	const int Bytes = BlockAlign * 40 + 100; // Partial last block
+
+	unsigned char* adpcm = (unsigned char*)malloc(Bytes);
+	unsigned int seed = 3;
+
+	for (int i = 0; i < Bytes; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		adpcm[i] = (unsigned char)(seed >> 16);
+	}
+
+	for (int channels = 1; channels <= 2; channels++)
+	{
+		SoundClip* clip = SoundClip::CreateImaAdpcm(adpcm, Bytes, channels, 22050, BlockAlign);
+		REQUIRE(clip);
+
+		WaveFile wave(WaveFormatImaAdpcm, channels, BlockAlign, 4, adpcm, Bytes);
+		StreamSource* stream = StreamSource::OpenMemory(wave.Data, wave.Size, false, 2048, false);
+		REQUIRE(stream);
+
+		int frames = clip->GetFrameCount();
+		short* out = (short*)malloc(sizeof(short) * (frames + 100) * channels);
+
+		CHECK(stream->GetFrameCount() == frames);
+		CHECK(ReadAll(stream, out, frames + 100) == frames);
+		CHECK(memcmp(out, clip->GetData(), sizeof(short) * frames * channels) == 0);
+
+		stream->Release();
+		clip->Release();
+		free(out);
+	}
+
+	free(adpcm);
+}
+
+/* Refill thread */
+
+TEST(StreamSource, DecoderThreadKeepsUpWithReader)
+{
+	const int Frames = 200000;
+
+	short* samples = MakeRamp(Frames, 2);
+	short* out = (short*)malloc(sizeof(short) * Frames * 2);
+	WaveFile wave(WaveFormatPcm, 2, 4, 16, samples, Frames * 4);
+
+	for (int round = 0; round < 3; round++)
+	{
+		StreamSource* stream = StreamSource::OpenMemory(wave.Data, wave.Size, false, 4096, true);
+		REQUIRE(stream);
+
+		int total = 0;
+		int idle = 0;
+
+		// Mixer-sized reads, the consumer never refills itself so every frame past the first ring comes from the thread
+		while (!stream->IsFinished() && idle < 5000)
+		{
+			int count = stream->Read(out + total * 2, Frames - total < 512 ? Frames - total : 512);
+
+			total += count;
+
+			if (count == 0)
+			{
+				idle++;
+				Platform::SleepMs(1);
+			}
+			else
+			{
+				idle = 0;
+			}
+		}
+
+		CHECK(total == Frames);
+		CHECK(stream->IsFinished());
+		CHECK(memcmp(out, samples, sizeof(short) * Frames * 2) == 0);
+
+		stream->Release();
+	}
+
+	free(samples);
+	free(out);
+}
+
+TEST(StreamSource, MixerPlaysStreamToTheEnd)
+{
+	const int Frames = 30000;
+
+	short* samples = MakeRamp(Frames, 1);
+	short* out = (short*)malloc(sizeof(short) * 2 * 1024);
+	WaveFile wave(WaveFormatPcm, 1, 2, 16, samples, Frames * 2);
+	NullAudioSink sink(22050, 1024);
+	AudioMixer mixer(&sink, 4, true);
+
+	StreamSource* stream = StreamSource::OpenMemory(wave.Data, wave.Size, false, 4096, true);
+	REQUIRE(stream);
+
+	VoiceParams params;
+	params.Pitch = 1.5f; // Interpolating path, reads ahead and carries frames between blocks
+	VoiceHandle handle = mixer.Play(stream, params);
+
+	int blocks = 0;
+
+	while (mixer.IsPlaying(handle) && blocks < 10000)
+	{
+		mixer.Render(out, 1024);
+		blocks++;
+
+		if (stream->GetBufferedFrames() < 2048)
+			Platform::SleepMs(1);
+	}
+
+	CHECK(!mixer.IsPlaying(handle));
+	CHECK(blocks >= Frames / 1536);
+	CHECK(stream->IsFinished());
+
+	stream->Release();
+	free(samples);
+	free(out);
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "Test.h"
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Tests
+	{
+		struct TestEntry
+		{
+			const char* Group;
+			const char* Name;
+			TestFunction Function;
+		};
+
+		static const int MaxTests = 256;
+
+		static TestEntry tests[MaxTests];
+		static int testCount;
+		static int failureCount;
+		static const TestEntry* currentTest;
+
+		TestRegistration::TestRegistration(const char* group, const char* name, TestFunction function)
+		{
+			if (testCount == MaxTests)
+			{
+				fprintf(stderr, "Too many tests, raise MaxTests in Test.cpp\n");
+				return;
+			}
+
+			tests[testCount].Group = group;
+			tests[testCount].Name = name;
+			tests[testCount].Function = function;
+			testCount++;
+		}
+
+		void Fail(const char* file, int line, const char* expression)
+		{
+			failureCount++;
+			printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+		}
+
+		const char* GetScratchPath(const char* suffix)
+		{
+			static char path[256];
+
+			sprintf(path, "dx6tests.%s.%s.%s", currentTest ? currentTest->Group : "", currentTest ? currentTest->Name : "", suffix);
+
+			return path;
+		}
+
+		static bool Matches(const TestEntry& test, const char* filter)
+		{
+			char fullName[128];
+			sprintf(fullName, "%s.%s", test.Group, test.Name);
+
+			return !filter || strstr(fullName, filter);
+		}
+	}
+}
+
+using namespace DXSharp;
+using namespace DXSharp::Tests;
+
+// DX6Tests [filter] - runs tests whose "Group.Name" contains filter, exit code 1 if any failed
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : 0;
+	int ran = 0;
+	int failedTests = 0;
+
+	for (int i = 0; i < testCount; i++)
+	{
+		if (!Matches(tests[i], filter))
+			continue;
+
+		int failuresBefore = failureCount;
+		Platform::UInt64 start = Platform::GetPerformanceCounter();
+
+		printf("%s.%s\n", tests[i].Group, tests[i].Name);
+		fflush(stdout);
+
+		currentTest = &tests[i];
+		tests[i].Function();
+		currentTest = 0;
+
+		double ms = (double)(Platform::GetPerformanceCounter() - start) * 1000.0 / (double)Platform::GetPerformanceFrequency();
+
+		if (failureCount != failuresBefore)
+		{
+			printf("  FAILED (%.0fms)\n", ms);
+			failedTests++;
+		}
+		else
+		{
+			printf("  ok (%.0fms)\n", ms);
+		}
+
+		ran++;
+	}
+
+	printf("\n%d of %d tests passed\n", ran - failedTests, ran);
+
+	return failedTests > 0 || ran == 0 ? 1 : 0;
+}
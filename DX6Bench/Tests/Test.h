@@ -0,0 +1,41 @@
+#pragma once
+
+// Minimal test harness for the native cores, built by "make test" in DX6Bench.
+//
+//   TEST(JobSystem, ParallelForCoversRange)
+//   {
+//       CHECK(sum == expected);
+//   }
+
+namespace DXSharp
+{
+	namespace Tests
+	{
+		typedef void (*TestFunction)();
+
+		// Adds a test to the list main() runs, used by TEST at static initialization
+		class TestRegistration
+		{
+		public:
+			TestRegistration(const char* group, const char* name, TestFunction function);
+		};
+
+		// Marks the running test as failed. Checks keep going, so one run shows every broken expectation.
+		void Fail(const char* file, int line, const char* expression);
+
+		// Path for scratch files, unique per test so tests can't see each other's leftovers
+		const char* GetScratchPath(const char* suffix);
+	}
+}
+
+#define TEST(group, name) \
+	static void group##_##name(); \
+	static DXSharp::Tests::TestRegistration group##_##name##_registration(#group, #name, group##_##name); \
+	static void group##_##name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) DXSharp::Tests::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+// Leaves the test on failure, for checks later code depends on (null pointers, sizes)
+#define REQUIRE(expression) \
+	do { if (!(expression)) { DXSharp::Tests::Fail(__FILE__, __LINE__, #expression); return; } } while (0)
@@ -0,0 +1,337 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "TransientVertexRing.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Rendering;
+
+// Linear allocation, wrapping and fencing on the memory backend, plus a simulated render thread that reads vertices late
+
+/* Helpers */
+
+// Memory backend that remembers how it was locked
+class RecordingStorage : public MemoryVertexRingStorage
+{
+public:
+	int Locks;
+	int Discards;
+	int NestedLocks;
+	int LastFirst;
+	int LastCount;
+	bool LastDiscard;
+	bool IsLocked;
+
+	RecordingStorage(int vertexSize, int capacity)
+		: MemoryVertexRingStorage(vertexSize, capacity)
+	{
+		Locks = 0;
+		Discards = 0;
+		NestedLocks = 0;
+		LastFirst = -1;
+		LastCount = -1;
+		LastDiscard = false;
+		IsLocked = false;
+	}
+
+	virtual void* Lock(int firstVertex, int vertexCount, bool discard)
+	{
+		if (IsLocked)
+			NestedLocks++;
+
+		Locks++;
+		Discards += discard ? 1 : 0;
+		LastFirst = firstVertex;
+		LastCount = vertexCount;
+		LastDiscard = discard;
+		IsLocked = true;
+
+		return MemoryVertexRingStorage::Lock(firstVertex, vertexCount, discard);
+	}
+
+	virtual void Unlock()
+	{
+		IsLocked = false;
+		MemoryVertexRingStorage::Unlock();
+	}
+};
+
+// A draw recorded in one frame and read back frames later, like the render thread replaying a list
+struct PendingDraw
+{
+	int* Data;
+	int Count;
+	long Fence;
+};
+
+struct PipelineStats
+{
+	int Draws;
+	int Failed;
+	int Corrupted; // Draws whose vertices changed before they were read
+};
+
+const int FrameSlots = 16;
+const int DrawsPerFrame = 3;
+
+static unsigned int NextRandom(unsigned int* seed)
+{
+	*seed = *seed * 1664525 + 1013904223;
+	return *seed >> 8;
+}
+
+// Each frame allocates a few draws stamped with its fence. The simulated GPU reads frame (f - gpuLatency) and checks
+// the stamps, then the ring is told frames up to (f - retireLatency) are done. Retiring ahead of the GPU is the bug.
+static void RunPipeline(TransientVertexRing* ring, int frames, int gpuLatency, int retireLatency, unsigned int seed, PipelineStats* stats)
+{
+	PendingDraw pending[FrameSlots][DrawsPerFrame];
+	int pendingCount[FrameSlots];
+
+	memset(stats, 0, sizeof(*stats));
+	memset(pendingCount, 0, sizeof(pendingCount));
+
+	for (long frame = 1; frame <= frames + gpuLatency; frame++)
+	{
+		int slot = frame % FrameSlots;
+		pendingCount[slot] = 0;
+
+		if (frame <= frames)
+		{
+			int draws = 1 + NextRandom(&seed) % DrawsPerFrame;
+
+			for (int i = 0; i < draws; i++)
+			{
+				TransientVertexRing::Allocation allocation;
+				int count = 1 + NextRandom(&seed) % (ring->GetCapacity() / 4);
+
+				if (!ring->Allocate(count, frame, &allocation))
+				{
+					stats->Failed++;
+					continue;
+				}
+
+				int* vertices = (int*)allocation.Data;
+
+				for (int v = 0; v < count; v++)
+					vertices[v] = (int)frame;
+
+				PendingDraw& draw = pending[slot][pendingCount[slot]++];
+				draw.Data = vertices;
+				draw.Count = count;
+				draw.Fence = frame;
+				stats->Draws++;
+			}
+
+			ring->Commit();
+		}
+
+		long drawn = frame - gpuLatency;
+
+		if (drawn >= 1)
+		{
+			int drawnSlot = drawn % FrameSlots;
+
+			for (int i = 0; i < pendingCount[drawnSlot]; i++)
+			{
+				PendingDraw& draw = pending[drawnSlot][i];
+
+				for (int v = 0; v < draw.Count; v++)
+				{
+					if (draw.Data[v] != (int)draw.Fence)
+					{
+						stats->Corrupted++;
+						break;
+					}
+				}
+			}
+		}
+
+		ring->Retire(frame - retireLatency);
+	}
+}
+
+/* Allocation */
+
+TEST(TransientVertexRing, AllocatesLinearlyWithinALap)
+{
+	RecordingStorage* storage = new RecordingStorage(sizeof(int), 100);
+	TransientVertexRing ring(storage, sizeof(int), 100);
+	TransientVertexRing::Allocation first, second;
+
+	REQUIRE(ring.Allocate(10, 1, &first));
+	CHECK(first.FirstVertex == 0);
+	CHECK(first.VertexCount == 10);
+	CHECK(storage->LastDiscard); // First lock of a fresh buffer discards
+	CHECK(storage->IsLocked);
+
+	REQUIRE(ring.Allocate(20, 1, &second));
+	CHECK(second.FirstVertex == 10);
+	CHECK((unsigned char*)second.Data == (unsigned char*)first.Data + 10 * sizeof(int));
+	CHECK(!storage->LastDiscard);
+	CHECK(storage->NestedLocks == 0); // Allocate unlocked the previous range first
+
+	ring.Commit();
+	CHECK(!storage->IsLocked);
+	ring.Commit(); // Nothing left to unlock
+	CHECK(storage->Locks == 2);
+
+	CHECK(ring.GetUsedCount() == 30);
+	CHECK(ring.GetWrapCount() == 0);
+	CHECK(ring.GetFailedCount() == 0);
+}
+
+TEST(TransientVertexRing, RejectsBadSizes)
+{
+	TransientVertexRing ring(new MemoryVertexRingStorage(sizeof(int), 100), sizeof(int), 100);
+	TransientVertexRing::Allocation allocation;
+
+	CHECK(!ring.Allocate(0, 1, &allocation));
+	CHECK(!ring.Allocate(-5, 1, &allocation));
+	CHECK(!ring.Allocate(101, 1, &allocation));
+	CHECK(ring.GetFailedCount() == 3);
+	CHECK(ring.GetUsedCount() == 0);
+
+	CHECK(ring.Allocate(100, 1, &allocation)); // Whole buffer in one go is fine
+	CHECK(ring.GetUsedCount() == 100);
+}
+
+/* Wrapping */
+
+TEST(TransientVertexRing, WrapSkipsTheTailAndDiscards)
+{
+	RecordingStorage* storage = new RecordingStorage(sizeof(int), 100);
+	TransientVertexRing ring(storage, sizeof(int), 100);
+	TransientVertexRing::Allocation allocation;
+
+	REQUIRE(ring.Allocate(60, 1, &allocation));
+	ring.Retire(1);
+	REQUIRE(ring.Allocate(30, 2, &allocation));
+	CHECK(allocation.FirstVertex == 60);
+	CHECK(!storage->LastDiscard);
+
+	// 20 don't fit in the 10 left at the end, so they start over at 0
+	REQUIRE(ring.Allocate(20, 3, &allocation));
+	CHECK(allocation.FirstVertex == 0);
+	CHECK(storage->LastDiscard);
+	CHECK(ring.GetWrapCount() == 1);
+	CHECK(ring.GetUsedCount() == 60); // Frame 2, the skipped tail and frame 3
+
+	ring.Retire(2);
+	CHECK(ring.GetUsedCount() == 30);
+	ring.Retire(3);
+	CHECK(ring.GetUsedCount() == 0);
+}
+
+TEST(TransientVertexRing, EndingExactlyAtTheEndStillDiscardsNextLap)
+{
+	RecordingStorage* storage = new RecordingStorage(sizeof(int), 100);
+	TransientVertexRing ring(storage, sizeof(int), 100);
+	TransientVertexRing::Allocation allocation;
+
+	REQUIRE(ring.Allocate(40, 0, &allocation));
+	REQUIRE(ring.Allocate(60, 0, &allocation));
+	CHECK(allocation.FirstVertex == 40);
+	ring.Retire(0);
+
+	// No tail to skip, but the driver may still be drawing from the start of the buffer
+	REQUIRE(ring.Allocate(10, 0, &allocation));
+	CHECK(allocation.FirstVertex == 0);
+	CHECK(storage->LastDiscard);
+	CHECK(ring.GetWrapCount() == 1);
+	CHECK(ring.GetUsedCount() == 10);
+}
+
+/* Fences */
+
+TEST(TransientVertexRing, FullRingFailsUntilAFrameRetires)
+{
+	TransientVertexRing ring(new MemoryVertexRingStorage(sizeof(int), 100), sizeof(int), 100);
+	TransientVertexRing::Allocation allocation;
+
+	REQUIRE(ring.Allocate(60, 1, &allocation));
+	REQUIRE(ring.Allocate(40, 2, &allocation));
+
+	CHECK(!ring.Allocate(10, 3, &allocation)); // Would land on frame 1
+	CHECK(ring.GetFailedCount() == 1);
+
+	ring.Retire(1);
+
+	REQUIRE(ring.Allocate(10, 3, &allocation));
+	CHECK(allocation.FirstVertex == 0);
+	REQUIRE(ring.Allocate(50, 3, &allocation)); // Right up to where frame 2 starts
+	CHECK(allocation.FirstVertex == 10);
+	CHECK(!ring.Allocate(1, 3, &allocation));
+	CHECK(ring.GetUsedCount() == 100);
+
+	ring.Retire(2);
+	CHECK(ring.Allocate(1, 3, &allocation));
+}
+
+TEST(TransientVertexRing, FrameCountIsLimitedByFences)
+{
+	TransientVertexRing ring(new MemoryVertexRingStorage(sizeof(int), 100), sizeof(int), 100);
+	TransientVertexRing::Allocation allocation;
+
+	for (int i = 1; i <= TransientVertexRing::MaxFences; i++)
+		CHECK(ring.Allocate(1, i, &allocation));
+
+	CHECK(ring.Allocate(1, TransientVertexRing::MaxFences, &allocation)); // Same frame adds to its fence
+	CHECK(!ring.Allocate(1, TransientVertexRing::MaxFences + 1, &allocation));
+	CHECK(ring.GetFailedCount() == 1);
+
+	ring.Retire(1);
+	CHECK(ring.GetUsedCount() == TransientVertexRing::MaxFences);
+	CHECK(ring.Allocate(1, TransientVertexRing::MaxFences + 1, &allocation));
+}
+
+TEST(TransientVertexRing, RetireCoversEveryOlderFrame)
+{
+	TransientVertexRing ring(new MemoryVertexRingStorage(sizeof(int), 100), sizeof(int), 100);
+	TransientVertexRing::Allocation allocation;
+
+	REQUIRE(ring.Allocate(10, 1, &allocation));
+	REQUIRE(ring.Allocate(10, 2, &allocation));
+	REQUIRE(ring.Allocate(10, 5, &allocation)); // Fence ids may skip
+	REQUIRE(ring.Allocate(10, 6, &allocation));
+
+	ring.Retire(0);
+	CHECK(ring.GetUsedCount() == 40);
+
+	ring.Retire(4);
+	CHECK(ring.GetUsedCount() == 20);
+
+	ring.Retire(2); // Going back doesn't undo anything
+	CHECK(ring.GetUsedCount() == 20);
+
+	ring.Retire(100);
+	CHECK(ring.GetUsedCount() == 0);
+}
+
+/* Pipeline */
+
+TEST(TransientVertexRing, LateReadsNeverSeeOverwrittenVertices)
+{
+	TransientVertexRing ring(new MemoryVertexRingStorage(sizeof(int), 256), sizeof(int), 256);
+	PipelineStats stats;
+
+	RunPipeline(&ring, 5000, 3, 3, 1, &stats);
+
+	CHECK(stats.Corrupted == 0);
+	CHECK(stats.Draws > 5000);
+	CHECK(stats.Failed > 0); // Small ring, so it did run full and had to refuse
+	CHECK(ring.GetWrapCount() > 100);
+	CHECK(ring.GetUsedCount() == 0);
+}
+
+TEST(TransientVertexRing, RetiringAheadOfTheReaderIsCaught)
+{
+	TransientVertexRing ring(new MemoryVertexRingStorage(sizeof(int), 256), sizeof(int), 256);
+	PipelineStats stats;
+
+	// Retires each frame as soon as it's recorded while reads still lag by three frames
+	RunPipeline(&ring, 5000, 3, 0, 1, &stats);
+
+	CHECK(stats.Corrupted > 0);
+	CHECK(stats.Failed == 0); // Nothing ever looked in flight, so the ring had no reason to refuse
+}
@@ -0,0 +1,239 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Test.h"
+#include "VertexFormats.h"
+
+using namespace DXSharp;
+using namespace DXSharp::Rendering;
+
+// Compile-time and runtime layouts must agree, and so must the two ConvertVertices that are built on them
+
+/* Helpers */
+
+const int Count = 7;
+
+// Every byte different, so an element copied from the wrong offset can't go unnoticed
+static void FillPattern(void* vertices, int bytes, int seed)
+{
+	unsigned char* p = (unsigned char*)vertices;
+
+	for (int i = 0; i < bytes; i++)
+		p[i] = (unsigned char)(seed + i * 7);
+}
+
+static bool LayoutMatches(const VertexFormatInfo& info, int size, int normal, int diffuse, int specular, int texCount, int tex0, int tex1)
+{
+	return info.Size == size && info.NormalOffset == normal && info.DiffuseOffset == diffuse && info.SpecularOffset == specular &&
+		info.TexCount == texCount && info.TexOffset[0] == tex0 && info.TexOffset[1] == tex1;
+}
+
+template<typename V> static bool RuntimeMatchesTemplate()
+{
+	typedef FvfLayout<V::Format> L;
+	VertexFormatInfo info;
+
+	return GetFormatInfo(V::Format, &info) && LayoutMatches(info, L::Size, L::NormalOffset, L::DiffuseOffset, L::SpecularOffset, L::TexCount, L::Tex0Offset, L::Tex1Offset);
+}
+
+// Dest is filled with a different pattern first, so bytes either path forgot to write show up too
+template<typename S, typename D> static bool ConversionsAgree(const VertexDefaults& defaults)
+{
+	S source[Count];
+	D byTemplate[Count];
+	D byRuntime[Count];
+
+	FillPattern(source, sizeof(source), 1);
+	FillPattern(byTemplate, sizeof(byTemplate), 100);
+	FillPattern(byRuntime, sizeof(byRuntime), 100);
+
+	ConvertVertices(source, byTemplate, Count, defaults);
+
+	if (!ConvertVertices(source, S::Format, byRuntime, D::Format, Count, defaults))
+		return false;
+
+	return memcmp(byTemplate, byRuntime, sizeof(byTemplate)) == 0;
+}
+
+template<typename S> static int CountDisagreements(const VertexDefaults& defaults)
+{
+	int failed = 0;
+
+	failed += ConversionsAgree<S, VertexPNCT>(defaults) ? 0 : 1;
+	failed += ConversionsAgree<S, VertexPT>(defaults) ? 0 : 1;
+	failed += ConversionsAgree<S, VertexPCT>(defaults) ? 0 : 1;
+	failed += ConversionsAgree<S, VertexPNT>(defaults) ? 0 : 1;
+	failed += ConversionsAgree<S, VertexLit>(defaults) ? 0 : 1;
+	failed += ConversionsAgree<S, VertexPCT2>(defaults) ? 0 : 1;
+
+	return failed;
+}
+
+// Going out to a layout with every element the source has and back must not change a byte
+template<typename S, typename D> static bool RoundTrips()
+{
+	VertexDefaults defaults;
+	S source[Count];
+	S back[Count];
+	D wide[Count];
+
+	FillPattern(source, sizeof(source), 3);
+	FillPattern(back, sizeof(back), 200);
+
+	ConvertVertices(source, wide, Count, defaults);
+	ConvertVertices(wide, back, Count, defaults);
+
+	return memcmp(source, back, sizeof(source)) == 0;
+}
+
+/* Layouts */
+
+TEST(VertexFormats, RuntimeLayoutMatchesTemplate)
+{
+	CHECK(RuntimeMatchesTemplate<VertexPNCT>());
+	CHECK(RuntimeMatchesTemplate<VertexPT>());
+	CHECK(RuntimeMatchesTemplate<VertexPCT>());
+	CHECK(RuntimeMatchesTemplate<VertexPNT>());
+	CHECK(RuntimeMatchesTemplate<VertexLit>());
+	CHECK(RuntimeMatchesTemplate<VertexPCT2>());
+}
+
+TEST(VertexFormats, OffsetsMatchTheStructs)
+{
+	VertexFormatInfo info;
+
+	REQUIRE(GetFormatInfo(VertexPNCT::Format, &info));
+	CHECK(LayoutMatches(info, sizeof(VertexPNCT), offsetof(VertexPNCT, NX), offsetof(VertexPNCT, Diffuse), -1, 1, offsetof(VertexPNCT, U), -1));
+
+	REQUIRE(GetFormatInfo(VertexLit::Format, &info));
+	CHECK(LayoutMatches(info, sizeof(VertexLit), -1, offsetof(VertexLit, Diffuse), offsetof(VertexLit, Specular), 1, offsetof(VertexLit, U), -1));
+
+	REQUIRE(GetFormatInfo(VertexPCT2::Format, &info));
+	CHECK(LayoutMatches(info, sizeof(VertexPCT2), -1, offsetof(VertexPCT2, Diffuse), -1, 2, offsetof(VertexPCT2, U), offsetof(VertexPCT2, U2)));
+
+	// Position only, no struct for it but still a valid FVF
+	REQUIRE(GetFormatInfo(FvfXyz, &info));
+	CHECK(LayoutMatches(info, 12, -1, -1, -1, 0, -1, -1));
+}
+
+TEST(VertexFormats, RejectsFormatsItCantDescribe)
+{
+	VertexFormatInfo info;
+	unsigned char dest[64];
+
+	CHECK(!GetFormatInfo(0, &info));
+	CHECK(!GetFormatInfo(FvfNormal | FvfTex1, &info)); // No position
+	CHECK(!GetFormatInfo(0x004 | FvfTex1, &info)); // D3DFVF_XYZRHW, pretransformed
+	CHECK(!GetFormatInfo(0x006 | FvfTex1, &info)); // D3DFVF_XYZB1, blend weight
+	CHECK(!GetFormatInfo(FvfXyz | 0x300, &info)); // Three texture sets
+
+	memset(dest, 0xAB, sizeof(dest));
+
+	CHECK(!ConvertVertices(dest, 0x004, dest + 32, VertexPT::Format, 1, VertexDefaults()));
+	CHECK(!ConvertVertices(dest, VertexPT::Format, dest + 32, FvfXyz | 0x300, 1, VertexDefaults()));
+	CHECK(dest[32] == 0xAB && dest[63] == 0xAB);
+}
+
+/* Conversion */
+
+TEST(VertexFormats, TemplateAndRuntimeConversionAgree)
+{
+	VertexDefaults defaults;
+	VertexDefaults custom;
+
+	custom.Normal[0] = 0.5f;
+	custom.Normal[1] = -1;
+	custom.Normal[2] = 2;
+	custom.Diffuse = 0x80402010;
+	custom.Specular = 0x01020304;
+
+	// Every pair of the six layouts, both with D3D's defaults and with non-trivial ones
+	CHECK(CountDisagreements<VertexPNCT>(defaults) == 0);
+	CHECK(CountDisagreements<VertexPT>(defaults) == 0);
+	CHECK(CountDisagreements<VertexPCT>(defaults) == 0);
+	CHECK(CountDisagreements<VertexPNT>(defaults) == 0);
+	CHECK(CountDisagreements<VertexLit>(defaults) == 0);
+	CHECK(CountDisagreements<VertexPCT2>(defaults) == 0);
+
+	CHECK(CountDisagreements<VertexPNCT>(custom) == 0);
+	CHECK(CountDisagreements<VertexPT>(custom) == 0);
+	CHECK(CountDisagreements<VertexPCT>(custom) == 0);
+	CHECK(CountDisagreements<VertexPNT>(custom) == 0);
+	CHECK(CountDisagreements<VertexLit>(custom) == 0);
+	CHECK(CountDisagreements<VertexPCT2>(custom) == 0);
+}
+
+TEST(VertexFormats, MissingElementsTakeDefaults)
+{
+	VertexDefaults defaults;
+	VertexPT source[1] = { { 1, 2, 3, 0.25f, 0.75f } };
+	VertexPNCT full[1];
+	VertexPCT2 detail[1];
+
+	ConvertVertices(source, full, 1, defaults);
+
+	CHECK(full[0].X == 1 && full[0].Y == 2 && full[0].Z == 3);
+	CHECK(full[0].NX == 0 && full[0].NY == 1 && full[0].NZ == 0);
+	CHECK(full[0].Diffuse == 0xFFFFFFFF);
+	CHECK(full[0].U == 0.25f && full[0].V == 0.75f);
+
+	// Detail stage gets the base coordinates when the source has only one set
+	ConvertVertices(source, detail, 1, defaults);
+
+	CHECK(detail[0].U2 == 0.25f && detail[0].V2 == 0.75f);
+
+	// And zeros with no coordinates at all
+	VertexPNCT runtime[1];
+	float position[3] = { 4, 5, 6 };
+
+	REQUIRE(ConvertVertices(position, FvfXyz, runtime, VertexPNCT::Format, 1, defaults));
+	CHECK(runtime[0].X == 4 && runtime[0].Z == 6);
+	CHECK(runtime[0].U == 0 && runtime[0].V == 0);
+}
+
+TEST(VertexFormats, WideningRoundTripsExactly)
+{
+	// Every layout into one that holds all its elements and back
+	CHECK((RoundTrips<VertexPT, VertexPNCT>()));
+	CHECK((RoundTrips<VertexPT, VertexPCT2>()));
+	CHECK((RoundTrips<VertexPCT, VertexPNCT>()));
+	CHECK((RoundTrips<VertexPCT, VertexLit>()));
+	CHECK((RoundTrips<VertexPCT, VertexPCT2>()));
+	CHECK((RoundTrips<VertexPNT, VertexPNCT>()));
+	CHECK((RoundTrips<VertexPNCT, VertexPNCT>()));
+	CHECK((RoundTrips<VertexPCT2, VertexPCT2>()));
+
+	// Runtime path with a layout no struct has, normal + diffuse + specular + two sets
+	const int wideFormat = FvfXyz | FvfNormal | FvfDiffuse | FvfSpecular | FvfTex2;
+	VertexFormatInfo info;
+
+	REQUIRE(GetFormatInfo(wideFormat, &info));
+	REQUIRE(info.Size == 48);
+
+	VertexLit source[Count];
+	VertexLit back[Count];
+	unsigned char wide[Count * 48];
+
+	FillPattern(source, sizeof(source), 5);
+	FillPattern(back, sizeof(back), 50);
+
+	REQUIRE(ConvertVertices(source, VertexLit::Format, wide, wideFormat, Count, VertexDefaults()));
+	REQUIRE(ConvertVertices(wide, wideFormat, back, VertexLit::Format, Count, VertexDefaults()));
+	CHECK(memcmp(source, back, sizeof(source)) == 0);
+}
+
+TEST(VertexFormats, NarrowingKeepsWhatFits)
+{
+	VertexPNCT source[Count];
+	VertexPT narrow[Count];
+
+	FillPattern(source, sizeof(source), 9);
+	ConvertVertices(source, narrow, Count, VertexDefaults());
+
+	for (int i = 0; i < Count; i++)
+	{
+		CHECK(memcmp(&narrow[i].X, &source[i].X, 12) == 0);
+		CHECK(memcmp(&narrow[i].U, &source[i].U, 8) == 0);
+	}
+}
@@ -0,0 +1,785 @@
+#include "AudioMixer.h"
+#include "ImaAdpcm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		static const Platform::UInt64 FixedOne = (Platform::UInt64)1 << 32;
+		static const Platform::UInt64 FixedFractionMask = FixedOne - 1;
+		static const int HandleIndexBits = 10; // Enough for MaxVoices
+		static const float HalfPi = 1.5707963f;
+
+		/* SoundClip */
+
+		SoundClip::SoundClip()
+		{
+			refs = 1;
+			data = 0;
+		}
+
+		SoundClip::~SoundClip()
+		{
+			free(data);
+		}
+
+		SoundClip* SoundClip::Create(const void* pcm, int bytes, int channels, int sampleRate, int bitsPerSample, bool isFloat, bool* isOutOfMemory)
+		{
+			if (isOutOfMemory)
+				*isOutOfMemory = false;
+
+			if (!pcm || channels < 1 || channels > 2 || sampleRate <= 0)
+				return 0;
+
+			if (isFloat ? bitsPerSample != 32 : (bitsPerSample != 8 && bitsPerSample != 16))
+				return 0;
+
+			int frames = bytes / (channels * (bitsPerSample / 8));
+
+			if (frames <= 0)
+				return 0;
+
+			SoundClip* clip = new SoundClip();
+			clip->channels = channels;
+			clip->sampleRate = sampleRate;
+			clip->frames = frames;
+
+			int samples = frames * channels;
+			clip->data = malloc(samples * (isFloat ? sizeof(float) : sizeof(short)));
+
+			if (!clip->data)
+			{
+				clip->Release();
+
+				if (isOutOfMemory)
+					*isOutOfMemory = true;
+
+				return 0;
+			}
+
+			if (isFloat)
+			{
+				clip->format = SampleFloat32;
+				memcpy(clip->data, pcm, samples * sizeof(float));
+			}
+			else
+			{
+				clip->format = SampleInt16;
+
+				if (bitsPerSample == 16)
+					memcpy(clip->data, pcm, samples * sizeof(short));
+				else
+				{
+					const unsigned char* src = (const unsigned char*)pcm;
+					short* dst = (short*)clip->data;
+
+					for (int i = 0; i < samples; i++)
+						dst[i] = (short)((src[i] - 128) << 8);
+				}
+			}
+
+			return clip;
+		}
+
+		SoundClip* SoundClip::CreateImaAdpcm(const void* data, int bytes, int channels, int sampleRate, int blockAlign, bool* isOutOfMemory)
+		{
+			if (isOutOfMemory)
+				*isOutOfMemory = false;
+
+			if (!data || channels < 1 || channels > 2 || sampleRate <= 0 || blockAlign <= 4 * channels)
+				return 0;
+
+			int blockFrames = GetImaAdpcmBlockFrames(blockAlign, channels);
+			int frames = bytes / blockAlign * blockFrames + GetImaAdpcmBlockFrames(bytes % blockAlign, channels);
+
+			if (frames <= 0)
+				return 0;
+
+			SoundClip* clip = new SoundClip();
+			clip->format = SampleInt16;
+			clip->channels = channels;
+			clip->sampleRate = sampleRate;
+			clip->data = malloc(frames * channels * sizeof(short));
+
+			if (!clip->data)
+			{
+				clip->Release();
+
+				if (isOutOfMemory)
+					*isOutOfMemory = true;
+
+				return 0;
+			}
+
+			const unsigned char* src = (const unsigned char*)data;
+			short* dst = (short*)clip->data;
+			int decoded = 0;
+
+			while (bytes > 0 && decoded < frames)
+			{
+				int blockBytes = bytes < blockAlign ? bytes : blockAlign;
+
+				decoded += DecodeImaAdpcmBlock(src, blockBytes, channels, dst + decoded * channels, frames - decoded);
+				src += blockBytes;
+				bytes -= blockBytes;
+			}
+
+			clip->frames = decoded;
+
+			if (decoded == 0)
+			{
+				clip->Release();
+				return 0;
+			}
+
+			return clip;
+		}
+
+		void SoundClip::AddRef()
+		{
+			Platform::AtomicIncrement(&refs);
+		}
+
+		void SoundClip::Release()
+		{
+			if (Platform::AtomicDecrement(&refs) == 0)
+				delete this;
+		}
+
+		const void* SoundClip::GetData()
+		{
+			return data;
+		}
+
+		SoundClip::SampleFormat SoundClip::GetFormat()
+		{
+			return format;
+		}
+
+		int SoundClip::GetChannels()
+		{
+			return channels;
+		}
+
+		int SoundClip::GetSampleRate()
+		{
+			return sampleRate;
+		}
+
+		int SoundClip::GetFrameCount()
+		{
+			return frames;
+		}
+
+		int SoundClip::GetMemoryUsage()
+		{
+			return frames * channels * (format == SampleFloat32 ? sizeof(float) : sizeof(short));
+		}
+
+		/* Resampling */
+
+		static inline float ToFloat(short s)
+		{
+			return s * (1.0f / 32768.0f);
+		}
+
+		static inline float ToFloat(float s)
+		{
+			return s;
+		}
+
+		// Linear interpolation. Returns less than frames if non-looping source ran out.
+		template<typename T> static int Resample(const T* data, int channels, int total, bool loop, Platform::UInt64& position, Platform::UInt64 step, float* dst, int frames)
+		{
+			Platform::UInt64 end = (Platform::UInt64)total << 32;
+
+			for (int i = 0; i < frames; i++)
+			{
+				if (position >= end)
+				{
+					if (!loop)
+						return i;
+
+					position %= end;
+				}
+
+				int index = (int)(position >> 32);
+				int next = index + 1;
+				float frac = (float)(unsigned int)(position & FixedFractionMask) * (1.0f / 4294967296.0f);
+
+				if (next >= total)
+					next = loop ? 0 : index;
+
+				const T* s0 = data + index * channels;
+				const T* s1 = data + next * channels;
+
+				for (int c = 0; c < channels; c++)
+				{
+					float a = ToFloat(s0[c]);
+					dst[c] = a + (ToFloat(s1[c]) - a) * frac;
+				}
+
+				dst += channels;
+				position += step;
+			}
+
+			return frames;
+		}
+
+		/* AudioMixer */
+
+		AudioMixer::AudioMixer(AudioSink* sink, int voiceCount, bool allowSimd)
+		{
+			this->sink = sink;
+			kernels = allowSimd ? MixKernels::GetBest() : MixKernels::GetScalar();
+
+			if (voiceCount < 1)
+				voiceCount = 1;
+
+			if (voiceCount > MaxVoices)
+				voiceCount = MaxVoices;
+
+			this->voiceCount = voiceCount;
+			voices = new Voice[voiceCount];
+
+			for (int i = 0; i < voiceCount; i++)
+			{
+				voices[i].clip = 0;
+				voices[i].stream = 0;
+				voices[i].generation = 0;
+			}
+
+			activeVoices = 0;
+			playCounter = 0;
+			stolenVoices = 0;
+			framesMixed = 0;
+			masterGain = 1;
+			outputRate = sink->GetSampleRate();
+
+			bus = new float[BlockFrames * 2];
+			scratch = new float[BlockFrames * 2];
+			output = new short[BlockFrames * 2];
+			streamBuffer = new short[(BlockFrames * MaxStreamStep + 4) * 2];
+
+			isRunning = 0;
+			threadPeriod = 10;
+		}
+
+		AudioMixer::~AudioMixer()
+		{
+			StopThread();
+
+			for (int i = 0; i < voiceCount; i++)
+			{
+				if (voices[i].clip || voices[i].stream)
+					FreeVoice(voices[i]);
+			}
+
+			delete[] voices;
+			delete[] bus;
+			delete[] scratch;
+			delete[] output;
+			delete[] streamBuffer;
+		}
+
+		AudioMixer::Voice* AudioMixer::GetVoice(VoiceHandle handle)
+		{
+			int index = handle & ((1 << HandleIndexBits) - 1);
+
+			if (index >= voiceCount)
+				return 0;
+
+			Voice* voice = &voices[index];
+
+			if ((!voice->clip && !voice->stream) || voice->generation != handle >> HandleIndexBits)
+				return 0;
+
+			return voice;
+		}
+
+		int AudioMixer::AllocateVoice(int priority)
+		{
+			int victim = -1;
+
+			for (int i = 0; i < voiceCount; i++)
+			{
+				Voice& v = voices[i];
+
+				if (!v.clip && !v.stream)
+					return i;
+
+				if (victim < 0)
+				{
+					victim = i;
+					continue;
+				}
+
+				// Lowest priority first, then the quietest, then the oldest
+				Voice& w = voices[victim];
+
+				if (v.params.Priority < w.params.Priority ||
+					(v.params.Priority == w.params.Priority && (v.params.Gain < w.params.Gain ||
+					(v.params.Gain == w.params.Gain && v.startOrder < w.startOrder))))
+					victim = i;
+			}
+
+			if (voices[victim].params.Priority > priority)
+				return -1;
+
+			FreeVoice(voices[victim]);
+			stolenVoices++;
+
+			return victim;
+		}
+
+		void AudioMixer::FreeVoice(Voice& voice)
+		{
+			if (voice.clip)
+				voice.clip->Release();
+
+			if (voice.stream)
+				voice.stream->Release();
+
+			voice.clip = 0;
+			voice.stream = 0;
+			activeVoices--;
+		}
+
+		void AudioMixer::UpdateStep(Voice& voice)
+		{
+			float pitch = voice.params.Pitch;
+
+			if (pitch < 1.0f / 64)
+				pitch = 1.0f / 64;
+
+			if (pitch > 16)
+				pitch = 16;
+
+			int sampleRate = voice.clip ? voice.clip->GetSampleRate() : voice.stream->GetSampleRate();
+			double ratio = (double)pitch * sampleRate / outputRate;
+
+			if (voice.stream && ratio > MaxStreamStep)
+				ratio = MaxStreamStep;
+
+			// Exact 1.0 keeps the non-interpolating copy path
+			voice.step = pitch == 1.0f && sampleRate == outputRate ? FixedOne : (Platform::UInt64)(ratio * 4294967296.0);
+
+			if (voice.step == 0)
+				voice.step = 1;
+		}
+
+		void AudioMixer::GetTargetGains(Voice& voice, float& left, float& right)
+		{
+			float gain = voice.params.Gain * masterGain;
+			float pan = voice.params.Pan;
+
+			if (pan < -1)
+				pan = -1;
+
+			if (pan > 1)
+				pan = 1;
+
+			if ((voice.clip ? voice.clip->GetChannels() : voice.stream->GetChannels()) == 1)
+			{
+				// Constant power pan law
+				float angle = (pan + 1) * 0.5f * HalfPi;
+
+				left = gain * (float)cos(angle);
+				right = gain * (float)sin(angle);
+			}
+			else
+			{
+				// Stereo sources are balanced instead
+				left = gain * (pan > 0 ? 1 - pan : 1);
+				right = gain * (pan < 0 ? 1 + pan : 1);
+			}
+		}
+
+		int AudioMixer::FetchVoice(Voice& voice, float* dst, int frames)
+		{
+			SoundClip* clip = voice.clip;
+			int channels = clip->GetChannels();
+			int total = clip->GetFrameCount();
+
+			if (voice.step == FixedOne && (voice.position & FixedFractionMask) == 0)
+			{
+				// Same rate, no interpolation needed - plain conversion of contiguous runs
+				int produced = 0;
+
+				while (produced < frames)
+				{
+					int index = (int)(voice.position >> 32);
+
+					if (index >= total)
+					{
+						if (!voice.params.Loop)
+							break;
+
+						index = 0;
+						voice.position = 0;
+					}
+
+					int count = frames - produced;
+
+					if (count > total - index)
+						count = total - index;
+
+					if (clip->GetFormat() == SoundClip::SampleInt16)
+						kernels.Int16ToFloat(dst + produced * channels, (const short*)clip->GetData() + index * channels, count * channels);
+					else
+						memcpy(dst + produced * channels, (const float*)clip->GetData() + index * channels, count * channels * sizeof(float));
+
+					produced += count;
+					voice.position += (Platform::UInt64)count << 32;
+				}
+
+				return produced;
+			}
+
+			if (clip->GetFormat() == SoundClip::SampleInt16)
+				return Resample((const short*)clip->GetData(), channels, total, voice.params.Loop, voice.position, voice.step, dst, frames);
+
+			return Resample((const float*)clip->GetData(), channels, total, voice.params.Loop, voice.position, voice.step, dst, frames);
+		}
+
+		int AudioMixer::FetchStream(Voice& voice, float* dst, int frames)
+		{
+			StreamSource* stream = voice.stream;
+			int channels = stream->GetChannels();
+
+			if (voice.step == FixedOne && (voice.position & FixedFractionMask) == 0 && voice.carryFrames == 0)
+			{
+				int count = stream->Read(streamBuffer, frames);
+
+				// Decoder fell behind - play silence instead of ending the voice
+				if (count < frames && !stream->IsFinished())
+				{
+					memset(streamBuffer + count * channels, 0, (frames - count) * channels * sizeof(short));
+					count = frames;
+				}
+
+				kernels.Int16ToFloat(dst, streamBuffer, count * channels);
+
+				return count;
+			}
+
+			// Frames needed to interpolate the whole block, and to have the next block's first frame at hand
+			Platform::UInt64 last = voice.position + voice.step * (frames - 1);
+			Platform::UInt64 end = voice.position + voice.step * frames;
+			int needed = (int)(last >> 32) + 2;
+
+			if ((int)(end >> 32) + 1 > needed)
+				needed = (int)(end >> 32) + 1;
+
+			memcpy(streamBuffer, voice.carry, voice.carryFrames * channels * sizeof(short));
+
+			int toRead = needed - voice.carryFrames;
+			int count = stream->Read(streamBuffer + voice.carryFrames * channels, toRead);
+
+			if (count < toRead && !stream->IsFinished())
+			{
+				memset(streamBuffer + (voice.carryFrames + count) * channels, 0, (toRead - count) * channels * sizeof(short));
+				count = toRead;
+			}
+
+			int available = voice.carryFrames + count;
+			int produced = Resample(streamBuffer, channels, available, false, voice.position, voice.step, dst, frames);
+
+			// Keep what's left after the new position for the next block, at most 2 frames
+			int index = (int)(voice.position >> 32);
+			voice.carryFrames = index < available ? available - index : 0;
+
+			if (voice.carryFrames > 2)
+				voice.carryFrames = 2;
+
+			memcpy(voice.carry, streamBuffer + index * channels, voice.carryFrames * channels * sizeof(short));
+			voice.position &= FixedFractionMask;
+
+			return produced;
+		}
+
+		void AudioMixer::RenderBlock(short* out, int frames)
+		{
+			memset(bus, 0, frames * 2 * sizeof(float));
+
+			for (int i = 0; i < voiceCount; i++)
+			{
+				Voice& voice = voices[i];
+
+				if (!voice.clip && !voice.stream)
+					continue;
+
+				int channels = voice.clip ? voice.clip->GetChannels() : voice.stream->GetChannels();
+				int produced = voice.clip ? FetchVoice(voice, scratch, frames) : FetchStream(voice, scratch, frames);
+
+				float left, right;
+				GetTargetGains(voice, left, right);
+
+				if (!voice.isStarted)
+				{
+					voice.gainL = left;
+					voice.gainR = right;
+					voice.isStarted = true;
+				}
+
+				if (produced > 0)
+				{
+					if (channels == 1)
+						kernels.MixMono(bus, scratch, produced, voice.gainL, voice.gainR, left, right);
+					else
+						kernels.MixStereo(bus, scratch, produced, voice.gainL, voice.gainR, left, right);
+				}
+
+				voice.gainL = left;
+				voice.gainR = right;
+
+				if (produced < frames)
+					FreeVoice(voice);
+			}
+
+			kernels.FloatToInt16(out, bus, frames * 2);
+			framesMixed += frames;
+		}
+
+		VoiceHandle AudioMixer::Play(SoundClip* clip, const VoiceParams& params)
+		{
+			if (!clip)
+				return 0;
+
+			return StartVoice(clip, 0, params);
+		}
+
+		VoiceHandle AudioMixer::Play(StreamSource* stream, const VoiceParams& params)
+		{
+			if (!stream)
+				return 0;
+
+			return StartVoice(0, stream, params);
+		}
+
+		VoiceHandle AudioMixer::StartVoice(SoundClip* clip, StreamSource* stream, const VoiceParams& params)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			int index = AllocateVoice(params.Priority);
+
+			if (index < 0)
+				return 0;
+
+			Voice& voice = voices[index];
+
+			if (clip)
+				clip->AddRef();
+
+			if (stream)
+				stream->AddRef();
+
+			voice.clip = clip;
+			voice.stream = stream;
+			voice.carryFrames = 0;
+			voice.params = params;
+			voice.position = 0;
+
+			if (clip && params.StartFrame > 0)
+				voice.position = (Platform::UInt64)(params.StartFrame % clip->GetFrameCount()) << 32;
+
+			voice.isStarted = false;
+			voice.startOrder = playCounter++;
+
+			voice.generation = (voice.generation + 1) & ((1u << (32 - HandleIndexBits)) - 1);
+
+			if (voice.generation == 0)
+				voice.generation = 1;
+
+			UpdateStep(voice);
+			activeVoices++;
+
+			return (voice.generation << HandleIndexBits) | (unsigned int)index;
+		}
+
+		void AudioMixer::Stop(VoiceHandle handle)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+			Voice* voice = GetVoice(handle);
+
+			if (voice)
+				FreeVoice(*voice);
+		}
+
+		bool AudioMixer::IsPlaying(VoiceHandle handle)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			return GetVoice(handle) != 0;
+		}
+
+		void AudioMixer::SetGain(VoiceHandle handle, float gain)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+			Voice* voice = GetVoice(handle);
+
+			if (voice)
+				voice->params.Gain = gain;
+		}
+
+		void AudioMixer::SetPan(VoiceHandle handle, float pan)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+			Voice* voice = GetVoice(handle);
+
+			if (voice)
+				voice->params.Pan = pan;
+		}
+
+		void AudioMixer::SetPitch(VoiceHandle handle, float pitch)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+			Voice* voice = GetVoice(handle);
+
+			if (voice)
+			{
+				voice->params.Pitch = pitch;
+				UpdateStep(*voice);
+			}
+		}
+
+		bool AudioMixer::SetParams(VoiceHandle handle, float gain, float pan, float pitch, int* frame)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+			Voice* voice = GetVoice(handle);
+
+			if (!voice)
+				return false;
+
+			voice->params.Gain = gain;
+			voice->params.Pan = pan;
+
+			if (voice->params.Pitch != pitch)
+			{
+				voice->params.Pitch = pitch;
+				UpdateStep(*voice);
+			}
+
+			if (frame)
+				*frame = (int)(voice->position >> 32);
+
+			return true;
+		}
+
+		void AudioMixer::SetMasterGain(float gain)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+			masterGain = gain;
+		}
+
+		float AudioMixer::GetMasterGain()
+		{
+			return masterGain;
+		}
+
+		int AudioMixer::GetVoiceCount()
+		{
+			return voiceCount;
+		}
+
+		int AudioMixer::GetActiveVoiceCount()
+		{
+			return activeVoices;
+		}
+
+		long AudioMixer::GetStolenVoiceCount()
+		{
+			return stolenVoices;
+		}
+
+		Platform::UInt64 AudioMixer::GetFramesMixed()
+		{
+			return framesMixed;
+		}
+
+		bool AudioMixer::IsSimdEnabled()
+		{
+			return kernels.IsSimd;
+		}
+
+		int AudioMixer::Update()
+		{
+			int written = 0;
+			int writable = sink->GetWritableFrames();
+
+			while (writable > 0)
+			{
+				int frames = writable > BlockFrames ? BlockFrames : writable;
+
+				{
+					Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+					RenderBlock(output, frames);
+					sink->Write(output, frames);
+				}
+
+				writable -= frames;
+				written += frames;
+			}
+
+			return written;
+		}
+
+		void AudioMixer::Render(short* out, int frames)
+		{
+			while (frames > 0)
+			{
+				int count = frames > BlockFrames ? BlockFrames : frames;
+
+				{
+					Platform::ScopedLock<Platform::Mutex> guard(lock);
+					RenderBlock(out, count);
+				}
+
+				out += count * 2;
+				frames -= count;
+			}
+		}
+
+		void AudioMixer::ThreadEntry(void* arg)
+		{
+			AudioMixer* self = (AudioMixer*)arg;
+
+			while (self->isRunning)
+			{
+				self->Update();
+				Platform::SleepMs(self->threadPeriod);
+			}
+		}
+
+		void AudioMixer::StartThread(int periodMs)
+		{
+			if (isRunning)
+				return;
+
+			threadPeriod = periodMs > 0 ? periodMs : 1;
+			isRunning = 1;
+
+			if (!thread.Start(ThreadEntry, this))
+				isRunning = 0;
+		}
+
+		void AudioMixer::StopThread()
+		{
+			if (Platform::AtomicExchange(&isRunning, 0))
+				thread.Join();
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
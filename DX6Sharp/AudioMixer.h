@@ -0,0 +1,167 @@
+#pragma once
+
+#include "Platform.h"
+#include "MixKernels.h"
+#include "AudioSink.h"
+#include "StreamSource.h"
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		// Immutable PCM data shared between voices. Refcounted, since voice may outlive the owner's handle.
+		class SoundClip
+		{
+		public:
+			enum SampleFormat
+			{
+				SampleInt16,
+				SampleFloat32
+			};
+		private:
+			volatile long refs;
+			void* data;
+			SampleFormat format;
+			int channels;
+			int sampleRate;
+			int frames;
+
+			SoundClip();
+			~SoundClip();
+			SoundClip(const SoundClip&);
+			SoundClip& operator=(const SoundClip&);
+		public:
+			// Accepts 8-bit unsigned, 16-bit and 32-bit float PCM, mono or stereo. 8-bit is widened to 16-bit.
+			// Returns null if format is not supported or the samples couldn't be allocated, isOutOfMemory tells which.
+			static SoundClip* Create(const void* pcm, int bytes, int channels, int sampleRate, int bitsPerSample, bool isFloat, bool* isOutOfMemory = 0);
+			static SoundClip* CreateImaAdpcm(const void* data, int bytes, int channels, int sampleRate, int blockAlign, bool* isOutOfMemory = 0);
+
+			void AddRef();
+			void Release();
+
+			const void* GetData();
+			SampleFormat GetFormat();
+			int GetChannels();
+			int GetSampleRate();
+			int GetFrameCount();
+			int GetMemoryUsage();
+		};
+
+		typedef unsigned int VoiceHandle; // 0 is never a valid handle
+
+		struct VoiceParams
+		{
+			float Gain;
+			float Pan; // -1 left, 1 right
+			float Pitch; // Playback rate multiplier
+			int Priority; // Higher priority voices steal lower ones when pool is exhausted
+			bool Loop; // Ignored by streams, they loop on their own
+			int StartFrame; // Clips only, lets a voice resume where a virtualized sound would be by now
+
+			VoiceParams()
+			{
+				Gain = 1;
+				Pan = 0;
+				Pitch = 1;
+				Priority = 0;
+				Loop = false;
+				StartFrame = 0;
+			}
+		};
+
+		// Mixes a fixed pool of voices into a single stereo stream, resampling each one to the sink rate.
+		// All methods are thread-safe, mixing may run on its own thread (StartThread) or be pumped with Update.
+		class AudioMixer
+		{
+		public:
+			static const int MaxVoices = 256;
+			static const int BlockFrames = 256;
+			static const int MaxStreamStep = 8; // Streams can't be pitched up further, read-ahead buffer is sized for it
+		private:
+			struct Voice
+			{
+				SoundClip* clip; // Voice is free if both clip and stream are null
+				StreamSource* stream;
+				short carry[4]; // Stream frames read ahead by previous block, needed for interpolation
+				int carryFrames;
+				Platform::UInt64 position; // 32.32 fixed point, in source frames
+				Platform::UInt64 step;
+				VoiceParams params;
+				float gainL, gainR; // Gains applied at the end of previous block, ramp starts from here
+				bool isStarted;
+				unsigned int generation;
+				Platform::UInt64 startOrder;
+			};
+
+			AudioSink* sink;
+			MixKernels kernels;
+
+			Voice* voices;
+			int voiceCount;
+			int activeVoices;
+			Platform::UInt64 playCounter;
+			long stolenVoices;
+			Platform::UInt64 framesMixed;
+
+			float masterGain;
+			int outputRate;
+
+			float* bus;
+			float* scratch;
+			short* output;
+			short* streamBuffer;
+
+			Platform::Mutex lock;
+
+			Platform::Thread thread;
+			volatile long isRunning;
+			int threadPeriod;
+
+			AudioMixer(const AudioMixer&);
+			AudioMixer& operator=(const AudioMixer&);
+
+			Voice* GetVoice(VoiceHandle handle);
+			int AllocateVoice(int priority);
+			void FreeVoice(Voice& voice);
+			void UpdateStep(Voice& voice);
+			void GetTargetGains(Voice& voice, float& left, float& right);
+			int FetchVoice(Voice& voice, float* dst, int frames);
+			int FetchStream(Voice& voice, float* dst, int frames);
+			VoiceHandle StartVoice(SoundClip* clip, StreamSource* stream, const VoiceParams& params);
+			void RenderBlock(short* out, int frames);
+
+			static void ThreadEntry(void* arg);
+		public:
+			// Mixer doesn't own the sink
+			AudioMixer(AudioSink* sink, int voiceCount, bool allowSimd);
+			~AudioMixer();
+
+			VoiceHandle Play(SoundClip* clip, const VoiceParams& params); // Returns 0 if every voice has higher priority
+			VoiceHandle Play(StreamSource* stream, const VoiceParams& params); // Stream must not be played by two voices at once
+			void Stop(VoiceHandle handle);
+			bool IsPlaying(VoiceHandle handle);
+
+			void SetGain(VoiceHandle handle, float gain);
+			void SetPan(VoiceHandle handle, float pan);
+			void SetPitch(VoiceHandle handle, float pitch);
+
+			// Gain, pan and pitch under a single lock. Returns false if voice has ended or was stolen,
+			// otherwise optionally reports playback position in source frames.
+			bool SetParams(VoiceHandle handle, float gain, float pan, float pitch, int* frame);
+			void SetMasterGain(float gain);
+			float GetMasterGain();
+
+			int GetVoiceCount();
+			int GetActiveVoiceCount();
+			long GetStolenVoiceCount();
+			Platform::UInt64 GetFramesMixed();
+			bool IsSimdEnabled();
+
+			int Update(); // Mixes as much as sink accepts right now, returns frame count
+			void Render(short* out, int frames); // Mixes straight into caller's buffer, bypassing sink
+
+			void StartThread(int periodMs);
+			void StopThread();
+		};
+	}
+}
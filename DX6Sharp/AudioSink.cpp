@@ -0,0 +1,137 @@
+#include "AudioSink.h"
+
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		/* NullAudioSink */
+
+		NullAudioSink::NullAudioSink(int sampleRate, int framesPerUpdate)
+		{
+			this->sampleRate = sampleRate;
+			this->framesPerUpdate = framesPerUpdate;
+			framesWritten = 0;
+		}
+
+		Platform::UInt64 NullAudioSink::GetFramesWritten()
+		{
+			return framesWritten;
+		}
+
+		int NullAudioSink::GetSampleRate()
+		{
+			return sampleRate;
+		}
+
+		int NullAudioSink::GetWritableFrames()
+		{
+			return framesPerUpdate;
+		}
+
+		void NullAudioSink::Write(const short* frames, int count)
+		{
+			framesWritten += count;
+		}
+
+		/* WaveFileAudioSink */
+
+		static void PutInt(unsigned char* dst, unsigned int value)
+		{
+			dst[0] = (unsigned char)value;
+			dst[1] = (unsigned char)(value >> 8);
+			dst[2] = (unsigned char)(value >> 16);
+			dst[3] = (unsigned char)(value >> 24);
+		}
+
+		static void PutShort(unsigned char* dst, unsigned short value)
+		{
+			dst[0] = (unsigned char)value;
+			dst[1] = (unsigned char)(value >> 8);
+		}
+
+		WaveFileAudioSink::WaveFileAudioSink(const char* fileName, int sampleRate, int framesPerUpdate)
+		{
+			this->sampleRate = sampleRate;
+			this->framesPerUpdate = framesPerUpdate;
+			framesWritten = 0;
+
+			file = fopen(fileName, "wb");
+
+			if (file)
+				WriteHeader();
+		}
+
+		WaveFileAudioSink::~WaveFileAudioSink()
+		{
+			Close();
+		}
+
+		void WaveFileAudioSink::WriteHeader()
+		{
+			unsigned char hdr[44];
+			unsigned int dataBytes = (unsigned int)(framesWritten * 4);
+
+			memcpy(hdr, "RIFF", 4);
+			PutInt(hdr + 4, 36 + dataBytes);
+			memcpy(hdr + 8, "WAVEfmt ", 8);
+			PutInt(hdr + 16, 16);
+			PutShort(hdr + 20, 1); // PCM
+			PutShort(hdr + 22, 2);
+			PutInt(hdr + 24, sampleRate);
+			PutInt(hdr + 28, sampleRate * 4);
+			PutShort(hdr + 32, 4);
+			PutShort(hdr + 34, 16);
+			memcpy(hdr + 36, "data", 4);
+			PutInt(hdr + 40, dataBytes);
+
+			fseek(file, 0, SEEK_SET);
+			fwrite(hdr, 1, sizeof(hdr), file);
+			fseek(file, 0, SEEK_END);
+		}
+
+		bool WaveFileAudioSink::IsOpen()
+		{
+			return file != 0;
+		}
+
+		void WaveFileAudioSink::Close()
+		{
+			if (file)
+			{
+				WriteHeader();
+				fclose(file);
+				file = 0;
+			}
+		}
+
+		int WaveFileAudioSink::GetSampleRate()
+		{
+			return sampleRate;
+		}
+
+		int WaveFileAudioSink::GetWritableFrames()
+		{
+			return file ? framesPerUpdate : 0;
+		}
+
+		void WaveFileAudioSink::Write(const short* frames, int count)
+		{
+			if (!file)
+				return;
+
+			// Samples are little-endian already on every platform we build for
+			fwrite(frames, 4, count, file);
+			framesWritten += count;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
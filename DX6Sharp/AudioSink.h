@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <stdio.h>
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		// Destination for mixed audio. Format is always interleaved 16-bit stereo at GetSampleRate().
+		class AudioSink
+		{
+		public:
+			virtual ~AudioSink() { }
+
+			virtual int GetSampleRate() = 0;
+			virtual int GetWritableFrames() = 0; // How much can be written right now without blocking
+			virtual void Write(const short* frames, int count) = 0;
+		};
+
+		// Swallows everything. Always accepts framesPerUpdate, so each mixer update renders a fixed amount.
+		class NullAudioSink : public AudioSink
+		{
+		private:
+			int sampleRate;
+			int framesPerUpdate;
+			Platform::UInt64 framesWritten;
+		public:
+			NullAudioSink(int sampleRate, int framesPerUpdate);
+
+			Platform::UInt64 GetFramesWritten();
+
+			virtual int GetSampleRate();
+			virtual int GetWritableFrames();
+			virtual void Write(const short* frames, int count);
+		};
+
+		// Writes a RIFF WAVE file, sizes are patched on close
+		class WaveFileAudioSink : public AudioSink
+		{
+		private:
+			FILE* file;
+			int sampleRate;
+			int framesPerUpdate;
+			Platform::UInt64 framesWritten;
+
+			void WriteHeader();
+		public:
+			WaveFileAudioSink(const char* fileName, int sampleRate, int framesPerUpdate);
+			~WaveFileAudioSink();
+
+			bool IsOpen();
+			void Close();
+
+			virtual int GetSampleRate();
+			virtual int GetWritableFrames();
+			virtual void Write(const short* frames, int count);
+		};
+	}
+}
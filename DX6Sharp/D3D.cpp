@@ -9,11 +9,17 @@ namespace DXSharp
 {
 	namespace D3D
 	{
-		Device::Device(IDirect3D3* direct3d, IDirect3DDevice3* device)
+		Device::Device(DXSharp::Helpers::Window^ window, IDirect3D3* direct3d, IDirect3DDevice3* device)
 		{
+			this->window = window;
 			this->direct3d = direct3d;
 			this->device = device;
 
+			renderThread = 0;
+			commandSink = 0;
+			transientRing = 0;
+			transientBuffer = 0;
+
 			IDirect3DMaterial3* mat;
 
 			Guard(direct3d->CreateMaterial(&mat, 0));
@@ -35,6 +41,7 @@ namespace DXSharp
 			viewport.dvClipHeight = clipHeight;
 			viewport.dvMaxZ = maxZ;
 
+			Flush();
 			Guard(direct3d->CreateViewport(&vp, 0));
 			Guard(device->AddViewport(vp));
 			Guard(vp->SetViewport2(&viewport));
@@ -42,10 +49,30 @@ namespace DXSharp
 			Guard(device->SetCurrentViewport(vp));
 
 			currentViewport = vp;
+
+			if (commandSink)
+				commandSink->SetViewport(vp);
 		}
 
 		void Device::Clear(int count, Rect^ rct, ClearTarget flags, Color^ color, float zValue, int stencilValue)
 		{
+			if (renderThread)
+			{
+				Rendering::ClearDesc desc;
+				desc.Count = count;
+				desc.X = rct->X;
+				desc.Y = rct->Y;
+				desc.Width = rct->Width;
+				desc.Height = rct->Height;
+				desc.Flags = (int)flags;
+				desc.Color = color->GetRGBA();
+				desc.Z = zValue;
+				desc.Stencil = stencilValue;
+
+				renderThread->GetCurrentList()->Clear(desc);
+				return;
+			}
+
 			D3DRECT rect = { rct->X, rct->Y, rct->Width, rct->Height };
 
 			currentViewport->Clear2(count, &rect, (int)flags, color->GetRGBA(), zValue, stencilValue);
@@ -53,49 +80,79 @@ namespace DXSharp
 
 		void Device::BeginScene()
 		{
-			Guard(device->BeginScene());
-
-			device->SetRenderState(D3DRENDERSTATE_CULLMODE, D3DCULL_CW);
-			device->SetRenderState(D3DRENDERSTATE_ZENABLE, D3DZB_TRUE);
-			device->SetTextureStageState(0, D3DTSS_MIPFILTER, D3DTFP_LINEAR);
-			device->SetTextureStageState(0, D3DTSS_MINFILTER, D3DFILTER_LINEAR);
-			device->SetTextureStageState(0, D3DTSS_MAGFILTER, D3DFILTER_LINEAR);
-
-			device->SetTextureStageState(1, D3DTSS_MIPFILTER, D3DTFP_LINEAR);
-			device->SetTextureStageState(1, D3DTSS_MINFILTER, D3DFILTER_LINEAR);
-			device->SetTextureStageState(1, D3DTSS_MAGFILTER, D3DFILTER_LINEAR);
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->BeginScene();
+				return;
+			}
 
-			device->SetRenderState(D3DRENDERSTATE_BLENDENABLE, true);
-			device->SetRenderState(D3DRENDERSTATE_SRCBLEND, D3DBLEND_SRCALPHA);
-			device->SetRenderState(D3DRENDERSTATE_DESTBLEND, D3DBLEND_INVSRCALPHA);
-			device->SetRenderState(D3DRENDERSTATE_DITHERENABLE, true);
-			device->SetRenderState(D3DRENDERSTATE_SPECULARENABLE, true);
+			Guard(device->BeginScene());
 
-			device->SetRenderState(D3DRENDERSTATE_COLORKEYENABLE, true);
+			Rendering::ApplySceneDefaults(device);
 		}
 
 		void Device::EndScene()
 		{
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->EndScene();
+				return;
+			}
+
 			Guard(device->EndScene());
 		}
 
 		void Device::SetTexture(int stage, Texture^ tex)
 		{
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->SetTexture(stage, tex->texture);
+				return;
+			}
+
 			Guard(device->SetTexture(stage, tex->texture));
 		}
 
 		void Device::SetRenderState(RenderState renderState, unsigned int value)
 		{
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->SetRenderState((int)renderState, value);
+				return;
+			}
+
 			Guard(device->SetRenderState((D3DRENDERSTATETYPE)renderState, value));
 		}
 
 		void Device::SetRenderState(RenderState renderState, float value)
 		{
-			Guard(device->SetRenderState((D3DRENDERSTATETYPE)renderState, (DWORD)value));
+			SetRenderState(renderState, (unsigned int)(DWORD)value);
 		}
 
 		void Device::SetMaterial(Material^ material)
 		{
+			if (material != nullptr && renderThread)
+			{
+				Rendering::MaterialDesc desc;
+				desc.Diffuse[0] = material->DiffuseR;
+				desc.Diffuse[1] = material->DiffuseG;
+				desc.Diffuse[2] = material->DiffuseB;
+				desc.Diffuse[3] = material->DiffuseA;
+				desc.Ambient[0] = material->AmbientR;
+				desc.Ambient[1] = material->AmbientG;
+				desc.Ambient[2] = material->AmbientB;
+				desc.Emissive[0] = material->EmissiveR;
+				desc.Emissive[1] = material->EmissiveG;
+				desc.Emissive[2] = material->EmissiveB;
+				desc.Specular[0] = material->SpecularR;
+				desc.Specular[1] = material->SpecularG;
+				desc.Specular[2] = material->SpecularB;
+				desc.Power = material->Power;
+
+				renderThread->GetCurrentList()->SetMaterial(desc);
+				return;
+			}
+
 			if (material != nullptr)
 			{
 				D3DMATERIAL mat;
@@ -132,14 +189,27 @@ namespace DXSharp
 
 		void Device::SetTextureStageState(int stage, int state, int value)
 		{
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->SetTextureStageState(stage, state, value);
+				return;
+			}
+
 			Guard(device->SetTextureStageState(stage, (D3DTEXTURESTAGESTATETYPE)state, value));
 		}
 
 		void Device::SetTransform(TransformType transform, array<float>^ matrix)
 		{
+			pin_ptr<float> arrPtr = &matrix[0];
+
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->SetTransform((int)transform, arrPtr);
+				return;
+			}
+
 			D3DMATRIX m;
 			D3DMATRIX identity;
-			pin_ptr<float> arrPtr = &matrix[0];
 			
 			memcpy(&m._11, arrPtr, 16 * sizeof(float));
 			float* f = (float*)&m._11;
@@ -151,6 +221,7 @@ namespace DXSharp
 		{
 			if (l != nullptr)
 			{
+				Flush(); // Viewport lights are not recorded
 				Guard(currentViewport->AddLight(l->light));
 			}
 		}
@@ -159,12 +230,19 @@ namespace DXSharp
 		{
 			if (l != nullptr)
 			{
+				Flush();
 				Guard(currentViewport->DeleteLight(l->light));
 			}
 		}
 
 		void Device::Begin(PrimitiveType primitiveType, int vertexTypeDesc, bool lit)
 		{
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->BeginDraw((int)primitiveType, vertexTypeDesc, !lit ? D3DDP_DONOTLIGHT : 0, sizeof(D3D::Vertex));
+				return;
+			}
+
 			Guard(device->Begin((D3DPRIMITIVETYPE)primitiveType, vertexTypeDesc, !lit ? D3DDP_DONOTLIGHT : 0));
 		}
 
@@ -173,14 +251,322 @@ namespace DXSharp
 			pin_ptr<D3D::Vertex> ptr = &vertex;
 			//Console::WriteLine("{0} {1} {2}", ptr->X, ptr->Y, ptr->Z);
 
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->AddVertex(ptr);
+				return;
+			}
+
 			device->Vertex(ptr);
 		}
 
 		void Device::End()
 		{
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->EndDraw();
+				return;
+			}
+
 			Guard(device->End(0));
 		}
 
+		void Device::DrawPrimitive(PrimitiveType primitiveType, int vertexTypeDesc, bool lit, array<DXSharp::D3D::Vertex>^ vertices, int startVertex, int vertexCount)
+		{
+			if (vertices == nullptr || startVertex < 0 || vertexCount < 0 || startVertex + vertexCount > vertices->Length)
+				throw gcnew ArgumentException("Vertex range is out of array bounds");
+
+			if (vertexCount == 0)
+				return;
+
+			pin_ptr<D3D::Vertex> ptr = &vertices[startVertex];
+			Submit(primitiveType, vertexTypeDesc, sizeof(D3D::Vertex), lit, ptr, vertexCount);
+		}
+
+		// One instantiation per vertex struct, so format and stride are constants in each submission path
+		template<typename T>
+		static void SubmitArray(Device^ device, PrimitiveType primitiveType, bool lit, Array^ vertices, int startVertex, int vertexCount)
+		{
+			array<T>^ typed = safe_cast<array<T>^>(vertices);
+			pin_ptr<T> ptr = &typed[startVertex];
+
+			device->Submit(primitiveType, T::Format, sizeof(T), lit, ptr, vertexCount);
+		}
+
+		void Device::DrawPrimitive(PrimitiveType primitiveType, bool lit, Array^ vertices, int startVertex, int vertexCount)
+		{
+			if (vertices == nullptr || startVertex < 0 || vertexCount < 0 || startVertex + vertexCount > vertices->Length)
+				throw gcnew ArgumentException("Vertex range is out of array bounds");
+
+			if (vertexCount == 0)
+				return;
+
+			Type^ type = vertices->GetType()->GetElementType();
+
+			if (type == D3D::Vertex::typeid)
+				SubmitArray<D3D::Vertex>(this, primitiveType, lit, vertices, startVertex, vertexCount);
+			else if (type == VertexPNT::typeid)
+				SubmitArray<VertexPNT>(this, primitiveType, lit, vertices, startVertex, vertexCount);
+			else if (type == VertexPCT::typeid)
+				SubmitArray<VertexPCT>(this, primitiveType, lit, vertices, startVertex, vertexCount);
+			else if (type == VertexPT::typeid)
+				SubmitArray<VertexPT>(this, primitiveType, lit, vertices, startVertex, vertexCount);
+			else if (type == VertexLit::typeid)
+				SubmitArray<VertexLit>(this, primitiveType, lit, vertices, startVertex, vertexCount);
+			else if (type == VertexPCT2::typeid)
+				SubmitArray<VertexPCT2>(this, primitiveType, lit, vertices, startVertex, vertexCount);
+			else
+				throw gcnew ArgumentException("Unsupported vertex type " + type->Name);
+		}
+
+		void Device::Submit(PrimitiveType primitiveType, int vertexFormat, int vertexSize, bool lit, const void* vertices, int vertexCount)
+		{
+			int flags = !lit ? D3DDP_DONOTLIGHT : 0;
+
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->DrawPrimitive((int)primitiveType, vertexFormat, flags, vertices, vertexSize, vertexCount);
+				return;
+			}
+
+			Guard(device->DrawPrimitive((D3DPRIMITIVETYPE)primitiveType, vertexFormat, (LPVOID)vertices, vertexCount, flags));
+		}
+
+		/* Vertex formats */
+
+		// Rendering:: layouts spell out D3DFVF_* values, make sure they agree with the SDK
+		typedef char FvfCheck[Rendering::FvfXyz == D3DFVF_XYZ && Rendering::FvfNormal == D3DFVF_NORMAL && Rendering::FvfDiffuse == D3DFVF_DIFFUSE &&
+			Rendering::FvfSpecular == D3DFVF_SPECULAR && Rendering::FvfTex1 == D3DFVF_TEX1 && Rendering::FvfTex2 == D3DFVF_TEX2 ? 1 : -1];
+
+		template<typename Native, typename Managed>
+		static array<Managed>^ ConvertArray(array<D3D::Vertex>^ source)
+		{
+			array<Managed>^ ret = gcnew array<Managed>(source->Length);
+
+			if (source->Length == 0)
+				return ret;
+
+			pin_ptr<D3D::Vertex> src = &source[0];
+			pin_ptr<Managed> dst = &ret[0];
+
+			Rendering::ConvertVertices((const Rendering::VertexPNCT*)src, (Native*)dst, source->Length, Rendering::VertexDefaults());
+
+			return ret;
+		}
+
+		Array^ VertexConverter::Convert(array<Vertex>^ source, int format)
+		{
+			if (source == nullptr)
+				throw gcnew ArgumentNullException("source");
+
+			switch (format)
+			{
+			case Vertex::Format:
+				return (array<Vertex>^)source->Clone();
+			case VertexPT::Format:
+				return ConvertArray<Rendering::VertexPT, VertexPT>(source);
+			case VertexPCT::Format:
+				return ConvertArray<Rendering::VertexPCT, VertexPCT>(source);
+			case VertexPNT::Format:
+				return ConvertArray<Rendering::VertexPNT, VertexPNT>(source);
+			case VertexLit::Format:
+				return ConvertArray<Rendering::VertexLit, VertexLit>(source);
+			case VertexPCT2::Format:
+				return ConvertArray<Rendering::VertexPCT2, VertexPCT2>(source);
+			}
+
+			throw gcnew ArgumentException(String::Format("Vertex format 0x{0:X} has no matching vertex struct", format));
+		}
+
+		int VertexConverter::GetVertexSize(int format)
+		{
+			Rendering::VertexFormatInfo info;
+			return Rendering::GetFormatInfo(format, &info) ? info.Size : 0;
+		}
+
+		/* Transient vertices */
+
+		Rendering::TransientVertexRing* Device::GetTransientRing()
+		{
+			if (transientRing)
+				return transientRing;
+
+			// Render thread draws by pointer, locking a vertex buffer under it from here would not be safe. Frames it hasn't
+			// replayed yet keep their vertices, so each of them and the one being recorded gets the immediate mode budget.
+			if (renderThread)
+			{
+				int capacity = TransientVertexCount * (renderThread->GetMaxFrameLatency() + 1);
+				transientRing = new Rendering::TransientVertexRing(new Rendering::MemoryVertexRingStorage(sizeof(D3D::Vertex), capacity), sizeof(D3D::Vertex), capacity);
+			}
+			else
+			{
+				transientBuffer = new Rendering::D3DVertexRingStorage(direct3d, VertexFormat, sizeof(D3D::Vertex), TransientVertexCount);
+				transientRing = new Rendering::TransientVertexRing(transientBuffer, sizeof(D3D::Vertex), TransientVertexCount);
+			}
+
+			return transientRing;
+		}
+
+		void Device::ReleaseTransientRing()
+		{
+			delete transientRing; // Owns storage too
+			transientRing = 0;
+			transientBuffer = 0;
+		}
+
+		TransientVertices Device::AllocateTransient(int vertexCount)
+		{
+			Rendering::TransientVertexRing* ring = GetTransientRing();
+			long fence = 0;
+
+			if (renderThread)
+			{
+				// Vertices are read when the list being recorded now gets replayed
+				fence = renderThread->GetFramesSubmitted() + 1;
+				ring->Retire(renderThread->GetFramesExecuted());
+			}
+			else
+			{
+				ring->Retire(fence); // Draws were issued already, driver side is covered by the discard on wrap
+			}
+
+			TransientVertices ret;
+			ret.data = 0;
+			ret.firstVertex = 0;
+			ret.count = 0;
+
+			Rendering::TransientVertexRing::Allocation allocation;
+
+			if (ring->Allocate(vertexCount, fence, &allocation))
+			{
+				ret.data = (D3D::Vertex*)allocation.Data;
+				ret.firstVertex = allocation.FirstVertex;
+				ret.count = allocation.VertexCount;
+			}
+
+			return ret;
+		}
+
+		void Device::DrawTransient(PrimitiveType primitiveType, bool lit, TransientVertices vertices)
+		{
+			DrawTransient(primitiveType, lit, vertices, 0, vertices.count);
+		}
+
+		void Device::DrawTransient(PrimitiveType primitiveType, bool lit, TransientVertices vertices, int startVertex, int vertexCount)
+		{
+			if (startVertex < 0 || vertexCount < 0 || startVertex + vertexCount > vertices.count)
+				throw gcnew ArgumentException("Vertex range is out of transient allocation bounds");
+
+			if (vertexCount == 0)
+				return;
+
+			transientRing->Commit();
+			int flags = !lit ? D3DDP_DONOTLIGHT : 0;
+
+			if (renderThread)
+			{
+				renderThread->GetCurrentList()->DrawExternal((int)primitiveType, VertexFormat, flags, vertices.data + startVertex, sizeof(D3D::Vertex), vertexCount);
+				return;
+			}
+
+			Guard(device->DrawPrimitiveVB((D3DPRIMITIVETYPE)primitiveType, transientBuffer->GetBuffer(), vertices.firstVertex + startVertex, vertexCount, flags));
+		}
+
+		int TransientVertices::Count::get()
+		{
+			return count;
+		}
+
+		D3D::Vertex TransientVertices::default::get(int index)
+		{
+			if (index < 0 || index >= count)
+				throw gcnew ArgumentOutOfRangeException("index");
+
+			return data[index];
+		}
+
+		void TransientVertices::default::set(int index, D3D::Vertex value)
+		{
+			if (index < 0 || index >= count)
+				throw gcnew ArgumentOutOfRangeException("index");
+
+			data[index] = value;
+		}
+
+		void TransientVertices::CopyFrom(array<D3D::Vertex>^ source, int sourceIndex, int destIndex, int length)
+		{
+			if (source == nullptr || sourceIndex < 0 || destIndex < 0 || length < 0 || sourceIndex + length > source->Length || destIndex + length > count)
+				throw gcnew ArgumentException("Vertex range is out of bounds");
+
+			if (length == 0)
+				return;
+
+			pin_ptr<D3D::Vertex> ptr = &source[sourceIndex];
+			memcpy(data + destIndex, ptr, length * sizeof(D3D::Vertex));
+		}
+
+		/* Render thread */
+
+		void Device::EnableRenderThread(int maxFrameLatency)
+		{
+			if (renderThread)
+				return;
+
+			ReleaseTransientRing(); // Recreated in system memory on next use
+
+			commandSink = new Rendering::D3DCommandSink(device, material, window->hwnd, window->primarySurface, window->d3dSurface);
+			commandSink->SetViewport(currentViewport);
+
+			renderThread = new Rendering::RenderThread(commandSink, maxFrameLatency);
+		}
+
+		void Device::DisableRenderThread()
+		{
+			if (!renderThread)
+				return;
+
+			delete renderThread; // Executes everything recorded so far
+			renderThread = 0;
+
+			ReleaseTransientRing();
+
+			Rendering::D3DCommandSink* sink = commandSink;
+			const Checks::CheckSite* site;
+			HRESULT res = sink->TakeError(&site);
+
+			commandSink = 0;
+			delete sink;
+
+			if (FAILED(res))
+				DXSharp::Helpers::ExceptionManager::Throw(*site, res);
+		}
+
+		void Device::Flush()
+		{
+			if (!renderThread)
+				return;
+
+			renderThread->Flush();
+			ThrowRenderThreadError();
+		}
+
+		void Device::SubmitFrame()
+		{
+			renderThread->GetCurrentList()->Present();
+			renderThread->SubmitFrame();
+
+			ThrowRenderThreadError(); // Reports failures from a frame or two ago
+		}
+
+		void Device::ThrowRenderThreadError()
+		{
+			const Checks::CheckSite* site;
+			HRESULT res = commandSink->TakeError(&site);
+
+			if (FAILED(res))
+				DXSharp::Helpers::ExceptionManager::Throw(*site, res);
+		}
+
 		Light::Light(Device^ device)
 		{
 			IDirect3DLight* _light;
@@ -266,9 +652,11 @@ namespace DXSharp
 			IDirectDraw4* dd2;
 			window->ddraw->QueryInterface(IID_IDirectDraw4, (LPVOID*)&dd2);
 
-			Guard(dd2->CreateSurface(&desc, &surf, 0));
+			HRESULT res = dd2->CreateSurface(&desc, &surf, 0);
+			dd2->Release();
+			Guard(res);
 			Guard(surf->QueryInterface(IID_IDirect3DTexture2, (LPVOID*)&tex));
-			
+
 
 			surface = surf;
 			texture = tex;
@@ -276,6 +664,41 @@ namespace DXSharp
 			this->window = window;
 		}
 
+		Texture::~Texture()
+		{
+			try
+			{
+				// Frames already recorded for the render thread may still set this texture
+				if (window->device != nullptr)
+					window->device->Flush();
+			}
+			finally
+			{
+				if (texture)
+				{
+					texture->Release();
+					texture = 0;
+				}
+
+				if (surface)
+				{
+					surface->Release(); // Takes the attached mip levels with it
+					surface = 0;
+				}
+			}
+		}
+
+		int Texture::SizeInBytes::get()
+		{
+			// 16 bit texels, every mip level a quarter of the one above
+			int size = 0;
+
+			for (int i = 0, w = Width, h = Height; i < Math::Max(MipCount, 1); i++, w = Math::Max(w / 2, 1), h = Math::Max(h / 2, 1))
+				size += w * h * 2;
+
+			return size;
+		}
+
 		IDirectDrawSurface4* Texture::AllocateTemporaryTexture(int width, int height)
 		{
 			DDSURFACEDESC2 desc;
@@ -293,7 +716,9 @@ namespace DXSharp
 			window->ddraw->QueryInterface(IID_IDirectDraw4, (LPVOID*)&dd4);
 
 			IDirectDrawSurface4* tmpSurface;
-			Guard(dd4->CreateSurface(&desc, &tmpSurface, 0));
+			HRESULT res = dd4->CreateSurface(&desc, &tmpSurface, 0);
+			dd4->Release();
+			Guard(res);
 
 			return tmpSurface;
 		}
@@ -329,20 +754,29 @@ namespace DXSharp
 					memcpy(desc.lpSurface, pixelData, pixels->Length); // Warning, this can potentially crash application if method supplied with non-full bitmap buffer
 					Guard(tmpSurface->Unlock(0));
 
-					Console::WriteLine("Uploading mip {0}x{1}", desc.dwWidth, desc.dwHeight);
+					LOG_SITE(uploadSite, "D3D", LogDebug, "Uploading mip {0}x{1}");
+					Logging::Logger::Write(uploadSite, desc.dwWidth, desc.dwHeight);
 
-					Guard(mipSurf->Blt(0, tmpSurface, 0, DDBLT_WAIT, 0));
+					res = mipSurf->Blt(0, tmpSurface, 0, DDBLT_WAIT, 0);
 					tmpSurface->Release();
 
-					mipSurf->Release();
+					// The top level is ours to keep, only the references GetAttachedSurface added go
+					if (mipSurf != surface)
+						mipSurf->Release();
+
+					Guard(res);
 					return;
 				}
 
 				IDirectDrawSurface4* currSurf = mipSurf;
 				res = mipSurf->GetAttachedSurface(&caps, &mipSurf);
-				//currSurf->Release();
+
+				if (currSurf != surface)
+					currSurf->Release();
 			}
-			
+
+			tmpSurface->Release();
+
 			throw gcnew ArgumentException("Bug in mipmap uploading code (requested mip not found)");
 		}
 
@@ -0,0 +1,181 @@
+#include "D3DCommandSink.h"
+
+#include <string.h>
+
+// Every replayed call gets its own check site, failures are parked for the game thread
+#define SinkCheck(expr) \
+	do \
+	{ \
+		CHECK_SITE(sinkSite, #expr); \
+		HRESULT sinkResult = (expr); \
+		if (Checks::Check(sinkSite, sinkResult)) \
+			SetError(sinkSite, sinkResult); \
+	} while (0)
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		void ApplySceneDefaults(IDirect3DDevice3* device)
+		{
+			device->SetRenderState(D3DRENDERSTATE_CULLMODE, D3DCULL_CW);
+			device->SetRenderState(D3DRENDERSTATE_ZENABLE, D3DZB_TRUE);
+			device->SetTextureStageState(0, D3DTSS_MIPFILTER, D3DTFP_LINEAR);
+			device->SetTextureStageState(0, D3DTSS_MINFILTER, D3DFILTER_LINEAR);
+			device->SetTextureStageState(0, D3DTSS_MAGFILTER, D3DFILTER_LINEAR);
+
+			device->SetTextureStageState(1, D3DTSS_MIPFILTER, D3DTFP_LINEAR);
+			device->SetTextureStageState(1, D3DTSS_MINFILTER, D3DFILTER_LINEAR);
+			device->SetTextureStageState(1, D3DTSS_MAGFILTER, D3DFILTER_LINEAR);
+
+			device->SetRenderState(D3DRENDERSTATE_BLENDENABLE, true);
+			device->SetRenderState(D3DRENDERSTATE_SRCBLEND, D3DBLEND_SRCALPHA);
+			device->SetRenderState(D3DRENDERSTATE_DESTBLEND, D3DBLEND_INVSRCALPHA);
+			device->SetRenderState(D3DRENDERSTATE_DITHERENABLE, true);
+			device->SetRenderState(D3DRENDERSTATE_SPECULARENABLE, true);
+
+			device->SetRenderState(D3DRENDERSTATE_COLORKEYENABLE, true);
+		}
+
+		D3DCommandSink::D3DCommandSink(IDirect3DDevice3* device, IDirect3DMaterial3* material, HWND hwnd, IDirectDrawSurface4* primarySurface, IDirectDrawSurface4* renderTarget)
+		{
+			this->device = device;
+			this->material = material;
+			this->hwnd = hwnd;
+			this->primarySurface = primarySurface;
+			this->renderTarget = renderTarget;
+
+			viewport = 0;
+			errorResult = S_OK;
+			errorSite = 0;
+		}
+
+		void D3DCommandSink::SetError(const Checks::CheckSite& site, HRESULT res)
+		{
+			// Render thread is the only writer, so site is published before the result
+			if (errorResult == S_OK)
+			{
+				errorSite = &site;
+				Platform::FullBarrier();
+				errorResult = res;
+			}
+		}
+
+		void D3DCommandSink::SetViewport(IDirect3DViewport3* viewport)
+		{
+			this->viewport = viewport;
+		}
+
+		HRESULT D3DCommandSink::TakeError(const Checks::CheckSite** site)
+		{
+			HRESULT res = (HRESULT)errorResult;
+
+			if (FAILED(res))
+			{
+				*site = errorSite;
+				Platform::AtomicExchange(&errorResult, S_OK);
+			}
+
+			return res;
+		}
+
+		void D3DCommandSink::Clear(const ClearDesc& desc)
+		{
+			if (!viewport)
+				return;
+
+			D3DRECT rect = { desc.X, desc.Y, desc.Width, desc.Height };
+
+			viewport->Clear2(desc.Count, &rect, desc.Flags, desc.Color, desc.Z, desc.Stencil);
+		}
+
+		void D3DCommandSink::BeginScene()
+		{
+			SinkCheck(device->BeginScene());
+
+			ApplySceneDefaults(device);
+		}
+
+		void D3DCommandSink::EndScene()
+		{
+			SinkCheck(device->EndScene());
+		}
+
+		void D3DCommandSink::SetTransform(int type, const float* matrix)
+		{
+			D3DMATRIX m;
+			memcpy(&m._11, matrix, 16 * sizeof(float));
+
+			SinkCheck(device->SetTransform((D3DTRANSFORMSTATETYPE)type, &m));
+		}
+
+		void D3DCommandSink::SetTexture(int stage, void* texture)
+		{
+			SinkCheck(device->SetTexture(stage, (IDirect3DTexture2*)texture));
+		}
+
+		void D3DCommandSink::SetRenderState(int state, unsigned int value)
+		{
+			SinkCheck(device->SetRenderState((D3DRENDERSTATETYPE)state, value));
+		}
+
+		void D3DCommandSink::SetTextureStageState(int stage, int state, int value)
+		{
+			SinkCheck(device->SetTextureStageState(stage, (D3DTEXTURESTAGESTATETYPE)state, value));
+		}
+
+		void D3DCommandSink::SetMaterial(const MaterialDesc& desc)
+		{
+			D3DMATERIAL mat;
+			memset(&mat, 0, sizeof(mat));
+			mat.dwSize = sizeof(mat);
+			mat.diffuse.r = desc.Diffuse[0];
+			mat.diffuse.g = desc.Diffuse[1];
+			mat.diffuse.b = desc.Diffuse[2];
+			mat.diffuse.a = desc.Diffuse[3];
+
+			mat.ambient.r = desc.Ambient[0];
+			mat.ambient.g = desc.Ambient[1];
+			mat.ambient.b = desc.Ambient[2];
+
+			mat.emissive.r = desc.Emissive[0];
+			mat.emissive.g = desc.Emissive[1];
+			mat.emissive.b = desc.Emissive[2];
+
+			mat.dcvSpecular.r = desc.Specular[0];
+			mat.dcvSpecular.g = desc.Specular[1];
+			mat.dcvSpecular.b = desc.Specular[2];
+
+			mat.power = desc.Power;
+
+			SinkCheck(material->SetMaterial(&mat));
+
+			D3DMATERIALHANDLE handle;
+			SinkCheck(material->GetHandle(device, &handle));
+
+			SinkCheck(device->SetLightState(D3DLIGHTSTATE_MATERIAL, handle));
+			device->SetLightState(D3DLIGHTSTATE_AMBIENT, RGB(255, 254, 242));
+		}
+
+		void D3DCommandSink::DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount)
+		{
+			SinkCheck(device->DrawPrimitive((D3DPRIMITIVETYPE)primitiveType, vertexFormat, (LPVOID)vertices, vertexCount, flags));
+		}
+
+		void D3DCommandSink::Present()
+		{
+			RECT rct = { };
+			GetWindowRect(hwnd, &rct);
+
+			SinkCheck(primarySurface->Blt(&rct, renderTarget, 0, 0, 0));
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Windows.h>
+#include <d3d.h>
+#include <ddraw.h>
+
+#include "RenderCommands.h"
+#include "HResultCheck.h"
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		// States every scene starts with. Shared by immediate Device::BeginScene and the render thread.
+		void ApplySceneDefaults(IDirect3DDevice3* device);
+
+		// Replays command lists into a D3D6 device. Runs on the render thread, so failures can't be thrown here -
+		// first failed call is remembered and rethrown by Device on the game thread.
+		class D3DCommandSink : public CommandSink
+		{
+		private:
+			IDirect3DDevice3* device;
+			IDirect3DViewport3* viewport;
+			IDirect3DMaterial3* material;
+
+			HWND hwnd;
+			IDirectDrawSurface4* primarySurface;
+			IDirectDrawSurface4* renderTarget;
+
+			volatile long errorResult;
+			const Checks::CheckSite* errorSite;
+
+			void SetError(const Checks::CheckSite& site, HRESULT res);
+		public:
+			D3DCommandSink(IDirect3DDevice3* device, IDirect3DMaterial3* material, HWND hwnd, IDirectDrawSurface4* primarySurface, IDirectDrawSurface4* renderTarget);
+
+			void SetViewport(IDirect3DViewport3* viewport); // Only while render thread is idle
+
+			// Returns and clears first failure, S_OK if none
+			HRESULT TakeError(const Checks::CheckSite** site);
+
+			virtual void Clear(const ClearDesc& desc);
+			virtual void BeginScene();
+			virtual void EndScene();
+			virtual void SetTransform(int type, const float* matrix);
+			virtual void SetTexture(int stage, void* texture);
+			virtual void SetRenderState(int state, unsigned int value);
+			virtual void SetTextureStageState(int stage, int state, int value);
+			virtual void SetMaterial(const MaterialDesc& material);
+			virtual void DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount);
+			virtual void Present();
+		};
+	}
+}
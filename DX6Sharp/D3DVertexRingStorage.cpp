@@ -0,0 +1,88 @@
+#include "D3DVertexRingStorage.h"
+#include "HResultCheck.h"
+
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+// DirectX 7 vertex buffer lock hints, not in the DirectX 6 ddraw.h
+#ifndef DDLOCK_NOOVERWRITE
+#define DDLOCK_NOOVERWRITE 0x00001000L
+#endif
+
+#ifndef DDLOCK_DISCARDCONTENTS
+#define DDLOCK_DISCARDCONTENTS 0x00002000L
+#endif
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		D3DVertexRingStorage::D3DVertexRingStorage(IDirect3D3* direct3d, int vertexFormat, int vertexSize, int capacity)
+		{
+			CHECK_SITE(createSite, "direct3d->CreateVertexBuffer()");
+
+			this->vertexSize = vertexSize;
+			buffer = 0;
+			useLockHints = true;
+
+			D3DVERTEXBUFFERDESC desc;
+			memset(&desc, 0, sizeof(desc));
+			desc.dwSize = sizeof(desc);
+			desc.dwCaps = D3DVBCAPS_WRITEONLY;
+			desc.dwFVF = vertexFormat;
+			desc.dwNumVertices = capacity;
+
+			IDirect3DVertexBuffer* vb;
+
+			if (!Checks::Check(createSite, direct3d->CreateVertexBuffer(&desc, &vb, 0, 0)))
+				buffer = vb;
+		}
+
+		D3DVertexRingStorage::~D3DVertexRingStorage()
+		{
+			if (buffer)
+				buffer->Release();
+		}
+
+		IDirect3DVertexBuffer* D3DVertexRingStorage::GetBuffer()
+		{
+			return buffer;
+		}
+
+		void* D3DVertexRingStorage::Lock(int firstVertex, int vertexCount, bool discard)
+		{
+			CHECK_SITE(lockSite, "buffer->Lock()");
+
+			if (!buffer)
+				return 0;
+
+			// IDirect3DVertexBuffer::Lock has no range, the whole buffer is locked and the allocation is an offset into it.
+			// The hint is what keeps a DX7 runtime from stalling on pending draws. DX6 only knows DDLOCK_WAIT, WRITEONLY,
+			// READONLY and NOSYSLOCK and may fail the call instead of ignoring the rest, then the driver waits for the draws.
+			DWORD flags = DDLOCK_WAIT | DDLOCK_WRITEONLY | (discard ? DDLOCK_DISCARDCONTENTS : DDLOCK_NOOVERWRITE);
+			void* data;
+
+			if (useLockHints && SUCCEEDED(buffer->Lock(flags, &data, 0)))
+				return (unsigned char*)data + firstVertex * vertexSize;
+
+			if (Checks::Check(lockSite, buffer->Lock(DDLOCK_WAIT, &data, 0)))
+				return 0;
+
+			useLockHints = false; // Plain lock works where the hinted one didn't, so don't pay for the failed call every frame
+
+			return (unsigned char*)data + firstVertex * vertexSize;
+		}
+
+		void D3DVertexRingStorage::Unlock()
+		{
+			buffer->Unlock();
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
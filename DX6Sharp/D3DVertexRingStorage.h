@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Windows.h>
+#include <d3d.h>
+#include <ddraw.h>
+
+#include "TransientVertexRing.h"
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		// Dynamic D3D6 vertex buffer. Draw from it with DrawPrimitiveVB(GetBuffer(), allocation.FirstVertex, ...).
+		class D3DVertexRingStorage : public VertexRingStorage
+		{
+		private:
+			IDirect3DVertexBuffer* buffer;
+			int vertexSize;
+			bool useLockHints; // Cleared once the runtime rejects the DX7 lock flags
+		public:
+			// Check GetBuffer() for failure, e.g. FVF not supported by the driver
+			D3DVertexRingStorage(IDirect3D3* direct3d, int vertexFormat, int vertexSize, int capacity);
+			~D3DVertexRingStorage();
+
+			IDirect3DVertexBuffer* GetBuffer();
+
+			virtual void* Lock(int firstVertex, int vertexCount, bool discard);
+			virtual void Unlock();
+		};
+	}
+}
@@ -0,0 +1,260 @@
+#include "dxsharp.h"
+
+using namespace System::Runtime::InteropServices;
+
+namespace DXSharp
+{
+	namespace Diagnostics
+	{
+		/* LogArg */
+
+		LogArg::operator LogArg(int value)
+		{
+			LogArg ret;
+			ret.Type = Logging::ArgInt;
+			ret.Int = value;
+
+			return ret;
+		}
+
+		LogArg::operator LogArg(Int64 value)
+		{
+			LogArg ret;
+			ret.Type = Logging::ArgInt;
+			ret.Int = value;
+
+			return ret;
+		}
+
+		LogArg::operator LogArg(float value)
+		{
+			LogArg ret;
+			ret.Type = Logging::ArgDouble;
+			ret.Double = value;
+
+			return ret;
+		}
+
+		LogArg::operator LogArg(double value)
+		{
+			LogArg ret;
+			ret.Type = Logging::ArgDouble;
+			ret.Double = value;
+
+			return ret;
+		}
+
+		LogArg::operator LogArg(bool value)
+		{
+			LogArg ret;
+			ret.Type = Logging::ArgBool;
+			ret.Int = value;
+
+			return ret;
+		}
+
+		LogArg::operator LogArg(String^ value)
+		{
+			LogArg ret;
+			ret.Type = Logging::ArgString;
+			ret.Text = value == nullptr ? "(null)" : value;
+
+			return ret;
+		}
+
+		/* LogSite */
+
+		LogSite::LogSite(String^ category, LogLevel level, String^ format)
+		{
+			site = new Logging::LogSite();
+			site->Category = (const char*)Marshal::StringToHGlobalAnsi(category).ToPointer();
+			site->Level = (Logging::LogLevel)level;
+			site->File = "";
+			site->Line = 0;
+			site->Format = (const char*)Marshal::StringToHGlobalAnsi(format).ToPointer();
+			site->Id = 0;
+			site->CategoryIndex = 0;
+		}
+
+		bool LogSite::IsEnabled::get()
+		{
+			return Logging::Logger::IsEnabled(*site);
+		}
+
+		void LogSite::Write(int count, LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5, LogArg a6, LogArg a7)
+		{
+			if (!Logging::Logger::IsEnabled(*site))
+				return;
+
+			LogArg source[] = { a0, a1, a2, a3, a4, a5, a6, a7 };
+			Logging::LogArg args[Logging::Logger::MaxArgs];
+			char text[Logging::Logger::RecordTextBytes];
+			int textUsed = 0;
+
+			for (int i = 0; i < count; i++)
+			{
+				args[i].Type = source[i].Type;
+
+				if (source[i].Type == Logging::ArgDouble)
+					args[i].Double = source[i].Double;
+				else if (source[i].Type == Logging::ArgString)
+				{
+					// Record only keeps RecordTextBytes of text anyway, so narrow just that much
+					String^ s = source[i].Text;
+					int length = Math::Min(s->Length, Logging::Logger::RecordTextBytes - textUsed);
+
+					for (int c = 0; c < length; c++)
+						text[textUsed + c] = s[c] < 128 ? (char)s[c] : '?';
+
+					args[i].String = text + textUsed;
+					args[i].Length = length;
+					textUsed += length;
+				}
+				else
+					args[i].Int = source[i].Int;
+			}
+
+			Logging::Logger::WriteArgs(*site, args, count);
+		}
+
+		void LogSite::Write()
+		{
+			Write(0, LogArg(), LogArg(), LogArg(), LogArg(), LogArg(), LogArg(), LogArg(), LogArg());
+		}
+
+		void LogSite::Write(LogArg a0)
+		{
+			Write(1, a0, LogArg(), LogArg(), LogArg(), LogArg(), LogArg(), LogArg(), LogArg());
+		}
+
+		void LogSite::Write(LogArg a0, LogArg a1)
+		{
+			Write(2, a0, a1, LogArg(), LogArg(), LogArg(), LogArg(), LogArg(), LogArg());
+		}
+
+		void LogSite::Write(LogArg a0, LogArg a1, LogArg a2)
+		{
+			Write(3, a0, a1, a2, LogArg(), LogArg(), LogArg(), LogArg(), LogArg());
+		}
+
+		void LogSite::Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3)
+		{
+			Write(4, a0, a1, a2, a3, LogArg(), LogArg(), LogArg(), LogArg());
+		}
+
+		void LogSite::Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4)
+		{
+			Write(5, a0, a1, a2, a3, a4, LogArg(), LogArg(), LogArg());
+		}
+
+		void LogSite::Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5)
+		{
+			Write(6, a0, a1, a2, a3, a4, a5, LogArg(), LogArg());
+		}
+
+		void LogSite::Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5, LogArg a6)
+		{
+			Write(7, a0, a1, a2, a3, a4, a5, a6, LogArg());
+		}
+
+		void LogSite::Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5, LogArg a6, LogArg a7)
+		{
+			Write(8, a0, a1, a2, a3, a4, a5, a6, a7);
+		}
+
+		/* Logger */
+
+		void Logger::InitializeConsole()
+		{
+			Logging::StdioLogOutput* output = new Logging::StdioLogOutput(stdout);
+
+			if (!Logging::Logger::Initialize(output, Logging::Logger::DefaultCapacity))
+				delete output; // Already running
+		}
+
+		void Logger::InitializeFile(String^ fileName)
+		{
+			IntPtr name = Marshal::StringToHGlobalAnsi(fileName);
+			Logging::StdioLogOutput* output = new Logging::StdioLogOutput((const char*)name.ToPointer());
+			Marshal::FreeHGlobal(name);
+
+			if (!output->IsOpen())
+			{
+				delete output;
+				throw gcnew ArgumentException(String::Format("Can't create {0}", fileName));
+			}
+
+			if (!Logging::Logger::Initialize(output, Logging::Logger::DefaultCapacity))
+				delete output;
+		}
+
+		void Logger::Shutdown()
+		{
+			Logging::Logger::Shutdown();
+		}
+
+		void Logger::Flush()
+		{
+			Logging::Logger::Flush();
+		}
+
+		void Logger::SetLevel(String^ category, LogLevel level)
+		{
+			IntPtr name = Marshal::StringToHGlobalAnsi(category);
+			Logging::Logger::SetLevel((const char*)name.ToPointer(), (Logging::LogLevel)level);
+			Marshal::FreeHGlobal(name);
+		}
+
+		int Logger::Written::get()
+		{
+			return (int)Logging::Logger::GetWrittenCount();
+		}
+
+		int Logger::Dropped::get()
+		{
+			return (int)Logging::Logger::GetDroppedCount();
+		}
+
+		/* CheckStatistics */
+
+		array<CheckSiteStats>^ CheckStatistics::GetSites()
+		{
+			// List only grows at the head, so everything after the head read here stays put
+			Checks::CheckSite* first = Checks::GetFirstSite();
+			int count = 0;
+
+			for (Checks::CheckSite* site = first; site; site = site->Next)
+				count++;
+
+			array<CheckSiteStats>^ ret = gcnew array<CheckSiteStats>(count);
+			Checks::CheckSite* site = first;
+
+			for (int i = 0; i < count; i++, site = site->Next)
+			{
+				ret[i].Expression = gcnew String(site->Expression);
+				ret[i].File = gcnew String(site->File);
+				ret[i].Line = site->Line;
+				ret[i].Calls = (int)site->Calls;
+				ret[i].Failures = (int)site->Failures;
+				ret[i].LastResult = (int)site->LastResult;
+			}
+
+			return ret;
+		}
+
+		void CheckStatistics::Reset()
+		{
+			Checks::ResetCounters();
+		}
+
+		int CheckStatistics::SiteCount::get()
+		{
+			return Checks::GetSiteCount();
+		}
+
+		int CheckStatistics::TotalFailures::get()
+		{
+			return (int)Checks::GetTotalFailures();
+		}
+	}
+}
@@ -0,0 +1,170 @@
+#include "DirectSoundAudioSink.h"
+
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		static const DWORD FrameBytes = 4; // 16-bit stereo
+
+		DirectSoundAudioSink::DirectSoundAudioSink(IDirectSound* dsound, int sampleRate, int bufferMs, int latencyMs)
+		{
+			this->sampleRate = sampleRate;
+			buffer = 0;
+			writeOffset = 0;
+			isPrimed = false;
+			underruns = 0;
+
+			bufferBytes = (DWORD)(sampleRate * bufferMs / 1000) * FrameBytes;
+			latencyBytes = (DWORD)(sampleRate * latencyMs / 1000) * FrameBytes;
+
+			if (latencyBytes > bufferBytes / 4 * 3)
+				latencyBytes = bufferBytes / 4 * 3 / FrameBytes * FrameBytes;
+
+			WAVEFORMATEX fmt;
+			memset(&fmt, 0, sizeof(fmt));
+			fmt.wFormatTag = WAVE_FORMAT_PCM;
+			fmt.nChannels = 2;
+			fmt.nSamplesPerSec = sampleRate;
+			fmt.wBitsPerSample = 16;
+			fmt.nBlockAlign = (WORD)FrameBytes;
+			fmt.nAvgBytesPerSec = sampleRate * FrameBytes;
+
+			DSBUFFERDESC desc;
+			memset(&desc, 0, sizeof(desc));
+			desc.dwSize = sizeof(desc);
+			desc.dwFlags = DSBCAPS_GETCURRENTPOSITION2 | DSBCAPS_GLOBALFOCUS;
+			desc.dwBufferBytes = bufferBytes;
+			desc.lpwfxFormat = &fmt;
+
+			createResult = dsound->CreateSoundBuffer(&desc, &buffer, 0);
+
+			if (FAILED(createResult))
+			{
+				buffer = 0;
+				return;
+			}
+
+			// Start from silence, mixer catches up on first update
+			void* ptr;
+			DWORD bytes;
+
+			if (SUCCEEDED(buffer->Lock(0, bufferBytes, &ptr, &bytes, 0, 0, DSBLOCK_ENTIREBUFFER)))
+			{
+				memset(ptr, 0, bytes);
+				buffer->Unlock(ptr, bytes, 0, 0);
+			}
+
+			buffer->Play(0, 0, DSBPLAY_LOOPING);
+		}
+
+		DirectSoundAudioSink::~DirectSoundAudioSink()
+		{
+			if (buffer)
+			{
+				buffer->Stop();
+				buffer->Release();
+			}
+		}
+
+		HRESULT DirectSoundAudioSink::GetCreateResult()
+		{
+			return createResult;
+		}
+
+		long DirectSoundAudioSink::GetUnderrunCount()
+		{
+			return underruns;
+		}
+
+		bool DirectSoundAudioSink::Restore()
+		{
+			isPrimed = false;
+
+			if (FAILED(buffer->Restore()))
+				return false;
+
+			return SUCCEEDED(buffer->Play(0, 0, DSBPLAY_LOOPING));
+		}
+
+		int DirectSoundAudioSink::GetSampleRate()
+		{
+			return sampleRate;
+		}
+
+		int DirectSoundAudioSink::GetWritableFrames()
+		{
+			if (!buffer)
+				return 0;
+
+			DWORD play, write;
+
+			if (FAILED(buffer->GetCurrentPosition(&play, &write)))
+			{
+				Restore();
+				return 0;
+			}
+
+			if (!isPrimed)
+			{
+				writeOffset = write;
+				isPrimed = true;
+			}
+
+			DWORD queued = (writeOffset + bufferBytes - play) % bufferBytes;
+			DWORD safe = (write + bufferBytes - play) % bufferBytes;
+
+			// We never queue more than latencyBytes, so anything else means play cursor overtook us
+			if (queued < safe || queued > latencyBytes)
+			{
+				underruns++;
+				writeOffset = write;
+				queued = safe;
+			}
+
+			if (queued >= latencyBytes)
+				return 0;
+
+			return (int)((latencyBytes - queued) / FrameBytes);
+		}
+
+		void DirectSoundAudioSink::Write(const short* frames, int count)
+		{
+			if (!buffer || count <= 0)
+				return;
+
+			DWORD bytes = count * FrameBytes;
+			void* ptr1;
+			void* ptr2;
+			DWORD bytes1, bytes2;
+
+			HRESULT res = buffer->Lock(writeOffset, bytes, &ptr1, &bytes1, &ptr2, &bytes2, 0);
+
+			if (res == DSERR_BUFFERLOST)
+			{
+				Restore();
+				return;
+			}
+
+			if (FAILED(res))
+				return;
+
+			memcpy(ptr1, frames, bytes1);
+
+			if (ptr2)
+				memcpy(ptr2, (const char*)frames + bytes1, bytes2);
+
+			buffer->Unlock(ptr1, bytes1, ptr2, bytes2);
+			writeOffset = (writeOffset + bytes) % bufferBytes;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Windows.h>
+#include <MMReg.h>
+#include <dsound.h>
+
+#include "AudioSink.h"
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		// Single looping secondary buffer that the mixer keeps filled latencyMs ahead of the play cursor
+		class DirectSoundAudioSink : public AudioSink
+		{
+		private:
+			IDirectSoundBuffer* buffer;
+			int sampleRate;
+			DWORD bufferBytes;
+			DWORD latencyBytes;
+			DWORD writeOffset;
+			bool isPrimed;
+			long underruns;
+			HRESULT createResult;
+
+			bool Restore();
+		public:
+			DirectSoundAudioSink(IDirectSound* dsound, int sampleRate, int bufferMs, int latencyMs);
+			~DirectSoundAudioSink();
+
+			HRESULT GetCreateResult(); // Sink is silent if buffer couldn't be created
+			long GetUnderrunCount();
+
+			virtual int GetSampleRate();
+			virtual int GetWritableFrames();
+			virtual void Write(const short* frames, int count);
+		};
+	}
+}
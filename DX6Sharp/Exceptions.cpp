@@ -0,0 +1,120 @@
+#include "dxsharp.h"
+
+namespace DXSharp
+{
+	namespace Helpers
+	{
+		/* DirectXException */
+
+		DirectXException::DirectXException(const Checks::CheckSite& site, HRESULT res)
+			: Exception(FormatMessage(site, res))
+		{
+			HResult = res;
+			expression = gcnew String(site.Expression);
+			file = gcnew String(site.File);
+			line = site.Line;
+		}
+
+		String^ DirectXException::FormatMessage(const Checks::CheckSite& site, HRESULT res)
+		{
+			const char* name = Checks::GetErrorName(res);
+			String^ error = name ? gcnew String(name) : String::Format("0x{0:X8}", res);
+
+			return String::Format("Call to {0} failed with {1} ({2}:{3})", gcnew String(site.Expression), error, System::IO::Path::GetFileName(gcnew String(site.File)), site.Line);
+		}
+
+		int DirectXException::Result::get()
+		{
+			return HResult;
+		}
+
+		String^ DirectXException::Expression::get()
+		{
+			return expression;
+		}
+
+		String^ DirectXException::File::get()
+		{
+			return file;
+		}
+
+		int DirectXException::Line::get()
+		{
+			return line;
+		}
+
+		/* Specific failures */
+
+		GraphicsException::GraphicsException(const Checks::CheckSite& site, HRESULT res)
+			: DirectXException(site, res)
+		{
+		}
+
+		SurfaceLostException::SurfaceLostException(const Checks::CheckSite& site, HRESULT res)
+			: GraphicsException(site, res)
+		{
+		}
+
+		OutOfVideoMemoryException::OutOfVideoMemoryException(const Checks::CheckSite& site, HRESULT res)
+			: GraphicsException(site, res)
+		{
+		}
+
+		SoundException::SoundException(const Checks::CheckSite& site, HRESULT res)
+			: DirectXException(site, res)
+		{
+		}
+
+		BufferLostException::BufferLostException(const Checks::CheckSite& site, HRESULT res)
+			: SoundException(site, res)
+		{
+		}
+
+		DirectXOutOfMemoryException::DirectXOutOfMemoryException(const Checks::CheckSite& site, HRESULT res)
+			: DirectXException(site, res)
+		{
+		}
+
+		InvalidCallException::InvalidCallException(const Checks::CheckSite& site, HRESULT res)
+			: DirectXException(site, res)
+		{
+		}
+
+		UnsupportedFeatureException::UnsupportedFeatureException(const Checks::CheckSite& site, HRESULT res)
+			: DirectXException(site, res)
+		{
+		}
+
+		/* ExceptionManager */
+
+		void ExceptionManager::Throw(const Checks::CheckSite& site, HRESULT res)
+		{
+			switch (Checks::Classify(res))
+			{
+			case Checks::ErrorSurfaceLost:
+				throw gcnew SurfaceLostException(site, res);
+			case Checks::ErrorOutOfVideoMemory:
+				throw gcnew OutOfVideoMemoryException(site, res);
+			case Checks::ErrorBufferLost:
+				throw gcnew BufferLostException(site, res);
+			case Checks::ErrorOutOfMemory:
+				throw gcnew DirectXOutOfMemoryException(site, res);
+			case Checks::ErrorInvalidCall:
+				throw gcnew InvalidCallException(site, res);
+			case Checks::ErrorUnsupported:
+				throw gcnew UnsupportedFeatureException(site, res);
+			}
+
+			// Generic and still drawing - only the API it came from is known
+			switch (Checks::GetFacility(res))
+			{
+			case Checks::FacilityGraphics:
+				throw gcnew GraphicsException(site, res);
+			case Checks::FacilitySound:
+				throw gcnew SoundException(site, res);
+			}
+
+			throw gcnew DirectXException(site, res);
+		}
+	}
+}
@@ -0,0 +1,250 @@
+#include "dxsharp.h"
+
+using namespace System::IO;
+using namespace System::Collections::Generic;
+using namespace System::Runtime::InteropServices;
+
+namespace DXSharp
+{
+	namespace IO
+	{
+		// Paths are ASCII, so converting into a stack buffer saves an HGlobal round trip per lookup
+		static void ToAnsiPath(String^ path, char* buffer, int size)
+		{
+			int length = Math::Min(path->Length, size - 1);
+
+			for (int i = 0; i < length; i++)
+			{
+				wchar_t c = path[i];
+				buffer[i] = c < 128 ? (char)c : '?';
+			}
+
+			buffer[length] = 0;
+		}
+
+		// Owns the buffer an LZ4 entry was unpacked into
+		ref class ExtractedStream : UnmanagedMemoryStream
+		{
+		private:
+			IntPtr buffer;
+		public:
+			ExtractedStream(IntPtr buffer, unsigned int size)
+				: UnmanagedMemoryStream((unsigned char*)buffer.ToPointer(), size)
+			{
+				this->buffer = buffer;
+			}
+
+			~ExtractedStream()
+			{
+				this->!ExtractedStream();
+			}
+
+			!ExtractedStream()
+			{
+				if (buffer != IntPtr::Zero)
+				{
+					Marshal::FreeHGlobal(buffer);
+					buffer = IntPtr::Zero;
+				}
+			}
+		};
+
+		/* PackArchive */
+
+		PackArchive::PackArchive(String^ fileName, bool verifyChecksums)
+		{
+			this->fileName = fileName;
+			pack = new Assets::PackFile();
+
+			IntPtr name = Marshal::StringToHGlobalAnsi(fileName);
+			bool isOpen = pack->Open((const char*)name.ToPointer(), verifyChecksums);
+			Marshal::FreeHGlobal(name);
+
+			if (!isOpen)
+			{
+				delete pack;
+				pack = 0;
+
+				throw gcnew IOException(String::Format("Can't open pack {0}: file is missing or damaged", fileName));
+			}
+		}
+
+		PackArchive::~PackArchive()
+		{
+			this->!PackArchive();
+		}
+
+		PackArchive::!PackArchive()
+		{
+			delete pack;
+			pack = 0;
+		}
+
+		int PackArchive::Find(String^ path)
+		{
+			char buffer[Assets::PackFile::MaxPath];
+			ToAnsiPath(path, buffer, Assets::PackFile::MaxPath);
+
+			return pack->Find(buffer);
+		}
+
+		bool PackArchive::Contains(String^ path)
+		{
+			return Find(path) >= 0;
+		}
+
+		Stream^ PackArchive::Open(String^ path)
+		{
+			int index = Find(path);
+
+			return index >= 0 ? OpenEntry(index) : nullptr;
+		}
+
+		Stream^ PackArchive::OpenEntry(int index)
+		{
+			Assets::PackSpan span;
+
+			if (pack->GetSpan(index, &span))
+				return gcnew UnmanagedMemoryStream((unsigned char*)span.Data, span.Size);
+
+			if (!pack->IsCompressed(index))
+				return nullptr; // Failed verification
+
+			unsigned int size = pack->GetSize(index);
+			IntPtr buffer = Marshal::AllocHGlobal(Math::Max((int)size, 1));
+
+			if (!pack->Read(index, buffer.ToPointer(), size))
+			{
+				Marshal::FreeHGlobal(buffer);
+				return nullptr;
+			}
+
+			return gcnew ExtractedStream(buffer, size);
+		}
+
+		String^ PackArchive::FileName::get()
+		{
+			return fileName;
+		}
+
+		int PackArchive::EntryCount::get()
+		{
+			return pack->GetEntryCount();
+		}
+
+		int PackArchive::FailedCount::get()
+		{
+			return pack->GetFailedCount();
+		}
+
+		/* FileSystem */
+
+		FileSystem::FileSystem()
+		{
+			packs = gcnew List<PackArchive^>();
+			allowLooseFiles = true;
+			verifyChecksums = false;
+		}
+
+		void FileSystem::Mount(String^ fileName)
+		{
+			PackArchive^ pack = gcnew PackArchive(fileName, verifyChecksums);
+
+			// Newest first, so patch packs override what's already mounted
+			packs->Insert(0, pack);
+		}
+
+		void FileSystem::UnmountAll()
+		{
+			for each (PackArchive^ pack in packs)
+				delete pack;
+
+			packs->Clear();
+		}
+
+		bool FileSystem::TryGetSpan(String^ path, Assets::PackSpan* span)
+		{
+			for each (PackArchive^ pack in packs)
+			{
+				int index = pack->Find(path);
+
+				if (index >= 0)
+				{
+					if (!pack->pack->GetSpan(index, span))
+						return false;
+
+					packReads++;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool FileSystem::Exists(String^ path)
+		{
+			for each (PackArchive^ pack in packs)
+			{
+				if (pack->Contains(path))
+					return true;
+			}
+
+			return allowLooseFiles && File::Exists(path);
+		}
+
+		Stream^ FileSystem::Open(String^ path)
+		{
+			for each (PackArchive^ pack in packs)
+			{
+				int index = pack->Find(path);
+
+				if (index >= 0)
+				{
+					Stream^ ret = pack->OpenEntry(index);
+
+					if (ret != nullptr)
+						packReads++;
+
+					return ret;
+				}
+			}
+
+			if (!allowLooseFiles || !File::Exists(path))
+				return nullptr;
+
+			looseReads++;
+
+			return File::OpenRead(path);
+		}
+
+		bool FileSystem::AllowLooseFiles::get()
+		{
+			return allowLooseFiles;
+		}
+
+		void FileSystem::AllowLooseFiles::set(bool value)
+		{
+			allowLooseFiles = value;
+		}
+
+		bool FileSystem::VerifyChecksums::get()
+		{
+			return verifyChecksums;
+		}
+
+		void FileSystem::VerifyChecksums::set(bool value)
+		{
+			verifyChecksums = value;
+		}
+
+		int FileSystem::PackReads::get()
+		{
+			return packReads;
+		}
+
+		int FileSystem::LooseReads::get()
+		{
+			return looseReads;
+		}
+	}
+}
@@ -0,0 +1,331 @@
+#include "FrameClock.h"
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Timing
+	{
+		/* Clock sources */
+
+		Platform::UInt64 SystemClockSource::GetTicks()
+		{
+			return Platform::GetPerformanceCounter();
+		}
+
+		Platform::UInt64 SystemClockSource::GetFrequency()
+		{
+			return Platform::GetPerformanceFrequency();
+		}
+
+		void SystemClockSource::Sleep(int ms)
+		{
+			Platform::SleepMs(ms);
+		}
+
+		void SystemClockSource::Spin()
+		{
+		}
+
+		ManualClockSource::ManualClockSource(Platform::UInt64 frequency)
+		{
+			this->frequency = frequency;
+			ticks = 0;
+		}
+
+		void ManualClockSource::Advance(double seconds)
+		{
+			ticks += (Platform::UInt64)(seconds * (double)(Platform::Int64)frequency + 0.5);
+		}
+
+		Platform::UInt64 ManualClockSource::GetTicks()
+		{
+			return ticks;
+		}
+
+		Platform::UInt64 ManualClockSource::GetFrequency()
+		{
+			return frequency;
+		}
+
+		void ManualClockSource::Sleep(int ms)
+		{
+			Advance(ms > 0 ? ms / 1000.0 : 0.00001); // Yielding with Sleep(0) still has to make progress
+		}
+
+		void ManualClockSource::Spin()
+		{
+			Platform::UInt64 microsecond = frequency / 1000000;
+
+			ticks += microsecond ? microsecond : 1;
+		}
+
+		/* FrameHistogram */
+
+		const double FrameHistogram::BucketWidth = 0.00025;
+
+		FrameHistogram::FrameHistogram()
+		{
+			Reset();
+		}
+
+		void FrameHistogram::Reset()
+		{
+			for (int i = 0; i < BucketCount; i++)
+				buckets[i] = 0;
+
+			count = 0;
+			total = 0;
+			minTime = 0;
+			maxTime = 0;
+		}
+
+		void FrameHistogram::Add(double seconds)
+		{
+			int bucket = (int)(seconds / BucketWidth);
+
+			if (bucket < 0)
+				bucket = 0;
+
+			if (bucket >= BucketCount)
+				bucket = BucketCount - 1;
+
+			buckets[bucket]++;
+
+			if (count == 0 || seconds < minTime)
+				minTime = seconds;
+
+			if (count == 0 || seconds > maxTime)
+				maxTime = seconds;
+
+			count++;
+			total += seconds;
+		}
+
+		unsigned int FrameHistogram::GetCount()
+		{
+			return count;
+		}
+
+		double FrameHistogram::GetAverage()
+		{
+			return count ? total / count : 0;
+		}
+
+		double FrameHistogram::GetMin()
+		{
+			return minTime;
+		}
+
+		double FrameHistogram::GetMax()
+		{
+			return maxTime;
+		}
+
+		double FrameHistogram::GetPercentile(double percent)
+		{
+			if (count == 0)
+				return 0;
+
+			double threshold = (percent / 100.0) * count;
+			unsigned int accum = 0;
+
+			for (int i = 0; i < BucketCount; i++)
+			{
+				accum += buckets[i];
+
+				if (accum >= threshold && accum > 0)
+				{
+					double bound = (i + 1) * BucketWidth;
+
+					return i == BucketCount - 1 || bound > maxTime ? maxTime : bound;
+				}
+			}
+
+			return maxTime;
+		}
+
+		/* FrameClock */
+
+		const double FrameClock::SpinTime = 0.0005;
+
+		FrameClock::FrameClock(ClockSource* source, bool ownsSource, double fixedStep)
+		{
+			this->source = source;
+			this->ownsSource = ownsSource;
+
+			invFrequency = 1.0 / (double)(Platform::Int64)source->GetFrequency();
+			this->fixedStep = fixedStep;
+			maxFrameTime = 0.25;
+			maxStepsPerFrame = 8;
+			targetFrameTime = 0;
+			spinThreshold = 0.002; // Sleep(1) on 9x may oversleep up to a whole scheduler quantum
+
+			frameStart = lastFrameStart = source->GetTicks();
+			isFirstFrame = true;
+
+			frameTime = 0;
+			accumulator = 0;
+			simulationTime = 0;
+			realTime = 0;
+			stepsThisFrame = 0;
+			frameIndex = 0;
+		}
+
+		FrameClock::~FrameClock()
+		{
+			if (ownsSource)
+				delete source;
+		}
+
+		double FrameClock::ToSeconds(Platform::UInt64 ticks)
+		{
+			return (double)(Platform::Int64)ticks * invFrequency;
+		}
+
+		void FrameClock::SetFixedStep(double seconds)
+		{
+			if (seconds > 0)
+				fixedStep = seconds;
+		}
+
+		void FrameClock::SetMaxStepsPerFrame(int steps)
+		{
+			maxStepsPerFrame = steps > 0 ? steps : 1;
+		}
+
+		void FrameClock::SetMaxFrameTime(double seconds)
+		{
+			maxFrameTime = seconds;
+		}
+
+		void FrameClock::SetFrameRateLimit(double fps)
+		{
+			targetFrameTime = fps > 0 ? 1.0 / fps : 0;
+		}
+
+		double FrameClock::GetFrameRateLimit()
+		{
+			return targetFrameTime > 0 ? 1.0 / targetFrameTime : 0;
+		}
+
+		void FrameClock::SetSpinThreshold(double seconds)
+		{
+			spinThreshold = seconds;
+		}
+
+		void FrameClock::BeginFrame()
+		{
+			Platform::UInt64 now = source->GetTicks();
+
+			lastFrameStart = frameStart;
+			frameStart = now;
+
+			if (isFirstFrame)
+			{
+				// First frame has nothing to measure against, run exactly one step
+				frameTime = fixedStep;
+				isFirstFrame = false;
+			}
+			else
+			{
+				frameTime = ToSeconds(frameStart - lastFrameStart);
+				histogram.Add(frameTime);
+			}
+
+			realTime += frameTime;
+			accumulator += frameTime > maxFrameTime ? maxFrameTime : frameTime;
+			stepsThisFrame = 0;
+			frameIndex++;
+		}
+
+		bool FrameClock::Step()
+		{
+			if (accumulator < fixedStep)
+				return false;
+
+			if (stepsThisFrame >= maxStepsPerFrame)
+			{
+				// Can't keep up - drop whole steps and let simulation run slower than real time
+				while (accumulator >= fixedStep)
+					accumulator -= fixedStep;
+
+				return false;
+			}
+
+			accumulator -= fixedStep;
+			simulationTime += fixedStep;
+			stepsThisFrame++;
+
+			return true;
+		}
+
+		void FrameClock::EndFrame()
+		{
+			if (targetFrameTime <= 0)
+				return;
+
+			for (;;)
+			{
+				double elapsed = ToSeconds(source->GetTicks() - frameStart);
+				double remaining = targetFrameTime - elapsed;
+
+				if (remaining <= 0)
+					break;
+
+				if (remaining > spinThreshold)
+					source->Sleep((int)((remaining - spinThreshold) * 1000.0));
+				else if (remaining > SpinTime)
+					source->Sleep(0);
+				else
+					source->Spin(); // Sleep(0) gives up the quantum on 9x, so the end is never left to the scheduler
+			}
+		}
+
+		double FrameClock::GetFixedStep()
+		{
+			return fixedStep;
+		}
+
+		double FrameClock::GetFrameTime()
+		{
+			return frameTime;
+		}
+
+		double FrameClock::GetAlpha()
+		{
+			return accumulator / fixedStep;
+		}
+
+		double FrameClock::GetSimulationTime()
+		{
+			return simulationTime;
+		}
+
+		double FrameClock::GetRealTime()
+		{
+			return realTime;
+		}
+
+		int FrameClock::GetStepsThisFrame()
+		{
+			return stepsThisFrame;
+		}
+
+		Platform::UInt64 FrameClock::GetFrameIndex()
+		{
+			return frameIndex;
+		}
+
+		FrameHistogram& FrameClock::GetHistogram()
+		{
+			return histogram;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
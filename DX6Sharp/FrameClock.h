@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Timing
+	{
+		// Time source used by FrameClock. Replaced with ManualClockSource to drive pacing logic deterministically.
+		class ClockSource
+		{
+		public:
+			virtual ~ClockSource() { }
+
+			virtual Platform::UInt64 GetTicks() = 0;
+			virtual Platform::UInt64 GetFrequency() = 0;
+			virtual void Sleep(int ms) = 0;
+			virtual void Spin() = 0; // One turn of a busy wait, keeps the time slice
+		};
+
+		class SystemClockSource : public ClockSource
+		{
+		public:
+			virtual Platform::UInt64 GetTicks();
+			virtual Platform::UInt64 GetFrequency();
+			virtual void Sleep(int ms);
+			virtual void Spin();
+		};
+
+		// Time only moves when told to. Sleep and Spin advance it too, so pacing loops terminate.
+		class ManualClockSource : public ClockSource
+		{
+		private:
+			Platform::UInt64 ticks;
+			Platform::UInt64 frequency;
+		public:
+			ManualClockSource(Platform::UInt64 frequency);
+
+			void Advance(double seconds);
+
+			virtual Platform::UInt64 GetTicks();
+			virtual Platform::UInt64 GetFrequency();
+			virtual void Sleep(int ms);
+			virtual void Spin();
+		};
+
+		// Frame times in 0.25ms buckets up to 64ms, everything slower lands in the last bucket
+		class FrameHistogram
+		{
+		public:
+			static const int BucketCount = 256;
+			static const double BucketWidth;
+		private:
+			unsigned int buckets[BucketCount];
+			unsigned int count;
+			double total;
+			double minTime;
+			double maxTime;
+		public:
+			FrameHistogram();
+
+			void Reset();
+			void Add(double seconds);
+
+			unsigned int GetCount();
+			double GetAverage();
+			double GetMin();
+			double GetMax();
+			double GetPercentile(double percent); // Upper bound of bucket containing percentile, in seconds
+		};
+
+		// Fixed-timestep frame clock:
+		//   BeginFrame();
+		//   while (Step()) Simulate(GetFixedStep());
+		//   Render(GetAlpha());
+		//   EndFrame(); // Sleeps, yields, then spins to honour frame rate limit
+		//
+		// The limiter sleeps until spinThreshold is left, yields with Sleep(0) until SpinTime is left and busy-waits
+		// the rest. Only the busy wait is exact: a Sleep(0) that hands the quantum to another ready thread can still
+		// come back late by up to a scheduler tick (1ms with timeBeginPeriod(1), ~55ms on 9x without it).
+		class FrameClock
+		{
+		public:
+			static const double SpinTime; // Last part of a limited frame that is busy-waited without yielding
+		private:
+			ClockSource* source;
+			bool ownsSource;
+
+			double invFrequency;
+			double fixedStep;
+			double maxFrameTime; // Longer frames are clamped to avoid spiral of death after hitches
+			int maxStepsPerFrame;
+			double targetFrameTime;
+			double spinThreshold; // Remaining time below which we stop sleeping
+
+			Platform::UInt64 frameStart;
+			Platform::UInt64 lastFrameStart;
+			bool isFirstFrame;
+
+			double frameTime;
+			double accumulator;
+			double simulationTime;
+			double realTime;
+			int stepsThisFrame;
+			Platform::UInt64 frameIndex;
+
+			FrameHistogram histogram;
+
+			double ToSeconds(Platform::UInt64 ticks);
+		public:
+			FrameClock(ClockSource* source, bool ownsSource, double fixedStep);
+			~FrameClock();
+
+			void SetFixedStep(double seconds);
+			void SetMaxStepsPerFrame(int steps);
+			void SetMaxFrameTime(double seconds);
+			void SetFrameRateLimit(double fps); // 0 disables limit
+			double GetFrameRateLimit();
+			void SetSpinThreshold(double seconds);
+
+			void BeginFrame();
+			bool Step();
+			void EndFrame();
+
+			double GetFixedStep();
+			double GetFrameTime();
+			double GetAlpha();
+			double GetSimulationTime();
+			double GetRealTime();
+			int GetStepsThisFrame();
+			Platform::UInt64 GetFrameIndex();
+
+			FrameHistogram& GetHistogram();
+		};
+	}
+}
@@ -0,0 +1,177 @@
+#include "HResultCheck.h"
+#include "Logger.h"
+
+#include <stdio.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Checks
+	{
+		namespace
+		{
+			// Facilities from ddraw.h (_FACDD) and dsound.h (_FACDS)
+			const unsigned int FacilityDD = 0x876;
+			const unsigned int FacilityDS = 0x878;
+
+			struct KnownError
+			{
+				unsigned int Result;
+				CheckError Error;
+				const char* Name;
+			};
+
+			// Values spelled out so this compiles without the DirectX headers. Aliases (DDERR_OUTOFMEMORY == E_OUTOFMEMORY etc.)
+			// are listed once under the COM name.
+			const KnownError KnownErrors[] =
+			{
+				{ 0x80004001, ErrorUnsupported, "E_NOTIMPL" },
+				{ 0x80004002, ErrorUnsupported, "E_NOINTERFACE" },
+				{ 0x80004005, ErrorGeneric, "E_FAIL" },
+				{ 0x8007000E, ErrorOutOfMemory, "E_OUTOFMEMORY" },
+				{ 0x80070057, ErrorInvalidCall, "E_INVALIDARG" },
+
+				{ 0x88760082, ErrorInvalidCall, "DDERR_INVALIDOBJECT" },
+				{ 0x88760091, ErrorUnsupported, "DDERR_INVALIDPIXELFORMAT" },
+				{ 0x887600FF, ErrorGeneric, "DDERR_NOTFOUND" },
+				{ 0x8876017C, ErrorOutOfVideoMemory, "DDERR_OUTOFVIDEOMEMORY" },
+				{ 0x887601AE, ErrorStillDrawing, "DDERR_SURFACEBUSY" },
+				{ 0x887601C2, ErrorSurfaceLost, "DDERR_SURFACELOST" },
+				{ 0x8876021C, ErrorStillDrawing, "DDERR_WASSTILLDRAWING" },
+				{ 0x88760248, ErrorInvalidCall, "DDERR_NOTLOCKED" },
+				{ 0x88760302, ErrorInvalidCall, "D3DERR_SCENE_IN_SCENE" },
+				{ 0x88760303, ErrorInvalidCall, "D3DERR_SCENE_NOT_IN_SCENE" },
+				{ 0x88760304, ErrorGeneric, "D3DERR_SCENE_BEGIN_FAILED" },
+				{ 0x88760305, ErrorGeneric, "D3DERR_SCENE_END_FAILED" },
+
+				{ 0x8878000A, ErrorGeneric, "DSERR_ALLOCATED" },
+				{ 0x8878001E, ErrorUnsupported, "DSERR_CONTROLUNAVAIL" },
+				{ 0x88780032, ErrorInvalidCall, "DSERR_INVALIDCALL" },
+				{ 0x88780046, ErrorInvalidCall, "DSERR_PRIOLEVELNEEDED" },
+				{ 0x88780064, ErrorUnsupported, "DSERR_BADFORMAT" },
+				{ 0x88780078, ErrorUnsupported, "DSERR_NODRIVER" },
+				{ 0x88780096, ErrorBufferLost, "DSERR_BUFFERLOST" },
+				{ 0x887800AA, ErrorInvalidCall, "DSERR_UNINITIALIZED" }
+			};
+
+			const int KnownErrorCount = sizeof(KnownErrors) / sizeof(KnownErrors[0]);
+
+			const KnownError* Find(HRESULT res)
+			{
+				for (int i = 0; i < KnownErrorCount; i++)
+				{
+					if (KnownErrors[i].Result == (unsigned int)res)
+						return &KnownErrors[i];
+				}
+
+				return 0;
+			}
+
+			CheckSite* volatile firstSite = 0;
+			volatile long siteCount = 0;
+			Platform::SpinLock registerLock;
+		}
+
+		void Register(CheckSite& site)
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(registerLock);
+
+			// Also reached after ResetCounters() or if two threads raced the first call
+			if (site.IsRegistered)
+				return;
+
+			site.Next = firstSite;
+			Platform::FullBarrier(); // Readers walking the list must never see a half linked site
+			firstSite = &site;
+			site.IsRegistered = 1;
+			siteCount++;
+		}
+
+		void Fail(CheckSite& site, HRESULT res)
+		{
+			LOG_SITE(failSite, "Checks", LogError, "{0} at line {1}: {2}");
+
+			if (!Platform::AtomicRead(&site.IsRegistered))
+				Register(site);
+
+			Platform::AtomicIncrement(&site.Failures);
+			Platform::AtomicExchange(&site.LastResult, (long)res);
+
+			if (Logging::Logger::IsEnabled(failSite))
+			{
+				const char* name = GetErrorName(res);
+				char hex[16];
+
+				if (!name)
+				{
+					sprintf(hex, "0x%08X", (unsigned int)res);
+					name = hex;
+				}
+
+				Logging::Logger::Write(failSite, name, site.Line, site.Expression);
+			}
+		}
+
+		CheckError Classify(HRESULT res)
+		{
+			const KnownError* known = Find(res);
+			return known ? known->Error : ErrorGeneric;
+		}
+
+		CheckFacility GetFacility(HRESULT res)
+		{
+			unsigned int facility = ((unsigned int)res >> 16) & 0x1FFF;
+
+			if (facility == FacilityDD)
+				return FacilityGraphics;
+
+			if (facility == FacilityDS)
+				return FacilitySound;
+
+			return FacilitySystem;
+		}
+
+		const char* GetErrorName(HRESULT res)
+		{
+			const KnownError* known = Find(res);
+			return known ? known->Name : 0;
+		}
+
+		CheckSite* GetFirstSite()
+		{
+			return firstSite;
+		}
+
+		int GetSiteCount()
+		{
+			return siteCount;
+		}
+
+		long GetTotalFailures()
+		{
+			long total = 0;
+
+			for (CheckSite* site = firstSite; site; site = site->Next)
+				total += site->Failures;
+
+			return total;
+		}
+
+		void ResetCounters()
+		{
+			for (CheckSite* site = firstSite; site; site = site->Next)
+			{
+				site->Calls = 0;
+				site->Failures = 0;
+				site->LastResult = 0;
+			}
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Platform.h"
+
+// Stand-ins so the checking core builds without the Windows SDK
+#ifndef _WIN32
+typedef int HRESULT; // 32 bits like on Windows, long is 64 on LP64
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005)
+#endif
+
+#if defined(__GNUC__)
+#define CHECK_UNLIKELY(expr) __builtin_expect(!!(expr), 0)
+#else
+#define CHECK_UNLIKELY(expr) (expr)
+#endif
+
+namespace DXSharp
+{
+	namespace Checks
+	{
+		// Static descriptor of one checked call. Statics are constant-initialized, so declaring one costs nothing at runtime.
+		// Counters are bumped atomically, a site may be shared by the game and the render thread.
+		struct CheckSite
+		{
+			const char* File;
+			int Line;
+			const char* Expression;
+			volatile long Calls;
+			volatile long Failures;
+			volatile long LastResult;
+			CheckSite* Next; // Registry link, set on first call
+			volatile long IsRegistered;
+		};
+
+		// Declares a function-local static site: CHECK_SITE(site, "device->EndScene()");
+		#define CHECK_SITE(name, expression) \
+			static DXSharp::Checks::CheckSite name = { __FILE__, __LINE__, expression, 0, 0, 0, 0, 0 }
+
+		// What went wrong, independent of which API returned it. Managed side maps these to exception types.
+		enum CheckError
+		{
+			ErrorGeneric,
+			ErrorOutOfMemory,
+			ErrorOutOfVideoMemory,
+			ErrorSurfaceLost,
+			ErrorBufferLost,
+			ErrorInvalidCall,
+			ErrorUnsupported,
+			ErrorStillDrawing
+		};
+
+		enum CheckFacility
+		{
+			FacilitySystem,
+			FacilityGraphics, // DirectDraw and Direct3D share one facility
+			FacilitySound
+		};
+
+		void Register(CheckSite& site);
+		void Fail(CheckSite& site, HRESULT res); // Counts and logs the failure, never throws
+
+		// Fast path is an interlocked counter bump and a sign test. Returns true if res is a failure.
+		inline bool Check(CheckSite& site, HRESULT res)
+		{
+			if (CHECK_UNLIKELY(Platform::AtomicIncrement(&site.Calls) == 1))
+				Register(site);
+
+			if (CHECK_UNLIKELY(FAILED(res)))
+			{
+				Fail(site, res);
+				return true;
+			}
+
+			return false;
+		}
+
+		CheckError Classify(HRESULT res);
+		CheckFacility GetFacility(HRESULT res);
+		const char* GetErrorName(HRESULT res); // Symbolic name such as "DDERR_SURFACELOST", 0 if unknown
+
+		// Sites are linked in order of first use. List is only ever prepended, so walking it needs no lock.
+		CheckSite* GetFirstSite();
+		int GetSiteCount();
+		long GetTotalFailures();
+		void ResetCounters(); // Sites stay registered
+	}
+}
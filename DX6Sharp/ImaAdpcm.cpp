@@ -0,0 +1,139 @@
+#include "ImaAdpcm.h"
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		static const int IndexTable[16] =
+		{
+			-1, -1, -1, -1, 2, 4, 6, 8,
+			-1, -1, -1, -1, 2, 4, 6, 8
+		};
+
+		static const int StepTable[89] =
+		{
+			7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+			19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+			50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+			130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+			337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+			876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+			2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+			5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+			15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+		};
+
+		struct ChannelState
+		{
+			int Predictor;
+			int Index;
+		};
+
+		static inline short DecodeNibble(ChannelState& state, int code)
+		{
+			int step = StepTable[state.Index];
+			int diff = step >> 3;
+
+			if (code & 1)
+				diff += step >> 2;
+
+			if (code & 2)
+				diff += step >> 1;
+
+			if (code & 4)
+				diff += step;
+
+			if (code & 8)
+				state.Predictor -= diff;
+			else
+				state.Predictor += diff;
+
+			if (state.Predictor > 32767)
+				state.Predictor = 32767;
+
+			if (state.Predictor < -32768)
+				state.Predictor = -32768;
+
+			state.Index += IndexTable[code];
+
+			if (state.Index < 0)
+				state.Index = 0;
+
+			if (state.Index > 88)
+				state.Index = 88;
+
+			return (short)state.Predictor;
+		}
+
+		int GetImaAdpcmBlockFrames(int blockBytes, int channels)
+		{
+			int header = 4 * channels;
+
+			if (channels <= 0 || blockBytes < header)
+				return 0;
+
+			// Codes come in 4-byte runs per channel, 8 samples each
+			return 1 + (blockBytes - header) / header * 8;
+		}
+
+		int DecodeImaAdpcmBlock(const unsigned char* block, int blockBytes, int channels, short* out, int maxFrames)
+		{
+			ChannelState state[8];
+
+			if (channels > 8)
+				return 0;
+
+			int frames = GetImaAdpcmBlockFrames(blockBytes, channels);
+
+			if (frames > maxFrames)
+				frames = maxFrames;
+
+			if (frames <= 0)
+				return 0;
+
+			// Header sample is the first output sample
+			for (int c = 0; c < channels; c++)
+			{
+				const unsigned char* hdr = block + c * 4;
+
+				state[c].Predictor = (short)(hdr[0] | (hdr[1] << 8));
+				state[c].Index = hdr[2] > 88 ? 88 : hdr[2];
+
+				out[c] = (short)state[c].Predictor;
+			}
+
+			const unsigned char* codes = block + 4 * channels;
+			int frame = 1;
+
+			while (frame < frames)
+			{
+				int count = frames - frame < 8 ? frames - frame : 8;
+
+				for (int c = 0; c < channels; c++)
+				{
+					const unsigned char* run = codes + c * 4;
+					short* dst = out + frame * channels + c;
+
+					for (int i = 0; i < count; i++)
+					{
+						int code = (i & 1) ? run[i >> 1] >> 4 : run[i >> 1] & 0x0F;
+						dst[i * channels] = DecodeNibble(state[c], code);
+					}
+				}
+
+				codes += 4 * channels;
+				frame += count;
+			}
+
+			return frames;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
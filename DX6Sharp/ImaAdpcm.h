@@ -0,0 +1,15 @@
+#pragma once
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		// Microsoft flavour of IMA ADPCM (WAVE_FORMAT_IMA_ADPCM). Each block starts with per-channel
+		// predictor/step header, followed by 4-bit codes interleaved in 4-byte runs per channel.
+
+		int GetImaAdpcmBlockFrames(int blockBytes, int channels); // Frames stored in a (possibly truncated) block
+
+		// Decodes one block into interleaved 16-bit PCM, returns frame count
+		int DecodeImaAdpcmBlock(const unsigned char* block, int blockBytes, int channels, short* out, int maxFrames);
+	}
+}
@@ -0,0 +1,411 @@
+#include "JobSystem.h"
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Jobs
+	{
+		/* JobDeque */
+
+		JobDeque::JobDeque()
+		{
+			top = 0;
+			bottom = 0;
+		}
+
+		bool JobDeque::Push(const Job& job)
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(lock);
+
+			if (bottom - top >= Capacity)
+				return false;
+
+			jobs[bottom % Capacity] = job;
+			bottom++;
+
+			return true;
+		}
+
+		bool JobDeque::Pop(Job* job)
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(lock);
+
+			if (bottom == top)
+				return false;
+
+			bottom--;
+			*job = jobs[bottom % Capacity];
+
+			return true;
+		}
+
+		bool JobDeque::Steal(Job* job)
+		{
+			if (!lock.TryLock()) // Someone else is already working on this deque, try next one
+				return false;
+
+			bool found = bottom != top;
+
+			if (found)
+			{
+				*job = jobs[top % Capacity];
+				top++;
+			}
+
+			lock.Unlock();
+
+			return found;
+		}
+
+		bool JobDeque::PopFront(Job* job)
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(lock);
+
+			if (bottom == top)
+				return false;
+
+			*job = jobs[top % Capacity];
+			top++;
+
+			return true;
+		}
+
+		int JobDeque::Count()
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(lock);
+
+			return bottom - top;
+		}
+
+		/* Counters */
+
+		void ReleaseCounter(JobCounter* counter)
+		{
+			// Exactly one side sees the count at zero with the flag set: this one, or Complete() of the last job
+			if (Platform::AtomicAdd(&counter->Value, OrphanedCounter) == OrphanedCounter)
+				delete counter;
+		}
+
+		static long GetOutstanding(JobCounter* counter)
+		{
+			return Platform::AtomicRead(&counter->Value) & (OrphanedCounter - 1);
+		}
+
+		/* JobSystem */
+
+		JobSystem::JobSystem(int workerCount, bool deterministic) : wakeUp(0)
+		{
+			if (workerCount < 0 || deterministic)
+				workerCount = 0;
+
+			this->workerCount = workerCount;
+			this->deterministic = deterministic;
+			isRunning = 1;
+			freeContinuations = 0;
+			allocatedContinuations = 0;
+
+			deques = new JobDeque[workerCount + 1];
+			workers = new Worker[workerCount + 1];
+
+			for (int i = 0; i <= workerCount; i++)
+			{
+				workers[i].system = this;
+				workers[i].index = i;
+				workers[i].randomSeed = 0x9E3779B9u * (i + 1);
+			}
+
+			currentWorker.Set(&workers[0]);
+
+			for (int i = 1; i <= workerCount; i++)
+				workers[i].thread.Start(WorkerEntry, &workers[i]);
+		}
+
+		JobSystem::~JobSystem()
+		{
+			Platform::AtomicExchange(&isRunning, 0);
+			wakeUp.Release(workerCount);
+
+			for (int i = 1; i <= workerCount; i++)
+				workers[i].thread.Join();
+
+			delete[] workers;
+			delete[] deques;
+
+			while (allocatedContinuations)
+			{
+				Continuation* next = allocatedContinuations->NextAllocated;
+				delete allocatedContinuations;
+				allocatedContinuations = next;
+			}
+		}
+
+		int JobSystem::GetWorkerCount()
+		{
+			return workerCount;
+		}
+
+		bool JobSystem::IsDeterministic()
+		{
+			return deterministic;
+		}
+
+		void JobSystem::WorkerEntry(void* arg)
+		{
+			Worker* worker = (Worker*)arg;
+			JobSystem* system = worker->system;
+
+			system->currentWorker.Set(worker);
+
+			while (Platform::AtomicRead(&system->isRunning))
+			{
+				Job job;
+
+				if (system->FindJob(worker->index, &worker->randomSeed, &job))
+					system->Execute(job);
+				else
+					system->wakeUp.Wait(); // Each submitted job releases semaphore once, so sleeping here can't miss work
+			}
+		}
+
+		int JobSystem::GetCurrentDeque()
+		{
+			Worker* worker = (Worker*)currentWorker.Get();
+
+			// Threads that aren't part of the pool share owner's deque
+			return worker ? worker->index : 0;
+		}
+
+		bool JobSystem::FindJob(int dequeIndex, unsigned int* seed, Job* job)
+		{
+			if (deterministic)
+				return deques[0].PopFront(job);
+
+			if (deques[dequeIndex].Pop(job))
+				return true;
+
+			// Start stealing from random victim to spread contention
+			*seed = *seed * 1103515245u + 12345u;
+			int victim = (int)((*seed >> 16) % (unsigned int)(workerCount + 1));
+
+			for (int i = 0; i <= workerCount; i++)
+			{
+				int index = (victim + i) % (workerCount + 1);
+
+				if (index != dequeIndex && deques[index].Steal(job))
+					return true;
+			}
+
+			return false;
+		}
+
+		void JobSystem::Execute(const Job& job)
+		{
+			job.Function(job.Data, job.Start, job.End);
+
+			if (job.Counter)
+				Complete(job.Counter);
+		}
+
+		void JobSystem::Complete(JobCounter* counter)
+		{
+			// Not the last job, so nothing can be released yet and the lock isn't needed
+			for (;;)
+			{
+				long value = Platform::AtomicRead(&counter->Value);
+
+				if ((value & (OrphanedCounter - 1)) <= 1)
+					break;
+
+				if (Platform::AtomicCompareExchange(&counter->Value, value - 1, value) == value)
+					return;
+			}
+
+			Continuation* ready = 0;
+
+			// The decrement is the last access to the counter, a waiter may free it as soon as it sees zero
+			continuationLock.Lock();
+
+			if (GetOutstanding(counter) == 1)
+			{
+				ready = counter->Waiting;
+				counter->Waiting = 0;
+			}
+
+			long remaining = Platform::AtomicDecrement(&counter->Value);
+
+			continuationLock.Unlock();
+
+			if (remaining == OrphanedCounter)
+				delete counter;
+
+			// Parked in reverse, flip back so dependents start in submission order
+			Continuation* ordered = 0;
+
+			while (ready)
+			{
+				Continuation* next = ready->Next;
+				ready->Next = ordered;
+				ordered = ready;
+				ready = next;
+			}
+
+			while (ordered)
+			{
+				Job job = ordered->Pending;
+				job.DependsOn = 0;
+
+				continuationLock.Lock();
+				Continuation* next = ordered->Next;
+				ordered->Next = freeContinuations;
+				freeContinuations = ordered;
+				continuationLock.Unlock();
+
+				Enqueue(job);
+				ordered = next;
+			}
+		}
+
+		void JobSystem::Schedule(const Job& job)
+		{
+			if (job.DependsOn && GetOutstanding(job.DependsOn) > 0)
+			{
+				continuationLock.Lock();
+
+				if (GetOutstanding(job.DependsOn) > 0)
+				{
+					Continuation* node = freeContinuations;
+
+					if (node)
+					{
+						freeContinuations = node->Next;
+					}
+					else
+					{
+						// Pool only grows until the deepest frame was seen once
+						node = new Continuation();
+						node->NextAllocated = allocatedContinuations;
+						allocatedContinuations = node;
+					}
+
+					node->Pending = job;
+					node->Next = job.DependsOn->Waiting;
+					job.DependsOn->Waiting = node;
+
+					continuationLock.Unlock();
+					return;
+				}
+
+				continuationLock.Unlock();
+			}
+
+			Enqueue(job);
+		}
+
+		void JobSystem::Enqueue(const Job& job)
+		{
+			if (!deques[GetCurrentDeque()].Push(job))
+			{
+				Execute(job); // Deque is full, run it right away instead of dropping
+				return;
+			}
+
+			wakeUp.Release(1);
+		}
+
+		void JobSystem::Submit(JobFunction func, void* data, int start, int end, JobCounter* counter, JobCounter* dependsOn)
+		{
+			Job job;
+			job.Function = func;
+			job.Data = data;
+			job.Start = start;
+			job.End = end;
+			job.Counter = counter;
+			job.DependsOn = dependsOn;
+
+			if (counter)
+				Platform::AtomicIncrement(&counter->Value);
+
+			Schedule(job);
+		}
+
+		int JobSystem::ParallelFor(JobFunction func, void* data, int count, int minBatch, JobCounter* counter, JobCounter* dependsOn)
+		{
+			if (count <= 0)
+				return 0;
+
+			if (minBatch < 1)
+				minBatch = 1;
+
+			// Aim for ~4 batches per thread so stealing can even out uneven items
+			int batch = count / ((workerCount + 1) * 4);
+
+			if (batch < minBatch)
+				batch = minBatch;
+
+			int jobCount = (count + batch - 1) / batch;
+
+			if (counter)
+				Platform::AtomicAdd(&counter->Value, jobCount);
+
+			for (int i = 0; i < jobCount; i++)
+			{
+				Job job;
+				job.Function = func;
+				job.Data = data;
+				job.Start = i * batch;
+				job.End = job.Start + batch < count ? job.Start + batch : count;
+				job.Counter = counter;
+				job.DependsOn = dependsOn;
+
+				Schedule(job);
+			}
+
+			return jobCount;
+		}
+
+		bool JobSystem::RunPendingJob()
+		{
+			Worker* worker = (Worker*)currentWorker.Get();
+			Job job;
+			bool found;
+
+			if (worker)
+			{
+				found = FindJob(worker->index, &worker->randomSeed, &job);
+			}
+			else
+			{
+				// Threads outside the pool use the owner's deque, but can't share its victim seed
+				unsigned int seed = (unsigned int)(size_t)&job;
+				found = FindJob(0, &seed, &job);
+			}
+
+			if (found)
+			{
+				Execute(job);
+
+				return true;
+			}
+
+			return false;
+		}
+
+		void JobSystem::Wait(JobCounter* counter)
+		{
+			while (Platform::AtomicRead(&counter->Value) > 0)
+			{
+				if (!RunPendingJob())
+					Platform::YieldThread(); // Remaining jobs are being executed by other workers
+			}
+
+			Platform::FullBarrier();
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
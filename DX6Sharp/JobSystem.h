@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Jobs
+	{
+		typedef void (*JobFunction)(void* data, int start, int end);
+
+		struct Continuation;
+
+		// Number of outstanding jobs. Zero means everything attached to the counter has finished.
+		struct JobCounter
+		{
+			volatile long Value;
+			Continuation* Waiting; // Jobs submitted with this counter as DependsOn, queued once Value reaches zero
+
+			JobCounter()
+			{
+				Value = 0;
+				Waiting = 0;
+			}
+		};
+
+		// Set in JobCounter::Value by ReleaseCounter, the low bits keep counting outstanding jobs
+		const long OrphanedCounter = 0x40000000;
+
+		// Deletes a heap-allocated counter once no job refers to it anymore: right away if it's idle, otherwise
+		// the job that brings it to zero does. For owners that can't wait, like managed finalizers.
+		void ReleaseCounter(JobCounter* counter);
+
+		struct Job
+		{
+			JobFunction Function;
+			void* Data;
+			int Start;
+			int End;
+			JobCounter* Counter; // Decremented when job is finished, can be null
+			JobCounter* DependsOn; // Job isn't queued until this counter reaches zero, can be null. Jobs added to it later
+			                       // must be submitted before it can drop to zero, or dependents may already be on their way.
+		};
+
+		// Job parked on a counter it depends on
+		struct Continuation
+		{
+			Job Pending;
+			Continuation* Next;
+			Continuation* NextAllocated; // All nodes ever allocated, so the system can free them
+		};
+
+		// Fixed-size deque owned by one worker. Owner pushes and pops at the bottom (LIFO, cache-warm),
+		// thieves take from the top. Protected by a spinlock - contention is rare since only idle workers steal.
+		class JobDeque
+		{
+		public:
+			static const int Capacity = 4096;
+		private:
+			Job jobs[Capacity];
+			int top;
+			int bottom;
+			Platform::SpinLock lock;
+		public:
+			JobDeque();
+
+			bool Push(const Job& job);
+			bool Pop(Job* job);
+			bool Steal(Job* job);
+			bool PopFront(Job* job); // FIFO order, used in deterministic mode
+			int Count();
+		};
+
+		class JobSystem
+		{
+		private:
+			struct Worker
+			{
+				JobSystem* system;
+				int index;
+				unsigned int randomSeed;
+				Platform::Thread thread;
+			};
+
+			int workerCount;
+			bool deterministic;
+			volatile long isRunning;
+
+			JobDeque* deques; // 0 is the owner (main) thread, 1..N are workers
+			Worker* workers;
+			Platform::Semaphore wakeUp;
+			Platform::ThreadLocal currentWorker;
+
+			// Guards JobCounter::Waiting of every counter and the last decrement of counters, so a dependent job
+			// is either parked before the counter reaches zero or queued right away
+			Platform::SpinLock continuationLock;
+			Continuation* freeContinuations;
+			Continuation* allocatedContinuations;
+
+			static void WorkerEntry(void* arg);
+
+			int GetCurrentDeque();
+			bool FindJob(int dequeIndex, unsigned int* seed, Job* job);
+			void Execute(const Job& job);
+			void Complete(JobCounter* counter);
+			void Schedule(const Job& job);
+			void Enqueue(const Job& job);
+		public:
+			// workerCount of 0 runs everything on the calling thread inside Wait().
+			// Deterministic mode ignores workerCount and executes jobs strictly in submission order on the waiting thread.
+			JobSystem(int workerCount, bool deterministic);
+			~JobSystem();
+
+			int GetWorkerCount();
+			bool IsDeterministic();
+
+			void Submit(JobFunction func, void* data, int start, int end, JobCounter* counter, JobCounter* dependsOn);
+
+			// Splits [0, count) into batches of at least minBatch items. Returns number of jobs submitted.
+			int ParallelFor(JobFunction func, void* data, int count, int minBatch, JobCounter* counter, JobCounter* dependsOn);
+
+			// Helps executing pending jobs until the counter reaches zero
+			void Wait(JobCounter* counter);
+
+			// Runs one pending job if there is any
+			bool RunPendingJob();
+		};
+	}
+}
@@ -0,0 +1,193 @@
+#include "dxsharp.h"
+
+using namespace System::Runtime::InteropServices;
+
+namespace DXSharp
+{
+	namespace Jobs
+	{
+		// Keeps managed delegate alive while its batches are in flight
+		struct ManagedJob
+		{
+			void* handle; // GCHandle
+			void* scheduler; // Weak GCHandle of the JobScheduler that gets exceptions
+			volatile long refs;
+		};
+
+		static const long ManagedJobBias = 0x40000000;
+
+		static void ManagedJobEntry(void* data, int start, int end)
+		{
+			ManagedJob* job = (ManagedJob*)data;
+			GCHandle handle = GCHandle::FromIntPtr(IntPtr(job->handle));
+
+			try
+			{
+				((JobRangeHandler^)handle.Target)(start, end);
+			}
+			catch (Exception^ e)
+			{
+				JobScheduler^ scheduler = (JobScheduler^)GCHandle::FromIntPtr(IntPtr(job->scheduler)).Target;
+
+				if (scheduler != nullptr)
+					scheduler->ReportError(e);
+			}
+
+			if (Platform::AtomicDecrement(&job->refs) == 0)
+			{
+				handle.Free();
+				delete job;
+			}
+		}
+
+		static ManagedJob* AllocateManagedJob(JobRangeHandler^ handler, void* scheduler)
+		{
+			if (handler == nullptr)
+				throw gcnew ArgumentException("Job handler can't be null");
+
+			ManagedJob* job = new ManagedJob();
+			job->handle = GCHandle::ToIntPtr(GCHandle::Alloc(handler)).ToPointer();
+			job->scheduler = scheduler;
+			job->refs = ManagedJobBias; // Batches may finish before we know how many were submitted
+
+			return job;
+		}
+
+		static void ReleaseManagedJob(ManagedJob* job, int submittedCount)
+		{
+			if (Platform::AtomicAdd(&job->refs, submittedCount - ManagedJobBias) == 0)
+			{
+				GCHandle::FromIntPtr(IntPtr(job->handle)).Free();
+				delete job;
+			}
+		}
+
+		/* JobGroup */
+
+		JobGroup::JobGroup()
+		{
+			counter = new JobCounter();
+			counter->Value = 0;
+		}
+
+		JobGroup::~JobGroup()
+		{
+			this->!JobGroup();
+		}
+
+		JobGroup::!JobGroup()
+		{
+			// Workers may still be finishing jobs of a group that was dropped without Wait
+			if (counter)
+			{
+				ReleaseCounter(counter);
+				counter = 0;
+			}
+		}
+
+		bool JobGroup::IsDone::get()
+		{
+			return counter == 0 || counter->Value == 0;
+		}
+
+		/* JobScheduler */
+
+		JobScheduler::JobScheduler(int workerCount)
+		{
+			system = new JobSystem(workerCount, false);
+			selfHandle = GCHandle::ToIntPtr(GCHandle::Alloc(this, GCHandleType::Weak)).ToPointer();
+		}
+
+		JobScheduler::JobScheduler(int workerCount, bool deterministic)
+		{
+			system = new JobSystem(workerCount, deterministic);
+			selfHandle = GCHandle::ToIntPtr(GCHandle::Alloc(this, GCHandleType::Weak)).ToPointer();
+		}
+
+		JobScheduler::~JobScheduler()
+		{
+			this->!JobScheduler();
+		}
+
+		JobScheduler::!JobScheduler()
+		{
+			if (system)
+			{
+				delete system;
+				system = 0;
+			}
+
+			if (selfHandle)
+			{
+				GCHandle::FromIntPtr(IntPtr(selfHandle)).Free();
+				selfHandle = 0;
+			}
+		}
+
+		int JobScheduler::WorkerCount::get()
+		{
+			return system->GetWorkerCount();
+		}
+
+		bool JobScheduler::IsDeterministic::get()
+		{
+			return system->IsDeterministic();
+		}
+
+		void JobScheduler::ReportError(Exception^ e)
+		{
+			System::Threading::Interlocked::CompareExchange<Exception^>(pendingError, e, nullptr);
+		}
+
+		void JobScheduler::ThrowPendingError()
+		{
+			Exception^ e = System::Threading::Interlocked::Exchange<Exception^>(pendingError, nullptr);
+
+			if (e != nullptr)
+				throw gcnew InvalidOperationException("Job failed: " + e->Message, e);
+		}
+
+		void JobScheduler::Run(JobRangeHandler^ handler, JobGroup^ group)
+		{
+			RunAfter(nullptr, handler, group);
+		}
+
+		void JobScheduler::RunAfter(JobGroup^ dependency, JobRangeHandler^ handler, JobGroup^ group)
+		{
+			ManagedJob* job = AllocateManagedJob(handler, selfHandle);
+
+			system->Submit(ManagedJobEntry, job, 0, 1, group != nullptr ? group->counter : 0, dependency != nullptr ? dependency->counter : 0);
+			ReleaseManagedJob(job, 1);
+		}
+
+		void JobScheduler::ParallelFor(int count, int minBatch, JobRangeHandler^ handler, JobGroup^ group)
+		{
+			ManagedJob* job = AllocateManagedJob(handler, selfHandle);
+			int submitted = system->ParallelFor(ManagedJobEntry, job, count, minBatch, group != nullptr ? group->counter : 0, 0);
+
+			ReleaseManagedJob(job, submitted);
+		}
+
+		void JobScheduler::ParallelFor(int count, int minBatch, JobRangeHandler^ handler)
+		{
+			JobCounter counter;
+			counter.Value = 0;
+
+			ManagedJob* job = AllocateManagedJob(handler, selfHandle);
+			int submitted = system->ParallelFor(ManagedJobEntry, job, count, minBatch, &counter, 0);
+
+			ReleaseManagedJob(job, submitted);
+			system->Wait(&counter);
+
+			ThrowPendingError();
+		}
+
+		void JobScheduler::Wait(JobGroup^ group)
+		{
+			if (group != nullptr && group->counter)
+				system->Wait(group->counter);
+
+			ThrowPendingError();
+		}
+	}
+}
@@ -0,0 +1,562 @@
+#include "Logger.h"
+
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Logging
+	{
+		static const int FlushPeriod = 20; // ms, how long records may sit in the ring before being written
+		static const int LineBytes = 1024;
+
+		static const char* LevelNames[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF" };
+
+		/* StdioLogOutput */
+
+		StdioLogOutput::StdioLogOutput(FILE* file)
+		{
+			this->file = file;
+			isOwned = false;
+		}
+
+		StdioLogOutput::StdioLogOutput(const char* fileName)
+		{
+			file = fopen(fileName, "w");
+			isOwned = true;
+		}
+
+		StdioLogOutput::~StdioLogOutput()
+		{
+			if (file && isOwned)
+				fclose(file);
+		}
+
+		bool StdioLogOutput::IsOpen()
+		{
+			return file != 0;
+		}
+
+		void StdioLogOutput::Write(const char* line, int length)
+		{
+			if (file)
+				fwrite(line, 1, length, file);
+		}
+
+		void StdioLogOutput::Flush()
+		{
+			if (file)
+				fflush(file);
+		}
+
+		/* Logger */
+
+		Logger::Record* Logger::ring = 0;
+		long Logger::mask = 0;
+		volatile long Logger::enqueuePos = 0;
+		volatile long Logger::dequeuePos = 0;
+
+		LogSite* Logger::sites[MaxSites];
+		volatile long Logger::siteCount = 0;
+		char Logger::categories[MaxCategories][MaxCategoryName];
+		volatile long Logger::levels[MaxCategories];
+		int Logger::categoryCount = 0;
+		Platform::SpinLock Logger::registerLock;
+
+		LogOutput* Logger::output = 0;
+		Platform::Thread* Logger::thread = 0;
+		Platform::Semaphore* Logger::wake = 0;
+		volatile long Logger::isRunning = 0;
+		volatile long Logger::activeCalls = 0;
+		Platform::UInt64 Logger::startTime = 0;
+		double Logger::timeScale = 0;
+
+		volatile long Logger::written = 0;
+		volatile long Logger::dropped = 0;
+		long Logger::reportedDropped = 0;
+
+		bool Logger::Initialize(LogOutput* output, int capacity)
+		{
+			if (ring)
+				return false;
+
+			int size = 2;
+
+			while (size < capacity)
+				size <<= 1;
+
+			ring = new Record[size];
+			mask = size - 1;
+
+			for (int i = 0; i < size; i++)
+				ring[i].Sequence = i;
+
+			enqueuePos = 0;
+			dequeuePos = 0;
+
+			Logger::output = output;
+			startTime = Platform::GetPerformanceCounter();
+			timeScale = 1.0 / (double)Platform::GetPerformanceFrequency();
+
+			wake = new Platform::Semaphore(0);
+			thread = new Platform::Thread();
+
+			// Ring must be fully set up before producers may see isRunning
+			Platform::AtomicExchange(&isRunning, 1);
+
+			if (!thread->Start(ThreadEntry, 0))
+				Platform::AtomicExchange(&isRunning, 0); // Records are silently discarded then, Shutdown still cleans up
+
+			return true;
+		}
+
+		void Logger::Shutdown()
+		{
+			if (!ring)
+				return;
+
+			if (Platform::AtomicExchange(&isRunning, 0))
+			{
+				wake->Release(1);
+				thread->Join();
+			}
+
+			// Callers that got past the isRunning check may still be filling a slot or poking the semaphore
+			while (Platform::AtomicRead(&activeCalls) > 0)
+				Platform::YieldThread();
+
+			Drain();
+			output->Flush();
+
+			delete thread;
+			delete wake;
+			delete output;
+			delete[] ring;
+
+			thread = 0;
+			wake = 0;
+			output = 0;
+			ring = 0;
+		}
+
+		bool Logger::IsInitialized()
+		{
+			return Platform::AtomicRead(&isRunning) != 0;
+		}
+
+		bool Logger::Enter()
+		{
+			// Both sides use full barriers, so either Shutdown sees this call or this call sees Shutdown
+			Platform::AtomicIncrement(&activeCalls);
+
+			if (Platform::AtomicRead(&isRunning))
+				return true;
+
+			Platform::AtomicDecrement(&activeCalls);
+
+			return false;
+		}
+
+		void Logger::Leave()
+		{
+			Platform::AtomicDecrement(&activeCalls);
+		}
+
+		int Logger::FindCategory(const char* name)
+		{
+			for (int i = 0; i < categoryCount; i++)
+			{
+				if (strncmp(categories[i], name, MaxCategoryName - 1) == 0)
+					return i;
+			}
+
+			if (categoryCount >= MaxCategories)
+				return -1;
+
+			strncpy(categories[categoryCount], name, MaxCategoryName - 1);
+			categories[categoryCount][MaxCategoryName - 1] = 0;
+			levels[categoryCount] = LogInfo;
+
+			return categoryCount++;
+		}
+
+		bool Logger::Register(LogSite& site)
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(registerLock);
+
+			// Another thread may have won the race
+			if (site.Id)
+				return true;
+
+			int category = FindCategory(site.Category ? site.Category : "");
+
+			if (category < 0 || siteCount >= MaxSites - 1)
+				return false;
+
+			// Id 0 means unregistered, so ids start at 1
+			long id = siteCount + 1;
+			sites[id] = &site;
+			site.CategoryIndex = category;
+
+			// CategoryIndex must be visible before Id, other threads skip registration once Id is set
+			Platform::FullBarrier();
+			site.Id = id;
+			siteCount = id;
+
+			return true;
+		}
+
+		void Logger::Push(LogSite& site, const LogArg* args, int count)
+		{
+			if (!Enter())
+				return;
+
+			if (count > MaxArgs)
+				count = MaxArgs;
+
+			Record* record;
+			long pos = Platform::AtomicRead(&enqueuePos);
+
+			for (;;)
+			{
+				record = &ring[pos & mask];
+				long diff = Platform::AtomicRead(&record->Sequence) - pos;
+
+				if (diff == 0)
+				{
+					long prev = Platform::AtomicCompareExchange(&enqueuePos, pos + 1, pos);
+
+					if (prev == pos)
+						break;
+
+					pos = prev;
+				}
+				else if (diff < 0)
+				{
+					// Consumer is a whole ring behind - drop instead of waiting
+					Platform::AtomicIncrement(&dropped);
+					Leave();
+					return;
+				}
+				else
+					pos = Platform::AtomicRead(&enqueuePos);
+			}
+
+			record->Site = (unsigned short)site.Id;
+			record->ArgCount = (unsigned char)count;
+			record->Time = Platform::GetPerformanceCounter();
+
+			int text = 0;
+
+			for (int i = 0; i < count; i++)
+			{
+				const LogArg& arg = args[i];
+				record->Types[i] = (unsigned char)arg.Type;
+
+				if (arg.Type == ArgDouble)
+					memcpy(&record->Values[i], &arg.Double, sizeof(double));
+				else if (arg.Type == ArgString)
+				{
+					int length = arg.Length >= 0 ? arg.Length : (int)strlen(arg.String);
+
+					if (length > RecordTextBytes - text)
+						length = RecordTextBytes - text;
+
+					memcpy(record->Text + text, arg.String, length);
+					record->Values[i] = (text << 16) | length;
+					text += length;
+				}
+				else
+					record->Values[i] = arg.Int;
+			}
+
+			record->TextUsed = (unsigned char)text;
+
+			// Publish - consumer reads the slot once it sees pos + 1
+			Platform::AtomicExchange(&record->Sequence, pos + 1);
+			Leave();
+		}
+
+		static int AppendString(char* line, int used, const char* s, int length)
+		{
+			if (length > LineBytes - 2 - used)
+				length = LineBytes - 2 - used;
+
+			if (length > 0)
+			{
+				memcpy(line + used, s, length);
+				used += length;
+			}
+
+			return used;
+		}
+
+		void Logger::Format(const Record& record)
+		{
+			char line[LineBytes];
+			LogSite* site = sites[record.Site];
+
+			double time = (double)(Platform::Int64)(record.Time - startTime) * timeScale;
+			int used = sprintf(line, "%10.3f %-5s %-8s ", time, LevelNames[site->Level], site->Category);
+
+			const char* p = site->Format;
+
+			while (*p && used < LineBytes - 2)
+			{
+				if (p[0] == '{' && p[1] == '{')
+				{
+					line[used++] = '{';
+					p += 2;
+					continue;
+				}
+
+				if (p[0] == '}' && p[1] == '}')
+				{
+					line[used++] = '}';
+					p += 2;
+					continue;
+				}
+
+				if (p[0] != '{' || p[1] < '0' || p[1] > '9')
+				{
+					line[used++] = *p++;
+					continue;
+				}
+
+				// {index} or {index:spec}, spec is accepted but ignored
+				int index = 0;
+				p++;
+
+				while (*p >= '0' && *p <= '9')
+					index = index * 10 + (*p++ - '0');
+
+				while (*p && *p != '}')
+					p++;
+
+				if (*p)
+					p++;
+
+				if (index >= record.ArgCount)
+				{
+					used = AppendString(line, used, "{?}", 3);
+					continue;
+				}
+
+				char buffer[64];
+				Platform::Int64 value = record.Values[index];
+
+				switch (record.Types[index])
+				{
+				case ArgInt:
+					used = AppendString(line, used, buffer, sprintf(buffer, "%lld", (long long)value));
+					break;
+				case ArgUInt:
+					used = AppendString(line, used, buffer, sprintf(buffer, "%llu", (unsigned long long)value));
+					break;
+				case ArgDouble:
+				{
+					double d;
+					memcpy(&d, &value, sizeof(double));
+					used = AppendString(line, used, buffer, sprintf(buffer, "%g", d));
+					break;
+				}
+				case ArgBool:
+					used = AppendString(line, used, value ? "True" : "False", value ? 4 : 5);
+					break;
+				case ArgString:
+					used = AppendString(line, used, record.Text + (value >> 16), (int)(value & 0xFFFF));
+					break;
+				}
+			}
+
+			line[used++] = '\n';
+			output->Write(line, used);
+		}
+
+		int Logger::Drain()
+		{
+			int count = 0;
+
+			for (;;)
+			{
+				long pos = dequeuePos;
+				Record& record = ring[pos & mask];
+
+				if (Platform::AtomicRead(&record.Sequence) - (pos + 1) != 0)
+					break;
+
+				Format(record);
+
+				// Hand the slot back to producers for the next lap
+				Platform::AtomicExchange(&record.Sequence, pos + mask + 1);
+				Platform::AtomicExchange(&dequeuePos, pos + 1);
+
+				count++;
+			}
+
+			if (count > 0)
+				Platform::AtomicAdd(&written, count);
+
+			long lost = Platform::AtomicRead(&dropped);
+
+			if (lost != reportedDropped)
+			{
+				char line[64];
+				int length = sprintf(line, "Logger: %ld messages dropped, ring is full\n", lost - reportedDropped);
+
+				output->Write(line, length);
+				reportedDropped = lost;
+			}
+
+			return count;
+		}
+
+		void Logger::ThreadEntry(void* arg)
+		{
+			while (Platform::AtomicRead(&isRunning))
+			{
+				wake->Wait(FlushPeriod);
+
+				if (Drain() > 0)
+					output->Flush();
+			}
+		}
+
+		void Logger::WriteArgs(LogSite& site, const LogArg* args, int count)
+		{
+			if (IsEnabled(site))
+				Push(site, args, count);
+		}
+
+		void Logger::Write(LogSite& site)
+		{
+			if (IsEnabled(site))
+				Push(site, 0, 0);
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0)
+		{
+			if (IsEnabled(site))
+				Push(site, &a0, 1);
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0, const LogArg& a1)
+		{
+			if (IsEnabled(site))
+			{
+				LogArg args[] = { a0, a1 };
+				Push(site, args, 2);
+			}
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2)
+		{
+			if (IsEnabled(site))
+			{
+				LogArg args[] = { a0, a1, a2 };
+				Push(site, args, 3);
+			}
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3)
+		{
+			if (IsEnabled(site))
+			{
+				LogArg args[] = { a0, a1, a2, a3 };
+				Push(site, args, 4);
+			}
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4)
+		{
+			if (IsEnabled(site))
+			{
+				LogArg args[] = { a0, a1, a2, a3, a4 };
+				Push(site, args, 5);
+			}
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5)
+		{
+			if (IsEnabled(site))
+			{
+				LogArg args[] = { a0, a1, a2, a3, a4, a5 };
+				Push(site, args, 6);
+			}
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5, const LogArg& a6)
+		{
+			if (IsEnabled(site))
+			{
+				LogArg args[] = { a0, a1, a2, a3, a4, a5, a6 };
+				Push(site, args, 7);
+			}
+		}
+
+		void Logger::Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5, const LogArg& a6, const LogArg& a7)
+		{
+			if (IsEnabled(site))
+			{
+				LogArg args[] = { a0, a1, a2, a3, a4, a5, a6, a7 };
+				Push(site, args, 8);
+			}
+		}
+
+		void Logger::SetLevel(const char* category, LogLevel level)
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(registerLock);
+			int index = FindCategory(category);
+
+			if (index >= 0)
+				levels[index] = level;
+		}
+
+		LogLevel Logger::GetLevel(const char* category)
+		{
+			Platform::ScopedLock<Platform::SpinLock> guard(registerLock);
+			int index = FindCategory(category);
+
+			return index >= 0 ? (LogLevel)levels[index] : LogInfo;
+		}
+
+		void Logger::Flush()
+		{
+			if (!Enter())
+				return;
+
+			long target = Platform::AtomicRead(&enqueuePos);
+
+			// Slots claimed before this point may still be written by their producers, Drain picks them up once published
+			while (Platform::AtomicRead(&dequeuePos) - target < 0 && Platform::AtomicRead(&isRunning))
+			{
+				wake->Release(1);
+				Platform::SleepMs(1);
+			}
+
+			Leave();
+		}
+
+		long Logger::GetWrittenCount()
+		{
+			return Platform::AtomicRead(&written);
+		}
+
+		long Logger::GetDroppedCount()
+		{
+			return Platform::AtomicRead(&dropped);
+		}
+
+		int Logger::GetSiteCount()
+		{
+			return siteCount;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
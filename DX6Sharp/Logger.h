@@ -0,0 +1,195 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <stdio.h>
+
+namespace DXSharp
+{
+	namespace Logging
+	{
+		enum LogLevel
+		{
+			LogTrace,
+			LogDebug,
+			LogInfo,
+			LogWarning,
+			LogError,
+			LogOff
+		};
+
+		// Static descriptor of a single logging statement. Id is assigned on first use and is what goes
+		// into the ring instead of the format string, so call site costs no stack walk or string work.
+		struct LogSite
+		{
+			const char* Category;
+			LogLevel Level;
+			const char* File;
+			int Line;
+			const char* Format; // .NET style placeholders: {0}, {1}...
+			volatile long Id; // 0 until registered
+			int CategoryIndex;
+		};
+
+		// Declares a function-local static site: LOG_SITE(site, "D3D", LogDebug, "Uploading mip {0}x{1}");
+		#define LOG_SITE(name, category, level, format) \
+			static DXSharp::Logging::LogSite name = { category, DXSharp::Logging::level, __FILE__, __LINE__, format, 0, 0 }
+
+		enum LogArgType
+		{
+			ArgInt,
+			ArgUInt,
+			ArgDouble,
+			ArgBool,
+			ArgString
+		};
+
+		// Raw argument, converted implicitly at the call site. Strings are copied into the record, so they may be temporary.
+		struct LogArg
+		{
+			LogArgType Type;
+			int Length; // Strings only
+
+			union
+			{
+				Platform::Int64 Int;
+				double Double;
+				const char* String;
+			};
+
+			LogArg() { Type = ArgInt; Int = 0; Length = 0; }
+			LogArg(int value) { Type = ArgInt; Int = value; }
+			LogArg(long value) { Type = ArgInt; Int = value; }
+			LogArg(Platform::Int64 value) { Type = ArgInt; Int = value; }
+			LogArg(unsigned int value) { Type = ArgUInt; Int = (Platform::Int64)value; }
+			LogArg(unsigned long value) { Type = ArgUInt; Int = (Platform::Int64)value; }
+			LogArg(Platform::UInt64 value) { Type = ArgUInt; Int = (Platform::Int64)value; }
+			LogArg(float value) { Type = ArgDouble; Double = value; }
+			LogArg(double value) { Type = ArgDouble; Double = value; }
+			LogArg(bool value) { Type = ArgBool; Int = value; }
+			LogArg(const char* value) { Type = ArgString; String = value ? value : "(null)"; Length = -1; }
+			LogArg(const char* value, int length) { Type = ArgString; String = value; Length = length; }
+		};
+
+		// Destination for formatted lines, called from logger thread only
+		class LogOutput
+		{
+		public:
+			virtual ~LogOutput() { }
+
+			virtual void Write(const char* line, int length) = 0;
+			virtual void Flush() = 0;
+		};
+
+		class StdioLogOutput : public LogOutput
+		{
+		private:
+			FILE* file;
+			bool isOwned;
+		public:
+			StdioLogOutput(FILE* file); // Not closed, e.g. stdout
+			StdioLogOutput(const char* fileName); // Truncates existing file
+			~StdioLogOutput();
+
+			bool IsOpen();
+
+			virtual void Write(const char* line, int length);
+			virtual void Flush();
+		};
+
+		// Process-wide asynchronous logger. Producers push fixed-size binary records into a bounded lock-free
+		// ring (Vyukov MPSC scheme, each slot has its own sequence number); formatting and I/O happen on
+		// a background thread. When the ring is full records are dropped rather than blocking the caller.
+		class Logger
+		{
+		public:
+			static const int MaxArgs = 8;
+			static const int MaxSites = 4096;
+			static const int MaxCategories = 32;
+			static const int RecordTextBytes = 40; // String arguments share this, longer ones are truncated
+			static const int DefaultCapacity = 8192; // Records
+			static const int MaxCategoryName = 32;
+		private:
+			struct Record
+			{
+				volatile long Sequence;
+				unsigned short Site;
+				unsigned char ArgCount;
+				unsigned char TextUsed;
+				Platform::UInt64 Time;
+				unsigned char Types[MaxArgs];
+				Platform::Int64 Values[MaxArgs]; // Doubles are stored bitwise, strings as offset << 16 | length into Text
+				char Text[RecordTextBytes];
+			};
+
+			static Record* ring;
+			static long mask;
+			static volatile long enqueuePos;
+			static volatile long dequeuePos;
+
+			static LogSite* sites[MaxSites];
+			static volatile long siteCount;
+			static char categories[MaxCategories][MaxCategoryName]; // Copies, SetLevel may pass a temporary
+			static volatile long levels[MaxCategories];
+			static int categoryCount;
+			static Platform::SpinLock registerLock;
+
+			static LogOutput* output;
+			static Platform::Thread* thread;
+			static Platform::Semaphore* wake;
+			static volatile long isRunning;
+			static volatile long activeCalls; // Push and Flush calls past the isRunning check, Shutdown waits for them
+			static Platform::UInt64 startTime;
+			static double timeScale;
+
+			static volatile long written;
+			static volatile long dropped;
+			static long reportedDropped;
+
+			Logger();
+
+			static bool Enter();
+			static void Leave();
+			static bool Register(LogSite& site);
+			static int FindCategory(const char* name); // Adds it if missing, -1 if table is full. Register lock must be held.
+			static void Push(LogSite& site, const LogArg* args, int count);
+			static int Drain();
+			static void Format(const Record& record);
+			static void ThreadEntry(void* arg);
+		public:
+			// Takes ownership of output. Returns false if already initialized.
+			static bool Initialize(LogOutput* output, int capacity);
+			static void Shutdown(); // Writes everything still queued. Concurrent Write calls are safe and discarded.
+
+			static bool IsInitialized();
+
+			inline static bool IsEnabled(LogSite& site)
+			{
+				if (!site.Id && !Register(site))
+					return false;
+
+				return site.Level >= levels[site.CategoryIndex];
+			}
+
+			static void Write(LogSite& site);
+			static void Write(LogSite& site, const LogArg& a0);
+			static void Write(LogSite& site, const LogArg& a0, const LogArg& a1);
+			static void Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2);
+			static void Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3);
+			static void Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4);
+			static void Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5);
+			static void Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5, const LogArg& a6);
+			static void Write(LogSite& site, const LogArg& a0, const LogArg& a1, const LogArg& a2, const LogArg& a3, const LogArg& a4, const LogArg& a5, const LogArg& a6, const LogArg& a7);
+			static void WriteArgs(LogSite& site, const LogArg* args, int count); // Extra args are ignored
+
+			static void SetLevel(const char* category, LogLevel level); // Categories not set explicitly log Info and above
+			static LogLevel GetLevel(const char* category);
+
+			static void Flush(); // Blocks until everything queued so far is written
+
+			static long GetWrittenCount();
+			static long GetDroppedCount();
+			static int GetSiteCount();
+		};
+	}
+}
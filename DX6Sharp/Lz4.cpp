@@ -0,0 +1,113 @@
+#include "Lz4.h"
+
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Assets
+	{
+		static const int MinMatch = 4;
+
+		// Length fields continue in extra bytes while they are 255
+		static bool ReadLength(const unsigned char*& ip, const unsigned char* end, int& length)
+		{
+			unsigned int b;
+
+			do
+			{
+				if (ip >= end)
+					return false;
+
+				b = *ip++;
+
+				if (length > 0x7FFFFF00) // No valid block gets anywhere near, stops int overflow
+					return false;
+
+				length += b;
+			} while (b == 255);
+
+			return true;
+		}
+
+		int Lz4Decompress(const void* source, int sourceSize, void* dest, int destSize)
+		{
+			const unsigned char* ip = (const unsigned char*)source;
+			const unsigned char* ipEnd = ip + sourceSize;
+			unsigned char* op = (unsigned char*)dest;
+			unsigned char* opStart = op;
+			unsigned char* opEnd = op + destSize;
+
+			if (sourceSize <= 0)
+				return -1;
+
+			for (;;)
+			{
+				unsigned int token = *ip++;
+
+				int literals = token >> 4;
+
+				if (literals == 15 && !ReadLength(ip, ipEnd, literals))
+					return -1;
+
+				if (literals > ipEnd - ip || literals > opEnd - op)
+					return -1;
+
+				memcpy(op, ip, literals);
+				ip += literals;
+				op += literals;
+
+				// Last sequence has literals only
+				if (ip == ipEnd)
+					break;
+
+				if (ipEnd - ip < 2)
+					return -1;
+
+				int offset = ip[0] | (ip[1] << 8);
+				ip += 2;
+
+				if (offset == 0 || offset > op - opStart)
+					return -1;
+
+				int length = token & 15;
+
+				if (length == 15 && !ReadLength(ip, ipEnd, length))
+					return -1;
+
+				if (length > opEnd - op - MinMatch)
+					return -1;
+
+				length += MinMatch;
+
+				// Matches may overlap their own output (offset < length, runs). Everything written since match start
+				// repeats with period offset, so each copy can take twice as much as the previous one.
+				const unsigned char* match = op - offset;
+
+				while (length > 0)
+				{
+					int n = (int)(op - match);
+
+					if (n > length)
+						n = length;
+
+					memcpy(op, match, n);
+					op += n;
+					length -= n;
+				}
+
+				if (ip >= ipEnd)
+					return -1;
+			}
+
+			return (int)(op - opStart);
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
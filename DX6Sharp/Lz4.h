@@ -0,0 +1,12 @@
+#pragma once
+
+namespace DXSharp
+{
+	namespace Assets
+	{
+		// Decoder for the LZ4 block format (raw blocks, no frame header). Every length and match offset is checked
+		// against both buffers, so damaged input can't write or read out of bounds.
+		// Returns number of bytes written to dest, -1 if input is malformed or doesn't fit.
+		int Lz4Decompress(const void* source, int sourceSize, void* dest, int destSize);
+	}
+}
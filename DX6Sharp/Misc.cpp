@@ -6,12 +6,6 @@ namespace DXSharp
 {
 	namespace Helpers
 	{
-		void ExceptionManager::Assert(HRESULT res, String^ methodName)
-		{
-			if (FAILED(res))
-				throw gcnew ArgumentException(String::Format("Call to {0} failed with HRESULT: {1}", methodName, res));
-		}
-
 		void Window::CreateDDrawContext()
 		{
 			IDirectDraw* dd;
@@ -22,7 +16,7 @@ namespace DXSharp
 			Guard(DirectDrawCreate(0, &dd, 0));
 
 			ddraw = dd;
-			Guard(ddraw->SetCooperativeLevel(hwnd, DDSCL_NORMAL));
+			Guard(ddraw->SetCooperativeLevel(hwnd, DDSCL_NORMAL | DDSCL_MULTITHREADED)); // Device may be driven from render thread
 
 			// Create primary surface
 			DDSURFACEDESC desc;
@@ -92,7 +86,8 @@ namespace DXSharp
 		{
 			if (fmt->dwRGBBitCount == 16 && fmt->dwFlags == DDPF_RGB)
 			{
-				Console::WriteLine("Found opaque texture format: {0} {1}", fmt->dwRGBBitCount, fmt->dwFlags);
+				LOG_SITE(formatSite, "D3D", LogInfo, "Found opaque texture format: {0} {1}");
+				Logging::Logger::Write(formatSite, fmt->dwRGBBitCount, fmt->dwFlags);
 
 				Window::opaqueTextureFormat = new DDPIXELFORMAT();
 				memcpy(Window::opaqueTextureFormat, fmt, sizeof(DDPIXELFORMAT));
@@ -107,7 +102,8 @@ namespace DXSharp
 		{
 			if (fmt->dwFlags == DDPF_ZBUFFER && fmt->dwZBufferBitDepth == 16) // 16-bit Z-Buffer will be fine, since 24 and 32-bit ones consume much more memory
 			{
-				Console::WriteLine("Found Z-Buffer format: {0} {1}", fmt->dwZBufferBitDepth, fmt->dwFlags);
+				LOG_SITE(formatSite, "D3D", LogInfo, "Found Z-Buffer format: {0} {1}");
+				Logging::Logger::Write(formatSite, fmt->dwZBufferBitDepth, fmt->dwFlags);
 
 				Window::zBufferFormat = new DDPIXELFORMAT();
 				memcpy(Window::zBufferFormat, fmt, sizeof(DDPIXELFORMAT));
@@ -150,11 +146,19 @@ namespace DXSharp
 			// Enumerate and pick best texture format
 			device->EnumTextureFormats(OnTextureFormatSearchCallback, 0);
 
-			return gcnew DXSharp::D3D::Device(d3d, device);
+			this->device = gcnew DXSharp::D3D::Device(this, d3d, device);
+
+			return this->device;
 		}
 
 		void Window::Present()
 		{
+			if (device != nullptr && device->IsRenderThreadEnabled)
+			{
+				device->SubmitFrame(); // Blt is recorded too and happens on render thread
+				return;
+			}
+
 			RECT rct = { };
 			GetWindowRect(hwnd, &rct);
 
@@ -0,0 +1,198 @@
+#include "MixKernels.h"
+
+#ifdef PLATFORM_SSE
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		/* Scalar */
+
+		static void Int16ToFloatScalar(float* dst, const short* src, int count)
+		{
+			for (int i = 0; i < count; i++)
+				dst[i] = src[i] * (1.0f / 32768.0f);
+		}
+
+		static void FloatToInt16Scalar(short* dst, const float* src, int count)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				float v = src[i];
+
+				if (v > 1.0f)
+					v = 1.0f;
+
+				if (v < -1.0f)
+					v = -1.0f;
+
+				v *= 32767.0f;
+				dst[i] = (short)(v >= 0 ? v + 0.5f : v - 0.5f);
+			}
+		}
+
+		static void MixMonoScalar(float* bus, const float* src, int frames, float l0, float r0, float l1, float r1)
+		{
+			float dl = (l1 - l0) / frames;
+			float dr = (r1 - r0) / frames;
+
+			for (int i = 0; i < frames; i++)
+			{
+				bus[i * 2] += src[i] * (l0 + dl * i);
+				bus[i * 2 + 1] += src[i] * (r0 + dr * i);
+			}
+		}
+
+		static void MixStereoScalar(float* bus, const float* src, int frames, float l0, float r0, float l1, float r1)
+		{
+			float dl = (l1 - l0) / frames;
+			float dr = (r1 - r0) / frames;
+
+			for (int i = 0; i < frames; i++)
+			{
+				bus[i * 2] += src[i * 2] * (l0 + dl * i);
+				bus[i * 2 + 1] += src[i * 2 + 1] * (r0 + dr * i);
+			}
+		}
+
+#ifdef PLATFORM_SSE
+		/* SSE */
+
+		static void Int16ToFloatSSE2(float* dst, const short* src, int count)
+		{
+			__m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+			int i = 0;
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+				__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); // Sign extension without SSE4.1
+				__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+				_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+				_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+			}
+
+			Int16ToFloatScalar(dst + i, src + i, count - i);
+		}
+
+		static void FloatToInt16SSE2(short* dst, const float* src, int count)
+		{
+			__m128 minValue = _mm_set1_ps(-1.0f);
+			__m128 maxValue = _mm_set1_ps(1.0f);
+			__m128 scale = _mm_set1_ps(32767.0f);
+			int i = 0;
+
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), minValue), maxValue), scale);
+				__m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), minValue), maxValue), scale);
+
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+			}
+
+			FloatToInt16Scalar(dst + i, src + i, count - i);
+		}
+
+		static void MixMonoSSE(float* bus, const float* src, int frames, float l0, float r0, float l1, float r1)
+		{
+			float dl = (l1 - l0) / frames;
+			float dr = (r1 - r0) / frames;
+
+			// Each vector holds two stereo frames: L R L R
+			__m128 gain = _mm_set_ps(r0 + dr, l0 + dl, r0, l0);
+			__m128 step = _mm_set_ps(dr * 2, dl * 2, dr * 2, dl * 2);
+			int i = 0;
+
+			for (; i + 4 <= frames; i += 4)
+			{
+				__m128 s = _mm_loadu_ps(src + i);
+				__m128 s01 = _mm_unpacklo_ps(s, s);
+				__m128 s23 = _mm_unpackhi_ps(s, s);
+
+				_mm_storeu_ps(bus + i * 2, _mm_add_ps(_mm_loadu_ps(bus + i * 2), _mm_mul_ps(s01, gain)));
+				gain = _mm_add_ps(gain, step);
+
+				_mm_storeu_ps(bus + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(bus + i * 2 + 4), _mm_mul_ps(s23, gain)));
+				gain = _mm_add_ps(gain, step);
+			}
+
+			for (; i < frames; i++)
+			{
+				bus[i * 2] += src[i] * (l0 + dl * i);
+				bus[i * 2 + 1] += src[i] * (r0 + dr * i);
+			}
+		}
+
+		static void MixStereoSSE(float* bus, const float* src, int frames, float l0, float r0, float l1, float r1)
+		{
+			float dl = (l1 - l0) / frames;
+			float dr = (r1 - r0) / frames;
+
+			__m128 gain = _mm_set_ps(r0 + dr, l0 + dl, r0, l0);
+			__m128 step = _mm_set_ps(dr * 2, dl * 2, dr * 2, dl * 2);
+			int i = 0;
+
+			for (; i + 2 <= frames; i += 2)
+			{
+				_mm_storeu_ps(bus + i * 2, _mm_add_ps(_mm_loadu_ps(bus + i * 2), _mm_mul_ps(_mm_loadu_ps(src + i * 2), gain)));
+				gain = _mm_add_ps(gain, step);
+			}
+
+			for (; i < frames; i++)
+			{
+				bus[i * 2] += src[i * 2] * (l0 + dl * i);
+				bus[i * 2 + 1] += src[i * 2 + 1] * (r0 + dr * i);
+			}
+		}
+#endif
+
+		MixKernels MixKernels::GetScalar()
+		{
+			MixKernels k;
+			k.Int16ToFloat = Int16ToFloatScalar;
+			k.FloatToInt16 = FloatToInt16Scalar;
+			k.MixMono = MixMonoScalar;
+			k.MixStereo = MixStereoScalar;
+			k.IsSimd = false;
+
+			return k;
+		}
+
+		MixKernels MixKernels::GetBest()
+		{
+			MixKernels k = GetScalar();
+
+#ifdef PLATFORM_SSE
+			int features = Platform::GetCpuFeatures();
+
+			if (features & Platform::CpuSSE)
+			{
+				k.MixMono = MixMonoSSE;
+				k.MixStereo = MixStereoSSE;
+				k.IsSimd = true;
+			}
+
+			// Pentium III has SSE, but integer conversions need SSE2
+			if (features & Platform::CpuSSE2)
+			{
+				k.Int16ToFloat = Int16ToFloatSSE2;
+				k.FloatToInt16 = FloatToInt16SSE2;
+			}
+#endif
+
+			return k;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
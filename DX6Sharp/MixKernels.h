@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		// Inner loops of the mixer. Bus is always interleaved stereo float, gains are ramped linearly
+		// from (l0, r0) to (l1, r1) over the block to avoid zipper noise when parameters change.
+		struct MixKernels
+		{
+			void (*Int16ToFloat)(float* dst, const short* src, int count);
+			void (*FloatToInt16)(short* dst, const float* src, int count); // Clamps to [-1, 1]
+			void (*MixMono)(float* bus, const float* src, int frames, float l0, float r0, float l1, float r1);
+			void (*MixStereo)(float* bus, const float* src, int frames, float l0, float r0, float l1, float r1);
+
+			bool IsSimd;
+
+			static MixKernels GetScalar();
+			static MixKernels GetBest(); // SSE/SSE2 versions if CPU supports them, scalar otherwise
+		};
+	}
+}
@@ -0,0 +1,313 @@
+#include "dxsharp.h"
+
+using namespace System::Runtime::InteropServices;
+
+namespace DXSharp
+{
+	namespace Sound
+	{
+		static const int MixerThreadPeriod = 10; // ms
+		static const int MixerBufferLength = 500; // ms
+		static const int OfflineUpdateFrames = 1024; // Per Update for null/wave outputs
+
+		/* AudioClip */
+
+		AudioClip::AudioClip(WaveFormat format, array<byte>^ pcmData)
+		{
+			if (pcmData == nullptr || pcmData->Length == 0)
+				throw gcnew ArgumentException("PCM data can't be empty");
+
+			if (format.FormatTag != WAVE_FORMAT_PCM && format.FormatTag != WAVE_FORMAT_IEEE_FLOAT && format.FormatTag != Audio::WaveFormatImaAdpcm)
+				throw gcnew ArgumentException(String::Format("Unsupported wave format tag {0}", format.FormatTag));
+
+			pin_ptr<byte> data = &pcmData[0];
+			bool isOutOfMemory;
+
+			if (format.FormatTag == Audio::WaveFormatImaAdpcm)
+				clip = Audio::SoundClip::CreateImaAdpcm(data, pcmData->Length, format.Channels, format.SamplesPerSec, format.BlockAlign, &isOutOfMemory);
+			else
+				clip = Audio::SoundClip::Create(data, pcmData->Length, format.Channels, format.SamplesPerSec, format.BitsPerSample, format.FormatTag == WAVE_FORMAT_IEEE_FLOAT, &isOutOfMemory);
+
+			if (isOutOfMemory)
+				throw gcnew OutOfMemoryException(String::Format("Can't allocate samples for a {0} byte clip", pcmData->Length));
+
+			if (!clip)
+				throw gcnew ArgumentException(String::Format("Unsupported PCM layout: {0} channels, {1} bits", format.Channels, format.BitsPerSample));
+		}
+
+		AudioClip::~AudioClip()
+		{
+			this->!AudioClip();
+		}
+
+		AudioClip::!AudioClip()
+		{
+			if (clip)
+			{
+				clip->Release(); // Voices still playing it keep their own reference
+				clip = 0;
+			}
+		}
+
+		int AudioClip::Channels::get()
+		{
+			return clip->GetChannels();
+		}
+
+		int AudioClip::SampleRate::get()
+		{
+			return clip->GetSampleRate();
+		}
+
+		int AudioClip::FrameCount::get()
+		{
+			return clip->GetFrameCount();
+		}
+
+		float AudioClip::Duration::get()
+		{
+			return (float)clip->GetFrameCount() / clip->GetSampleRate();
+		}
+
+		int AudioClip::MemoryUsage::get()
+		{
+			return clip->GetMemoryUsage();
+		}
+
+		/* AudioStream */
+
+		AudioStream::AudioStream(Audio::StreamSource* stream)
+		{
+			this->stream = stream;
+		}
+
+		AudioStream::~AudioStream()
+		{
+			this->!AudioStream();
+		}
+
+		AudioStream::!AudioStream()
+		{
+			if (stream)
+			{
+				stream->Release();
+				stream = 0;
+			}
+		}
+
+		AudioStream^ AudioStream::Open(String^ fileName, bool loop)
+		{
+			Audio::StreamSource* stream;
+			Assets::PackSpan span;
+
+			// Stored pack entries are already mapped, compressed ones can't be streamed and have to exist loose
+			if (IO::FileSystem::TryGetSpan(fileName, &span))
+			{
+				stream = Audio::StreamSource::OpenMemory(span.Data, span.Size, loop, Audio::StreamSource::DefaultRingFrames, true);
+			}
+			else if (!IO::FileSystem::AllowLooseFiles)
+			{
+				stream = 0;
+			}
+			else
+			{
+				IntPtr name = Marshal::StringToHGlobalAnsi(fileName);
+				stream = Audio::StreamSource::Open((const char*)name.ToPointer(), loop, Audio::StreamSource::DefaultRingFrames);
+				Marshal::FreeHGlobal(name);
+			}
+
+			if (!stream)
+				throw gcnew ArgumentException(String::Format("Can't stream {0}: file is missing or format is not supported", fileName));
+
+			return gcnew AudioStream(stream);
+		}
+
+		int AudioStream::Channels::get()
+		{
+			return stream->GetChannels();
+		}
+
+		int AudioStream::SampleRate::get()
+		{
+			return stream->GetSampleRate();
+		}
+
+		float AudioStream::Duration::get()
+		{
+			return (float)stream->GetFrameCount() / stream->GetSampleRate();
+		}
+
+		int AudioStream::MemoryUsage::get()
+		{
+			return stream->GetMemoryUsage();
+		}
+
+		int AudioStream::BufferedFrames::get()
+		{
+			return stream->GetBufferedFrames();
+		}
+
+		int AudioStream::Underruns::get()
+		{
+			return (int)stream->GetUnderrunCount();
+		}
+
+		/* Mixer */
+
+		Mixer::Mixer(Audio::AudioSink* sink, int voiceCount)
+		{
+			this->sink = sink;
+			mixer = new Audio::AudioMixer(sink, voiceCount, true);
+		}
+
+		Mixer::Mixer(DirectSound^ device, int sampleRate, int voiceCount, int latencyMs)
+		{
+			Audio::DirectSoundAudioSink* dsSink = new Audio::DirectSoundAudioSink(device->dsound, sampleRate, MixerBufferLength, latencyMs);
+			HRESULT res = dsSink->GetCreateResult();
+
+			CHECK_SITE(createSite, "dsound->CreateSoundBuffer()");
+
+			if (Checks::Check(createSite, res))
+			{
+				delete dsSink;
+				DXSharp::Helpers::ExceptionManager::Throw(createSite, res);
+			}
+
+			sink = dsSink;
+			mixer = new Audio::AudioMixer(sink, voiceCount, true);
+			mixer->StartThread(MixerThreadPeriod);
+		}
+
+		Mixer::~Mixer()
+		{
+			this->!Mixer();
+		}
+
+		Mixer::!Mixer()
+		{
+			if (mixer)
+			{
+				delete mixer; // Stops mixing thread before sink goes away
+				delete sink;
+
+				mixer = 0;
+				sink = 0;
+			}
+		}
+
+		Mixer^ Mixer::CreateNull(int sampleRate, int voiceCount)
+		{
+			return gcnew Mixer(new Audio::NullAudioSink(sampleRate, OfflineUpdateFrames), voiceCount);
+		}
+
+		Mixer^ Mixer::CreateWaveFile(String^ fileName, int sampleRate, int voiceCount)
+		{
+			IntPtr name = Marshal::StringToHGlobalAnsi(fileName);
+			Audio::WaveFileAudioSink* waveSink = new Audio::WaveFileAudioSink((const char*)name.ToPointer(), sampleRate, OfflineUpdateFrames);
+			Marshal::FreeHGlobal(name);
+
+			if (!waveSink->IsOpen())
+			{
+				delete waveSink;
+				throw gcnew ArgumentException(String::Format("Can't create {0}", fileName));
+			}
+
+			return gcnew Mixer(waveSink, voiceCount);
+		}
+
+		VoiceHandle Mixer::Play(AudioClip^ clip, float gain, float pan, float pitch, int priority, bool loop)
+		{
+			if (clip == nullptr)
+				throw gcnew ArgumentException("Clip can't be null");
+
+			Audio::VoiceParams params;
+			params.Gain = gain;
+			params.Pan = pan;
+			params.Pitch = pitch;
+			params.Priority = priority;
+			params.Loop = loop;
+
+			VoiceHandle ret;
+			ret.Id = mixer->Play(clip->clip, params);
+
+			return ret;
+		}
+
+		VoiceHandle Mixer::Play(AudioStream^ stream, float gain, float pan, float pitch, int priority)
+		{
+			if (stream == nullptr)
+				throw gcnew ArgumentException("Stream can't be null");
+
+			Audio::VoiceParams params;
+			params.Gain = gain;
+			params.Pan = pan;
+			params.Pitch = pitch;
+			params.Priority = priority;
+
+			VoiceHandle ret;
+			ret.Id = mixer->Play(stream->stream, params);
+
+			return ret;
+		}
+
+		void Mixer::Stop(VoiceHandle voice)
+		{
+			mixer->Stop(voice.Id);
+		}
+
+		bool Mixer::IsPlaying(VoiceHandle voice)
+		{
+			return mixer->IsPlaying(voice.Id);
+		}
+
+		void Mixer::SetGain(VoiceHandle voice, float gain)
+		{
+			mixer->SetGain(voice.Id, gain);
+		}
+
+		void Mixer::SetPan(VoiceHandle voice, float pan)
+		{
+			mixer->SetPan(voice.Id, pan);
+		}
+
+		void Mixer::SetPitch(VoiceHandle voice, float pitch)
+		{
+			mixer->SetPitch(voice.Id, pitch);
+		}
+
+		int Mixer::Update()
+		{
+			return mixer->Update();
+		}
+
+		float Mixer::MasterGain::get()
+		{
+			return mixer->GetMasterGain();
+		}
+
+		void Mixer::MasterGain::set(float value)
+		{
+			mixer->SetMasterGain(value);
+		}
+
+		int Mixer::VoiceCount::get()
+		{
+			return mixer->GetVoiceCount();
+		}
+
+		int Mixer::ActiveVoices::get()
+		{
+			return mixer->GetActiveVoiceCount();
+		}
+
+		int Mixer::StolenVoices::get()
+		{
+			return (int)mixer->GetStolenVoiceCount();
+		}
+
+		bool Mixer::IsSimdEnabled::get()
+		{
+			return mixer->IsSimdEnabled();
+		}
+	}
+}
@@ -0,0 +1,355 @@
+#include "PackFile.h"
+#include "Lz4.h"
+#include "Logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Assets
+	{
+		/* Paths */
+
+		int NormalizePath(const char* path, char* buffer, int bufferSize)
+		{
+			while (path[0] == '.' && (path[1] == '/' || path[1] == '\\'))
+				path += 2;
+
+			while (*path == '/' || *path == '\\')
+				path++;
+
+			int length = 0;
+
+			for (; *path && length < bufferSize - 1; path++)
+			{
+				char c = *path;
+
+				if (c == '\\')
+					c = '/';
+				else if (c >= 'A' && c <= 'Z')
+					c += 'a' - 'A';
+
+				// Collapse "a//b"
+				if (c == '/' && length > 0 && buffer[length - 1] == '/')
+					continue;
+
+				buffer[length++] = c;
+			}
+
+			buffer[length] = 0;
+
+			return length;
+		}
+
+		unsigned int HashPath(const char* normalizedPath)
+		{
+			unsigned int hash = 2166136261u;
+
+			for (const unsigned char* p = (const unsigned char*)normalizedPath; *p; p++)
+			{
+				hash ^= *p;
+				hash *= 16777619u;
+			}
+
+			return hash;
+		}
+
+		/* Crc32 */
+
+		static unsigned int crcTable[256];
+		static volatile long isCrcTableReady = 0;
+
+		static void BuildCrcTable()
+		{
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				unsigned int c = i;
+
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+				crcTable[i] = c;
+			}
+
+			// Racing threads fill in identical values, flag only goes up after the table is complete
+			Platform::FullBarrier();
+			isCrcTableReady = 1;
+		}
+
+		unsigned int Crc32(const void* data, unsigned int size, unsigned int crc)
+		{
+			if (!isCrcTableReady)
+				BuildCrcTable();
+
+			const unsigned char* p = (const unsigned char*)data;
+			crc = ~crc;
+
+			for (unsigned int i = 0; i < size; i++)
+				crc = crcTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+
+			return ~crc;
+		}
+
+		/* PackFile */
+
+		PackFile::PackFile()
+		{
+			base = 0;
+			entries = 0;
+			names = 0;
+			entryCount = 0;
+
+			verify = false;
+			verified = 0;
+			failedCount = 0;
+		}
+
+		PackFile::~PackFile()
+		{
+			Close();
+		}
+
+		bool PackFile::Open(const char* fileName, bool verify)
+		{
+			Close();
+
+			if (!file.Open(fileName))
+				return false;
+
+			this->verify = verify;
+
+			if (!Validate())
+			{
+				LOG_SITE(invalidSite, "Assets", LogError, "{0} is not a valid pack");
+				Logging::Logger::Write(invalidSite, fileName);
+
+				Close();
+				return false;
+			}
+
+			if (verify)
+			{
+				verified = (unsigned char*)malloc(entryCount);
+				memset(verified, 0, entryCount);
+			}
+
+			return true;
+		}
+
+		bool PackFile::Validate()
+		{
+			unsigned int size = file.GetSize();
+			const unsigned char* data = (const unsigned char*)file.GetData();
+
+			if (size < sizeof(PackHeader))
+				return false;
+
+			const PackHeader* header = (const PackHeader*)data;
+
+			if (header->Magic != PackMagic || header->Version != PackVersion)
+				return false;
+
+			// Loaders may cast spans to their structures, so the promised alignment is enforced below
+			if (header->Alignment == 0 || (header->Alignment & (header->Alignment - 1)))
+				return false;
+
+			unsigned int directorySize = sizeof(PackEntry) * header->EntryCount;
+
+			if (header->EntryCount > (size - sizeof(PackHeader)) / sizeof(PackEntry) ||
+				header->NamesOffset != sizeof(PackHeader) + directorySize ||
+				header->NamesSize > size - header->NamesOffset ||
+				(header->NamesSize > 0 && data[header->NamesOffset + header->NamesSize - 1] != 0))
+				return false;
+
+			if (Crc32(data + sizeof(PackHeader), directorySize + header->NamesSize) != header->DirectoryCrc)
+				return false;
+
+			const PackEntry* e = (const PackEntry*)(data + sizeof(PackHeader));
+
+			for (unsigned int i = 0; i < header->EntryCount; i++)
+			{
+				if (e[i].NameOffset >= header->NamesSize || e[i].Offset > size || e[i].StoredSize > size - e[i].Offset ||
+					(e[i].Offset & (header->Alignment - 1)))
+					return false;
+
+				if (!(e[i].Flags & PackEntryLz4) && e[i].StoredSize != e[i].Size)
+					return false;
+
+				// One LZ4 byte expands to at most 255, anything larger is a damaged size that Verify would try to allocate
+				if ((e[i].Flags & PackEntryLz4) && e[i].Size / 255 > e[i].StoredSize)
+					return false;
+
+				if (i > 0 && e[i].Hash < e[i - 1].Hash)
+					return false;
+			}
+
+			base = data;
+			entries = e;
+			names = (const char*)data + header->NamesOffset;
+			entryCount = header->EntryCount;
+
+			return true;
+		}
+
+		void PackFile::Close()
+		{
+			free(verified);
+			verified = 0;
+
+			file.Close();
+
+			base = 0;
+			entries = 0;
+			names = 0;
+			entryCount = 0;
+			failedCount = 0;
+		}
+
+		bool PackFile::IsOpen()
+		{
+			return base != 0;
+		}
+
+		int PackFile::Find(const char* path)
+		{
+			char normalized[MaxPath];
+			NormalizePath(path, normalized, MaxPath);
+
+			unsigned int hash = HashPath(normalized);
+
+			// Lower bound of hash, then step over the (rare) entries sharing it
+			int lo = 0;
+			int hi = entryCount;
+
+			while (lo < hi)
+			{
+				int mid = (lo + hi) / 2;
+
+				if (entries[mid].Hash < hash)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+
+			for (; lo < entryCount && entries[lo].Hash == hash; lo++)
+			{
+				if (strcmp(names + entries[lo].NameOffset, normalized) == 0)
+					return lo;
+			}
+
+			return -1;
+		}
+
+		int PackFile::GetEntryCount()
+		{
+			return entryCount;
+		}
+
+		const char* PackFile::GetName(int index)
+		{
+			return names + entries[index].NameOffset;
+		}
+
+		unsigned int PackFile::GetSize(int index)
+		{
+			return entries[index].Size;
+		}
+
+		bool PackFile::IsCompressed(int index)
+		{
+			return (entries[index].Flags & PackEntryLz4) != 0;
+		}
+
+		bool PackFile::CheckEntry(int index, const void* data)
+		{
+			if (verified[index] == 0)
+				verified[index] = Crc32(data, entries[index].Size) == entries[index].Crc ? 1 : 2;
+
+			if (verified[index] == 1)
+				return true;
+
+			LOG_SITE(crcSite, "Assets", LogError, "CRC mismatch in {0}");
+			Logging::Logger::Write(crcSite, GetName(index));
+
+			Platform::AtomicIncrement(&failedCount);
+			return false;
+		}
+
+		bool PackFile::GetSpan(int index, PackSpan* span)
+		{
+			if (index < 0 || index >= entryCount || IsCompressed(index))
+				return false;
+
+			const void* data = base + entries[index].Offset;
+
+			if (verify && !CheckEntry(index, data))
+				return false;
+
+			span->Data = data;
+			span->Size = entries[index].Size;
+
+			return true;
+		}
+
+		bool PackFile::Read(int index, void* dest, unsigned int destSize)
+		{
+			if (index < 0 || index >= entryCount || destSize < entries[index].Size)
+				return false;
+
+			const PackEntry& e = entries[index];
+
+			if (e.Flags & PackEntryLz4)
+			{
+				if (Lz4Decompress(base + e.Offset, e.StoredSize, dest, e.Size) != (int)e.Size)
+				{
+					LOG_SITE(corruptSite, "Assets", LogError, "Can't decompress {0}");
+					Logging::Logger::Write(corruptSite, GetName(index));
+
+					Platform::AtomicIncrement(&failedCount);
+					return false;
+				}
+			}
+			else
+			{
+				memcpy(dest, base + e.Offset, e.Size);
+			}
+
+			return !verify || CheckEntry(index, dest);
+		}
+
+		bool PackFile::Verify(int index)
+		{
+			if (index < 0 || index >= entryCount)
+				return false;
+
+			const PackEntry& e = entries[index];
+
+			if (!(e.Flags & PackEntryLz4))
+				return Crc32(base + e.Offset, e.Size) == e.Crc;
+
+			void* buffer = malloc(e.Size > 0 ? e.Size : 1);
+
+			if (!buffer)
+				return false;
+
+			bool ret = Lz4Decompress(base + e.Offset, e.StoredSize, buffer, e.Size) == (int)e.Size && Crc32(buffer, e.Size) == e.Crc;
+			free(buffer);
+
+			return ret;
+		}
+
+		long PackFile::GetFailedCount()
+		{
+			return failedCount;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Assets
+	{
+		// On-disk layout, all little-endian. Written by TexTool's pack mode (PackBuilder.cs), keep both in sync.
+		//
+		//   PackHeader
+		//   PackEntry[EntryCount]   sorted by (Hash, Name) so lookups are a binary search
+		//   names                   zero-terminated normalized paths
+		//   payloads                each starting at a multiple of Alignment
+		//
+		// Header and directory sit at the front, so opening a pack only touches its first pages.
+		struct PackHeader
+		{
+			unsigned int Magic;
+			unsigned int Version;
+			unsigned int EntryCount;
+			unsigned int Alignment;
+			unsigned int NamesOffset;
+			unsigned int NamesSize;
+			unsigned int DirectoryCrc; // Of entries and names
+			unsigned int Reserved;
+		};
+
+		enum PackEntryFlags
+		{
+			PackEntryLz4 = 1 // Payload is a single LZ4 block
+		};
+
+		struct PackEntry
+		{
+			unsigned int Hash; // HashPath of the name
+			unsigned int NameOffset; // Within names
+			unsigned int Offset; // Of payload, from the start of the file
+			unsigned int StoredSize;
+			unsigned int Size; // Uncompressed
+			unsigned int Crc; // Of uncompressed data
+			unsigned int Flags;
+			unsigned int Reserved;
+		};
+
+		static const unsigned int PackMagic = 0x4B505844; // "DXPK"
+		static const unsigned int PackVersion = 1;
+
+		// Paths are matched case-insensitively with '/' as separator and without leading "./" or "/".
+		// Returns length of the normalized path, which is truncated to bufferSize - 1 characters.
+		int NormalizePath(const char* path, char* buffer, int bufferSize);
+		unsigned int HashPath(const char* normalizedPath); // FNV-1a
+
+		unsigned int Crc32(const void* data, unsigned int size, unsigned int crc = 0); // Same as zlib's crc32
+
+		struct PackSpan
+		{
+			const void* Data;
+			unsigned int Size;
+		};
+
+		// Read-only view of a pack. The file is mapped once; stored entries are handed out as pointers into the
+		// mapping, so reading them costs no copies and no system calls beyond page faults.
+		// Lookups don't modify anything and may run on any thread.
+		class PackFile
+		{
+		private:
+			Platform::MappedFile file;
+
+			const unsigned char* base;
+			const PackEntry* entries;
+			const char* names;
+			int entryCount;
+
+			bool verify;
+			unsigned char* verified; // Per entry: 0 - not checked yet, 1 - good, 2 - CRC mismatch
+			long failedCount;
+
+			bool Validate();
+			bool CheckEntry(int index, const void* data);
+
+			PackFile(const PackFile&);
+			PackFile& operator=(const PackFile&);
+		public:
+			static const int MaxPath = 260;
+
+			PackFile();
+			~PackFile();
+
+			// Fails if the file is missing, truncated or its directory is damaged. With verify, every entry's CRC
+			// is checked the first time it's read and entries that don't match are treated as unreadable.
+			bool Open(const char* fileName, bool verify);
+			void Close();
+			bool IsOpen();
+
+			int Find(const char* path); // Index of entry, -1 if there is none
+			int GetEntryCount();
+			const char* GetName(int index);
+			unsigned int GetSize(int index); // Uncompressed size
+			bool IsCompressed(int index);
+
+			// Zero-copy access, fails for compressed entries - use Read for those
+			bool GetSpan(int index, PackSpan* span);
+
+			// Copies or decompresses the whole entry, destSize must be at least GetSize(index)
+			bool Read(int index, void* dest, unsigned int destSize);
+
+			bool Verify(int index); // Checks CRC now, regardless of verify flag
+			long GetFailedCount(); // Entries rejected because of bad CRC or bad compressed data
+		};
+	}
+}
@@ -0,0 +1,622 @@
+#include "Platform.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#endif
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Platform
+	{
+		/* Atomics */
+
+#ifdef _WIN32
+		long AtomicIncrement(volatile long* value)
+		{
+			return InterlockedIncrement(value);
+		}
+
+		long AtomicDecrement(volatile long* value)
+		{
+			return InterlockedDecrement(value);
+		}
+
+		long AtomicAdd(volatile long* value, long amount)
+		{
+			return InterlockedExchangeAdd(value, amount) + amount;
+		}
+
+		long AtomicExchange(volatile long* value, long newValue)
+		{
+			return InterlockedExchange(value, newValue);
+		}
+
+		long AtomicCompareExchange(volatile long* value, long newValue, long comparand)
+		{
+			return InterlockedCompareExchange(value, newValue, comparand);
+		}
+
+		long AtomicRead(volatile long* value)
+		{
+			return *value; // Volatile reads have acquire semantics in MSVC
+		}
+
+		void FullBarrier()
+		{
+			volatile long barrier = 0;
+			InterlockedExchange(&barrier, 1); // MemoryBarrier() is not available in the 9x-era SDK
+		}
+
+		void SleepMs(int ms)
+		{
+			Sleep(ms);
+		}
+
+		void YieldThread()
+		{
+			Sleep(0);
+		}
+
+		int GetProcessorCount()
+		{
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+
+			return (int)info.dwNumberOfProcessors;
+		}
+
+		UInt64 GetPerformanceCounter()
+		{
+			LARGE_INTEGER counter;
+
+			if (!QueryPerformanceCounter(&counter))
+				return GetTickCount(); // Some very old boards have no usable PIT-backed counter
+
+			return (UInt64)counter.QuadPart;
+		}
+
+		UInt64 GetPerformanceFrequency()
+		{
+			LARGE_INTEGER freq;
+
+			if (!QueryPerformanceFrequency(&freq) || freq.QuadPart == 0)
+				return 1000;
+
+			return (UInt64)freq.QuadPart;
+		}
+#else
+		long AtomicIncrement(volatile long* value)
+		{
+			return __sync_add_and_fetch(value, 1);
+		}
+
+		long AtomicDecrement(volatile long* value)
+		{
+			return __sync_sub_and_fetch(value, 1);
+		}
+
+		long AtomicAdd(volatile long* value, long amount)
+		{
+			return __sync_add_and_fetch(value, amount);
+		}
+
+		long AtomicExchange(volatile long* value, long newValue)
+		{
+			// Full barrier like InterlockedExchange. __sync_lock_test_and_set only acquires, and the extra fence
+			// in front of it is invisible to ThreadSanitizer, which then flags everything SpinLock protects.
+			long old;
+
+			do
+			{
+				old = __atomic_load_n(value, __ATOMIC_RELAXED);
+			}
+			while (__sync_val_compare_and_swap(value, old, newValue) != old);
+
+			return old;
+		}
+
+		long AtomicCompareExchange(volatile long* value, long newValue, long comparand)
+		{
+			return __sync_val_compare_and_swap(value, comparand, newValue);
+		}
+
+		long AtomicRead(volatile long* value)
+		{
+			return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+		}
+
+		void FullBarrier()
+		{
+			__sync_synchronize();
+		}
+
+		void SleepMs(int ms)
+		{
+			usleep(ms * 1000);
+		}
+
+		void YieldThread()
+		{
+			sched_yield();
+		}
+
+		int GetProcessorCount()
+		{
+			long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+			return count > 0 ? (int)count : 1;
+		}
+
+		UInt64 GetPerformanceCounter()
+		{
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+
+			return (UInt64)ts.tv_sec * 1000000000ULL + (UInt64)ts.tv_nsec;
+		}
+
+		UInt64 GetPerformanceFrequency()
+		{
+			return 1000000000ULL;
+		}
+#endif
+
+		/* CPU features */
+
+		int GetCpuFeatures()
+		{
+			static volatile long features = -1;
+
+			if (features >= 0)
+				return features;
+
+			int result = 0;
+			unsigned int edx = 0;
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+			int info[4];
+			__cpuid(info, 1);
+			edx = (unsigned int)info[3];
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+			unsigned int eax, ebx, ecx;
+
+			if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+				edx = 0;
+#endif
+
+			// SSE also needs FXSR, otherwise OS doesn't save XMM registers (Win95 and NT4 before SP4)
+			if ((edx & (1 << 25)) && (edx & (1 << 24)))
+			{
+				result |= CpuSSE;
+
+				if (edx & (1 << 26))
+					result |= CpuSSE2;
+			}
+
+			AtomicExchange(&features, result);
+
+			return result;
+		}
+
+		/* SpinLock */
+
+		SpinLock::SpinLock()
+		{
+			state = 0;
+		}
+
+		void SpinLock::Lock()
+		{
+			int spins = 0;
+
+			while (AtomicCompareExchange(&state, 1, 0) != 0)
+			{
+				if (++spins > 64)
+				{
+					YieldThread();
+					spins = 0;
+				}
+			}
+		}
+
+		bool SpinLock::TryLock()
+		{
+			return AtomicCompareExchange(&state, 1, 0) == 0;
+		}
+
+		void SpinLock::Unlock()
+		{
+			AtomicExchange(&state, 0);
+		}
+
+		/* Mutex */
+
+#ifdef _WIN32
+		Mutex::Mutex()
+		{
+			InitializeCriticalSection(&cs);
+		}
+
+		Mutex::~Mutex()
+		{
+			DeleteCriticalSection(&cs);
+		}
+
+		void Mutex::Lock()
+		{
+			EnterCriticalSection(&cs);
+		}
+
+		void Mutex::Unlock()
+		{
+			LeaveCriticalSection(&cs);
+		}
+#else
+		Mutex::Mutex()
+		{
+			pthread_mutex_init(&mutex, 0);
+		}
+
+		Mutex::~Mutex()
+		{
+			pthread_mutex_destroy(&mutex);
+		}
+
+		void Mutex::Lock()
+		{
+			pthread_mutex_lock(&mutex);
+		}
+
+		void Mutex::Unlock()
+		{
+			pthread_mutex_unlock(&mutex);
+		}
+#endif
+
+		/* Semaphore */
+
+#ifdef _WIN32
+		Semaphore::Semaphore(int initialCount)
+		{
+			handle = CreateSemaphoreA(0, initialCount, 0x7fffffff, 0);
+		}
+
+		Semaphore::~Semaphore()
+		{
+			CloseHandle(handle);
+		}
+
+		void Semaphore::Release(int count)
+		{
+			if (count > 0)
+				ReleaseSemaphore(handle, count, 0);
+		}
+
+		void Semaphore::Wait()
+		{
+			WaitForSingleObject(handle, INFINITE);
+		}
+
+		bool Semaphore::Wait(int timeoutMs)
+		{
+			return WaitForSingleObject(handle, timeoutMs) == WAIT_OBJECT_0;
+		}
+#else
+		Semaphore::Semaphore(int initialCount)
+		{
+			sem_init(&sem, 0, initialCount);
+		}
+
+		Semaphore::~Semaphore()
+		{
+			sem_destroy(&sem);
+		}
+
+		void Semaphore::Release(int count)
+		{
+			for (int i = 0; i < count; i++)
+				sem_post(&sem);
+		}
+
+		void Semaphore::Wait()
+		{
+			while (sem_wait(&sem) != 0 && errno == EINTR)
+				;
+		}
+
+		bool Semaphore::Wait(int timeoutMs)
+		{
+			timespec ts;
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_sec += timeoutMs / 1000;
+			ts.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+
+			if (ts.tv_nsec >= 1000000000L)
+			{
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000L;
+			}
+
+			int res;
+			while ((res = sem_timedwait(&sem, &ts)) != 0 && errno == EINTR)
+				;
+
+			return res == 0;
+		}
+#endif
+
+		/* Thread */
+
+#ifdef _WIN32
+		Thread::Thread()
+		{
+			handle = 0;
+			proc = 0;
+			arg = 0;
+		}
+
+		Thread::~Thread()
+		{
+			Join();
+		}
+
+		DWORD WINAPI Thread::Entry(LPVOID self)
+		{
+			Thread* thread = (Thread*)self;
+			thread->proc(thread->arg);
+
+			return 0;
+		}
+
+		bool Thread::Start(ThreadProc proc, void* arg)
+		{
+			DWORD threadId; // 9x requires non-null thread id pointer
+
+			this->proc = proc;
+			this->arg = arg;
+			handle = CreateThread(0, 0, Entry, this, 0, &threadId);
+
+			return handle != 0;
+		}
+
+		void Thread::Join()
+		{
+			if (handle)
+			{
+				WaitForSingleObject(handle, INFINITE);
+				CloseHandle(handle);
+				handle = 0;
+			}
+		}
+#else
+		Thread::Thread()
+		{
+			started = false;
+			proc = 0;
+			arg = 0;
+		}
+
+		Thread::~Thread()
+		{
+			Join();
+		}
+
+		void* Thread::Entry(void* self)
+		{
+			Thread* thread = (Thread*)self;
+			thread->proc(thread->arg);
+
+			return 0;
+		}
+
+		bool Thread::Start(ThreadProc proc, void* arg)
+		{
+			this->proc = proc;
+			this->arg = arg;
+			started = pthread_create(&thread, 0, Entry, this) == 0;
+
+			return started;
+		}
+
+		void Thread::Join()
+		{
+			if (started)
+			{
+				pthread_join(thread, 0);
+				started = false;
+			}
+		}
+#endif
+
+		/* MappedFile */
+
+#ifdef _WIN32
+		MappedFile::MappedFile()
+		{
+			file = INVALID_HANDLE_VALUE;
+			mapping = 0;
+			data = 0;
+			size = 0;
+		}
+
+		bool MappedFile::Open(const char* fileName)
+		{
+			Close();
+
+			file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			size = GetFileSize(file, 0);
+
+			// Empty files can't be mapped, but are still valid to open
+			if (size > 0)
+			{
+				mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+
+				if (mapping)
+					data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+				if (!data)
+				{
+					Close();
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		void MappedFile::Close()
+		{
+			if (data)
+				UnmapViewOfFile(data);
+
+			if (mapping)
+				CloseHandle(mapping);
+
+			if (file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+
+			file = INVALID_HANDLE_VALUE;
+			mapping = 0;
+			data = 0;
+			size = 0;
+		}
+#else
+		MappedFile::MappedFile()
+		{
+			fd = -1;
+			data = 0;
+			size = 0;
+		}
+
+		bool MappedFile::Open(const char* fileName)
+		{
+			Close();
+
+			fd = open(fileName, O_RDONLY);
+
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+
+			if (fstat(fd, &st) != 0)
+			{
+				Close();
+				return false;
+			}
+
+			size = (unsigned int)st.st_size;
+
+			if (size > 0)
+			{
+				data = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+				if (data == MAP_FAILED)
+				{
+					data = 0;
+					Close();
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		void MappedFile::Close()
+		{
+			if (data)
+				munmap(data, size);
+
+			if (fd >= 0)
+				close(fd);
+
+			fd = -1;
+			data = 0;
+			size = 0;
+		}
+#endif
+
+		MappedFile::~MappedFile()
+		{
+			Close();
+		}
+
+		const void* MappedFile::GetData()
+		{
+			return data;
+		}
+
+		unsigned int MappedFile::GetSize()
+		{
+			return size;
+		}
+
+		/* ThreadLocal */
+
+#ifdef _WIN32
+		ThreadLocal::ThreadLocal()
+		{
+			index = TlsAlloc();
+		}
+
+		ThreadLocal::~ThreadLocal()
+		{
+			TlsFree(index);
+		}
+
+		void* ThreadLocal::Get()
+		{
+			return TlsGetValue(index);
+		}
+
+		void ThreadLocal::Set(void* value)
+		{
+			TlsSetValue(index, value);
+		}
+#else
+		ThreadLocal::ThreadLocal()
+		{
+			pthread_key_create(&key, 0);
+		}
+
+		ThreadLocal::~ThreadLocal()
+		{
+			pthread_key_delete(key);
+		}
+
+		void* ThreadLocal::Get()
+		{
+			return pthread_getspecific(key);
+		}
+
+		void ThreadLocal::Set(void* value)
+		{
+			pthread_setspecific(key, value);
+		}
+#endif
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,200 @@
+#pragma once
+
+// Thin portability layer for the native (non-CLR) parts of DXSharp.
+// Everything in here is plain C++ so the engine cores (jobs, mixer, etc.) can be built without DirectX.
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+// SSE paths are compiled whenever the compiler can emit them, actual use is decided at runtime with GetCpuFeatures()
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define PLATFORM_SSE
+#endif
+
+namespace DXSharp
+{
+	namespace Platform
+	{
+#ifdef _MSC_VER
+		typedef __int64 Int64;
+		typedef unsigned __int64 UInt64;
+#else
+		typedef long long Int64;
+		typedef unsigned long long UInt64;
+#endif
+
+		typedef void (*ThreadProc)(void* arg);
+
+		long AtomicIncrement(volatile long* value);
+		long AtomicDecrement(volatile long* value);
+		long AtomicAdd(volatile long* value, long amount); // Returns new value
+		long AtomicExchange(volatile long* value, long newValue);
+		long AtomicCompareExchange(volatile long* value, long newValue, long comparand); // Returns initial value
+		long AtomicRead(volatile long* value); // Acquire load, for polling values other threads change atomically
+		void FullBarrier();
+
+		void SleepMs(int ms);
+		void YieldThread();
+		int GetProcessorCount();
+
+		enum CpuFeature
+		{
+			CpuSSE = 1,
+			CpuSSE2 = 2
+		};
+
+		int GetCpuFeatures(); // CpuFeature flags
+
+		// High-resolution monotonic counter (QPC on Windows, CLOCK_MONOTONIC in nanoseconds elsewhere)
+		UInt64 GetPerformanceCounter();
+		UInt64 GetPerformanceFrequency();
+
+		class SpinLock
+		{
+		private:
+			volatile long state;
+		public:
+			SpinLock();
+
+			void Lock();
+			bool TryLock();
+			void Unlock();
+		};
+
+		class Mutex
+		{
+		private:
+#ifdef _WIN32
+			CRITICAL_SECTION cs;
+#else
+			pthread_mutex_t mutex;
+#endif
+			Mutex(const Mutex&);
+			Mutex& operator=(const Mutex&);
+		public:
+			Mutex();
+			~Mutex();
+
+			void Lock();
+			void Unlock();
+		};
+
+		template<typename T> class ScopedLock
+		{
+		private:
+			T& lock;
+
+			ScopedLock(const ScopedLock&);
+			ScopedLock& operator=(const ScopedLock&);
+		public:
+			ScopedLock(T& l) : lock(l)
+			{
+				lock.Lock();
+			}
+
+			~ScopedLock()
+			{
+				lock.Unlock();
+			}
+		};
+
+		class Semaphore
+		{
+		private:
+#ifdef _WIN32
+			HANDLE handle;
+#else
+			sem_t sem;
+#endif
+			Semaphore(const Semaphore&);
+			Semaphore& operator=(const Semaphore&);
+		public:
+			Semaphore(int initialCount);
+			~Semaphore();
+
+			void Release(int count);
+			void Wait();
+			bool Wait(int timeoutMs);
+		};
+
+		class Thread
+		{
+		private:
+#ifdef _WIN32
+			HANDLE handle;
+#else
+			pthread_t thread;
+			bool started;
+#endif
+			ThreadProc proc;
+			void* arg;
+
+			Thread(const Thread&);
+			Thread& operator=(const Thread&);
+
+#ifdef _WIN32
+			static DWORD WINAPI Entry(LPVOID self);
+#else
+			static void* Entry(void* self);
+#endif
+		public:
+			Thread();
+			~Thread();
+
+			bool Start(ThreadProc proc, void* arg);
+			void Join();
+		};
+
+		// Read-only view of a whole file. Pages are brought in by the OS on access, so huge files cost no heap.
+		class MappedFile
+		{
+		private:
+#ifdef _WIN32
+			HANDLE file;
+			HANDLE mapping;
+#else
+			int fd;
+#endif
+			void* data;
+			unsigned int size;
+
+			MappedFile(const MappedFile&);
+			MappedFile& operator=(const MappedFile&);
+		public:
+			MappedFile();
+			~MappedFile();
+
+			bool Open(const char* fileName);
+			void Close();
+
+			const void* GetData();
+			unsigned int GetSize();
+		};
+
+		// Per-thread pointer slot (TlsAlloc is used instead of __declspec(thread), which is broken for LoadLibrary'd DLLs on 9x)
+		class ThreadLocal
+		{
+		private:
+#ifdef _WIN32
+			DWORD index;
+#else
+			pthread_key_t key;
+#endif
+			ThreadLocal(const ThreadLocal&);
+			ThreadLocal& operator=(const ThreadLocal&);
+		public:
+			ThreadLocal();
+			~ThreadLocal();
+
+			void* Get();
+			void Set(void* value);
+		};
+	}
+}
@@ -0,0 +1,569 @@
+#include "RenderCommands.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		struct CommandHeader
+		{
+			int Type;
+			int Size; // Including header
+		};
+
+		struct TransformCommand
+		{
+			int Type;
+			float Matrix[16];
+		};
+
+		struct TextureCommand
+		{
+			int Stage;
+			void* Texture;
+		};
+
+		struct RenderStateCommand
+		{
+			int State;
+			unsigned int Value;
+		};
+
+		struct TextureStageStateCommand
+		{
+			int Stage;
+			int State;
+			int Value;
+		};
+
+		struct DrawCommand
+		{
+			int PrimitiveType;
+			int VertexFormat;
+			int Flags;
+			int VertexSize;
+			int VertexCount;
+			int VertexOffset; // In list's vertex storage, which may be reallocated while recording
+		};
+
+		struct ExternalDrawCommand
+		{
+			int PrimitiveType;
+			int VertexFormat;
+			int Flags;
+			int VertexSize;
+			int VertexCount;
+			const void* Vertices;
+		};
+
+		static const int InitialCommandCapacity = 64 * 1024;
+		static const int InitialVertexCapacity = 1024 * 1024;
+
+		/* CommandList */
+
+		CommandList::CommandList()
+		{
+			commands = (unsigned char*)malloc(InitialCommandCapacity);
+			commandCapacity = commands ? InitialCommandCapacity : 0;
+			vertices = (unsigned char*)malloc(InitialVertexCapacity);
+			vertexCapacity = vertices ? InitialVertexCapacity : 0;
+
+			Reset();
+		}
+
+		CommandList::~CommandList()
+		{
+			free(commands);
+			free(vertices);
+		}
+
+		void CommandList::Reset()
+		{
+			commandSize = 0;
+			vertexSize = 0;
+			commandCount = 0;
+			openDraw = -1;
+			failed = false;
+		}
+
+		int CommandList::GetCommandCount()
+		{
+			return commandCount;
+		}
+
+		bool CommandList::HasFailed()
+		{
+			return failed;
+		}
+
+		int CommandList::GetMemoryUsage()
+		{
+			return commandCapacity + vertexCapacity;
+		}
+
+		unsigned char* CommandList::Grow(unsigned char* storage, int* capacity, int required)
+		{
+			int newCapacity = *capacity > 0 ? *capacity : 4096;
+
+			// Doubling past 1 GB would overflow, such a frame is broken anyway
+			while (newCapacity < required)
+			{
+				if (required < 0 || newCapacity >= 0x40000000)
+				{
+					failed = true;
+					return 0;
+				}
+
+				newCapacity *= 2;
+			}
+
+			// Old block stays valid when realloc fails, it's still freed by the destructor
+			unsigned char* grown = (unsigned char*)realloc(storage, newCapacity);
+
+			if (!grown)
+			{
+				failed = true;
+				return 0;
+			}
+
+			*capacity = newCapacity;
+
+			return grown;
+		}
+
+		void* CommandList::AllocateCommand(int type, int size)
+		{
+			// Pointer-sized padding keeps texture and external draw commands aligned on 64-bit hosts too
+			int align = sizeof(void*) - 1;
+			int total = sizeof(CommandHeader) + ((size + align) & ~align);
+
+			if (failed)
+				return 0;
+
+			if (commandSize + total > commandCapacity)
+			{
+				// Lists are reused every frame, so after a few frames this never happens again
+				unsigned char* grown = Grow(commands, &commandCapacity, commandSize + total);
+
+				if (!grown)
+					return 0;
+
+				commands = grown;
+			}
+
+			CommandHeader* header = (CommandHeader*)(commands + commandSize);
+			header->Type = type;
+			header->Size = total;
+
+			commandSize += total;
+			commandCount++;
+
+			return header + 1;
+		}
+
+		void* CommandList::AllocateVertices(int size)
+		{
+			if (failed || size < 0)
+			{
+				failed = true;
+				return 0;
+			}
+
+			if (vertexSize + size > vertexCapacity)
+			{
+				unsigned char* grown = Grow(vertices, &vertexCapacity, vertexSize + size);
+
+				if (!grown)
+					return 0;
+
+				vertices = grown;
+			}
+
+			void* ret = vertices + vertexSize;
+			vertexSize += size;
+
+			return ret;
+		}
+
+		void CommandList::Clear(const ClearDesc& desc)
+		{
+			ClearDesc* cmd = (ClearDesc*)AllocateCommand(CmdClear, sizeof(ClearDesc));
+
+			if (cmd)
+				*cmd = desc;
+		}
+
+		void CommandList::BeginScene()
+		{
+			AllocateCommand(CmdBeginScene, 0);
+		}
+
+		void CommandList::EndScene()
+		{
+			AllocateCommand(CmdEndScene, 0);
+		}
+
+		void CommandList::SetTransform(int type, const float* matrix)
+		{
+			TransformCommand* cmd = (TransformCommand*)AllocateCommand(CmdSetTransform, sizeof(TransformCommand));
+
+			if (!cmd)
+				return;
+
+			cmd->Type = type;
+			memcpy(cmd->Matrix, matrix, sizeof(cmd->Matrix));
+		}
+
+		void CommandList::SetTexture(int stage, void* texture)
+		{
+			TextureCommand* cmd = (TextureCommand*)AllocateCommand(CmdSetTexture, sizeof(TextureCommand));
+
+			if (!cmd)
+				return;
+
+			cmd->Stage = stage;
+			cmd->Texture = texture;
+		}
+
+		void CommandList::SetRenderState(int state, unsigned int value)
+		{
+			RenderStateCommand* cmd = (RenderStateCommand*)AllocateCommand(CmdSetRenderState, sizeof(RenderStateCommand));
+
+			if (!cmd)
+				return;
+
+			cmd->State = state;
+			cmd->Value = value;
+		}
+
+		void CommandList::SetTextureStageState(int stage, int state, int value)
+		{
+			TextureStageStateCommand* cmd = (TextureStageStateCommand*)AllocateCommand(CmdSetTextureStageState, sizeof(TextureStageStateCommand));
+
+			if (!cmd)
+				return;
+
+			cmd->Stage = stage;
+			cmd->State = state;
+			cmd->Value = value;
+		}
+
+		void CommandList::SetMaterial(const MaterialDesc& material)
+		{
+			MaterialDesc* cmd = (MaterialDesc*)AllocateCommand(CmdSetMaterial, sizeof(MaterialDesc));
+
+			if (cmd)
+				*cmd = material;
+		}
+
+		void CommandList::DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount)
+		{
+			if (vertexSize < 0 || vertexCount < 0 || (vertexSize > 0 && vertexCount > 0x7FFFFFFF / vertexSize))
+			{
+				failed = true;
+				return;
+			}
+
+			void* data = AllocateVertices(vertexSize * vertexCount);
+
+			if (!data)
+				return;
+
+			memcpy(data, vertices, vertexSize * vertexCount);
+
+			DrawCommand* cmd = (DrawCommand*)AllocateCommand(CmdDrawPrimitive, sizeof(DrawCommand));
+
+			if (!cmd)
+				return;
+
+			cmd->PrimitiveType = primitiveType;
+			cmd->VertexFormat = vertexFormat;
+			cmd->Flags = flags;
+			cmd->VertexSize = vertexSize;
+			cmd->VertexCount = vertexCount;
+			cmd->VertexOffset = (int)((unsigned char*)data - this->vertices);
+		}
+
+		void CommandList::Present()
+		{
+			AllocateCommand(CmdPresent, 0);
+		}
+
+		void CommandList::DrawExternal(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount)
+		{
+			ExternalDrawCommand* cmd = (ExternalDrawCommand*)AllocateCommand(CmdDrawExternal, sizeof(ExternalDrawCommand));
+
+			if (!cmd)
+				return;
+
+			cmd->PrimitiveType = primitiveType;
+			cmd->VertexFormat = vertexFormat;
+			cmd->Flags = flags;
+			cmd->VertexSize = vertexSize;
+			cmd->VertexCount = vertexCount;
+			cmd->Vertices = vertices;
+		}
+
+		void CommandList::BeginDraw(int primitiveType, int vertexFormat, int flags, int vertexSize)
+		{
+			DrawCommand* cmd = (DrawCommand*)AllocateCommand(CmdDrawPrimitive, sizeof(DrawCommand));
+
+			if (!cmd)
+				return; // openDraw stays -1, so AddVertex ignores the vertices
+
+			cmd->PrimitiveType = primitiveType;
+			cmd->VertexFormat = vertexFormat;
+			cmd->Flags = flags;
+			cmd->VertexSize = vertexSize;
+			cmd->VertexCount = 0;
+			cmd->VertexOffset = this->vertexSize;
+
+			openDraw = (int)((unsigned char*)cmd - commands);
+		}
+
+		void CommandList::AddVertex(const void* vertex)
+		{
+			if (openDraw < 0)
+				return;
+
+			// Command storage can't move here - only vertex storage grows between BeginDraw and EndDraw
+			DrawCommand* cmd = (DrawCommand*)(commands + openDraw);
+			void* data = AllocateVertices(cmd->VertexSize);
+
+			if (!data)
+				return;
+
+			memcpy(data, vertex, cmd->VertexSize);
+			cmd->VertexCount++;
+		}
+
+		void CommandList::EndDraw()
+		{
+			openDraw = -1;
+		}
+
+		void CommandList::Execute(CommandSink* sink)
+		{
+			int offset = 0;
+
+			// Half a frame could leave a scene open or draw with missing state, skip it and keep the last one on screen
+			if (failed)
+				return;
+
+			while (offset < commandSize)
+			{
+				CommandHeader* header = (CommandHeader*)(commands + offset);
+				void* payload = header + 1;
+
+				switch (header->Type)
+				{
+				case CmdClear:
+					sink->Clear(*(ClearDesc*)payload);
+					break;
+				case CmdBeginScene:
+					sink->BeginScene();
+					break;
+				case CmdEndScene:
+					sink->EndScene();
+					break;
+				case CmdSetTransform:
+					{
+						TransformCommand* cmd = (TransformCommand*)payload;
+						sink->SetTransform(cmd->Type, cmd->Matrix);
+					}
+					break;
+				case CmdSetTexture:
+					{
+						TextureCommand* cmd = (TextureCommand*)payload;
+						sink->SetTexture(cmd->Stage, cmd->Texture);
+					}
+					break;
+				case CmdSetRenderState:
+					{
+						RenderStateCommand* cmd = (RenderStateCommand*)payload;
+						sink->SetRenderState(cmd->State, cmd->Value);
+					}
+					break;
+				case CmdSetTextureStageState:
+					{
+						TextureStageStateCommand* cmd = (TextureStageStateCommand*)payload;
+						sink->SetTextureStageState(cmd->Stage, cmd->State, cmd->Value);
+					}
+					break;
+				case CmdSetMaterial:
+					sink->SetMaterial(*(MaterialDesc*)payload);
+					break;
+				case CmdDrawPrimitive:
+					{
+						DrawCommand* cmd = (DrawCommand*)payload;
+
+						if (cmd->VertexCount > 0)
+							sink->DrawPrimitive(cmd->PrimitiveType, cmd->VertexFormat, cmd->Flags, vertices + cmd->VertexOffset, cmd->VertexSize, cmd->VertexCount);
+					}
+					break;
+				case CmdDrawExternal:
+					{
+						ExternalDrawCommand* cmd = (ExternalDrawCommand*)payload;
+						sink->DrawPrimitive(cmd->PrimitiveType, cmd->VertexFormat, cmd->Flags, cmd->Vertices, cmd->VertexSize, cmd->VertexCount);
+					}
+					break;
+				case CmdPresent:
+					sink->Present();
+					break;
+				}
+
+				offset += header->Size;
+			}
+		}
+
+		/* FrameRing */
+
+		FrameRing::FrameRing(int capacity) : freeFrames((capacity < 1 ? 1 : (capacity > MaxFrames ? MaxFrames : capacity)) + 1), readyFrames(0), drained(0)
+		{
+			this->capacity = capacity < 1 ? 1 : (capacity > MaxFrames ? MaxFrames : capacity);
+			produced = 0;
+			consumed = 0;
+			isDrainWaiting = 0;
+		}
+
+		int FrameRing::GetCapacity()
+		{
+			return capacity;
+		}
+
+		int FrameRing::GetPendingCount()
+		{
+			return (int)(Platform::AtomicRead(&produced) - Platform::AtomicRead(&consumed));
+		}
+
+		CommandList* FrameRing::BeginWrite()
+		{
+			freeFrames.Wait();
+
+			return &lists[produced % (capacity + 1)];
+		}
+
+		void FrameRing::EndWrite()
+		{
+			Platform::AtomicIncrement(&produced); // Full barrier - list contents are visible before the index moves
+			readyFrames.Release(1);
+		}
+
+		CommandList* FrameRing::BeginRead(int timeoutMs)
+		{
+			if (!readyFrames.Wait(timeoutMs))
+				return 0;
+
+			return &lists[consumed % (capacity + 1)];
+		}
+
+		void FrameRing::EndRead()
+		{
+			long done = Platform::AtomicIncrement(&consumed);
+			freeFrames.Release(1);
+
+			if (done == Platform::AtomicRead(&produced) && Platform::AtomicExchange(&isDrainWaiting, 0) == 1)
+				drained.Release(1);
+		}
+
+		void FrameRing::WaitUntilDrained()
+		{
+			Platform::AtomicExchange(&isDrainWaiting, 1);
+
+			// Last frame may have finished before the flag was up. If the consumer took the flag anyway, its release is waited for.
+			if (GetPendingCount() == 0 && Platform::AtomicExchange(&isDrainWaiting, 0) == 1)
+				return;
+
+			drained.Wait();
+		}
+
+		/* RenderThread */
+
+		RenderThread::RenderThread(CommandSink* sink, int maxFrameLatency) : ring(maxFrameLatency)
+		{
+			this->sink = sink;
+			isRunning = 1;
+			framesExecuted = 0;
+			framesSubmitted = 0;
+
+			current = ring.BeginWrite();
+			current->Reset();
+
+			thread.Start(Entry, this);
+		}
+
+		RenderThread::~RenderThread()
+		{
+			Flush();
+
+			Platform::AtomicExchange(&isRunning, 0);
+			thread.Join();
+		}
+
+		void RenderThread::Entry(void* arg)
+		{
+			RenderThread* self = (RenderThread*)arg;
+
+			while (Platform::AtomicRead(&self->isRunning))
+			{
+				CommandList* list = self->ring.BeginRead(50);
+
+				if (!list)
+					continue;
+
+				list->Execute(self->sink);
+				list->Reset();
+
+				Platform::AtomicIncrement(&self->framesExecuted);
+				self->ring.EndRead();
+			}
+		}
+
+		CommandList* RenderThread::GetCurrentList()
+		{
+			return current;
+		}
+
+		void RenderThread::SubmitFrame()
+		{
+			ring.EndWrite();
+			framesSubmitted++;
+
+			current = ring.BeginWrite(); // This is where game thread gets throttled to the latency limit
+			current->Reset();
+		}
+
+		void RenderThread::Flush()
+		{
+			SubmitFrame();
+
+			// Current list is already acquired for writing, so everything else must be drained
+			ring.WaitUntilDrained();
+		}
+
+		int RenderThread::GetMaxFrameLatency()
+		{
+			return ring.GetCapacity();
+		}
+
+		long RenderThread::GetFramesExecuted()
+		{
+			return Platform::AtomicRead(&framesExecuted);
+		}
+
+		long RenderThread::GetFramesSubmitted()
+		{
+			return framesSubmitted;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		struct MaterialDesc
+		{
+			float Diffuse[4];
+			float Ambient[3];
+			float Specular[3];
+			float Emissive[3];
+			float Power;
+		};
+
+		struct ClearDesc
+		{
+			int Count;
+			int X, Y, Width, Height;
+			int Flags;
+			unsigned int Color;
+			float Z;
+			int Stencil;
+		};
+
+		// Receives replayed commands. D3DCommandSink talks to the real device, tools can plug in recorders.
+		class CommandSink
+		{
+		public:
+			virtual ~CommandSink() { }
+
+			virtual void Clear(const ClearDesc& desc) = 0;
+			virtual void BeginScene() = 0;
+			virtual void EndScene() = 0;
+			virtual void SetTransform(int type, const float* matrix) = 0;
+			virtual void SetTexture(int stage, void* texture) = 0;
+			virtual void SetRenderState(int state, unsigned int value) = 0;
+			virtual void SetTextureStageState(int stage, int state, int value) = 0;
+			virtual void SetMaterial(const MaterialDesc& material) = 0;
+			virtual void DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount) = 0;
+			virtual void Present() = 0;
+		};
+
+		// One frame worth of recorded state changes and draws. Vertices are copied into the list,
+		// so the game thread is free to modify its buffers right after recording.
+		class CommandList
+		{
+		public:
+			enum CommandType
+			{
+				CmdClear,
+				CmdBeginScene,
+				CmdEndScene,
+				CmdSetTransform,
+				CmdSetTexture,
+				CmdSetRenderState,
+				CmdSetTextureStageState,
+				CmdSetMaterial,
+				CmdDrawPrimitive,
+				CmdDrawExternal,
+				CmdPresent
+			};
+		private:
+			unsigned char* commands;
+			int commandSize;
+			int commandCapacity;
+
+			unsigned char* vertices;
+			int vertexSize;
+			int vertexCapacity;
+
+			int openDraw; // Offset of DrawPrimitive command being filled by BeginDraw/AddVertex, -1 if none
+			int commandCount;
+			bool failed;
+
+			CommandList(const CommandList&);
+			CommandList& operator=(const CommandList&);
+
+			unsigned char* Grow(unsigned char* storage, int* capacity, int required);
+			void* AllocateCommand(int type, int size); // Null once out of memory, the rest of the frame is dropped
+			void* AllocateVertices(int size);
+		public:
+			CommandList();
+			~CommandList();
+
+			void Reset();
+			int GetCommandCount();
+			int GetMemoryUsage();
+			bool HasFailed(); // Storage couldn't grow since last Reset, Execute skips the frame
+
+			void Clear(const ClearDesc& desc);
+			void BeginScene();
+			void EndScene();
+			void SetTransform(int type, const float* matrix);
+
+			// Records the pointer without AddRef, so a texture must not be released while a list that sets it is
+			// pending. Owners call RenderThread::Flush() first, Texture's destructor does it through Device::Flush.
+			void SetTexture(int stage, void* texture);
+
+			void SetRenderState(int state, unsigned int value);
+			void SetTextureStageState(int stage, int state, int value);
+			void SetMaterial(const MaterialDesc& material);
+			void DrawPrimitive(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount);
+			void Present();
+
+			// Records only the pointer, vertices must stay untouched until the list is executed (see TransientVertexRing)
+			void DrawExternal(int primitiveType, int vertexFormat, int flags, const void* vertices, int vertexSize, int vertexCount);
+
+			// Immediate-mode style recording (Begin/Vertex/End)
+			void BeginDraw(int primitiveType, int vertexFormat, int flags, int vertexSize);
+			void AddVertex(const void* vertex);
+			void EndDraw();
+
+			void Execute(CommandSink* sink);
+		};
+
+		// Single-producer/single-consumer ring of command lists. Indices are handed over with atomics,
+		// semaphores are only used to sleep when the ring is full or empty. Holds one list more than its
+		// capacity, so the producer can record the next frame while capacity frames are still pending.
+		class FrameRing
+		{
+		public:
+			static const int MaxFrames = 3;
+		private:
+			CommandList lists[MaxFrames + 1];
+			int capacity;
+			volatile long produced;
+			volatile long consumed;
+			volatile long isDrainWaiting; // Producer sleeps in WaitUntilDrained, consumer releases drained once empty
+			Platform::Semaphore freeFrames;
+			Platform::Semaphore readyFrames;
+			Platform::Semaphore drained;
+		public:
+			FrameRing(int capacity);
+
+			int GetCapacity();
+			int GetPendingCount(); // Submitted, but not yet finished by consumer, at most capacity once BeginWrite returns
+
+			CommandList* BeginWrite(); // Blocks while capacity frames are in flight
+			void EndWrite();
+
+			CommandList* BeginRead(int timeoutMs); // Returns null on timeout
+			void EndRead();
+
+			void WaitUntilDrained(); // Producer side, blocks until every submitted frame is finished
+		};
+
+		// Consumes frames from the ring on a dedicated thread
+		class RenderThread
+		{
+		private:
+			FrameRing ring;
+			CommandSink* sink;
+			CommandList* current;
+			volatile long isRunning;
+			Platform::Thread thread;
+			volatile long framesExecuted;
+			long framesSubmitted; // Game thread only
+
+			static void Entry(void* arg);
+		public:
+			// maxFrameLatency is the number of submitted frames game thread may get ahead of the GPU submission (1-3),
+			// recording of the next frame overlaps with them even at 1
+			RenderThread(CommandSink* sink, int maxFrameLatency);
+			~RenderThread();
+
+			CommandList* GetCurrentList();
+
+			void SubmitFrame(); // Hands current list to the render thread and starts recording next one
+			void Flush(); // Submits what is recorded so far and waits until render thread is idle
+
+			int GetMaxFrameLatency();
+			long GetFramesExecuted();
+			long GetFramesSubmitted(); // Current list becomes frame GetFramesSubmitted() + 1 once submitted
+		};
+	}
+}
@@ -0,0 +1,343 @@
+#include "ResourceCache.h"
+#include "PackFile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Assets
+	{
+		static const int IndexBits = 16;
+		static const unsigned int IndexMask = (1 << IndexBits) - 1;
+
+		static unsigned int HashKey(int type, const char* normalizedPath, unsigned int parameters)
+		{
+			// Continue FNV-1a of the path over type and parameters
+			unsigned int hash = HashPath(normalizedPath);
+			unsigned int extra[2] = { (unsigned int)type, parameters };
+
+			for (int i = 0; i < 2; i++)
+			{
+				for (int k = 0; k < 4; k++)
+				{
+					hash ^= (extra[i] >> (k * 8)) & 0xFF;
+					hash *= 16777619u;
+				}
+			}
+
+			return hash;
+		}
+
+		ResourceCache::ResourceCache(int capacity)
+			: loadSignal(0)
+		{
+			if (capacity > MaxCapacity)
+				capacity = MaxCapacity;
+
+			this->capacity = capacity;
+			entries = (Entry*)malloc(sizeof(Entry) * capacity);
+
+			for (int i = 0; i < capacity; i++)
+			{
+				entries[i].State = ResourceInvalid;
+				entries[i].Path = 0;
+				entries[i].Generation = 0;
+				entries[i].Next = i + 1 < capacity ? i + 1 : -1;
+			}
+
+			freeList = capacity > 0 ? 0 : -1;
+
+			int bucketCount = 16;
+
+			while (bucketCount < capacity * 2)
+				bucketCount *= 2;
+
+			buckets = (int*)malloc(sizeof(int) * bucketCount);
+			bucketMask = bucketCount - 1;
+
+			for (int i = 0; i < bucketCount; i++)
+				buckets[i] = -1;
+
+			memset(stats, 0, sizeof(stats));
+			waiters = 0;
+		}
+
+		ResourceCache::~ResourceCache()
+		{
+			for (int i = 0; i < capacity; i++)
+				free(entries[i].Path);
+
+			free(entries);
+			free(buckets);
+		}
+
+		ResourceHandle ResourceCache::MakeHandle(int index)
+		{
+			return ((unsigned int)entries[index].Generation << IndexBits) | (unsigned int)(index + 1);
+		}
+
+		ResourceCache::Entry* ResourceCache::Resolve(ResourceHandle handle)
+		{
+			int index = (int)(handle & IndexMask) - 1;
+
+			if (index < 0 || index >= capacity)
+				return 0;
+
+			Entry* e = &entries[index];
+
+			if (e->State == ResourceInvalid || e->Generation != (unsigned short)(handle >> IndexBits))
+				return 0;
+
+			return e;
+		}
+
+		ResourceHandle ResourceCache::Acquire(int type, const char* path, unsigned int parameters, bool* mustLoad)
+		{
+			*mustLoad = false;
+
+			if (type < 0 || type >= MaxTypes)
+				return 0;
+
+			char normalized[PackFile::MaxPath];
+			NormalizePath(path, normalized, PackFile::MaxPath);
+
+			unsigned int hash = HashKey(type, normalized, parameters);
+
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			int* bucket = &buckets[hash & bucketMask];
+
+			for (int i = *bucket; i >= 0; i = entries[i].Next)
+			{
+				Entry& e = entries[i];
+
+				if (e.Hash == hash && e.Type == type && e.Parameters == parameters && strcmp(e.Path, normalized) == 0)
+				{
+					if (e.Refs++ == 0)
+						stats[type].Referenced++;
+
+					if (e.State == ResourceLoading)
+						stats[type].Joins++;
+					else
+						stats[type].Hits++;
+
+					return MakeHandle(i);
+				}
+			}
+
+			if (freeList < 0)
+				return 0;
+
+			int index = freeList;
+			Entry& e = entries[index];
+			freeList = e.Next;
+
+			int length = (int)strlen(normalized);
+
+			e.Type = type;
+			e.Parameters = parameters;
+			e.Hash = hash;
+			e.Path = (char*)malloc(length + 1);
+			memcpy(e.Path, normalized, length + 1);
+			e.Refs = 1;
+			e.State = ResourceLoading;
+			e.Object = 0;
+			e.Bytes = 0;
+
+			e.Next = *bucket;
+			*bucket = index;
+
+			stats[type].Count++;
+			stats[type].Referenced++;
+			stats[type].Misses++;
+
+			*mustLoad = true;
+
+			return MakeHandle(index);
+		}
+
+		void ResourceCache::Finish(ResourceHandle handle, int state, void* object, unsigned int bytes)
+		{
+			int wake;
+
+			{
+				Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+				Entry* e = Resolve(handle);
+
+				if (!e || e->State != ResourceLoading)
+					return;
+
+				e->State = state;
+				e->Object = object;
+				e->Bytes = bytes;
+
+				if (state == ResourceReady)
+					stats[e->Type].Bytes += bytes;
+				else
+					stats[e->Type].Failures++;
+
+				wake = waiters;
+				waiters = 0;
+			}
+
+			if (wake > 0)
+				loadSignal.Release(wake);
+		}
+
+		void ResourceCache::Complete(ResourceHandle handle, void* object, unsigned int bytes)
+		{
+			Finish(handle, ResourceReady, object, bytes);
+		}
+
+		void ResourceCache::Fail(ResourceHandle handle)
+		{
+			Finish(handle, ResourceFailed, 0, 0);
+		}
+
+		ResourceState ResourceCache::Wait(ResourceHandle handle)
+		{
+			lock.Lock();
+
+			for (;;)
+			{
+				Entry* e = Resolve(handle);
+
+				if (!e || e->State != ResourceLoading)
+				{
+					ResourceState ret = e ? (ResourceState)e->State : ResourceInvalid;
+					lock.Unlock();
+
+					return ret;
+				}
+
+				// Registered before unlocking, so a load finishing in between still leaves a count for us
+				waiters++;
+				lock.Unlock();
+
+				loadSignal.Wait();
+				lock.Lock();
+			}
+		}
+
+		ResourceState ResourceCache::GetState(ResourceHandle handle)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			Entry* e = Resolve(handle);
+
+			return e ? (ResourceState)e->State : ResourceInvalid;
+		}
+
+		void* ResourceCache::GetResource(ResourceHandle handle)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			Entry* e = Resolve(handle);
+
+			return e && e->State == ResourceReady ? e->Object : 0;
+		}
+
+		void ResourceCache::AddRef(ResourceHandle handle)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			Entry* e = Resolve(handle);
+
+			if (e && e->Refs++ == 0)
+				stats[e->Type].Referenced++;
+		}
+
+		void ResourceCache::Release(ResourceHandle handle)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			Entry* e = Resolve(handle);
+
+			if (e && e->Refs > 0 && --e->Refs == 0)
+				stats[e->Type].Referenced--;
+		}
+
+		int ResourceCache::Unload(int type, UnloadedResource* unloaded, int maxCount)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			int count = 0;
+
+			for (int i = 0; i < capacity && count < maxCount; i++)
+			{
+				Entry& e = entries[i];
+
+				if (e.State == ResourceInvalid || e.State == ResourceLoading || e.Refs > 0 || (type >= 0 && e.Type != type))
+					continue;
+
+				unloaded[count].Type = e.Type;
+				unloaded[count].Object = e.Object;
+				unloaded[count].Bytes = e.Bytes;
+				count++;
+
+				// Unlink from its bucket
+				int* link = &buckets[e.Hash & bucketMask];
+
+				while (*link != i)
+					link = &entries[*link].Next;
+
+				*link = e.Next;
+
+				ResourceTypeStats& s = stats[e.Type];
+				s.Count--;
+				s.Unloads++;
+
+				if (e.State == ResourceReady)
+					s.Bytes -= e.Bytes;
+
+				free(e.Path);
+				e.Path = 0;
+				e.State = ResourceInvalid;
+				e.Object = 0;
+				e.Generation++; // Outstanding handles go stale
+
+				e.Next = freeList;
+				freeList = i;
+			}
+
+			return count;
+		}
+
+		void ResourceCache::GetStats(int type, ResourceTypeStats* result)
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			if (type >= 0 && type < MaxTypes)
+				*result = stats[type];
+			else
+				memset(result, 0, sizeof(*result));
+		}
+
+		int ResourceCache::GetCount()
+		{
+			Platform::ScopedLock<Platform::Mutex> guard(lock);
+
+			int count = 0;
+
+			for (int i = 0; i < MaxTypes; i++)
+				count += stats[i].Count;
+
+			return count;
+		}
+
+		int ResourceCache::GetCapacity()
+		{
+			return capacity;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
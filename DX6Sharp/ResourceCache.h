@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Assets
+	{
+		// Index in the low 16 bits (plus one, so 0 is never valid), slot generation above. Stale handles of
+		// unloaded entries are detected instead of reaching whatever took the slot.
+		typedef unsigned int ResourceHandle;
+
+		enum ResourceState
+		{
+			ResourceInvalid, // Handle is stale or 0
+			ResourceLoading,
+			ResourceReady,
+			ResourceFailed
+		};
+
+		struct ResourceTypeStats
+		{
+			int Count; // Entries in the cache, whatever their state
+			int Referenced; // Entries somebody holds a handle to
+			Platform::Int64 Bytes; // Reported by Complete, ready entries only
+			long Hits; // Acquire found the entry already loaded
+			long Misses; // Acquire had to load it
+			long Joins; // Acquire found it being loaded by somebody else
+			long Failures;
+			long Unloads;
+		};
+
+		// Object of an entry removed by Unload, to be destroyed by whoever created it
+		struct UnloadedResource
+		{
+			int Type;
+			void* Object;
+			unsigned int Bytes;
+		};
+
+		// Shares loaded resources by (type, path, parameters). The cache never loads anything itself: the first
+		// Acquire of a key tells the caller to load it, later ones get the same entry with another reference.
+		// Unreferenced entries stay cached until Unload, so things that come and go (enemies) don't reload.
+		// Paths are compared like pack paths - case-insensitive, either separator.
+		class ResourceCache
+		{
+		public:
+			static const int MaxTypes = 8;
+			static const int MaxCapacity = 0xFFFF;
+		private:
+			struct Entry
+			{
+				int Type;
+				unsigned int Parameters;
+				unsigned int Hash;
+				char* Path;
+
+				long Refs;
+				int State; // ResourceState, ResourceInvalid while the slot is free
+				void* Object;
+				unsigned int Bytes;
+
+				unsigned short Generation;
+				int Next; // Bucket chain while used, free list while not
+			};
+
+			Entry* entries;
+			int capacity;
+			int* buckets;
+			int bucketMask;
+			int freeList;
+
+			ResourceTypeStats stats[MaxTypes];
+
+			Platform::Mutex lock;
+			Platform::Semaphore loadSignal; // Released once per waiter whenever any load finishes
+			int waiters;
+
+			Entry* Resolve(ResourceHandle handle); // Lock must be held
+			ResourceHandle MakeHandle(int index);
+			void Finish(ResourceHandle handle, int state, void* object, unsigned int bytes);
+
+			ResourceCache(const ResourceCache&);
+			ResourceCache& operator=(const ResourceCache&);
+		public:
+			ResourceCache(int capacity);
+			~ResourceCache(); // Objects still cached are not destroyed, Unload them first
+
+			// Adds a reference to the entry of the key, creating it if needed. If mustLoad comes back true the
+			// caller owns the load and has to call Complete or Fail - anybody acquiring the key meanwhile gets the
+			// same handle with state ResourceLoading and may Wait for it. Returns 0 if the cache is full.
+			ResourceHandle Acquire(int type, const char* path, unsigned int parameters, bool* mustLoad);
+			void Complete(ResourceHandle handle, void* object, unsigned int bytes);
+			void Fail(ResourceHandle handle); // Failed entries are cached too, so missing files aren't probed again
+
+			// Blocks while the entry is loading. Never call it from the thread that owns the load.
+			ResourceState Wait(ResourceHandle handle);
+			ResourceState GetState(ResourceHandle handle);
+			void* GetResource(ResourceHandle handle); // 0 unless ready
+
+			void AddRef(ResourceHandle handle);
+			void Release(ResourceHandle handle);
+
+			// Removes up to maxCount unreferenced entries of type (-1 for all types) that are done loading and
+			// hands their objects back. Returns how many were removed, call again while that's maxCount.
+			int Unload(int type, UnloadedResource* unloaded, int maxCount);
+
+			void GetStats(int type, ResourceTypeStats* result);
+			int GetCount();
+			int GetCapacity();
+		};
+	}
+}
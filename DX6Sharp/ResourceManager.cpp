@@ -0,0 +1,177 @@
+#include "dxsharp.h"
+
+using namespace System::Runtime::InteropServices;
+
+namespace DXSharp
+{
+	namespace IO
+	{
+		ResourceManager::ResourceManager(int capacity)
+		{
+			cache = new Assets::ResourceCache(capacity);
+
+			typeNames = gcnew array<String^>(Assets::ResourceCache::MaxTypes);
+			loaders = gcnew array<ResourceLoader^>(Assets::ResourceCache::MaxTypes);
+			sizers = gcnew array<ResourceSizer^>(Assets::ResourceCache::MaxTypes);
+			typeCount = 0;
+		}
+
+		ResourceManager::~ResourceManager()
+		{
+			UnloadAll();
+			this->!ResourceManager();
+		}
+
+		ResourceManager::!ResourceManager()
+		{
+			// Objects left in the cache are only reachable through their GCHandles, which are gone with the process
+			delete cache;
+			cache = 0;
+		}
+
+		int ResourceManager::RegisterType(String^ name, ResourceLoader^ loader, ResourceSizer^ sizer)
+		{
+			if (loader == nullptr)
+				throw gcnew ArgumentNullException("loader");
+
+			if (typeCount == Assets::ResourceCache::MaxTypes)
+				throw gcnew InvalidOperationException("Too many resource types");
+
+			typeNames[typeCount] = name;
+			loaders[typeCount] = loader;
+			sizers[typeCount] = sizer;
+
+			return typeCount++;
+		}
+
+		ResourceHandle ResourceManager::Acquire(int type, String^ path, int parameters)
+		{
+			if (type < 0 || type >= typeCount)
+				throw gcnew ArgumentOutOfRangeException("type");
+
+			bool mustLoad;
+
+			IntPtr name = Marshal::StringToHGlobalAnsi(path);
+			Assets::ResourceHandle handle = cache->Acquire(type, (const char*)name.ToPointer(), parameters, &mustLoad);
+			Marshal::FreeHGlobal(name);
+
+			if (!handle)
+				throw gcnew InvalidOperationException(String::Format("Resource cache is full, can't add {0}", path));
+
+			ResourceHandle ret;
+			ret.Id = handle;
+
+			if (!mustLoad)
+			{
+				cache->Wait(handle);
+				return ret;
+			}
+
+			Object^ resource;
+
+			try
+			{
+				resource = loaders[type](path, parameters);
+			}
+			catch (Exception^)
+			{
+				cache->Fail(handle);
+				cache->Release(handle);
+				throw;
+			}
+
+			if (resource == nullptr)
+			{
+				cache->Fail(handle);
+				return ret;
+			}
+
+			int bytes = sizers[type] != nullptr ? sizers[type](resource) : 0;
+			cache->Complete(handle, GCHandle::ToIntPtr(GCHandle::Alloc(resource)).ToPointer(), bytes);
+
+			return ret;
+		}
+
+		Object^ ResourceManager::Get(ResourceHandle handle)
+		{
+			void* object = cache->GetResource(handle.Id);
+
+			return object ? GCHandle::FromIntPtr(IntPtr(object)).Target : nullptr;
+		}
+
+		void ResourceManager::AddRef(ResourceHandle handle)
+		{
+			cache->AddRef(handle.Id);
+		}
+
+		void ResourceManager::Release(ResourceHandle handle)
+		{
+			cache->Release(handle.Id);
+		}
+
+		int ResourceManager::Unload(int type)
+		{
+			const int BatchSize = 32;
+			Assets::UnloadedResource unloaded[BatchSize];
+			int total = 0;
+			int count;
+
+			do
+			{
+				count = cache->Unload(type, unloaded, BatchSize);
+
+				for (int i = 0; i < count; i++)
+				{
+					// Failed loads have no object
+					if (!unloaded[i].Object)
+						continue;
+
+					GCHandle gch = GCHandle::FromIntPtr(IntPtr(unloaded[i].Object));
+					IDisposable^ disposable = dynamic_cast<IDisposable^>(gch.Target);
+					gch.Free();
+
+					if (disposable != nullptr)
+						delete disposable;
+				}
+
+				total += count;
+			} while (count == BatchSize);
+
+			return total;
+		}
+
+		int ResourceManager::UnloadAll()
+		{
+			return Unload(-1);
+		}
+
+		ResourceTypeStats ResourceManager::GetStats(int type)
+		{
+			Assets::ResourceTypeStats stats;
+			cache->GetStats(type, &stats);
+
+			ResourceTypeStats ret;
+			ret.Name = type >= 0 && type < typeCount ? typeNames[type] : nullptr;
+			ret.Count = stats.Count;
+			ret.Referenced = stats.Referenced;
+			ret.Bytes = stats.Bytes;
+			ret.Hits = stats.Hits;
+			ret.Misses = stats.Misses;
+			ret.Joins = stats.Joins;
+			ret.Failures = stats.Failures;
+			ret.Unloads = stats.Unloads;
+
+			return ret;
+		}
+
+		int ResourceManager::TypeCount::get()
+		{
+			return typeCount;
+		}
+
+		int ResourceManager::Count::get()
+		{
+			return cache->GetCount();
+		}
+	}
+}
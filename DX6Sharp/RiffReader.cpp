@@ -0,0 +1,163 @@
+#include "RiffReader.h"
+#include "ImaAdpcm.h"
+
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		static unsigned int ReadUInt(const unsigned char* p)
+		{
+			return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+		}
+
+		static unsigned short ReadUShort(const unsigned char* p)
+		{
+			return (unsigned short)(p[0] | (p[1] << 8));
+		}
+
+		/* RiffReader */
+
+		RiffReader::RiffReader()
+		{
+			data = 0;
+			size = 0;
+			offset = 0;
+		}
+
+		bool RiffReader::Open(const void* data, unsigned int size)
+		{
+			this->data = (const unsigned char*)data;
+			this->size = 0;
+			offset = 12;
+
+			if (!data || size < 12 || memcmp(data, "RIFF", 4) != 0)
+				return false;
+
+			// Trust the smaller of declared and actual size
+			unsigned int declared = ReadUInt(this->data + 4) + 8;
+			this->size = declared < size && declared >= 12 ? declared : size;
+
+			memcpy(formType, this->data + 8, 4);
+
+			return true;
+		}
+
+		bool RiffReader::IsFormType(const char* type)
+		{
+			return size > 0 && memcmp(formType, type, 4) == 0;
+		}
+
+		bool RiffReader::NextChunk(RiffChunk& chunk)
+		{
+			if (offset + 8 > size)
+				return false;
+
+			memcpy(chunk.Id, data + offset, 4);
+			chunk.Size = ReadUInt(data + offset + 4);
+			chunk.Data = data + offset + 8;
+
+			unsigned int available = size - offset - 8;
+
+			if (chunk.Size > available)
+				chunk.Size = available;
+
+			offset += 8 + chunk.Size + (chunk.Size & 1); // Chunks are word aligned
+
+			return true;
+		}
+
+		bool RiffReader::FindChunk(const char* id, RiffChunk& chunk)
+		{
+			offset = 12;
+
+			while (NextChunk(chunk))
+			{
+				if (memcmp(chunk.Id, id, 4) == 0)
+					return true;
+			}
+
+			return false;
+		}
+
+		/* Wave */
+
+		bool ParseWave(const void* file, unsigned int size, WaveInfo& info)
+		{
+			RiffReader reader;
+			RiffChunk fmt, data;
+
+			memset(&info, 0, sizeof(info));
+
+			if (!reader.Open(file, size) || !reader.IsFormType("WAVE"))
+				return false;
+
+			if (!reader.FindChunk("fmt ", fmt) || fmt.Size < 16)
+				return false;
+
+			info.FormatTag = ReadUShort(fmt.Data);
+			info.Channels = ReadUShort(fmt.Data + 2);
+			info.SampleRate = ReadUInt(fmt.Data + 4);
+			info.AvgBytesPerSec = ReadUInt(fmt.Data + 8);
+			info.BlockAlign = ReadUShort(fmt.Data + 12);
+			info.BitsPerSample = ReadUShort(fmt.Data + 14);
+			info.SamplesPerBlock = 1;
+
+			// WAVE_FORMAT_EXTENSIBLE keeps real format in the first bytes of subformat GUID
+			if (info.FormatTag == 0xFFFE && fmt.Size >= 40)
+				info.FormatTag = ReadUShort(fmt.Data + 24);
+
+			if (info.Channels <= 0 || info.SampleRate <= 0 || info.BlockAlign <= 0)
+				return false;
+
+			// Decoders step through data by BlockAlign, a frame size that disagrees with the samples would read past the end
+			if ((info.FormatTag == WaveFormatPcm || info.FormatTag == WaveFormatFloat) && info.BlockAlign != info.Channels * info.BitsPerSample / 8)
+				return false;
+
+			// Same limit as SoundClip::CreateImaAdpcm, a block has to hold more than its headers
+			if (info.FormatTag == WaveFormatImaAdpcm && info.BlockAlign <= 4 * info.Channels)
+				return false;
+
+			if (info.FormatTag == WaveFormatImaAdpcm)
+			{
+				// cbSize + wSamplesPerBlock, derive it from block size if missing
+				if (fmt.Size >= 20)
+					info.SamplesPerBlock = ReadUShort(fmt.Data + 18);
+
+				if (info.SamplesPerBlock <= 0)
+					info.SamplesPerBlock = (info.BlockAlign - 4 * info.Channels) * 8 / (4 * info.Channels) + 1;
+			}
+
+			if (!reader.FindChunk("data", data))
+				return false;
+
+			info.Data = data.Data;
+			info.DataBytes = data.Size;
+
+			if (info.FormatTag == WaveFormatImaAdpcm)
+			{
+				unsigned int blocks = info.DataBytes / info.BlockAlign;
+				int blockFrames = GetImaAdpcmBlockFrames(info.BlockAlign, info.Channels);
+
+				if (info.SamplesPerBlock > blockFrames)
+					info.SamplesPerBlock = blockFrames;
+
+				// Partial last block still holds whatever complete runs are there
+				info.FrameCount = blocks * info.SamplesPerBlock + GetImaAdpcmBlockFrames(info.DataBytes % info.BlockAlign, info.Channels);
+			}
+			else
+				info.FrameCount = info.DataBytes / info.BlockAlign;
+
+			return true;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
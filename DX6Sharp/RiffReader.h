@@ -0,0 +1,57 @@
+#pragma once
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		struct RiffChunk
+		{
+			char Id[4];
+			unsigned int Size; // Without pad byte
+			const unsigned char* Data;
+		};
+
+		// Walks chunks of in-memory RIFF file. Sizes are validated against the buffer, truncated last chunk is clamped.
+		class RiffReader
+		{
+		private:
+			const unsigned char* data;
+			unsigned int size;
+			unsigned int offset;
+			char formType[4];
+		public:
+			RiffReader();
+
+			bool Open(const void* data, unsigned int size); // False if it isn't a RIFF file
+			bool IsFormType(const char* type);
+
+			bool NextChunk(RiffChunk& chunk);
+			bool FindChunk(const char* id, RiffChunk& chunk); // Searches from the beginning
+		};
+
+		enum WaveFormatTag
+		{
+			WaveFormatPcm = 1,
+			WaveFormatFloat = 3,
+			WaveFormatImaAdpcm = 0x11
+		};
+
+		struct WaveInfo
+		{
+			int FormatTag;
+			int Channels;
+			int SampleRate;
+			int AvgBytesPerSec;
+			int BlockAlign;
+			int BitsPerSample;
+			int SamplesPerBlock; // Frames per block for ADPCM, 1 for PCM
+
+			const unsigned char* Data;
+			unsigned int DataBytes;
+			int FrameCount;
+		};
+
+		// Parses fmt and data chunks of a WAVE file, skipping anything else (LIST, fact, cue, ...)
+		bool ParseWave(const void* file, unsigned int size, WaveInfo& info);
+	}
+}
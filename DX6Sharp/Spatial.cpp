@@ -0,0 +1,122 @@
+#include "dxsharp.h"
+
+namespace DXSharp
+{
+	namespace Sound
+	{
+		AudioScene::AudioScene(Mixer^ mixer, int realVoices)
+		{
+			if (mixer == nullptr)
+				throw gcnew ArgumentException("Mixer can't be null");
+
+			this->mixer = mixer; // Keeps native mixer alive for as long as we use it
+			scene = new Audio::SpatialAudio(mixer->mixer, realVoices, true);
+		}
+
+		AudioScene::~AudioScene()
+		{
+			this->!AudioScene();
+		}
+
+		AudioScene::!AudioScene()
+		{
+			if (scene)
+			{
+				delete scene;
+				scene = 0;
+			}
+		}
+
+		EmitterHandle AudioScene::AddEmitter(AudioClip^ clip, float gain, float minDistance, float maxDistance, int priority, bool loop)
+		{
+			if (clip == nullptr)
+				throw gcnew ArgumentException("Clip can't be null");
+
+			if (minDistance <= 0 || maxDistance < minDistance)
+				throw gcnew ArgumentException("Invalid emitter distance range");
+
+			Audio::EmitterParams params;
+			params.Gain = gain;
+			params.MinDistance = minDistance;
+			params.MaxDistance = maxDistance;
+			params.Priority = priority;
+			params.Loop = loop;
+
+			EmitterHandle ret;
+			ret.Id = scene->AddEmitter(clip->clip, params);
+
+			return ret;
+		}
+
+		void AudioScene::RemoveEmitter(EmitterHandle emitter)
+		{
+			scene->RemoveEmitter(emitter.Id);
+		}
+
+		void AudioScene::SetEmitter(EmitterHandle emitter, float x, float y, float z, float velocityX, float velocityY, float velocityZ)
+		{
+			scene->SetEmitterPosition(emitter.Id, x, y, z, velocityX, velocityY, velocityZ);
+		}
+
+		void AudioScene::SetEmitterGain(EmitterHandle emitter, float gain)
+		{
+			scene->SetEmitterGain(emitter.Id, gain);
+		}
+
+		void AudioScene::SetEmitterPitch(EmitterHandle emitter, float pitch)
+		{
+			scene->SetEmitterPitch(emitter.Id, pitch);
+		}
+
+		bool AudioScene::IsReal(EmitterHandle emitter)
+		{
+			return scene->IsEmitterReal(emitter.Id);
+		}
+
+		bool AudioScene::IsFinished(EmitterHandle emitter)
+		{
+			return scene->IsEmitterFinished(emitter.Id);
+		}
+
+		void AudioScene::SetListener(float x, float y, float z, float velocityX, float velocityY, float velocityZ,
+			float forwardX, float forwardY, float forwardZ, float upX, float upY, float upZ)
+		{
+			scene->SetListener(x, y, z, velocityX, velocityY, velocityZ, forwardX, forwardY, forwardZ, upX, upY, upZ);
+		}
+
+		void AudioScene::Update(float deltaTime)
+		{
+			scene->Update(deltaTime);
+		}
+
+		void AudioScene::SpeedOfSound::set(float value)
+		{
+			scene->SetSpeedOfSound(value);
+		}
+
+		void AudioScene::DopplerFactor::set(float value)
+		{
+			scene->SetDopplerFactor(value);
+		}
+
+		int AudioScene::EmitterCount::get()
+		{
+			return scene->GetEmitterCount();
+		}
+
+		int AudioScene::RealEmitters::get()
+		{
+			return scene->GetRealCount();
+		}
+
+		int AudioScene::VirtualEmitters::get()
+		{
+			return scene->GetVirtualCount();
+		}
+
+		bool AudioScene::IsSimdEnabled::get()
+		{
+			return scene->IsSimdEnabled();
+		}
+	}
+}
@@ -0,0 +1,571 @@
+#include "SpatialAudio.h"
+
+#include <string.h>
+#include <math.h>
+
+#ifdef PLATFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		static const int HandleIndexBits = 10; // Enough for MaxEmitters
+		static const int BatchArrays = 12;
+		static const float AudibleThreshold = 0.001f; // About -60dB
+		static const float RealVoiceBonus = 1.25f; // Hysteresis, so emitters of similar loudness don't keep swapping voices
+		static const float MaxDopplerSpeed = 0.5f; // Fraction of speed of sound relative velocities are clamped to
+
+		/* Kernels */
+
+		static void SpatializeScalar(SpatialBatch& b, int count)
+		{
+			float c = b.SpeedOfSound;
+			float maxSpeed = c * MaxDopplerSpeed;
+
+			for (int i = 0; i < count; i++)
+			{
+				float dx = b.X[i] - b.ListenerX;
+				float dy = b.Y[i] - b.ListenerY;
+				float dz = b.Z[i] - b.ListenerZ;
+				float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+				float inv = dist > 1e-4f ? 1.0f / dist : 0;
+
+				float clamped = dist < b.MinDistance[i] ? b.MinDistance[i] : dist;
+				b.Attenuation[i] = dist > b.MaxDistance[i] ? 0 : b.Gain[i] * b.MinDistance[i] / clamped;
+
+				float pan = (dx * b.RightX + dy * b.RightY + dz * b.RightZ) * inv;
+				b.Pan[i] = pan > 1 ? 1 : (pan < -1 ? -1 : pan);
+
+				// Velocities projected on listener->emitter direction: listener closing in raises pitch, emitter moving away lowers it
+				float vl = (b.ListenerVX * dx + b.ListenerVY * dy + b.ListenerVZ * dz) * inv * b.DopplerFactor;
+				float ve = (b.VX[i] * dx + b.VY[i] * dy + b.VZ[i] * dz) * inv * b.DopplerFactor;
+
+				vl = vl > maxSpeed ? maxSpeed : (vl < -maxSpeed ? -maxSpeed : vl);
+				ve = ve > maxSpeed ? maxSpeed : (ve < -maxSpeed ? -maxSpeed : ve);
+
+				b.Doppler[i] = (c + vl) / (c + ve);
+			}
+		}
+
+#ifdef PLATFORM_SSE
+		static void SpatializeSSE(SpatialBatch& b, int count)
+		{
+			__m128 lx = _mm_set1_ps(b.ListenerX), ly = _mm_set1_ps(b.ListenerY), lz = _mm_set1_ps(b.ListenerZ);
+			__m128 lvx = _mm_set1_ps(b.ListenerVX), lvy = _mm_set1_ps(b.ListenerVY), lvz = _mm_set1_ps(b.ListenerVZ);
+			__m128 rx = _mm_set1_ps(b.RightX), ry = _mm_set1_ps(b.RightY), rz = _mm_set1_ps(b.RightZ);
+			__m128 c = _mm_set1_ps(b.SpeedOfSound);
+			__m128 maxSpeed = _mm_set1_ps(b.SpeedOfSound * MaxDopplerSpeed);
+			__m128 minSpeed = _mm_sub_ps(_mm_setzero_ps(), maxSpeed);
+			__m128 factor = _mm_set1_ps(b.DopplerFactor);
+			__m128 one = _mm_set1_ps(1.0f);
+			__m128 minusOne = _mm_set1_ps(-1.0f);
+			__m128 epsilon = _mm_set1_ps(1e-4f);
+
+			// Batch arrays are padded, so count can be rounded up
+			for (int i = 0; i < count; i += 4)
+			{
+				__m128 dx = _mm_sub_ps(_mm_loadu_ps(b.X + i), lx);
+				__m128 dy = _mm_sub_ps(_mm_loadu_ps(b.Y + i), ly);
+				__m128 dz = _mm_sub_ps(_mm_loadu_ps(b.Z + i), lz);
+				__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+				__m128 inv = _mm_and_ps(_mm_cmpgt_ps(dist, epsilon), _mm_div_ps(one, dist));
+
+				__m128 minDist = _mm_loadu_ps(b.MinDistance + i);
+				__m128 att = _mm_div_ps(_mm_mul_ps(_mm_loadu_ps(b.Gain + i), minDist), _mm_max_ps(dist, minDist));
+				att = _mm_andnot_ps(_mm_cmpgt_ps(dist, _mm_loadu_ps(b.MaxDistance + i)), att);
+				_mm_storeu_ps(b.Attenuation + i, att);
+
+				__m128 pan = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, rx), _mm_mul_ps(dy, ry)), _mm_mul_ps(dz, rz)), inv);
+				_mm_storeu_ps(b.Pan + i, _mm_max_ps(_mm_min_ps(pan, one), minusOne));
+
+				__m128 scale = _mm_mul_ps(inv, factor);
+				__m128 vl = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, lvx), _mm_mul_ps(dy, lvy)), _mm_mul_ps(dz, lvz)), scale);
+				__m128 ve = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(b.VX + i)), _mm_mul_ps(dy, _mm_loadu_ps(b.VY + i))), _mm_mul_ps(dz, _mm_loadu_ps(b.VZ + i))), scale);
+
+				vl = _mm_max_ps(_mm_min_ps(vl, maxSpeed), minSpeed);
+				ve = _mm_max_ps(_mm_min_ps(ve, maxSpeed), minSpeed);
+
+				_mm_storeu_ps(b.Doppler + i, _mm_div_ps(_mm_add_ps(c, vl), _mm_add_ps(c, ve)));
+			}
+		}
+#endif
+
+		SpatialKernel SpatialAudio::GetScalarKernel()
+		{
+			return SpatializeScalar;
+		}
+
+		SpatialKernel SpatialAudio::GetBestKernel(bool& isSimd)
+		{
+#ifdef PLATFORM_SSE
+			if (Platform::GetCpuFeatures() & Platform::CpuSSE)
+			{
+				isSimd = true;
+				return SpatializeSSE;
+			}
+#endif
+
+			isSimd = false;
+			return SpatializeScalar;
+		}
+
+		/* SpatialAudio */
+
+		SpatialAudio::SpatialAudio(AudioMixer* mixer, int maxRealVoices, bool allowSimd)
+		{
+			this->mixer = mixer;
+
+			isSimd = false;
+			kernel = allowSimd ? GetBestKernel(isSimd) : GetScalarKernel();
+
+			if (maxRealVoices < 1)
+				maxRealVoices = 1;
+
+			if (maxRealVoices > mixer->GetVoiceCount())
+				maxRealVoices = mixer->GetVoiceCount();
+
+			maxReal = maxRealVoices;
+			ranking = new int[maxReal];
+			rankScore = new float[maxReal];
+
+			emitters = new Emitter[MaxEmitters];
+			emitterCount = 0;
+
+			for (int i = 0; i < MaxEmitters; i++)
+			{
+				emitters[i].clip = 0;
+				emitters[i].voice = 0;
+				emitters[i].generation = 0;
+			}
+
+			storage = new float[MaxEmitters * BatchArrays];
+			memset(storage, 0, MaxEmitters * BatchArrays * sizeof(float));
+
+			float** arrays[BatchArrays] = { &batch.X, &batch.Y, &batch.Z, &batch.VX, &batch.VY, &batch.VZ, &batch.Gain,
+				&batch.MinDistance, &batch.MaxDistance, &batch.Attenuation, &batch.Pan, &batch.Doppler };
+
+			for (int i = 0; i < BatchArrays; i++)
+				*arrays[i] = storage + i * MaxEmitters;
+
+			// Free slots stay silent, but must not produce NaNs
+			for (int i = 0; i < MaxEmitters; i++)
+			{
+				batch.MinDistance[i] = 1;
+				batch.MaxDistance[i] = 1;
+			}
+
+			batch.SpeedOfSound = 343.0f;
+			batch.DopplerFactor = 1;
+			SetListener(0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0);
+
+			realCount = 0;
+			virtualCount = 0;
+		}
+
+		SpatialAudio::~SpatialAudio()
+		{
+			for (int i = 0; i < emitterCount; i++)
+			{
+				Emitter& e = emitters[i];
+
+				if (!e.clip)
+					continue;
+
+				if (e.voice)
+					mixer->Stop(e.voice);
+
+				e.clip->Release();
+			}
+
+			delete[] emitters;
+			delete[] storage;
+			delete[] ranking;
+			delete[] rankScore;
+		}
+
+		SpatialAudio::Emitter* SpatialAudio::GetEmitter(EmitterHandle handle)
+		{
+			int index = handle & ((1 << HandleIndexBits) - 1);
+
+			if (index >= emitterCount)
+				return 0;
+
+			Emitter* e = &emitters[index];
+
+			if (!e->clip || e->generation != handle >> HandleIndexBits)
+				return 0;
+
+			return e;
+		}
+
+		EmitterHandle SpatialAudio::AddEmitter(SoundClip* clip, const EmitterParams& params)
+		{
+			if (!clip)
+				return 0;
+
+			int index = -1;
+
+			for (int i = 0; i < MaxEmitters; i++)
+			{
+				if (!emitters[i].clip)
+				{
+					index = i;
+					break;
+				}
+			}
+
+			if (index < 0)
+				return 0;
+
+			Emitter& e = emitters[index];
+
+			clip->AddRef();
+			e.clip = clip;
+			e.params = params;
+			e.voice = 0;
+			e.cursor = 0;
+			e.isFinished = false;
+
+			e.generation = (e.generation + 1) & ((1u << (32 - HandleIndexBits)) - 1);
+
+			if (e.generation == 0)
+				e.generation = 1;
+
+			batch.X[index] = batch.Y[index] = batch.Z[index] = 0;
+			batch.VX[index] = batch.VY[index] = batch.VZ[index] = 0;
+			batch.Gain[index] = params.Gain;
+			batch.MinDistance[index] = params.MinDistance > 0 ? params.MinDistance : 0.01f;
+			batch.MaxDistance[index] = params.MaxDistance > batch.MinDistance[index] ? params.MaxDistance : batch.MinDistance[index];
+
+			if (index >= emitterCount)
+				emitterCount = index + 1;
+
+			return (e.generation << HandleIndexBits) | (unsigned int)index;
+		}
+
+		void SpatialAudio::RemoveEmitter(EmitterHandle handle)
+		{
+			Emitter* e = GetEmitter(handle);
+
+			if (!e)
+				return;
+
+			int index = (int)(e - emitters);
+
+			if (e->voice)
+				mixer->Stop(e->voice);
+
+			e->clip->Release();
+			e->clip = 0;
+			e->voice = 0;
+
+			batch.Gain[index] = 0;
+			batch.MinDistance[index] = 1;
+			batch.MaxDistance[index] = 1;
+
+			while (emitterCount > 0 && !emitters[emitterCount - 1].clip)
+				emitterCount--;
+		}
+
+		void SpatialAudio::SetEmitterPosition(EmitterHandle handle, float x, float y, float z, float vx, float vy, float vz)
+		{
+			Emitter* e = GetEmitter(handle);
+
+			if (!e)
+				return;
+
+			int index = (int)(e - emitters);
+
+			batch.X[index] = x;
+			batch.Y[index] = y;
+			batch.Z[index] = z;
+			batch.VX[index] = vx;
+			batch.VY[index] = vy;
+			batch.VZ[index] = vz;
+		}
+
+		void SpatialAudio::SetEmitterGain(EmitterHandle handle, float gain)
+		{
+			Emitter* e = GetEmitter(handle);
+
+			if (e)
+			{
+				e->params.Gain = gain;
+				batch.Gain[e - emitters] = gain;
+			}
+		}
+
+		void SpatialAudio::SetEmitterPitch(EmitterHandle handle, float pitch)
+		{
+			Emitter* e = GetEmitter(handle);
+
+			if (e)
+				e->params.Pitch = pitch;
+		}
+
+		bool SpatialAudio::IsEmitterReal(EmitterHandle handle)
+		{
+			Emitter* e = GetEmitter(handle);
+
+			return e && e->voice != 0;
+		}
+
+		bool SpatialAudio::IsEmitterFinished(EmitterHandle handle)
+		{
+			Emitter* e = GetEmitter(handle);
+
+			return !e || e->isFinished;
+		}
+
+		int SpatialAudio::GetEmitterFrame(EmitterHandle handle)
+		{
+			Emitter* e = GetEmitter(handle);
+
+			return e ? (int)e->cursor : -1;
+		}
+
+		void SpatialAudio::SetListener(float x, float y, float z, float vx, float vy, float vz, float fx, float fy, float fz, float ux, float uy, float uz)
+		{
+			batch.ListenerX = x;
+			batch.ListenerY = y;
+			batch.ListenerZ = z;
+			batch.ListenerVX = vx;
+			batch.ListenerVY = vy;
+			batch.ListenerVZ = vz;
+
+			float rx = uy * fz - uz * fy;
+			float ry = uz * fx - ux * fz;
+			float rz = ux * fy - uy * fx;
+			float len = sqrtf(rx * rx + ry * ry + rz * rz);
+
+			// Degenerate basis (forward parallel to up) - keep previous right vector
+			if (len > 1e-6f)
+			{
+				batch.RightX = rx / len;
+				batch.RightY = ry / len;
+				batch.RightZ = rz / len;
+			}
+		}
+
+		void SpatialAudio::SetSpeedOfSound(float speed)
+		{
+			if (speed > 1)
+				batch.SpeedOfSound = speed;
+		}
+
+		void SpatialAudio::SetDopplerFactor(float factor)
+		{
+			batch.DopplerFactor = factor < 0 ? 0 : factor;
+		}
+
+		void SpatialAudio::Rank()
+		{
+			int count = 0;
+
+			for (int i = 0; i < emitterCount; i++)
+			{
+				Emitter& e = emitters[i];
+
+				if (!e.clip || e.isFinished || batch.Attenuation[i] < AudibleThreshold)
+					continue;
+
+				float score = batch.Attenuation[i] * (e.voice ? RealVoiceBonus : 1.0f);
+				int priority = e.params.Priority;
+
+				// Insertion into a short sorted list, maxReal is small compared to emitter count
+				int pos = count;
+
+				while (pos > 0)
+				{
+					Emitter& other = emitters[ranking[pos - 1]];
+
+					if (other.params.Priority > priority || (other.params.Priority == priority && rankScore[pos - 1] >= score))
+						break;
+
+					pos--;
+				}
+
+				if (pos >= maxReal)
+					continue;
+
+				int last = count < maxReal ? count : maxReal - 1;
+
+				for (int j = last; j > pos; j--)
+				{
+					ranking[j] = ranking[j - 1];
+					rankScore[j] = rankScore[j - 1];
+				}
+
+				ranking[pos] = i;
+				rankScore[pos] = score;
+
+				if (count < maxReal)
+					count++;
+			}
+
+			for (int i = count; i < maxReal; i++)
+				ranking[i] = -1;
+		}
+
+		void SpatialAudio::Promote(int index)
+		{
+			Emitter& e = emitters[index];
+
+			VoiceParams params;
+			params.Gain = batch.Attenuation[index];
+			params.Pan = batch.Pan[index];
+			params.Pitch = e.params.Pitch * batch.Doppler[index];
+			params.Priority = e.params.Priority;
+			params.Loop = e.params.Loop;
+			params.StartFrame = (int)e.cursor;
+
+			e.voice = mixer->Play(e.clip, params); // Stays virtual if mixer is busy with more important sounds
+		}
+
+		void SpatialAudio::Demote(int index)
+		{
+			Emitter& e = emitters[index];
+			int frame;
+
+			// Pick up exact position, so virtual cursor continues from where the voice stopped
+			if (mixer->SetParams(e.voice, 0, 0, 1, &frame))
+				e.cursor = frame;
+
+			mixer->Stop(e.voice);
+			e.voice = 0;
+		}
+
+		void SpatialAudio::Update(float deltaTime)
+		{
+			kernel(batch, (emitterCount + 3) & ~3);
+
+			// Virtual voices only advance their cursors
+			for (int i = 0; i < emitterCount; i++)
+			{
+				Emitter& e = emitters[i];
+
+				if (!e.clip || e.isFinished || e.voice)
+					continue;
+
+				int frames = e.clip->GetFrameCount();
+				e.cursor += deltaTime * e.clip->GetSampleRate() * e.params.Pitch * batch.Doppler[i];
+
+				if (e.cursor >= frames)
+				{
+					if (e.params.Loop)
+						e.cursor = fmod(e.cursor, (double)frames);
+					else
+						e.isFinished = true;
+				}
+			}
+
+			Rank();
+
+			// Demote first, so voices are free when promoted ones ask for them
+			for (int i = 0; i < emitterCount; i++)
+			{
+				Emitter& e = emitters[i];
+
+				if (!e.voice)
+					continue;
+
+				bool isRanked = false;
+
+				for (int j = 0; j < maxReal && ranking[j] >= 0; j++)
+				{
+					if (ranking[j] == i)
+					{
+						isRanked = true;
+						break;
+					}
+				}
+
+				if (!isRanked)
+					Demote(i);
+			}
+
+			realCount = 0;
+
+			for (int j = 0; j < maxReal && ranking[j] >= 0; j++)
+			{
+				int i = ranking[j];
+				Emitter& e = emitters[i];
+
+				if (e.voice)
+				{
+					int frame;
+
+					if (mixer->SetParams(e.voice, batch.Attenuation[i], batch.Pan[i], e.params.Pitch * batch.Doppler[i], &frame))
+					{
+						e.cursor = frame;
+						realCount++;
+						continue;
+					}
+
+					// Voice ended on its own or was stolen by a non-positional sound
+					double advance = deltaTime * e.clip->GetSampleRate() * e.params.Pitch * batch.Doppler[i];
+					e.voice = 0;
+
+					if (!e.params.Loop && e.cursor + advance * 2 >= e.clip->GetFrameCount())
+					{
+						e.isFinished = true;
+						continue;
+					}
+
+					e.cursor += advance;
+				}
+
+				Promote(i);
+
+				if (e.voice)
+					realCount++;
+			}
+
+			virtualCount = 0;
+
+			for (int i = 0; i < emitterCount; i++)
+			{
+				if (emitters[i].clip && !emitters[i].isFinished && !emitters[i].voice)
+					virtualCount++;
+			}
+		}
+
+		int SpatialAudio::GetEmitterCount()
+		{
+			int count = 0;
+
+			for (int i = 0; i < emitterCount; i++)
+			{
+				if (emitters[i].clip)
+					count++;
+			}
+
+			return count;
+		}
+
+		int SpatialAudio::GetRealCount()
+		{
+			return realCount;
+		}
+
+		int SpatialAudio::GetVirtualCount()
+		{
+			return virtualCount;
+		}
+
+		bool SpatialAudio::IsSimdEnabled()
+		{
+			return isSimd;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Platform.h"
+#include "AudioMixer.h"
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		typedef unsigned int EmitterHandle; // 0 is never a valid handle
+
+		struct EmitterParams
+		{
+			float Gain;
+			float Pitch;
+			float MinDistance; // Full volume inside this radius
+			float MaxDistance; // Emitter is culled beyond this distance
+			int Priority; // Outranks audibility when choosing real voices
+			bool Loop;
+
+			EmitterParams()
+			{
+				Gain = 1;
+				Pitch = 1;
+				MinDistance = 1;
+				MaxDistance = 100;
+				Priority = 0;
+				Loop = true;
+			}
+		};
+
+		// Positions, velocities and per-emitter results, kept as separate arrays so the kernel
+		// processes four emitters per iteration. Arrays are padded to a multiple of 4.
+		struct SpatialBatch
+		{
+			float* X;
+			float* Y;
+			float* Z;
+			float* VX;
+			float* VY;
+			float* VZ;
+			float* Gain;
+			float* MinDistance;
+			float* MaxDistance;
+
+			float* Attenuation; // Output, 0 when culled
+			float* Pan;
+			float* Doppler; // Pitch multiplier
+
+			// Listener
+			float ListenerX, ListenerY, ListenerZ;
+			float ListenerVX, ListenerVY, ListenerVZ;
+			float RightX, RightY, RightZ;
+			float SpeedOfSound;
+			float DopplerFactor;
+		};
+
+		typedef void (*SpatialKernel)(SpatialBatch& batch, int count);
+
+		// 3D positioning on top of AudioMixer. Attenuation, pan and Doppler for all emitters are computed
+		// in one pass, then only the most audible emitters get real mixer voices. The rest are virtual -
+		// their playback cursor keeps advancing, so they resume in the right place once they become audible.
+		// SetEmitterPosition for different emitters may run concurrently, everything else is single-threaded.
+		class SpatialAudio
+		{
+		public:
+			static const int MaxEmitters = 1024;
+		private:
+			struct Emitter
+			{
+				SoundClip* clip; // Free slot if null
+				EmitterParams params;
+				VoiceHandle voice; // 0 while virtual
+				double cursor; // Playback position in source frames
+				bool isFinished; // Non-looping sound reached the end
+				unsigned int generation;
+			};
+
+			AudioMixer* mixer;
+			SpatialKernel kernel;
+			bool isSimd;
+
+			Emitter* emitters;
+			int emitterCount; // Highest used slot + 1
+			int maxReal;
+
+			SpatialBatch batch;
+			float* storage;
+
+			int* ranking; // Top maxReal emitters, most audible first
+			float* rankScore;
+
+			float listenerForward[3];
+			float listenerUp[3];
+
+			int realCount;
+			int virtualCount;
+
+			SpatialAudio(const SpatialAudio&);
+			SpatialAudio& operator=(const SpatialAudio&);
+
+			Emitter* GetEmitter(EmitterHandle handle);
+			void Rank();
+			void Promote(int index);
+			void Demote(int index);
+		public:
+			// Mixer isn't owned. maxRealVoices should leave some mixer voices for non-positional sounds.
+			SpatialAudio(AudioMixer* mixer, int maxRealVoices, bool allowSimd);
+			~SpatialAudio();
+
+			EmitterHandle AddEmitter(SoundClip* clip, const EmitterParams& params);
+			void RemoveEmitter(EmitterHandle handle);
+
+			void SetEmitterPosition(EmitterHandle handle, float x, float y, float z, float vx, float vy, float vz);
+			void SetEmitterGain(EmitterHandle handle, float gain);
+			void SetEmitterPitch(EmitterHandle handle, float pitch);
+			bool IsEmitterReal(EmitterHandle handle);
+			bool IsEmitterFinished(EmitterHandle handle);
+			int GetEmitterFrame(EmitterHandle handle); // Playback position in source frames as of the last Update, -1 if invalid
+
+			// Left-handed, like Direct3D: right = up x forward
+			void SetListener(float x, float y, float z, float vx, float vy, float vz, float fx, float fy, float fz, float ux, float uy, float uz);
+			void SetSpeedOfSound(float speed);
+			void SetDopplerFactor(float factor); // 0 disables Doppler
+
+			void Update(float deltaTime);
+
+			int GetEmitterCount();
+			int GetRealCount();
+			int GetVirtualCount();
+			bool IsSimdEnabled();
+
+			static SpatialKernel GetScalarKernel();
+			static SpatialKernel GetBestKernel(bool& isSimd);
+		};
+	}
+}
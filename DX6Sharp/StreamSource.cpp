@@ -0,0 +1,339 @@
+#include "StreamSource.h"
+#include "ImaAdpcm.h"
+
+#include <string.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		static const int PcmBlockFrames = 1024;
+		static const int RefillTimeout = 100; // ms, decoder also tops up the ring periodically in case a signal was missed
+
+		StreamSource::StreamSource() : refillSignal(0)
+		{
+			refs = 1;
+			loop = false;
+			ring = 0;
+			ringFrames = 0;
+			writePos = 0;
+			readPos = 0;
+			block = 0;
+			blockFrames = 0;
+			dataOffset = 0;
+			isDecoderFinished = 0;
+			isRefillRequested = 0;
+			underruns = 0;
+			isRunning = 0;
+		}
+
+		StreamSource::~StreamSource()
+		{
+			if (Platform::AtomicExchange(&isRunning, 0))
+			{
+				refillSignal.Release(1);
+				thread.Join();
+			}
+
+			delete[] ring;
+			delete[] block;
+		}
+
+		bool StreamSource::Initialize(const void* data, unsigned int size, bool loop, int ringFrames)
+		{
+			if (!ParseWave(data, size, info))
+				return false;
+
+			if (info.Channels > 2)
+				return false;
+
+			switch (info.FormatTag)
+			{
+			case WaveFormatPcm:
+				if (info.BitsPerSample != 8 && info.BitsPerSample != 16)
+					return false;
+
+				blockFrames = PcmBlockFrames;
+				break;
+			case WaveFormatFloat:
+				if (info.BitsPerSample != 32)
+					return false;
+
+				blockFrames = PcmBlockFrames;
+				break;
+			case WaveFormatImaAdpcm:
+				if (info.SamplesPerBlock <= 0)
+					return false;
+
+				blockFrames = info.SamplesPerBlock;
+				break;
+			default:
+				return false;
+			}
+
+			this->loop = loop;
+
+			// Ring must fit at least two blocks, otherwise refill could never make progress
+			int frames = 1;
+
+			while (frames < ringFrames || frames < blockFrames * 2)
+				frames <<= 1;
+
+			this->ringFrames = frames;
+			ring = new short[frames * info.Channels];
+			block = new short[blockFrames * info.Channels];
+
+			return true;
+		}
+
+		void StreamSource::StartThread()
+		{
+			isRunning = 1;
+
+			if (!thread.Start(ThreadEntry, this))
+				isRunning = 0;
+		}
+
+		StreamSource* StreamSource::Open(const char* fileName, bool loop, int ringFrames)
+		{
+			StreamSource* stream = new StreamSource();
+
+			if (!stream->file.Open(fileName) || !stream->Initialize(stream->file.GetData(), stream->file.GetSize(), loop, ringFrames))
+			{
+				delete stream;
+				return 0;
+			}
+
+			stream->Refill();
+			stream->StartThread();
+
+			return stream;
+		}
+
+		StreamSource* StreamSource::OpenMemory(const void* data, unsigned int size, bool loop, int ringFrames, bool startThread)
+		{
+			StreamSource* stream = new StreamSource();
+
+			if (!stream->Initialize(data, size, loop, ringFrames))
+			{
+				delete stream;
+				return 0;
+			}
+
+			if (startThread)
+			{
+				stream->Refill();
+				stream->StartThread();
+			}
+
+			return stream;
+		}
+
+		void StreamSource::AddRef()
+		{
+			Platform::AtomicIncrement(&refs);
+		}
+
+		void StreamSource::Release()
+		{
+			if (Platform::AtomicDecrement(&refs) == 0)
+				delete this;
+		}
+
+		int StreamSource::DecodeNext()
+		{
+			if (dataOffset >= info.DataBytes)
+				return 0;
+
+			const unsigned char* src = info.Data + dataOffset;
+			unsigned int remaining = info.DataBytes - dataOffset;
+			int channels = info.Channels;
+
+			if (info.FormatTag == WaveFormatImaAdpcm)
+			{
+				int bytes = remaining < (unsigned int)info.BlockAlign ? (int)remaining : info.BlockAlign;
+				dataOffset += bytes;
+
+				return DecodeImaAdpcmBlock(src, bytes, channels, block, blockFrames);
+			}
+
+			int frames = (int)(remaining / info.BlockAlign);
+
+			if (frames > blockFrames)
+				frames = blockFrames;
+
+			int samples = frames * channels;
+			dataOffset += frames * info.BlockAlign;
+
+			if (frames == 0)
+			{
+				dataOffset = info.DataBytes; // Trailing garbage shorter than a frame
+				return 0;
+			}
+
+			if (info.FormatTag == WaveFormatFloat)
+			{
+				const float* f = (const float*)src;
+
+				for (int i = 0; i < samples; i++)
+				{
+					float v = f[i] * 32767.0f;
+					block[i] = (short)(v > 32767.0f ? 32767 : (v < -32768.0f ? -32768 : (int)v));
+				}
+			}
+			else if (info.BitsPerSample == 16)
+				memcpy(block, src, samples * sizeof(short));
+			else
+			{
+				for (int i = 0; i < samples; i++)
+					block[i] = (short)((src[i] - 128) << 8);
+			}
+
+			return frames;
+		}
+
+		int StreamSource::Refill()
+		{
+			int decoded = 0;
+			int channels = info.Channels;
+
+			while (!Platform::AtomicRead(&isDecoderFinished))
+			{
+				unsigned long write = (unsigned long)writePos;
+				unsigned long read = (unsigned long)Platform::AtomicRead(&readPos);
+				int freeFrames = ringFrames - (int)(write - read);
+
+				if (freeFrames < blockFrames)
+					break;
+
+				int frames = DecodeNext();
+
+				if (frames == 0)
+				{
+					if (loop && info.FrameCount > 0)
+					{
+						dataOffset = 0;
+						continue;
+					}
+
+					Platform::AtomicExchange(&isDecoderFinished, 1);
+					break;
+				}
+
+				int start = (int)(write & (ringFrames - 1));
+				int first = ringFrames - start < frames ? ringFrames - start : frames;
+
+				memcpy(ring + start * channels, block, first * channels * sizeof(short));
+
+				if (first < frames)
+					memcpy(ring, block + first * channels, (frames - first) * channels * sizeof(short));
+
+				// Frames must be visible before the consumer sees the new write position
+				Platform::FullBarrier();
+				Platform::AtomicExchange(&writePos, (long)(write + frames));
+
+				decoded += frames;
+
+				// Ends together with its last frame, not a refill later, so the voice doesn't play a block of silence first
+				if (!loop && dataOffset >= info.DataBytes)
+				{
+					Platform::AtomicExchange(&isDecoderFinished, 1);
+					break;
+				}
+			}
+
+			return decoded;
+		}
+
+		int StreamSource::Read(short* dst, int frames)
+		{
+			int channels = info.Channels;
+			unsigned long read = (unsigned long)readPos;
+			unsigned long write = (unsigned long)Platform::AtomicRead(&writePos);
+
+			int available = (int)(write - read);
+			int count = frames < available ? frames : available;
+
+			int start = (int)(read & (ringFrames - 1));
+			int first = ringFrames - start < count ? ringFrames - start : count;
+
+			memcpy(dst, ring + start * channels, first * channels * sizeof(short));
+
+			if (first < count)
+				memcpy(dst + first * channels, ring, (count - first) * channels * sizeof(short));
+
+			Platform::FullBarrier();
+			Platform::AtomicExchange(&readPos, (long)(read + count));
+
+			bool isDecoding = !Platform::AtomicRead(&isDecoderFinished);
+
+			if (count < frames && isDecoding)
+				underruns++;
+
+			// Our "notification position" - wake the decoder once the ring is half empty
+			if (available - count <= ringFrames / 2 && isRunning && isDecoding)
+			{
+				if (Platform::AtomicCompareExchange(&isRefillRequested, 1, 0) == 0)
+					refillSignal.Release(1);
+			}
+
+			return count;
+		}
+
+		bool StreamSource::IsFinished()
+		{
+			return Platform::AtomicRead(&isDecoderFinished) && readPos == Platform::AtomicRead(&writePos);
+		}
+
+		void StreamSource::ThreadEntry(void* arg)
+		{
+			StreamSource* self = (StreamSource*)arg;
+
+			while (Platform::AtomicRead(&self->isRunning))
+			{
+				self->refillSignal.Wait(RefillTimeout);
+				Platform::AtomicExchange(&self->isRefillRequested, 0);
+
+				self->Refill();
+			}
+		}
+
+		int StreamSource::GetChannels()
+		{
+			return info.Channels;
+		}
+
+		int StreamSource::GetSampleRate()
+		{
+			return info.SampleRate;
+		}
+
+		int StreamSource::GetFrameCount()
+		{
+			return info.FrameCount;
+		}
+
+		int StreamSource::GetBufferedFrames()
+		{
+			return (int)((unsigned long)Platform::AtomicRead(&writePos) - (unsigned long)Platform::AtomicRead(&readPos));
+		}
+
+		int StreamSource::GetMemoryUsage()
+		{
+			return (ringFrames + blockFrames) * info.Channels * sizeof(short) + sizeof(StreamSource);
+		}
+
+		long StreamSource::GetUnderrunCount()
+		{
+			return underruns;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Platform.h"
+#include "RiffReader.h"
+
+namespace DXSharp
+{
+	namespace Audio
+	{
+		// Decodes a WAVE file (PCM, float or IMA ADPCM) into a small ring of 16-bit frames.
+		// Compressed data stays in the mapped file, so resident memory doesn't depend on track length.
+		// Single consumer (one mixer voice) reads the ring, decoder thread refills it whenever
+		// consumer drains it past the half mark.
+		class StreamSource
+		{
+		private:
+			volatile long refs;
+
+			Platform::MappedFile file;
+			WaveInfo info;
+			bool loop;
+
+			short* ring;
+			int ringFrames; // Power of two
+			volatile long writePos; // Frame counters, only differences are meaningful
+			volatile long readPos;
+
+			short* block; // Decoded block before it's copied into the ring
+			int blockFrames;
+			unsigned int dataOffset; // Decoder cursor within data chunk
+
+			volatile long isDecoderFinished;
+			volatile long isRefillRequested;
+			long underruns;
+
+			Platform::Semaphore refillSignal;
+			Platform::Thread thread;
+			volatile long isRunning;
+
+			StreamSource();
+			~StreamSource();
+			StreamSource(const StreamSource&);
+			StreamSource& operator=(const StreamSource&);
+
+			bool Initialize(const void* data, unsigned int size, bool loop, int ringFrames);
+			void StartThread();
+			int DecodeNext(); // Decodes next block into block buffer, 0 at end of data
+
+			static void ThreadEntry(void* arg);
+		public:
+			static const int DefaultRingFrames = 16384;
+
+			// Maps the file and refills on a background thread. Returns null if file can't be read or format is unsupported.
+			static StreamSource* Open(const char* fileName, bool loop, int ringFrames);
+
+			// Streams from caller-owned memory. Without thread nothing is decoded until Refill is called.
+			static StreamSource* OpenMemory(const void* data, unsigned int size, bool loop, int ringFrames, bool startThread);
+
+			void AddRef();
+			void Release();
+
+			int Refill(); // Decodes until the ring is full or data runs out, returns frames decoded
+			int Read(short* dst, int frames); // Never blocks, returns less on underrun or at the end
+			bool IsFinished(); // Whole stream was read
+
+			int GetChannels();
+			int GetSampleRate();
+			int GetFrameCount();
+			int GetBufferedFrames();
+			int GetMemoryUsage(); // Heap only, mapped file pages are not counted
+			long GetUnderrunCount();
+		};
+	}
+}
@@ -0,0 +1,112 @@
+#include "dxsharp.h"
+
+namespace DXSharp
+{
+	namespace Timing
+	{
+		GameClock::GameClock(float fixedStep)
+		{
+			if (fixedStep <= 0)
+				throw gcnew ArgumentException("Fixed step must be positive");
+
+			clock = new FrameClock(new SystemClockSource(), true, fixedStep);
+		}
+
+		GameClock::~GameClock()
+		{
+			this->!GameClock();
+		}
+
+		GameClock::!GameClock()
+		{
+			if (clock)
+			{
+				delete clock;
+				clock = 0;
+			}
+		}
+
+		float GameClock::FixedStep::get()
+		{
+			return (float)clock->GetFixedStep();
+		}
+
+		void GameClock::FixedStep::set(float value)
+		{
+			if (value <= 0)
+				throw gcnew ArgumentException("Fixed step must be positive");
+
+			clock->SetFixedStep(value);
+		}
+
+		float GameClock::FrameRateLimit::get()
+		{
+			return (float)clock->GetFrameRateLimit();
+		}
+
+		void GameClock::FrameRateLimit::set(float value)
+		{
+			clock->SetFrameRateLimit(value);
+		}
+
+		float GameClock::FrameTime::get()
+		{
+			return (float)clock->GetFrameTime();
+		}
+
+		float GameClock::Alpha::get()
+		{
+			return (float)clock->GetAlpha();
+		}
+
+		double GameClock::SimulationTime::get()
+		{
+			return clock->GetSimulationTime();
+		}
+
+		double GameClock::RealTime::get()
+		{
+			return clock->GetRealTime();
+		}
+
+		int GameClock::StepsThisFrame::get()
+		{
+			return clock->GetStepsThisFrame();
+		}
+
+		float GameClock::AverageFrameTime::get()
+		{
+			return (float)clock->GetHistogram().GetAverage();
+		}
+
+		float GameClock::MaxFrameTime::get()
+		{
+			return (float)clock->GetHistogram().GetMax();
+		}
+
+		void GameClock::BeginFrame()
+		{
+			clock->BeginFrame();
+		}
+
+		bool GameClock::Step()
+		{
+			return clock->Step();
+		}
+
+		void GameClock::EndFrame()
+		{
+			clock->EndFrame();
+		}
+
+		float GameClock::GetFrameTimePercentile(float percent)
+		{
+			return (float)clock->GetHistogram().GetPercentile(percent);
+		}
+
+		void GameClock::ResetStats()
+		{
+			clock->GetHistogram().Reset();
+		}
+	}
+}
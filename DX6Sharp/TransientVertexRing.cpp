@@ -0,0 +1,187 @@
+#include "TransientVertexRing.h"
+
+#include <stdlib.h>
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		/* MemoryVertexRingStorage */
+
+		MemoryVertexRingStorage::MemoryVertexRingStorage(int vertexSize, int capacity)
+		{
+			this->vertexSize = vertexSize;
+			memory = (unsigned char*)malloc(vertexSize * capacity);
+		}
+
+		MemoryVertexRingStorage::~MemoryVertexRingStorage()
+		{
+			free(memory);
+		}
+
+		void* MemoryVertexRingStorage::Lock(int firstVertex, int vertexCount, bool discard)
+		{
+			return memory ? memory + firstVertex * vertexSize : 0;
+		}
+
+		void MemoryVertexRingStorage::Unlock()
+		{
+		}
+
+		/* TransientVertexRing */
+
+		TransientVertexRing::TransientVertexRing(VertexRingStorage* storage, int vertexSize, int capacity)
+		{
+			this->storage = storage;
+			this->vertexSize = vertexSize;
+			this->capacity = capacity;
+
+			writePos = 0;
+			retiredPos = 0;
+			fenceStart = 0;
+			fenceCount = 0;
+
+			isLocked = false;
+			needsDiscard = true; // First lock gets a fresh buffer too
+
+			wrapCount = 0;
+			failedCount = 0;
+		}
+
+		TransientVertexRing::~TransientVertexRing()
+		{
+			Commit();
+			delete storage;
+		}
+
+		bool TransientVertexRing::Allocate(int vertexCount, long fence, Allocation* result)
+		{
+			Commit();
+
+			if (vertexCount <= 0 || vertexCount > capacity)
+			{
+				failedCount++;
+				return false;
+			}
+
+			// A frame's vertices can't be split, so skip the tail of the buffer if they don't fit there
+			Platform::Int64 start = writePos;
+			int offset = (int)(start % capacity);
+			// Landing exactly on the end is a wrap too, the driver may still be reading the start of the buffer
+			bool wraps = offset + vertexCount > capacity || (offset == 0 && start > 0);
+
+			if (wraps && offset > 0)
+			{
+				start += capacity - offset;
+				offset = 0;
+			}
+
+			// New range must not reach into what the previous lap left in flight, i.e. [retiredPos, writePos)
+			if (retiredPos < writePos && start + vertexCount - capacity > retiredPos)
+			{
+				failedCount++;
+				return false;
+			}
+
+			Fence* last = fenceCount > 0 ? &fences[(fenceStart + fenceCount - 1) % MaxFences] : 0;
+
+			if (!last || last->Id != fence)
+			{
+				if (fenceCount == MaxFences)
+				{
+					failedCount++;
+					return false;
+				}
+
+				last = &fences[(fenceStart + fenceCount) % MaxFences];
+				last->Id = fence;
+				last->End = writePos;
+				fenceCount++;
+			}
+
+			void* data = storage->Lock(offset, vertexCount, wraps || needsDiscard);
+
+			if (!data)
+			{
+				failedCount++;
+				return false;
+			}
+
+			if (wraps)
+				wrapCount++;
+
+			if (retiredPos == writePos)
+				retiredPos = start; // Nothing in flight, skipped tail isn't worth counting as used
+
+			isLocked = true;
+			needsDiscard = false;
+
+			writePos = start + vertexCount;
+			last->End = writePos;
+
+			result->Data = data;
+			result->FirstVertex = offset;
+			result->VertexCount = vertexCount;
+
+			return true;
+		}
+
+		void TransientVertexRing::Commit()
+		{
+			if (!isLocked)
+				return;
+
+			storage->Unlock();
+			isLocked = false;
+		}
+
+		void TransientVertexRing::Retire(long fence)
+		{
+			while (fenceCount > 0 && fences[fenceStart].Id <= fence)
+			{
+				retiredPos = fences[fenceStart].End;
+
+				fenceStart = (fenceStart + 1) % MaxFences;
+				fenceCount--;
+			}
+		}
+
+		VertexRingStorage* TransientVertexRing::GetStorage()
+		{
+			return storage;
+		}
+
+		int TransientVertexRing::GetVertexSize()
+		{
+			return vertexSize;
+		}
+
+		int TransientVertexRing::GetCapacity()
+		{
+			return capacity;
+		}
+
+		int TransientVertexRing::GetUsedCount()
+		{
+			return (int)(writePos - retiredPos);
+		}
+
+		long TransientVertexRing::GetWrapCount()
+		{
+			return wrapCount;
+		}
+
+		long TransientVertexRing::GetFailedCount()
+		{
+			return failedCount;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
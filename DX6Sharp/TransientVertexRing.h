@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Platform.h"
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		// Memory behind a TransientVertexRing. Only one range is locked at a time.
+		class VertexRingStorage
+		{
+		public:
+			virtual ~VertexRingStorage() { }
+
+			// discard - ring wrapped, previous contents may be thrown away (DDLOCK_DISCARDCONTENTS),
+			// otherwise the range is guaranteed not to be in use (DDLOCK_NOOVERWRITE). Returns null on failure.
+			virtual void* Lock(int firstVertex, int vertexCount, bool discard) = 0;
+			virtual void Unlock() = 0;
+		};
+
+		// Plain system memory. Used when draws are replayed from pointers on the render thread, and by tools.
+		class MemoryVertexRingStorage : public VertexRingStorage
+		{
+		private:
+			unsigned char* memory;
+			int vertexSize;
+		public:
+			MemoryVertexRingStorage(int vertexSize, int capacity);
+			~MemoryVertexRingStorage();
+
+			virtual void* Lock(int firstVertex, int vertexCount, bool discard);
+			virtual void Unlock();
+		};
+
+		// Per-frame scratch vertices for geometry that changes every frame. Allocations are carved linearly out of
+		// a fixed buffer; when the end is reached the ring wraps and the next lock discards. Space is reused only
+		// after the frame that drew from it is retired, so recorded draws never see their vertices overwritten.
+		class TransientVertexRing
+		{
+		public:
+			static const int MaxFences = 8; // Frames with allocations still in flight
+
+			struct Allocation
+			{
+				void* Data;
+				int FirstVertex;
+				int VertexCount;
+			};
+		private:
+			struct Fence
+			{
+				long Id;
+				Platform::Int64 End; // Write position after the frame's last allocation
+			};
+
+			VertexRingStorage* storage;
+			int vertexSize;
+			int capacity;
+
+			// Positions grow forever, physical index is position % capacity
+			Platform::Int64 writePos;
+			Platform::Int64 retiredPos;
+
+			Fence fences[MaxFences];
+			int fenceStart;
+			int fenceCount;
+
+			bool isLocked;
+			bool needsDiscard;
+
+			long wrapCount;
+			long failedCount;
+
+			TransientVertexRing(const TransientVertexRing&);
+			TransientVertexRing& operator=(const TransientVertexRing&);
+		public:
+			// Takes ownership of storage, capacity is in vertices
+			TransientVertexRing(VertexRingStorage* storage, int vertexSize, int capacity);
+			~TransientVertexRing();
+
+			// fence identifies the frame that draws these vertices, ids never decrease. Data stays writable until
+			// Commit() or the next Allocate(). Returns false if the ring is full of in-flight frames.
+			bool Allocate(int vertexCount, long fence, Allocation* result);
+			void Commit(); // Unlocks storage, must happen before vertices are drawn
+
+			// Frames up to and including this fence are done with their vertices
+			void Retire(long fence);
+
+			VertexRingStorage* GetStorage();
+			int GetVertexSize();
+			int GetCapacity();
+			int GetUsedCount(); // Vertices in frames not yet retired, including the tail skipped on wrap
+			long GetWrapCount();
+			long GetFailedCount();
+		};
+	}
+}
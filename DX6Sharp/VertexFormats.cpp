@@ -0,0 +1,97 @@
+#include "VertexFormats.h"
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		bool GetFormatInfo(int format, VertexFormatInfo* info)
+		{
+			const int known = FvfXyz | FvfNormal | FvfDiffuse | FvfSpecular | FvfTexCountMask;
+			int texCount = (format & FvfTexCountMask) >> FvfTexCountShift;
+
+			if ((format & ~known) || !(format & FvfXyz) || texCount > 2)
+				return false;
+
+			int offset = 12;
+
+			info->Format = format;
+			info->NormalOffset = -1;
+			info->DiffuseOffset = -1;
+			info->SpecularOffset = -1;
+			info->TexOffset[0] = -1;
+			info->TexOffset[1] = -1;
+
+			if (format & FvfNormal)
+			{
+				info->NormalOffset = offset;
+				offset += 12;
+			}
+
+			if (format & FvfDiffuse)
+			{
+				info->DiffuseOffset = offset;
+				offset += 4;
+			}
+
+			if (format & FvfSpecular)
+			{
+				info->SpecularOffset = offset;
+				offset += 4;
+			}
+
+			for (int i = 0; i < texCount; i++)
+			{
+				info->TexOffset[i] = offset;
+				offset += 8;
+			}
+
+			info->TexCount = texCount;
+			info->Size = offset;
+
+			return true;
+		}
+
+		bool ConvertVertices(const void* source, int sourceFormat, void* dest, int destFormat, int count, const VertexDefaults& defaults)
+		{
+			VertexFormatInfo s, d;
+
+			if (!GetFormatInfo(sourceFormat, &s) || !GetFormatInfo(destFormat, &d))
+				return false;
+
+			const float zero[2] = { 0, 0 };
+
+			const unsigned char* src = (const unsigned char*)source;
+			unsigned char* dst = (unsigned char*)dest;
+
+			for (int i = 0; i < count; i++, src += s.Size, dst += d.Size)
+			{
+				memcpy(dst, src, 12);
+
+				if (d.NormalOffset >= 0)
+					memcpy(dst + d.NormalOffset, s.NormalOffset >= 0 ? src + s.NormalOffset : (const unsigned char*)defaults.Normal, 12);
+
+				if (d.DiffuseOffset >= 0)
+					memcpy(dst + d.DiffuseOffset, s.DiffuseOffset >= 0 ? src + s.DiffuseOffset : (const unsigned char*)&defaults.Diffuse, 4);
+
+				if (d.SpecularOffset >= 0)
+					memcpy(dst + d.SpecularOffset, s.SpecularOffset >= 0 ? src + s.SpecularOffset : (const unsigned char*)&defaults.Specular, 4);
+
+				if (d.TexOffset[0] >= 0)
+					memcpy(dst + d.TexOffset[0], s.TexOffset[0] >= 0 ? src + s.TexOffset[0] : (const unsigned char*)zero, 8);
+
+				if (d.TexOffset[1] >= 0)
+					memcpy(dst + d.TexOffset[1], s.TexOffset[1] >= 0 ? src + s.TexOffset[1] : s.TexOffset[0] >= 0 ? src + s.TexOffset[0] : (const unsigned char*)zero, 8);
+			}
+
+			return true;
+		}
+	}
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
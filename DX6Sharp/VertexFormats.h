@@ -0,0 +1,181 @@
+#pragma once
+
+#include <string.h>
+
+namespace DXSharp
+{
+	namespace Rendering
+	{
+		// Same values as D3DFVF_*, so layouts can be described without d3d.h
+		enum VertexFormatBits
+		{
+			FvfXyz = 0x002,
+			FvfNormal = 0x010,
+			FvfDiffuse = 0x040,
+			FvfSpecular = 0x080,
+			FvfTex1 = 0x100,
+			FvfTex2 = 0x200,
+			FvfTexCountMask = 0xF00,
+			FvfTexCountShift = 8
+		};
+
+		// Element offsets of an FVF code, resolved at compile time. D3D fixes the order: position, normal,
+		// diffuse, specular, texture coordinates. Missing elements have offset -1.
+		template<int Fvf> struct FvfLayout
+		{
+			enum
+			{
+				NormalOffset = (Fvf & FvfNormal) ? 12 : -1,
+				DiffuseOffset = (Fvf & FvfDiffuse) ? ((Fvf & FvfNormal) ? 24 : 12) : -1,
+				SpecularOffset = (Fvf & FvfSpecular) ? ((Fvf & FvfNormal) ? 24 : 12) + ((Fvf & FvfDiffuse) ? 4 : 0) : -1,
+				TexBase = ((Fvf & FvfNormal) ? 24 : 12) + ((Fvf & FvfDiffuse) ? 4 : 0) + ((Fvf & FvfSpecular) ? 4 : 0),
+				TexCount = (Fvf & FvfTexCountMask) >> FvfTexCountShift,
+				Tex0Offset = TexCount > 0 ? TexBase : -1,
+				Tex1Offset = TexCount > 1 ? TexBase + 8 : -1,
+				Size = TexBase + TexCount * 8
+			};
+		};
+
+		// Full layout, what D3D::Vertex and Device::VertexFormat use. 36 bytes.
+		struct VertexPNCT
+		{
+			enum { Format = FvfXyz | FvfNormal | FvfDiffuse | FvfTex1 };
+
+			float X, Y, Z;
+			float NX, NY, NZ;
+			unsigned int Diffuse;
+			float U, V;
+		};
+
+		// Unlit, color comes from texture only (skybox). 20 bytes.
+		struct VertexPT
+		{
+			enum { Format = FvfXyz | FvfTex1 };
+
+			float X, Y, Z;
+			float U, V;
+		};
+
+		// Unlit with per-vertex color or blend weight in alpha (terrain). 24 bytes.
+		struct VertexPCT
+		{
+			enum { Format = FvfXyz | FvfDiffuse | FvfTex1 };
+
+			float X, Y, Z;
+			unsigned int Diffuse;
+			float U, V;
+		};
+
+		// Lit by the device, material provides the color. 32 bytes.
+		struct VertexPNT
+		{
+			enum { Format = FvfXyz | FvfNormal | FvfTex1 };
+
+			float X, Y, Z;
+			float NX, NY, NZ;
+			float U, V;
+		};
+
+		// Lighting baked into diffuse and specular, drawn unlit. 28 bytes.
+		struct VertexLit
+		{
+			enum { Format = FvfXyz | FvfDiffuse | FvfSpecular | FvfTex1 };
+
+			float X, Y, Z;
+			unsigned int Diffuse;
+			unsigned int Specular;
+			float U, V;
+		};
+
+		// Separate coordinates for a detail texture in stage 1. 32 bytes.
+		struct VertexPCT2
+		{
+			enum { Format = FvfXyz | FvfDiffuse | FvfTex2 };
+
+			float X, Y, Z;
+			unsigned int Diffuse;
+			float U, V;
+			float U2, V2;
+		};
+
+		// Fails to compile if a struct doesn't match what D3D expects for its FVF
+		#define VERTEX_LAYOUT_CHECK(type) \
+			typedef char type##LayoutCheck[sizeof(type) == FvfLayout<type::Format>::Size ? 1 : -1]
+
+		VERTEX_LAYOUT_CHECK(VertexPNCT);
+		VERTEX_LAYOUT_CHECK(VertexPT);
+		VERTEX_LAYOUT_CHECK(VertexPCT);
+		VERTEX_LAYOUT_CHECK(VertexPNT);
+		VERTEX_LAYOUT_CHECK(VertexLit);
+		VERTEX_LAYOUT_CHECK(VertexPCT2);
+
+		// Values for elements the source layout doesn't have. Matches what D3D assumes for missing elements.
+		struct VertexDefaults
+		{
+			float Normal[3];
+			unsigned int Diffuse;
+			unsigned int Specular;
+
+			VertexDefaults()
+			{
+				Normal[0] = 0;
+				Normal[1] = 1;
+				Normal[2] = 0;
+				Diffuse = 0xFFFFFFFF;
+				Specular = 0;
+			}
+		};
+
+		// Runtime counterpart of FvfLayout for formats only known when loading
+		struct VertexFormatInfo
+		{
+			int Format;
+			int Size;
+			int NormalOffset;
+			int DiffuseOffset;
+			int SpecularOffset;
+			int TexCount;
+			int TexOffset[2];
+		};
+
+		// False for formats this code can't describe (pretransformed, blend weights, more than 2 texture sets)
+		bool GetFormatInfo(int format, VertexFormatInfo* info);
+
+		// Converts between any two supported layouts. Missing texture set 1 is filled from set 0, so detail
+		// stages get base coordinates by default. Returns false if either format is unsupported.
+		bool ConvertVertices(const void* source, int sourceFormat, void* dest, int destFormat, int count, const VertexDefaults& defaults);
+
+		// Same as above with both layouts fixed at compile time - every offset test folds away
+		template<typename Source, typename Dest>
+		void ConvertVertices(const Source* source, Dest* dest, int count, const VertexDefaults& defaults)
+		{
+			typedef FvfLayout<Source::Format> S;
+			typedef FvfLayout<Dest::Format> D;
+
+			const float zero[2] = { 0, 0 };
+
+			for (int i = 0; i < count; i++)
+			{
+				const unsigned char* s = (const unsigned char*)&source[i];
+				unsigned char* d = (unsigned char*)&dest[i];
+
+				memcpy(d, s, 12);
+
+				if (D::NormalOffset >= 0)
+					memcpy(d + D::NormalOffset, S::NormalOffset >= 0 ? s + S::NormalOffset : (const unsigned char*)defaults.Normal, 12);
+
+				if (D::DiffuseOffset >= 0)
+					memcpy(d + D::DiffuseOffset, S::DiffuseOffset >= 0 ? s + S::DiffuseOffset : (const unsigned char*)&defaults.Diffuse, 4);
+
+				if (D::SpecularOffset >= 0)
+					memcpy(d + D::SpecularOffset, S::SpecularOffset >= 0 ? s + S::SpecularOffset : (const unsigned char*)&defaults.Specular, 4);
+
+				if (D::Tex0Offset >= 0)
+					memcpy(d + D::Tex0Offset, S::Tex0Offset >= 0 ? s + S::Tex0Offset : (const unsigned char*)zero, 8);
+
+				if (D::Tex1Offset >= 0)
+					memcpy(d + D::Tex1Offset, S::Tex1Offset >= 0 ? s + S::Tex1Offset : S::Tex0Offset >= 0 ? s + S::Tex0Offset : (const unsigned char*)zero, 8);
+			}
+		}
+	}
+}
@@ -8,7 +8,28 @@
 #include <ddraw.h>
 #include <dsound.h>
 
-#define Guard(expr) DXSharp::Helpers::ExceptionManager::Assert(expr, #expr)
+#include "JobSystem.h"
+#include "FrameClock.h"
+#include "D3DCommandSink.h"
+#include "D3DVertexRingStorage.h"
+#include "VertexFormats.h"
+#include "AudioMixer.h"
+#include "SpatialAudio.h"
+#include "Logger.h"
+#include "HResultCheck.h"
+#include "PackFile.h"
+#include "ResourceCache.h"
+#include "DirectSoundAudioSink.h"
+
+// Successful calls only bump the site's counter, the exception is built when expr fails
+#define Guard(expr) \
+	do \
+	{ \
+		CHECK_SITE(guardSite, #expr); \
+		HRESULT guardResult = (expr); \
+		if (DXSharp::Checks::Check(guardSite, guardResult)) \
+			DXSharp::Helpers::ExceptionManager::Throw(guardSite, guardResult); \
+	} while (0)
 
 using namespace System;
 
@@ -22,10 +43,80 @@ namespace DXSharp
 
 	namespace Helpers
 	{
+		// Thrown for failed DirectX calls. Result holds the HRESULT, the rest points at the call that failed.
+		public ref class DirectXException : Exception
+		{
+		private:
+			String^ expression;
+			String^ file;
+			int line;
+
+			static String^ FormatMessage(const Checks::CheckSite& site, HRESULT res);
+		internal:
+			DirectXException(const Checks::CheckSite& site, HRESULT res);
+		public:
+			property int Result { int get(); }
+			property String^ Expression { String^ get(); }
+			property String^ File { String^ get(); }
+			property int Line { int get(); }
+		};
+
+		public ref class GraphicsException : DirectXException
+		{
+		internal:
+			GraphicsException(const Checks::CheckSite& site, HRESULT res);
+		};
+
+		// Surface memory was freed (mode switch, another app went exclusive). Restore() and reload contents.
+		public ref class SurfaceLostException : GraphicsException
+		{
+		internal:
+			SurfaceLostException(const Checks::CheckSite& site, HRESULT res);
+		};
+
+		public ref class OutOfVideoMemoryException : GraphicsException
+		{
+		internal:
+			OutOfVideoMemoryException(const Checks::CheckSite& site, HRESULT res);
+		};
+
+		public ref class SoundException : DirectXException
+		{
+		internal:
+			SoundException(const Checks::CheckSite& site, HRESULT res);
+		};
+
+		public ref class BufferLostException : SoundException
+		{
+		internal:
+			BufferLostException(const Checks::CheckSite& site, HRESULT res);
+		};
+
+		public ref class DirectXOutOfMemoryException : DirectXException
+		{
+		internal:
+			DirectXOutOfMemoryException(const Checks::CheckSite& site, HRESULT res);
+		};
+
+		// Bad parameters or wrong state, e.g. EndScene without BeginScene. Always a bug on our side.
+		public ref class InvalidCallException : DirectXException
+		{
+		internal:
+			InvalidCallException(const Checks::CheckSite& site, HRESULT res);
+		};
+
+		// Hardware or driver can't do what was asked
+		public ref class UnsupportedFeatureException : DirectXException
+		{
+		internal:
+			UnsupportedFeatureException(const Checks::CheckSite& site, HRESULT res);
+		};
+
 		ref class ExceptionManager
 		{
 		public:
-			static void Assert(HRESULT res, String^ methodName);
+			// Maps HRESULT to the most specific exception type and throws it
+			static void Throw(const Checks::CheckSite& site, HRESULT res);
 		};
 
 		public ref class Window
@@ -36,6 +127,8 @@ namespace DXSharp
 			IDirectDrawSurface4* primarySurface;
 			IDirectDrawSurface4* d3dSurface;
 
+			DXSharp::D3D::Device^ device;
+
 			static DDPIXELFORMAT* opaqueTextureFormat; // HACK
 			static DDPIXELFORMAT* zBufferFormat;
 
@@ -107,7 +200,7 @@ namespace DXSharp
 		
 		public ref class DirectSound
 		{
-		private:
+		internal:
 			IDirectSound* dsound;
 		public:
 			DirectSound();
@@ -119,6 +212,146 @@ namespace DXSharp
 
 			
 		};
+
+		public value struct VoiceHandle
+		{
+		internal:
+			unsigned int Id;
+		public:
+			property bool IsValid
+			{
+				bool get() { return Id != 0; }
+			}
+		};
+
+		// PCM data playable by Mixer. 8/16-bit integer, 32-bit float or IMA ADPCM, mono or stereo.
+		// ADPCM is decoded once at load.
+		public ref class AudioClip
+		{
+		internal:
+			Audio::SoundClip* clip;
+		public:
+			AudioClip(WaveFormat format, array<byte>^ pcmData);
+			~AudioClip();
+			!AudioClip();
+
+			property int Channels { int get(); }
+			property int SampleRate { int get(); }
+			property int FrameCount { int get(); }
+			property float Duration { float get(); }
+			property int MemoryUsage { int get(); }
+		};
+
+		// WAVE file decoded on the fly into a small ring, for music and other long sounds.
+		// Can be played by one voice at a time.
+		public ref class AudioStream
+		{
+		internal:
+			Audio::StreamSource* stream;
+
+			AudioStream(Audio::StreamSource* stream);
+		public:
+			~AudioStream();
+			!AudioStream();
+
+			static AudioStream^ Open(String^ fileName, bool loop);
+
+			property int Channels { int get(); }
+			property int SampleRate { int get(); }
+			property float Duration { float get(); }
+			property int MemoryUsage { int get(); }
+			property int BufferedFrames { int get(); }
+			property int Underruns { int get(); }
+		};
+
+		// Software mixer with fixed voice pool. All voices end up in a single streaming output buffer.
+		public ref class Mixer
+		{
+		internal:
+			Audio::AudioMixer* mixer;
+		private:
+			Audio::AudioSink* sink;
+
+			Mixer(Audio::AudioSink* sink, int voiceCount);
+		public:
+			// DirectSound output, mixing runs on its own thread
+			Mixer(DirectSound^ device, int sampleRate, int voiceCount, int latencyMs);
+			~Mixer();
+			!Mixer();
+
+			// Outputs without real-time clock, nothing is mixed until Update is called
+			static Mixer^ CreateNull(int sampleRate, int voiceCount);
+			static Mixer^ CreateWaveFile(String^ fileName, int sampleRate, int voiceCount);
+
+			VoiceHandle Play(AudioClip^ clip, float gain, float pan, float pitch, int priority, bool loop);
+			VoiceHandle Play(AudioStream^ stream, float gain, float pan, float pitch, int priority);
+			void Stop(VoiceHandle voice);
+			bool IsPlaying(VoiceHandle voice);
+
+			void SetGain(VoiceHandle voice, float gain);
+			void SetPan(VoiceHandle voice, float pan);
+			void SetPitch(VoiceHandle voice, float pitch);
+
+			int Update();
+
+			property float MasterGain
+			{
+				float get();
+				void set(float value);
+			}
+
+			property int VoiceCount { int get(); }
+			property int ActiveVoices { int get(); }
+			property int StolenVoices { int get(); }
+			property bool IsSimdEnabled { bool get(); }
+		};
+
+		public value struct EmitterHandle
+		{
+		internal:
+			unsigned int Id;
+		public:
+			property bool IsValid
+			{
+				bool get() { return Id != 0; }
+			}
+		};
+
+		// Positional sounds on top of Mixer. Only the most audible emitters own real voices, the rest
+		// keep advancing silently and take a voice back when they get close enough.
+		// Call Update once per simulation step, after emitters and listener were moved.
+		public ref class AudioScene
+		{
+		private:
+			Audio::SpatialAudio* scene;
+			Mixer^ mixer;
+		public:
+			AudioScene(Mixer^ mixer, int realVoices);
+			~AudioScene();
+			!AudioScene();
+
+			EmitterHandle AddEmitter(AudioClip^ clip, float gain, float minDistance, float maxDistance, int priority, bool loop);
+			void RemoveEmitter(EmitterHandle emitter);
+
+			void SetEmitter(EmitterHandle emitter, float x, float y, float z, float velocityX, float velocityY, float velocityZ);
+			void SetEmitterGain(EmitterHandle emitter, float gain);
+			void SetEmitterPitch(EmitterHandle emitter, float pitch);
+			bool IsReal(EmitterHandle emitter);
+			bool IsFinished(EmitterHandle emitter);
+
+			void SetListener(float x, float y, float z, float velocityX, float velocityY, float velocityZ,
+				float forwardX, float forwardY, float forwardZ, float upX, float upY, float upZ);
+
+			void Update(float deltaTime);
+
+			property float SpeedOfSound { void set(float value); }
+			property float DopplerFactor { void set(float value); }
+
+			property int EmitterCount { int get(); }
+			property int RealEmitters { int get(); }
+			property int VirtualEmitters { int get(); }
+			property bool IsSimdEnabled { bool get(); }
+		};
 	}
 
 	namespace D3D
@@ -216,12 +449,77 @@ namespace DXSharp
 		public value struct Vertex
 		{
 		public:
+			literal int Format = Rendering::VertexPNCT::Format;
+
 			float X, Y, Z;
 			float NX, NY, NZ;
 			D3DCOLOR Diffuse;
 			float U, V;
 		};
 
+		// Compact layouts, chosen per mesh at load time with VertexConverter. Field order mirrors the
+		// Rendering:: structs of the same name, which is what the FVF in Format describes.
+		public value struct VertexPT
+		{
+		public:
+			literal int Format = Rendering::VertexPT::Format;
+
+			float X, Y, Z;
+			float U, V;
+		};
+
+		public value struct VertexPCT
+		{
+		public:
+			literal int Format = Rendering::VertexPCT::Format;
+
+			float X, Y, Z;
+			D3DCOLOR Diffuse;
+			float U, V;
+		};
+
+		public value struct VertexPNT
+		{
+		public:
+			literal int Format = Rendering::VertexPNT::Format;
+
+			float X, Y, Z;
+			float NX, NY, NZ;
+			float U, V;
+		};
+
+		// Pre-lit, draw with lighting off
+		public value struct VertexLit
+		{
+		public:
+			literal int Format = Rendering::VertexLit::Format;
+
+			float X, Y, Z;
+			D3DCOLOR Diffuse;
+			D3DCOLOR Specular;
+			float U, V;
+		};
+
+		public value struct VertexPCT2
+		{
+		public:
+			literal int Format = Rendering::VertexPCT2::Format;
+
+			float X, Y, Z;
+			D3DCOLOR Diffuse;
+			float U, V;
+			float U2, V2;
+		};
+
+		public ref class VertexConverter abstract sealed
+		{
+		public:
+			// Returns Vertex[], VertexPT[], VertexPCT[]... depending on format. Elements the full layout has and the
+			// target lacks are dropped, the second texture set of VertexPCT2 starts as a copy of the first.
+			static Array^ Convert(array<Vertex>^ source, int format);
+			static int GetVertexSize(int format); // 0 if format is not supported
+		};
+
 		public enum class TextureStageState
 		{
 			ColorOp = D3DTSS_COLOROP,
@@ -270,21 +568,60 @@ namespace DXSharp
 
 			Texture(DXSharp::Helpers::Window^ window, int width, int height, int mipCount);
 
+			// No finalizer: surfaces may only be released on the device thread, once no recorded frame uses them.
+			// A texture that is never disposed lives until the DirectDraw object goes away.
+			~Texture();
+
 			void FromHBitmap(IntPtr hbitmap);
 			void FromPixelArray(array<byte>^ pixels, int width, int height, int mipLevel);
+
+			property int SizeInBytes { int get(); } // Video memory taken, all mip levels
+		};
+
+		// Vertices allocated from the device's per-frame ring (Device::AllocateTransient). Write them, then draw
+		// with Device::DrawTransient in the same frame - after the frame is presented the memory belongs to the ring again.
+		public value struct TransientVertices
+		{
+		internal:
+			D3D::Vertex* data;
+			int firstVertex;
+			int count;
+		public:
+			property int Count { int get(); } // 0 if ring had no room
+			property D3D::Vertex default[int] { D3D::Vertex get(int index); void set(int index, D3D::Vertex value); }
+
+			void CopyFrom(array<D3D::Vertex>^ source, int sourceIndex, int destIndex, int length);
 		};
 
 		public ref class Device
 		{
 		private:
 			IDirect3DViewport3* currentViewport;
+
+			// Dynamic geometry. Vertex buffer with NOOVERWRITE/DISCARD locks in immediate mode, system memory
+			// drawn by pointer on the render thread otherwise. Created on first use.
+			Rendering::TransientVertexRing* transientRing;
+			Rendering::D3DVertexRingStorage* transientBuffer; // Storage of transientRing in immediate mode
+
+			Rendering::TransientVertexRing* GetTransientRing();
+			void ReleaseTransientRing();
+
+			// Non-null while commands are recorded and replayed on a separate thread
+			Rendering::RenderThread* renderThread;
+			Rendering::D3DCommandSink* commandSink;
+
+			void ThrowRenderThreadError();
 		internal:
+			DXSharp::Helpers::Window^ window;
 			IDirect3D3* direct3d;
 			IDirect3DDevice3* device;
 
 			IDirect3DMaterial3* material;
 
-			Device(IDirect3D3* direct3d, IDirect3DDevice3* device);
+			Device(DXSharp::Helpers::Window^ window, IDirect3D3* direct3d, IDirect3DDevice3* device);
+
+			void SubmitFrame(); // Called by Window::Present in threaded mode
+			void Submit(PrimitiveType primitiveType, int vertexFormat, int vertexSize, bool lit, const void* vertices, int vertexCount);
 		public:
 			static const int VertexFormat = D3DFVF_XYZ | D3DFVF_NORMAL | D3DFVF_DIFFUSE | D3DFVF_TEX1;
 
@@ -307,7 +644,357 @@ namespace DXSharp
 			void Begin(PrimitiveType primitiveType, int vertexTypeDesc, bool lit);
 			void Vertex(Vertex vertex);
 			void End();
+
+			void DrawPrimitive(PrimitiveType primitiveType, int vertexTypeDesc, bool lit, array<DXSharp::D3D::Vertex>^ vertices, int startVertex, int vertexCount);
+
+			// vertices is an array of any vertex struct above, the format is taken from its element type
+			void DrawPrimitive(PrimitiveType primitiveType, bool lit, Array^ vertices, int startVertex, int vertexCount);
+
+			static const int TransientVertexCount = 32768; // Per frame in flight, ~1.1MB with VertexFormat
+
+			// Per-frame vertices of VertexFormat, no managed allocation. Count is 0 if frames in flight use up the ring.
+			TransientVertices AllocateTransient(int vertexCount);
+			void DrawTransient(PrimitiveType primitiveType, bool lit, TransientVertices vertices);
+			void DrawTransient(PrimitiveType primitiveType, bool lit, TransientVertices vertices, int startVertex, int vertexCount);
+
+			// Moves all device calls to a dedicated thread. Game thread records the frame and may run up to
+			// maxFrameLatency frames ahead. Textures must not be released while the device is in this mode.
+			void EnableRenderThread(int maxFrameLatency);
+			void DisableRenderThread();
+			void Flush(); // Waits until every recorded command is executed
+
+			property bool IsRenderThreadEnabled
+			{
+				bool get() { return renderThread != 0; }
+			}
+		};
+
+	}
+
+	namespace Jobs
+	{
+		public delegate void JobRangeHandler(int start, int end);
+
+		// Tracks completion of a set of submitted jobs
+		public ref class JobGroup
+		{
+		internal:
+			JobCounter* counter;
+		public:
+			JobGroup();
+			~JobGroup();
+			!JobGroup();
+
+			property bool IsDone
+			{
+				bool get();
+			}
+		};
+
+		public ref class JobScheduler
+		{
+		private:
+			JobSystem* system;
+			void* selfHandle; // Weak GCHandle, lets jobs find the scheduler to report exceptions to
+			Exception^ pendingError;
+
+			void ThrowPendingError();
+		internal:
+			void ReportError(Exception^ e);
+		public:
+			JobScheduler(int workerCount);
+			JobScheduler(int workerCount, bool deterministic);
+			~JobScheduler();
+			!JobScheduler();
+
+			property int WorkerCount
+			{
+				int get();
+			}
+
+			property bool IsDeterministic
+			{
+				bool get();
+			}
+
+			void Run(JobRangeHandler^ handler, JobGroup^ group);
+			void RunAfter(JobGroup^ dependency, JobRangeHandler^ handler, JobGroup^ group);
+			void ParallelFor(int count, int minBatch, JobRangeHandler^ handler, JobGroup^ group);
+			void ParallelFor(int count, int minBatch, JobRangeHandler^ handler);
+			void Wait(JobGroup^ group);
+		};
+	}
+
+	namespace Timing
+	{
+		// High-resolution fixed-timestep clock, wraps native FrameClock
+		public ref class GameClock
+		{
+		private:
+			FrameClock* clock;
+		public:
+			GameClock(float fixedStep);
+			~GameClock();
+			!GameClock();
+
+			property float FixedStep
+			{
+				float get();
+				void set(float value);
+			}
+
+			property float FrameRateLimit
+			{
+				float get();
+				void set(float value);
+			}
+
+			property float FrameTime
+			{
+				float get();
+			}
+
+			property float Alpha
+			{
+				float get();
+			}
+
+			property double SimulationTime
+			{
+				double get();
+			}
+
+			property double RealTime
+			{
+				double get();
+			}
+
+			property int StepsThisFrame
+			{
+				int get();
+			}
+
+			property float AverageFrameTime
+			{
+				float get();
+			}
+
+			property float MaxFrameTime
+			{
+				float get();
+			}
+
+			void BeginFrame();
+			bool Step();
+			void EndFrame();
+
+			float GetFrameTimePercentile(float percent);
+			void ResetStats();
+		};
+	}
+	namespace Diagnostics
+	{
+		public enum class LogLevel
+		{
+			Trace = Logging::LogTrace,
+			Debug = Logging::LogDebug,
+			Info = Logging::LogInfo,
+			Warning = Logging::LogWarning,
+			Error = Logging::LogError,
+			Off = Logging::LogOff
+		};
+
+		// Single log argument. Converted implicitly at the call site, so value types are never boxed.
+		public value struct LogArg
+		{
+		internal:
+			Logging::LogArgType Type;
+			Int64 Int;
+			double Double;
+			String^ Text;
+		public:
+			static operator LogArg(int value);
+			static operator LogArg(Int64 value);
+			static operator LogArg(float value);
+			static operator LogArg(double value);
+			static operator LogArg(bool value);
+			static operator LogArg(String^ value);
+		};
+
+		// Call site descriptor - keep one in a static readonly field per logging statement.
+		// Registered with the native logger for the process lifetime, so sites are never freed.
+		public ref class LogSite
+		{
+		private:
+			Logging::LogSite* site;
+
+			void Write(int count, LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5, LogArg a6, LogArg a7);
+		public:
+			LogSite(String^ category, LogLevel level, String^ format);
+
+			property bool IsEnabled { bool get(); }
+
+			void Write();
+			void Write(LogArg a0);
+			void Write(LogArg a0, LogArg a1);
+			void Write(LogArg a0, LogArg a1, LogArg a2);
+			void Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3);
+			void Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4);
+			void Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5);
+			void Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5, LogArg a6);
+			void Write(LogArg a0, LogArg a1, LogArg a2, LogArg a3, LogArg a4, LogArg a5, LogArg a6, LogArg a7);
+		};
+
+		// Asynchronous logger shared with native code, formatting and output happen on a background thread
+		public ref class Logger abstract sealed
+		{
+		public:
+			static void InitializeConsole();
+			static void InitializeFile(String^ fileName);
+			static void Shutdown();
+			static void Flush();
+
+			static void SetLevel(String^ category, LogLevel level);
+
+			static property int Written { int get(); }
+			static property int Dropped { int get(); }
+		};
+
+		// Counters of one Guard()ed call. Sites show up once they were executed at least once.
+		public value struct CheckSiteStats
+		{
+			String^ Expression;
+			String^ File;
+			int Line;
+			int Calls;
+			int Failures;
+			int LastResult; // HRESULT of the last failure, 0 if none
+		};
+
+		public ref class CheckStatistics abstract sealed
+		{
+		public:
+			static array<CheckSiteStats>^ GetSites();
+			static void Reset();
+
+			static property int SiteCount { int get(); }
+			static property int TotalFailures { int get(); }
 		};
+	}
+
+	namespace IO
+	{
+		// Read-only .pak archive built with "TexTool pack". Entries stored uncompressed are read straight from the
+		// mapping, LZ4 ones are unpacked into a buffer owned by the returned stream. Streams must not outlive the archive.
+		public ref class PackArchive
+		{
+		private:
+			String^ fileName;
+		internal:
+			Assets::PackFile* pack;
+
+			int Find(String^ path);
+			System::IO::Stream^ OpenEntry(int index);
+		public:
+			PackArchive(String^ fileName, bool verifyChecksums); // Throws IOException if the pack is missing or damaged
+			~PackArchive();
+			!PackArchive();
+
+			bool Contains(String^ path);
+			System::IO::Stream^ Open(String^ path); // nullptr if there is no such entry or it's damaged
 
+			property String^ FileName { String^ get(); }
+			property int EntryCount { int get(); }
+			property int FailedCount { int get(); } // Entries rejected on CRC or decompression errors
+		};
+
+		// Where loaders get their files from. Mounted packs are searched newest first, then the loose file on disk
+		// unless AllowLooseFiles is off - development builds run straight from the data folder without any pack.
+		public ref class FileSystem abstract sealed
+		{
+		private:
+			static System::Collections::Generic::List<PackArchive^>^ packs;
+			static bool allowLooseFiles;
+			static bool verifyChecksums;
+			static int packReads;
+			static int looseReads;
+
+			static FileSystem();
+		internal:
+			// Zero-copy view of a stored pack entry, false if it's loose, compressed or missing
+			static bool TryGetSpan(String^ path, Assets::PackSpan* span);
+		public:
+			static void Mount(String^ fileName);
+			static void UnmountAll(); // Only once every stream opened from packs is closed
+
+			static bool Exists(String^ path);
+			static System::IO::Stream^ Open(String^ path); // nullptr if the file is nowhere to be found
+
+			static property bool AllowLooseFiles { bool get(); void set(bool value); }
+			static property bool VerifyChecksums { bool get(); void set(bool value); } // Applies to packs mounted later
+			static property int PackReads { int get(); }
+			static property int LooseReads { int get(); }
+		};
+
+		public value struct ResourceHandle
+		{
+		internal:
+			unsigned int Id;
+		public:
+			property bool IsValid
+			{
+				bool get() { return Id != 0; }
+			}
+		};
+
+		public delegate Object^ ResourceLoader(String^ path, int parameters); // nullptr if it can't be loaded
+		public delegate int ResourceSizer(Object^ resource); // Bytes a loaded resource occupies
+
+		public value struct ResourceTypeStats
+		{
+			String^ Name;
+			int Count;
+			int Referenced;
+			Int64 Bytes;
+			int Hits;
+			int Misses;
+			int Joins; // Found loading on another thread and waited for it
+			int Failures;
+			int Unloads;
+		};
+
+		// Loads every (type, path, parameters) once and shares it. Acquire returns a handle holding a reference;
+		// resources nobody references stay loaded until Unload, which disposes them if they are IDisposable.
+		public ref class ResourceManager
+		{
+		private:
+			Assets::ResourceCache* cache;
+			array<String^>^ typeNames;
+			array<ResourceLoader^>^ loaders;
+			array<ResourceSizer^>^ sizers;
+			int typeCount;
+		public:
+			ResourceManager(int capacity);
+			~ResourceManager(); // Unloads whatever nobody references
+			!ResourceManager();
+
+			int RegisterType(String^ name, ResourceLoader^ loader, ResourceSizer^ sizer); // Returns the type id
+
+			// Loads on the calling thread if nobody did yet; concurrent callers wait for that load instead of
+			// starting their own. Handle of a failed load is valid, but Get returns nullptr for it.
+			ResourceHandle Acquire(int type, String^ path, int parameters);
+			Object^ Get(ResourceHandle handle);
+			void AddRef(ResourceHandle handle);
+			void Release(ResourceHandle handle);
+
+			// Dispose runs on the calling thread, so unload from the thread that owns the device when textures are cached
+			int Unload(int type);
+			int UnloadAll();
+
+			ResourceTypeStats GetStats(int type);
+
+			property int TypeCount { int get(); }
+			property int Count { int get(); }
+		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Reflection;
+using System.Text;
+
+namespace Planes3D.Tests
+{
+    [AttributeUsage(AttributeTargets.Method)]
+    public sealed class TestAttribute : Attribute
+    {
+    }
+
+    public sealed class TestFailedException : Exception
+    {
+        public TestFailedException(string message) : base(message)
+        {
+        }
+    }
+
+    public static class Check
+    {
+        public static void That(bool condition, string message)
+        {
+            if (!condition)
+                throw new TestFailedException(message);
+        }
+
+        public static void Equal<T>(T expected, T actual, string what)
+        {
+            if (!EqualityComparer<T>.Default.Equals(expected, actual))
+                throw new TestFailedException(what + ": expected " + expected + ", got " + actual);
+        }
+    }
+
+    /// <summary>
+    /// Runs every [Test] method of this assembly whose "Class.Method" name contains the first argument. Exit code 1 if any failed.
+    /// </summary>
+    public static class TestRunner
+    {
+        public static int Main(string[] args)
+        {
+            string filter = args.Length > 0 ? args[0] : null;
+            int ran = 0;
+            int failed = 0;
+
+            foreach (Type type in typeof(TestRunner).Assembly.GetTypes())
+            {
+                foreach (MethodInfo method in type.GetMethods(BindingFlags.Public | BindingFlags.Static))
+                {
+                    if (method.GetCustomAttributes(typeof(TestAttribute), false).Length == 0)
+                        continue;
+
+                    string name = type.Name + "." + method.Name;
+
+                    if (filter != null && !name.Contains(filter))
+                        continue;
+
+                    Console.WriteLine(name);
+                    ran++;
+
+                    try
+                    {
+                        method.Invoke(null, null);
+                        Console.WriteLine("  ok");
+                    }
+                    catch (TargetInvocationException e)
+                    {
+                        Console.WriteLine("  FAILED: " + (e.InnerException is TestFailedException ? e.InnerException.Message : e.InnerException.ToString()));
+                        failed++;
+                    }
+                }
+            }
+
+            Console.WriteLine();
+            Console.WriteLine((ran - failed) + " of " + ran + " tests passed");
+
+            return failed > 0 || ran == 0 ? 1 : 0;
+        }
+    }
+}
@@ -0,0 +1,440 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text;
+
+namespace Planes3D.Tests
+{
+    // Resolution of 1 keeps tick math exact, Scene uses 0.01 but the wheel only ever sees ticks
+    public static class TimerWheelTests
+    {
+        const int LevelOneDelay = 100; // Past the 64 slots of the first level
+        const int LevelTwoDelay = 5000; // Past 64 * 64
+        const int LevelThreeDelay = 300000; // Past 64 * 64 * 64
+        const int ParkedDelay = 17000000; // Past the 2^24 ticks the wheel covers, still exact as a float
+
+        private static List<float> fired;
+
+        private static void Record(float time)
+        {
+            fired.Add(time);
+        }
+
+        private static TimerWheel CreateWheel()
+        {
+            fired = new List<float>();
+
+            return new TimerWheel(1);
+        }
+
+        // Steps one tick at a time and returns the tick the only scheduled timer fired at, -1 if it didn't
+        private static int FindFireTick(TimerWheel wheel, int lastTick)
+        {
+            for (int tick = 1; tick <= lastTick; tick++)
+            {
+                wheel.Advance(tick);
+
+                if (fired.Count > 0)
+                    return tick;
+            }
+
+            return -1;
+        }
+
+        [Test]
+        public static void FiresOnceWhenDue()
+        {
+            TimerWheel wheel = CreateWheel();
+            TimerHandle handle = wheel.Schedule(5, Record);
+
+            wheel.Advance(4);
+            Check.Equal(0, fired.Count, "fired before due");
+            Check.That(handle.IsPending, "timer should be pending");
+
+            wheel.Advance(5);
+            Check.Equal(1, fired.Count, "fire count");
+            Check.Equal(5.0f, fired[0], "callback time");
+            Check.Equal(0, wheel.Count, "pending count");
+            Check.That(!handle.IsPending, "fired timer is still pending");
+
+            wheel.Advance(100);
+            Check.Equal(1, fired.Count, "one-shot timer fired again");
+        }
+
+        [Test]
+        public static void TimersThatAreNotDueStayPending()
+        {
+            // Scene's old task list dropped every task on the first Update, due or not
+            TimerWheel wheel = CreateWheel();
+
+            for (int i = 1; i <= 10; i++)
+                wheel.Schedule(i, Record);
+
+            for (int i = 1; i <= 10; i++)
+            {
+                wheel.Advance(i);
+
+                Check.Equal(i, fired.Count, "fired after tick " + i);
+                Check.Equal(10 - i, wheel.Count, "pending after tick " + i);
+            }
+        }
+
+        [Test]
+        public static void SameTickTimersAllFire()
+        {
+            TimerWheel wheel = CreateWheel();
+
+            for (int i = 0; i < 1000; i++)
+                wheel.Schedule(7, Record);
+
+            wheel.Advance(6);
+            Check.Equal(0, fired.Count, "fired early");
+
+            wheel.Advance(7);
+            Check.Equal(1000, fired.Count, "fire count");
+            Check.Equal(0, wheel.Count, "pending count");
+        }
+
+        [Test]
+        public static void ZeroDelayFromCallbackFiresOnNextTick()
+        {
+            TimerWheel wheel = CreateWheel();
+            int inner = 0;
+
+            wheel.Schedule(5, delegate(float time)
+            {
+                // Lands in the next slot, not the batch being fired
+                wheel.Schedule(0, delegate(float t) { inner++; });
+            });
+
+            wheel.Advance(5);
+            Check.Equal(0, inner, "fired in the same tick");
+            Check.Equal(1, wheel.Count, "pending count");
+
+            wheel.Advance(5.5f);
+            Check.Equal(0, inner, "fired without a new tick");
+
+            wheel.Advance(6);
+            Check.Equal(1, inner, "fire count");
+        }
+
+        [Test]
+        public static void CascadesFromEveryLevelOnTime()
+        {
+            int[] delays = { 63, 64, LevelOneDelay, 4095, 4096, LevelTwoDelay, 262143, 262144, LevelThreeDelay };
+
+            foreach (int delay in delays)
+            {
+                TimerWheel wheel = CreateWheel();
+                wheel.Schedule(delay, Record);
+
+                Check.Equal(delay, FindFireTick(wheel, delay + 10), "fire tick of delay " + delay);
+            }
+        }
+
+        [Test]
+        public static void CascadesAfterClockMovedOn()
+        {
+            // Same delays, but with the wheel's slots no longer aligned to zero
+            int[] delays = { 64, LevelOneDelay, LevelTwoDelay, LevelThreeDelay };
+
+            foreach (int delay in delays)
+            {
+                TimerWheel wheel = CreateWheel();
+                int start = 12345;
+                int fireTick = -1;
+
+                wheel.Schedule(1, Record);
+                wheel.Advance(start - 1);
+                fired.Clear();
+
+                wheel.Schedule(delay, Record);
+
+                for (int tick = start; tick <= start + delay + 10 && fireTick < 0; tick++)
+                {
+                    wheel.Advance(tick);
+
+                    if (fired.Count > 0)
+                        fireTick = tick;
+                }
+
+                Check.Equal(start - 1 + delay, fireTick, "fire tick of delay " + delay);
+            }
+        }
+
+        [Test]
+        public static void IdleSkipKeepsLaterTimersOnTime()
+        {
+            TimerWheel wheel = CreateWheel();
+
+            wheel.Advance(1000); // Nothing pending, wheel jumps straight there
+
+            wheel.Schedule(LevelOneDelay, Record);
+            wheel.Advance(1000 + LevelOneDelay - 1);
+            Check.Equal(0, fired.Count, "fired early");
+
+            wheel.Advance(1000 + LevelOneDelay);
+            Check.Equal(1, fired.Count, "fire count");
+        }
+
+        [Test]
+        public static void DelayPastWheelRangeIsParked()
+        {
+            TimerWheel wheel = CreateWheel();
+
+            wheel.Schedule(ParkedDelay, Record);
+
+            wheel.Advance(ParkedDelay - 2);
+            Check.Equal(0, fired.Count, "fired early");
+            Check.Equal(1, wheel.Count, "pending count");
+
+            wheel.Advance(ParkedDelay);
+            Check.Equal(1, fired.Count, "fire count");
+        }
+
+        [Test]
+        public static void RandomTimersFireExactlyOnceWhenDue()
+        {
+            Random random = new Random(1234);
+            TimerWheel wheel = new TimerWheel(1);
+            int[] fireCount = new int[2000];
+            float[] fireTime = new float[2000];
+            int[] expire = new int[2000];
+            float now = 0;
+
+            for (int i = 0; i < fireCount.Length; i++)
+            {
+                int index = i;
+
+                // Mostly short delays like gameplay timers, some far enough to cascade from the top level
+                expire[i] = random.Next(4) == 0 ? random.Next(LevelThreeDelay) : random.Next(LevelOneDelay * 3);
+
+                wheel.Schedule(expire[i], delegate(float time)
+                {
+                    fireCount[index]++;
+                    fireTime[index] = time;
+                });
+            }
+
+            // Uneven frames, sometimes long hitches
+            List<float> steps = new List<float>();
+
+            while (now < LevelThreeDelay + 1)
+            {
+                float previous = now;
+                now += random.Next(20) == 0 ? random.Next(1, 5000) : random.Next(1, 4);
+                steps.Add(now);
+
+                wheel.Advance(now);
+
+                for (int i = 0; i < fireCount.Length; i++)
+                {
+                    bool due = expire[i] <= now;
+
+                    if (due && fireCount[i] == 0)
+                        throw new TestFailedException("timer " + i + " due at " + expire[i] + " didn't fire by " + now);
+
+                    if (!due && fireCount[i] != 0)
+                        throw new TestFailedException("timer " + i + " due at " + expire[i] + " fired at " + fireTime[i]);
+                }
+            }
+
+            for (int i = 0; i < fireCount.Length; i++)
+                Check.Equal(1, fireCount[i], "fire count of timer " + i);
+
+            Check.Equal(0, wheel.Count, "pending count");
+        }
+
+        [Test]
+        public static void CancelBeforeFire()
+        {
+            TimerWheel wheel = CreateWheel();
+            TimerHandle handle = wheel.Schedule(LevelTwoDelay, Record);
+
+            Check.That(wheel.Cancel(handle), "cancel failed");
+            Check.That(!handle.IsPending, "cancelled timer is pending");
+            Check.Equal(0, wheel.Count, "pending count");
+            Check.That(!wheel.Cancel(handle), "second cancel succeeded");
+
+            wheel.Advance(LevelTwoDelay + 1);
+            Check.Equal(0, fired.Count, "cancelled timer fired");
+        }
+
+        [Test]
+        public static void StaleHandleDoesNotCancelReusedTimer()
+        {
+            TimerWheel wheel = CreateWheel();
+            TimerHandle first = wheel.Schedule(1, Record);
+
+            wheel.Advance(1);
+
+            // Fired timer went back to the pool, the next one reuses it
+            TimerHandle second = wheel.Schedule(1, Record);
+
+            Check.That(!wheel.Cancel(first), "stale handle cancelled a reused timer");
+            Check.That(second.IsPending, "reused timer isn't pending");
+
+            wheel.Advance(2);
+            Check.Equal(2, fired.Count, "fire count");
+        }
+
+        [Test]
+        public static void CancelFromOwnCallbackStopsRepeating()
+        {
+            TimerWheel wheel = CreateWheel();
+            TimerHandle handle = new TimerHandle();
+            int count = 0;
+
+            handle = wheel.Schedule(2, 2, delegate(float time)
+            {
+                if (++count == 3)
+                    wheel.Cancel(handle);
+            });
+
+            for (int tick = 1; tick <= 20; tick++)
+                wheel.Advance(tick);
+
+            Check.Equal(3, count, "fire count");
+            Check.Equal(0, wheel.Count, "pending count");
+            Check.That(!handle.IsPending, "cancelled timer is pending");
+        }
+
+        [Test]
+        public static void CancelOtherTimerOfSameBatch()
+        {
+            TimerWheel wheel = CreateWheel();
+            TimerHandle a = new TimerHandle();
+            TimerHandle b = new TimerHandle();
+            int count = 0;
+
+            // Whichever fires first cancels the other, so exactly one may run
+            a = wheel.Schedule(3, delegate(float time) { count++; wheel.Cancel(b); });
+            b = wheel.Schedule(3, delegate(float time) { count++; wheel.Cancel(a); });
+
+            wheel.Advance(3);
+
+            Check.Equal(1, count, "fire count");
+            Check.Equal(0, wheel.Count, "pending count");
+        }
+
+        [Test]
+        public static void ThrowingCallbackKeepsRestOfBatch()
+        {
+            TimerWheel wheel = CreateWheel();
+            TimerHandle cancelled = new TimerHandle();
+            int throws = 0;
+            int cancelledFires = 0;
+
+            // Same tick, so all of them are detached together. Whichever order they run in, some are still waiting when one throws.
+            for (int i = 0; i < 4; i++)
+                wheel.Schedule(3, Record);
+
+            wheel.Schedule(3, delegate(float time)
+            {
+                wheel.Cancel(cancelled);
+                throws++;
+                throw new InvalidOperationException("callback failed");
+            });
+
+            cancelled = wheel.Schedule(3, delegate(float time) { cancelledFires++; });
+            wheel.Schedule(3, 2, Record);
+            wheel.Schedule(4, Record);
+
+            bool caught = false;
+
+            try
+            {
+                wheel.Advance(3);
+            }
+            catch (InvalidOperationException)
+            {
+                caught = true;
+            }
+
+            Check.That(caught, "exception didn't reach the caller");
+            Check.Equal(1, throws, "throwing callback runs");
+            Check.That(!cancelled.IsPending, "timer cancelled by the throwing callback is pending");
+
+            // Same time again finishes the tick, the thrower is gone and nothing fires twice
+            wheel.Advance(3);
+            Check.Equal(1, throws, "throwing callback ran again");
+            Check.Equal(5, fired.Count, "timers of the tick fired after the exception");
+            Check.That(cancelledFires <= 1, "cancelled timer fired twice");
+
+            wheel.Advance(4);
+            Check.Equal(6, fired.Count, "timer of the next tick");
+            Check.Equal(4.0f, fired[5], "callback time");
+
+            wheel.Advance(5);
+            Check.Equal(7, fired.Count, "repeating timer wasn't re-armed");
+            Check.Equal(1, wheel.Count, "pending count");
+        }
+
+        [Test]
+        public static void RepeatingTimerCatchesUpAfterHitch()
+        {
+            TimerWheel wheel = CreateWheel();
+
+            wheel.Schedule(3, 3, Record);
+
+            wheel.Advance(10); // Due at 3, 6 and 9
+            Check.Equal(3, fired.Count, "fires during hitch");
+
+            wheel.Advance(11);
+            Check.Equal(3, fired.Count, "fired between intervals");
+
+            wheel.Advance(12);
+            Check.Equal(4, fired.Count, "fire count");
+            Check.Equal(1, wheel.Count, "repeating timer isn't pending");
+        }
+
+        [Test]
+        public static void ManyPendingTimersCostNothingUntilDue()
+        {
+            TimerWheel wheel = CreateWheel();
+            int count = 0;
+            Action<float> action = delegate(float time) { count++; };
+
+            for (int i = 0; i < 10000; i++)
+                wheel.Schedule(LevelOneDelay + i % 1000, action);
+
+            for (int tick = 1; tick < LevelOneDelay; tick++)
+                wheel.Advance(tick);
+
+            Check.Equal(0, count, "fired early");
+            Check.Equal(10000, wheel.Count, "pending count");
+
+            wheel.Advance(LevelOneDelay + 1000);
+            Check.Equal(10000, count, "fire count");
+        }
+
+        [Test]
+        public static void RejectsInvalidArguments()
+        {
+            bool threw = false;
+
+            try
+            {
+                new TimerWheel(0);
+            }
+            catch (ArgumentException)
+            {
+                threw = true;
+            }
+
+            Check.That(threw, "zero resolution accepted");
+
+            threw = false;
+
+            try
+            {
+                CreateWheel().Schedule(1, null);
+            }
+            catch (ArgumentException)
+            {
+                threw = true;
+            }
+
+            Check.That(threw, "null action accepted");
+        }
+    }
+}
@@ -2,7 +2,10 @@
 using System.Collections.Generic;
 using System.Text;
 using DXSharp.Helpers;
-using System.Diagnostics;
+using DXSharp.Jobs;
+using DXSharp.Timing;
+using DXSharp.Diagnostics;
+using DXSharp.IO;
 
 namespace Planes3D
 {
@@ -10,6 +13,13 @@ namespace Planes3D
     {
         public static Engine Current;
 
+        static readonly LogSite windowSite = new LogSite(Log.Engine, LogLevel.Info, "Creating window");
+        static readonly LogSite jobsSite = new LogSite(Log.Engine, LogLevel.Info, "Job scheduler started with {0} workers");
+        static readonly LogSite graphicsSite = new LogSite(Log.Engine, LogLevel.Info, "Initializing graphics...");
+        static readonly LogSite renderThreadSite = new LogSite(Log.Engine, LogLevel.Info, "Render thread enabled, max frame latency {0}");
+        static readonly LogSite packSite = new LogSite(Log.Engine, LogLevel.Info, "Mounted {0}");
+        static readonly LogSite loadedSite = new LogSite(Log.Engine, LogLevel.Info, "Loaded {0} files from packs, {1} loose");
+
         public static void Initialize()
         {
             Current = new Engine();
@@ -19,47 +29,65 @@ namespace Planes3D
         public Window Window;
         public Graphics Graphics;
         public SoundDevice Sound;
+        public JobScheduler Jobs;
+
+        const float SimulationRate = 60; // Fixed simulation steps per second
+        const float FrameRateLimit = 0; // 0 - render as fast as possible
+        const int MaxFrameLatency = 2; // Frames game thread may record ahead of render thread
+        const string PackFileName = "data.pak"; // Built with "TexTool pack data.pak . data FW190.tex -lz4"
 
-        private Stopwatch stopwatch;
+        public static readonly Vector3 SunDirection = new Vector3(0.3f, -0.8f, 0.9f); // Terrain bakes it into vertex colors
 
-        public float DeltaTime;
+        public GameClock Clock;
+
+        public float DeltaTime; // Fixed step length while simulation is updated
+        public float Interpolation; // How far rendering is between last two simulation steps, [0..1)
 
         private Terrain terrain;
-        private Water water;
         private Mesh mesh;
 
-        private PlayerAirplane player;
-
         private Engine()
         {
-            Log.WriteLine("Creating window");
+            windowSite.Write();
 
             Window = new Window(640, 480, false);
 
-            stopwatch = new Stopwatch();
+            Clock = new GameClock(1.0f / SimulationRate);
+            Clock.FrameRateLimit = FrameRateLimit;
+            DeltaTime = Clock.FixedStep;
         }
 
         private void InitializeModules()
         {
-            Log.WriteLine("Initializing graphics...");
+            // Without a pack (development) everything is read from loose files
+            if (System.IO.File.Exists(PackFileName))
+            {
+#if DEBUG
+                FileSystem.VerifyChecksums = true;
+#endif
+                FileSystem.Mount(PackFileName);
+                packSite.Write(PackFileName);
+            }
 
-            Graphics = new Graphics();
-            Sound = new SoundDevice();
+            // Main thread takes part in job execution too, so leave one core for it
+            Jobs = new JobScheduler(Math.Max(0, Environment.ProcessorCount - 1));
+            jobsSite.Write(Jobs.WorkerCount);
 
-            
+            graphicsSite.Write();
 
-            water = new Water();
+            Graphics = new Graphics();
+            Sound = new SoundDevice();
 
-            player = new PlayerAirplane();
+            Resources.Initialize();
 
             DXSharp.D3D.Light light = new DXSharp.D3D.Light(Graphics.Context);
             light.Type = DXSharp.D3D.LightType.Directional;
             light.R = 1.0f;
             light.G = 1.0f;
             light.B = 1.0f;
-            light.DX = 0.3f;
-            light.DY = -0.8f;
-            light.DZ = 0.9f;
+            light.DX = SunDirection.X;
+            light.DY = SunDirection.Y;
+            light.DZ = SunDirection.Z;
             light.X = 0;
             light.Y = 1000;
             light.Z = 1000;
@@ -67,27 +95,46 @@ namespace Planes3D
 
             Graphics.AddLight(light);
 
+            // Single core machines would only pay for context switches
+            if (Environment.ProcessorCount > 1)
+            {
+                Graphics.Context.EnableRenderThread(MaxFrameLatency);
+                renderThreadSite.Write(MaxFrameLatency);
+            }
+
             Game.Current = new Game();
             Game.Current.Start();
+
+            loadedSite.Write(FileSystem.PackReads, FileSystem.LooseReads);
+            Resources.WriteStats();
         }
         
         public void RunEventLoop()
         {
             while(Window.DoEvents())
             {
-                stopwatch.Start();
+                Clock.BeginFrame();
+                DeltaTime = Clock.FixedStep;
 
-                Game.Current.Update();
+                // Simulation always advances in fixed steps, no matter how fast we render
+                while (Clock.Step())
+                {
+                    Graphics.Camera.SaveState();
+                    Game.Current.Update();
+                    Sound.Update(Graphics.Camera, DeltaTime);
+                }
+
+                Interpolation = Clock.Alpha;
 
                 Graphics.BeginScene();
                 Game.Current.Draw();
                 Graphics.EndScene();
                 Window.Present();
 
-                stopwatch.Stop();
-                DeltaTime = (float)stopwatch.ElapsedMilliseconds / 1000.0f;
-                stopwatch.Reset();
+                Clock.EndFrame();
             }
+
+            Graphics.Context.DisableRenderThread();
         }
     }
 }
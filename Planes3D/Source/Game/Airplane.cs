@@ -1,6 +1,8 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Text;
+using DXSharp.Sound;
+using DXSharp.D3D;
 
 namespace Planes3D
 {
@@ -10,24 +12,29 @@ namespace Planes3D
 
         const float Speed = 35.0f;
         const float YawSpeed = 55.0f;
+        const float EngineHearingDistance = 250.0f;
 
         public int Health;
 
-        private Mesh mesh;
-        private Mesh propellerMesh;
-        private Material material;
+        private Resource<Mesh> mesh;
+        private Resource<Mesh> propellerMesh;
+        private Resource<Texture> texture;
+        private Material material; // Drawn with instead of the shared mesh's own, propeller too
 
-        private WaveBuffer engineSound;
+        private Resource<WaveBuffer> engineSound;
+        private EmitterHandle engineEmitter;
 
         public PlayerAirplane()
         {
-            mesh = Mesh.FromStream(System.IO.File.OpenRead("data/geometry/FW_190.smd"));
-            mesh.AssignedMaterial = Material.CreateDiffuse(TextureLoader.LoadFromFile("FW190.tex"));
+            mesh = Resources.LoadMesh("data/geometry/FW_190.smd", VertexPNT.Format);
+            propellerMesh = Resources.LoadMesh("data/geometry/propeller.smd", VertexPNT.Format);
+            texture = Resources.LoadTexture("FW190.tex");
+            material = Material.CreateDiffuse(texture.Value);
 
-            propellerMesh = Mesh.FromFile("data/geometry/propeller.smd");
-            propellerMesh.AssignedMaterial = mesh.AssignedMaterial;
+            engineSound = Resources.LoadSound("data/sound/propeller.wav");
 
-            engineSound = SoundLoader.LoadFromFile("data/sound/propeller.wav");
+            if (engineSound.Value != null)
+                engineEmitter = engineSound.Value.CreateEmitter(1.0f, 8.0f, EngineHearingDistance, 1, true); // Player's engine is never virtualized
 
             Position.Y = 15;
 
@@ -49,7 +56,7 @@ namespace Planes3D
 
         private void CheckCollision()
         {
-            bool isCollidedWithAnything = Game.Current.Terrain.CheckCollision(Position, mesh.Radius);
+            bool isCollidedWithAnything = Game.Current.Terrain.CheckCollision(Position, mesh.Value.Radius);
 
            // if (isCollidedWithAnything)
            //     Health = 0;
@@ -66,6 +73,10 @@ namespace Planes3D
                 CheckCollision();
             }
 
+            Vector3 velocity = GetForward();
+            float speed = Health > 0 ? Speed : 0;
+            Engine.Current.Sound.Scene.SetEmitter(engineEmitter, Position.X, Position.Y, Position.Z, velocity.X * speed, velocity.Y * speed, velocity.Z * speed);
+
             float rot = (float)Math.Atan2(Engine.Current.Graphics.Camera.Position.Z - Position.Z, Engine.Current.Graphics.Camera.Position.X - Position.X);
 
             Vector3 forward = GetForward();
@@ -81,7 +92,18 @@ namespace Planes3D
         public override void Draw()
         {
             if(Health > 0)
-                Engine.Current.Graphics.DrawMesh(mesh, Position, Rotation, new Vector3(1, 1, 1));
+                Engine.Current.Graphics.DrawMesh(mesh.Value, GetRenderPosition(), GetRenderRotation(), new Vector3(1, 1, 1), material);
+        }
+
+        public override void OnRemoved()
+        {
+            if (engineEmitter.IsValid)
+                Engine.Current.Sound.Scene.RemoveEmitter(engineEmitter);
+
+            mesh.Release();
+            propellerMesh.Release();
+            texture.Release();
+            engineSound.Release();
         }
     }
 }
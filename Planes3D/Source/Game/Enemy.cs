@@ -1,6 +1,8 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Text;
+using DXSharp.Sound;
+using DXSharp.D3D;
 
 namespace Planes3D
 {
@@ -10,19 +12,33 @@ namespace Planes3D
 
         const float Speed = 10.0f;
         const float YawSpeed = 35;
+        const float EngineHearingDistance = 250.0f;
 
         public int Health;
 
-        private Mesh mesh;
+        // Shared by all enemies (and the player), every one of them gets its own material and emitter
+        private Resource<Mesh> mesh;
+        private Resource<Texture> texture;
+        private Resource<WaveBuffer> engineSound;
+
+        private Material material;
+        private EmitterHandle engineEmitter;
 
         public Enemy()
         {
-            mesh = Mesh.FromStream(System.IO.File.OpenRead("data/geometry/FW_190.smd"));
-            mesh.AssignedMaterial = Material.CreateDiffuse(TextureLoader.LoadFromFile("FW190.tex"));
+            mesh = Resources.LoadMesh("data/geometry/FW_190.smd", VertexPNT.Format);
+            texture = Resources.LoadTexture("FW190.tex");
+            material = Material.CreateDiffuse(texture.Value);
+
+            engineSound = Resources.LoadSound("data/sound/propeller.wav");
+
+            if (engineSound.Value != null)
+                engineEmitter = engineSound.Value.CreateEmitter(1.0f, 8.0f, EngineHearingDistance, 0, true);
 
             Position.Y = 15;
 
             Health = 100;
+            IsParallelUpdate = true;
         }
 
         private void Move(float v, float h)
@@ -50,12 +66,25 @@ namespace Planes3D
 
             Vector3 forward = GetForward();
             Vector3 up = GetUp();
+
+            // Emitters are independent slots, so this is fine from parallel updates
+            Engine.Current.Sound.Scene.SetEmitter(engineEmitter, Position.X, Position.Y, Position.Z, forward.X * Speed, forward.Y * Speed, forward.Z * Speed);
         }
 
         public override void Draw()
         {
             if (Health > 0)
-                Engine.Current.Graphics.DrawMesh(mesh, Position, Rotation, new Vector3(1, 1, 1));
+                Engine.Current.Graphics.DrawMesh(mesh.Value, GetRenderPosition(), GetRenderRotation(), new Vector3(1, 1, 1), material);
+        }
+
+        public override void OnRemoved()
+        {
+            if (engineEmitter.IsValid)
+                Engine.Current.Sound.Scene.RemoveEmitter(engineEmitter);
+
+            mesh.Release();
+            texture.Release();
+            engineSound.Release();
         }
     }
 }
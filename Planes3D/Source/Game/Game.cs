@@ -10,6 +10,7 @@ namespace Planes3D
 
         public PlayerAirplane Player;
         public Terrain Terrain;
+        public Water Water;
 
         public Enemy enemy;
 
@@ -22,12 +23,15 @@ namespace Planes3D
             Terrain = new Terrain();
             Terrain.Build("data/heightmap.bmp");
 
+            Water = new Water();
+
             Enemy enemy = new Enemy();
             enemy.Position = new Vector3(25, 15, 35);
 
             Scene = new Scene();
             Scene.Add(enemy);
             Scene.Add(Player);
+            Scene.Add(Water);
         }
 
         public void Update()
@@ -37,6 +41,8 @@ namespace Planes3D
 
         public void Draw()
         {
+            // Foliage is culled on workers while the scene records its draws
+            Terrain.BeginCulling(new Vector3(0, 0, 0));
             Scene.Draw();
             Terrain.Draw(new Vector3(0, 0, 0));
         }
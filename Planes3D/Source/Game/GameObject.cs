@@ -10,9 +10,18 @@ namespace Planes3D
         public string Tag;
         public bool IsEnabled;
 
+        /// <summary>
+        /// Object's Update only touches its own state (and reads others), so Scene may run it on a worker thread alongside other such objects.
+        /// </summary>
+        public bool IsParallelUpdate;
+
         public Vector3 Position;
         public Vector3 Rotation;
 
+        // State at the beginning of current simulation step, used to interpolate rendering between steps
+        public Vector3 PreviousPosition;
+        public Vector3 PreviousRotation;
+
         public Vector3 GetForward()
         {
             return new Vector3((float)Math.Sin(Rotation.Y * MathUtils.DegToRad), -(float)Math.Sin(Rotation.X * MathUtils.DegToRad), (float)Math.Cos(Rotation.Y * MathUtils.DegToRad));
@@ -28,6 +37,22 @@ namespace Planes3D
             return GetRight().Cross(new Vector3(-1, 0, 0));
         }
 
+        public void SaveState()
+        {
+            PreviousPosition = Position;
+            PreviousRotation = Rotation;
+        }
+
+        public Vector3 GetRenderPosition()
+        {
+            return MathUtils.Lerp(PreviousPosition, Position, Engine.Current.Interpolation);
+        }
+
+        public Vector3 GetRenderRotation()
+        {
+            return MathUtils.Lerp(PreviousRotation, Rotation, Engine.Current.Interpolation);
+        }
+
         public virtual void Update()
         {
 
@@ -37,5 +62,13 @@ namespace Planes3D
         {
 
         }
+
+        /// <summary>
+        /// Called once the scene dropped the object, release shared resources and emitters here.
+        /// </summary>
+        public virtual void OnRemoved()
+        {
+
+        }
     }
 }
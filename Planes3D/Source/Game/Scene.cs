@@ -1,42 +1,43 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Text;
-using System.Diagnostics;
+using DXSharp.Jobs;
 
 namespace Planes3D
 {
     public sealed class Scene
     {
-        private class Task
-        {
-            public float Time;
-            public Action<float> Action;
-        }
+        const float TaskResolution = 0.01f;
 
-        private Stopwatch timeSinceLoad;
-        private List<Task> tasks;
+        private double loadTime;
+        private TimerWheel tasks;
         private List<GameObject> objectList;
-        private List<Task> taskRemovalList;
         private List<GameObject> objectRemovalList;
+        private List<GameObject> parallelUpdateList;
+        private JobRangeHandler parallelUpdateHandler;
 
         public float TimeSinceLoad;
 
         public Scene()
         {
-            timeSinceLoad = new Stopwatch();
-            timeSinceLoad.Start();
+            loadTime = Engine.Current.Clock.SimulationTime;
 
-            tasks = new List<Task>();
+            tasks = new TimerWheel(TaskResolution);
             objectList = new List<GameObject>();
 
-            taskRemovalList = new List<Task>();
             objectRemovalList = new List<GameObject>();
+
+            parallelUpdateList = new List<GameObject>();
+            parallelUpdateHandler = new JobRangeHandler(UpdateParallelRange); // Cached to not allocate delegate every frame
         }
 
         public void Add(GameObject obj)
         {
             if (!objectList.Contains(obj))
+            {
+                obj.SaveState(); // Don't interpolate from origin on first frame
                 objectList.Add(obj);
+            }
         }
 
         public void Remove(GameObject obj)
@@ -45,37 +46,57 @@ namespace Planes3D
                 objectRemovalList.Add(obj);
         }
 
-        public void ScheduleTask(float delay, Action<float> action)
+        public TimerHandle ScheduleTask(float delay, Action<float> action)
         {
-            tasks.Add(new Task()
-            {
-                Time = TimeSinceLoad + delay,
-                Action = action
-            });
+            return tasks.Schedule(delay, action);
+        }
+
+        public TimerHandle ScheduleRepeatingTask(float delay, float interval, Action<float> action)
+        {
+            return tasks.Schedule(delay, interval, action);
+        }
+
+        public bool CancelTask(TimerHandle handle)
+        {
+            return tasks.Cancel(handle);
+        }
+
+        private void UpdateParallelRange(int start, int end)
+        {
+            for (int i = start; i < end; i++)
+                parallelUpdateList[i].Update();
         }
 
         public void Update()
         {
+            TimeSinceLoad = (float)(Engine.Current.Clock.SimulationTime - loadTime);
+
+            // Objects that can affect others (player, camera) go first, then independent ones are fanned out to workers
             foreach (GameObject obj in objectList)
-                obj.Update();
+            {
+                obj.SaveState();
 
-            foreach (GameObject obj in objectRemovalList)
-                objectList.Remove(obj);
+                if (obj.IsParallelUpdate)
+                    parallelUpdateList.Add(obj);
+                else
+                    obj.Update();
+            }
 
-            foreach(Task task in tasks)
+            if (parallelUpdateList.Count > 0)
             {
-                if (task.Time < TimeSinceLoad)
-                    task.Action(TimeSinceLoad);
+                Engine.Current.Jobs.ParallelFor(parallelUpdateList.Count, 1, parallelUpdateHandler);
+                parallelUpdateList.Clear();
+            }
 
-                taskRemovalList.Add(task);
+            foreach (GameObject obj in objectRemovalList)
+            {
+                if (objectList.Remove(obj))
+                    obj.OnRemoved();
             }
 
-            foreach (Task task in taskRemovalList)
-                tasks.Remove(task);
+            tasks.Advance(TimeSinceLoad);
 
             objectRemovalList.Clear();
-            taskRemovalList.Clear();
-            TimeSinceLoad = (float)timeSinceLoad.ElapsedMilliseconds / 1000.0f;
         }
 
         public void Draw()
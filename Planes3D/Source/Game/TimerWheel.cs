@@ -0,0 +1,339 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text;
+
+namespace Planes3D
+{
+    /// <summary>
+    /// Handle returned by TimerWheel.Schedule. Stays safe to cancel after timer has fired, since timer nodes are pooled and versioned.
+    /// </summary>
+    public struct TimerHandle
+    {
+        internal TimerWheel.Timer Timer;
+        internal int Generation;
+
+        public bool IsPending
+        {
+            get { return Timer != null && Timer.Generation == Generation && Timer.Wheel != null; }
+        }
+    }
+
+    /// <summary>
+    /// Hierarchical timing wheel (4 levels of 64 slots). Insertion and cancellation are O(1), expiry is amortized O(1) per timer,
+    /// and timers that aren't due are never touched, so thousands of pending timers cost almost nothing per frame.
+    /// </summary>
+    public sealed class TimerWheel
+    {
+        internal sealed class Timer
+        {
+            public Timer Next;
+            public Timer Prev;
+            public TimerWheel Wheel; // Null when timer isn't linked into any slot
+            public int Level;
+            public int Slot;
+
+            public long Expire; // Real expiration tick, slot may be earlier if delay is out of wheel range
+            public long Interval; // In ticks, 0 for one-shot timers
+            public Action<float> Action;
+            public int Generation;
+            public bool IsCancelled;
+        }
+
+        const int SlotBits = 6;
+        const int SlotCount = 1 << SlotBits;
+        const int SlotMask = SlotCount - 1;
+        const int LevelCount = 4;
+        const long MaxDelta = (1L << (SlotBits * LevelCount)) - 1;
+
+        private Timer[,] slots;
+        private Timer freeList;
+        private long nextTick; // Next tick to be processed
+        private float resolution;
+        private float currentTime;
+        private int count;
+
+        public int Count
+        {
+            get { return count; }
+        }
+
+        public float Resolution
+        {
+            get { return resolution; }
+        }
+
+        public TimerWheel(float resolution)
+        {
+            if (resolution <= 0)
+                throw new ArgumentException("Resolution must be positive");
+
+            this.resolution = resolution;
+            slots = new Timer[LevelCount, SlotCount];
+        }
+
+        private long ToTicks(float time)
+        {
+            return (long)(time / resolution);
+        }
+
+        private Timer AllocateTimer()
+        {
+            Timer timer = freeList;
+
+            if (timer != null)
+            {
+                freeList = timer.Next;
+                timer.Next = null;
+            }
+            else
+            {
+                timer = new Timer();
+            }
+
+            return timer;
+        }
+
+        private void RecycleTimer(Timer timer)
+        {
+            timer.Generation++;
+            timer.Action = null;
+            timer.Prev = null;
+            timer.Next = freeList;
+            freeList = timer;
+        }
+
+        private void Link(Timer timer)
+        {
+            long expire = timer.Expire;
+
+            if (expire < nextTick)
+                expire = nextTick;
+
+            long delta = expire - nextTick;
+
+            if (delta > MaxDelta)
+            {
+                // Parked in the farthest slot, will be re-inserted when it cascades down
+                delta = MaxDelta;
+                expire = nextTick + MaxDelta;
+            }
+
+            int level = 0;
+            while (level < LevelCount - 1 && delta >= (1L << (SlotBits * (level + 1))))
+                level++;
+
+            int slot = (int)((expire >> (SlotBits * level)) & SlotMask);
+
+            timer.Wheel = this;
+            timer.Level = level;
+            timer.Slot = slot;
+            timer.Prev = null;
+            timer.Next = slots[level, slot];
+
+            if (timer.Next != null)
+                timer.Next.Prev = timer;
+
+            slots[level, slot] = timer;
+        }
+
+        private void Unlink(Timer timer)
+        {
+            if (timer.Prev != null)
+                timer.Prev.Next = timer.Next;
+            else
+                slots[timer.Level, timer.Slot] = timer.Next;
+
+            if (timer.Next != null)
+                timer.Next.Prev = timer.Prev;
+
+            timer.Next = null;
+            timer.Prev = null;
+            timer.Wheel = null;
+        }
+
+        public TimerHandle Schedule(float delay, Action<float> action)
+        {
+            return Schedule(delay, 0, action);
+        }
+
+        /// <summary>
+        /// Schedules action to be called after delay seconds. If interval is positive, timer repeats with that period until cancelled.
+        /// </summary>
+        public TimerHandle Schedule(float delay, float interval, Action<float> action)
+        {
+            if (action == null)
+                throw new ArgumentException("Action can't be null");
+
+            Timer timer = AllocateTimer();
+            timer.Action = action;
+            timer.Expire = ToTicks(currentTime + Math.Max(delay, 0));
+            timer.Interval = interval > 0 ? Math.Max(ToTicks(interval), 1) : 0;
+            timer.IsCancelled = false;
+
+            Link(timer);
+            count++;
+
+            TimerHandle handle = new TimerHandle();
+            handle.Timer = timer;
+            handle.Generation = timer.Generation;
+
+            return handle;
+        }
+
+        public bool Cancel(TimerHandle handle)
+        {
+            Timer timer = handle.Timer;
+
+            if (timer == null || timer.Generation != handle.Generation)
+                return false;
+
+            if (timer.Wheel == null)
+            {
+                // Timer is in the batch being fired right now (i.e cancelled from a callback), it'll be dropped instead of fired or re-armed
+                timer.IsCancelled = true;
+
+                return true;
+            }
+
+            Unlink(timer);
+            RecycleTimer(timer);
+            count--;
+
+            return true;
+        }
+
+        private int Cascade(int level, int slot)
+        {
+            Timer timer = slots[level, slot];
+            slots[level, slot] = null;
+
+            while (timer != null)
+            {
+                Timer next = timer.Next;
+                Link(timer);
+                timer = next;
+            }
+
+            return slot;
+        }
+
+        /// <summary>
+        /// Advances wheel to the given clock time and fires all timers that became due. If a callback throws, the exception
+        /// propagates and timers that haven't fired yet stay pending for the next call.
+        /// </summary>
+        public void Advance(float time)
+        {
+            long targetTick = ToTicks(time);
+
+            currentTime = time;
+
+            if (count == 0)
+            {
+                // Nothing to fire, skip straight to the target
+                if (targetTick >= nextTick)
+                    nextTick = targetTick + 1;
+
+                return;
+            }
+
+            while (nextTick <= targetTick)
+            {
+                long tick = nextTick;
+                int index = (int)(tick & SlotMask);
+
+                if (index == 0)
+                {
+                    for (int level = 1; level < LevelCount; level++)
+                    {
+                        if (Cascade(level, (int)((tick >> (SlotBits * level)) & SlotMask)) != 0)
+                            break;
+                    }
+                }
+
+                Timer timer = slots[0, index];
+                slots[0, index] = null;
+
+                // Move on before firing, so timers scheduled from callbacks land in upcoming slots instead of the detached one
+                nextTick++;
+
+                // Detached timers are marked as firing, so cancelling them from callbacks doesn't touch slot lists
+                for (Timer t = timer; t != null; t = t.Next)
+                    t.Wheel = null;
+
+                while (timer != null)
+                {
+                    Timer next = timer.Next;
+                    timer.Next = null;
+                    timer.Prev = null;
+
+                    if (timer.IsCancelled)
+                    {
+                        RecycleTimer(timer);
+                        count--;
+                    }
+                    else if (timer.Expire > tick)
+                    {
+                        Link(timer); // Was parked out of range
+                    }
+                    else
+                    {
+                        try
+                        {
+                            timer.Action(time);
+                        }
+                        catch
+                        {
+                            // Rest of the batch is only reachable from here. This tick is processed again on the next Advance,
+                            // so it goes back into the tick's slot and fires then, in time.
+                            nextTick = tick;
+                            Relink(next);
+                            Rearm(timer, tick);
+                            throw;
+                        }
+
+                        Rearm(timer, tick);
+                    }
+
+                    timer = next;
+                }
+            }
+        }
+
+        private void Rearm(Timer timer, long tick)
+        {
+            if (timer.Interval > 0 && !timer.IsCancelled)
+            {
+                timer.Expire = tick + timer.Interval;
+                Link(timer);
+            }
+            else
+            {
+                RecycleTimer(timer);
+                count--;
+            }
+        }
+
+        // Due timers land in the slot of nextTick, cancelled ones are dropped
+        private void Relink(Timer timer)
+        {
+            while (timer != null)
+            {
+                Timer next = timer.Next;
+                timer.Next = null;
+                timer.Prev = null;
+
+                if (timer.IsCancelled)
+                {
+                    RecycleTimer(timer);
+                    count--;
+                }
+                else
+                {
+                    Link(timer);
+                }
+
+                timer = next;
+            }
+        }
+    }
+}
@@ -2,6 +2,7 @@
 using System.Collections.Generic;
 using System.Text;
 using DXSharp.D3D;
+using DXSharp.Jobs;
 
 namespace Planes3D
 {
@@ -16,6 +17,8 @@ namespace Planes3D
         private Mesh mesh;
         private Vertex[] verts;
         private float time;
+        private JobRangeHandler animateHandler;
+        private JobGroup animateGroup;
 
         public Water()
         {
@@ -98,19 +101,20 @@ namespace Planes3D
 
             mesh = new Mesh(verts, MeshTopology.Triangles);
             mesh.AssignedMaterial = Material.CreateDiffuse(TextureLoader.LoadFromFile("data/textures/water.tex"));
+
+            animateHandler = new JobRangeHandler(AnimateRows);
+            animateGroup = new JobGroup();
         }
 
-        public override void Update()
+        // Rows are independent, so animation is split between job workers
+        private void AnimateRows(int start, int end)
         {
             const float WaveHeight = 0.4f;
-            base.Update();
-
-            time += 0.1f;
-
-            int vertOffset = 0;
 
-            for (int i = 0; i < Size; i++)
+            for (int i = start; i < end; i++)
             {
+                int vertOffset = i * Size * 6;
+
                 for (int j = 0; j < Size; j++)
                 {
                     float baseX = i * Scale;
@@ -151,11 +155,45 @@ namespace Planes3D
             }
         }
 
+        public override void Update()
+        {
+            base.Update();
+
+            // Rows of the previous step may still be in flight when a frame runs several steps
+            Engine.Current.Jobs.Wait(animateGroup);
+
+            time += 0.1f;
+
+            // Animation runs alongside the rest of the scene update, Draw waits for it
+            Engine.Current.Jobs.ParallelFor(Size, 8, animateHandler, animateGroup);
+        }
+
         public override void Draw()
         {
             base.Draw();
 
-            Engine.Current.Graphics.DrawMesh(mesh, new Vector3(0, -7, 0), new Vector3(0, 0, 0), new Vector3(1, 1, 1));
+            Engine.Current.Jobs.Wait(animateGroup);
+
+            // Grid changes every frame, so it goes through the transient ring instead of the mesh path
+            Graphics graphics = Engine.Current.Graphics;
+            TransientVertices frameVerts = graphics.Context.AllocateTransient(verts.Length);
+
+            if (frameVerts.Count == 0)
+            {
+                graphics.DrawMesh(mesh, new Vector3(0, -7, 0), new Vector3(0, 0, 0), new Vector3(1, 1, 1));
+                return;
+            }
+
+            frameVerts.CopyFrom(verts, 0, 0, verts.Length);
+            graphics.DrawTransient(frameVerts, mesh.Topology, mesh.AssignedMaterial, new Vector3(0, -7, 0), new Vector3(0, 0, 0));
+        }
+
+        public override void OnRemoved()
+        {
+            base.OnRemoved();
+
+            Engine.Current.Jobs.Wait(animateGroup);
+            animateGroup.Dispose();
         }
     }
 }
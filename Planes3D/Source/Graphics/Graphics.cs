@@ -2,6 +2,7 @@
 using System.Collections.Generic;
 using System.Text;
 using DXSharp.D3D;
+using DXSharp.Diagnostics;
 
 namespace Planes3D
 {
@@ -9,6 +10,8 @@ namespace Planes3D
     {
         public Vector3 Position;
         public Vector3 Rotation;
+        public Vector3 PreviousPosition;
+        public Vector3 PreviousRotation;
         public float FOV;
         public float Aspect;
         public float Near;
@@ -50,16 +53,40 @@ namespace Planes3D
             return Frustum.IsSphereInFrustum(position.X, position.Y, position.Z, radius);
         }
 
-        public void MarkUpdated()
+        private void BuildMatrices(Vector3 position, Vector3 rotation)
         {
-            View = Matrix.RotationZ(-Rotation.Z * MathUtils.DegToRad) *
-                               Matrix.RotationX(-Rotation.X * MathUtils.DegToRad) *
-                               Matrix.RotationY(-Rotation.Y * MathUtils.DegToRad) *
-                               Matrix.Translation(-Position.X, -Position.Y, -Position.Z);
+            View = Matrix.RotationZ(-rotation.Z * MathUtils.DegToRad) *
+                               Matrix.RotationX(-rotation.X * MathUtils.DegToRad) *
+                               Matrix.RotationY(-rotation.Y * MathUtils.DegToRad) *
+                               Matrix.Translation(-position.X, -position.Y, -position.Z);
             Projection = Matrix.Perspective(FOV * MathUtils.DegToRad, Aspect, Near, Far);
 
             Frustum.Calculate(Projection * View);
         }
+
+        public void MarkUpdated()
+        {
+            BuildMatrices(Position, Rotation);
+        }
+
+        public void SaveState()
+        {
+            PreviousPosition = Position;
+            PreviousRotation = Rotation;
+        }
+
+        public Vector3 GetForward()
+        {
+            return new Vector3((float)Math.Sin(Rotation.Y * MathUtils.DegToRad), -(float)Math.Sin(Rotation.X * MathUtils.DegToRad), (float)Math.Cos(Rotation.Y * MathUtils.DegToRad));
+        }
+
+        /// <summary>
+        /// Rebuilds view for rendering between two simulation steps, so camera moves as smoothly as interpolated objects
+        /// </summary>
+        public void Interpolate(float alpha)
+        {
+            BuildMatrices(MathUtils.Lerp(PreviousPosition, Position, alpha), MathUtils.Lerp(PreviousRotation, Rotation, alpha));
+        }
     }
 
     public sealed class GraphicsStats
@@ -68,14 +95,21 @@ namespace Planes3D
         public int NumTriangles;
         public int TextureMemoryPressure;
         public float FrameTime;
+        public int SimulationSteps;
 
         private float NextUpdate;
 
+        static readonly LogSite statsSite = new LogSite(Log.Graphics, LogLevel.Info, "DrawCalls: {0}, Triangle count: {1}, TextureMemoryPressure: {2}, Frame time: {3} (avg {4}, p99 {5}, max {6}), Steps: {7}");
+
         public void Update()
         {
             if (NextUpdate < 0)
             {
-                Log.WriteLine("DrawCalls: {0}, Triangle count: {1}, TextureMemoryPressure: {2}, Frame time: {3}", NumDrawCalls, NumTriangles, TextureMemoryPressure, FrameTime);
+                DXSharp.Timing.GameClock clock = Engine.Current.Clock;
+
+                statsSite.Write(NumDrawCalls, NumTriangles, TextureMemoryPressure, FrameTime,
+                    clock.AverageFrameTime, clock.GetFrameTimePercentile(99), clock.MaxFrameTime, SimulationSteps);
+                clock.ResetStats();
 
                 NextUpdate = 1;
             }
@@ -138,6 +172,10 @@ namespace Planes3D
         {
             Stats.NumDrawCalls = 0;
             Stats.NumTriangles = 0;
+            Stats.FrameTime = Engine.Current.Clock.FrameTime;
+            Stats.SimulationSteps = Engine.Current.Clock.StepsThisFrame;
+
+            Camera.Interpolate(Engine.Current.Interpolation);
 
             // Prepare view and projection matrices
             Context.SetTransform(TransformType.View, Camera.View.Items);
@@ -226,6 +264,28 @@ namespace Planes3D
             }
         }
 
+        private void SetWorldTransform(Vector3 position, Vector3 rotation)
+        {
+            Matrix world = Matrix.Translation(position.X, position.Y, position.Z) *
+                           Matrix.RotationY(rotation.Y * MathUtils.DegToRad) *
+                           Matrix.RotationZ(rotation.Z * MathUtils.DegToRad) *
+                           Matrix.RotationX(rotation.X * MathUtils.DegToRad);
+            Context.SetTransform(TransformType.World, world.Items);
+        }
+
+        private static PrimitiveType GetPrimitiveType(MeshTopology topology)
+        {
+            switch (topology)
+            {
+                case MeshTopology.Lines:
+                    return PrimitiveType.LineList;
+                case MeshTopology.Points:
+                    return PrimitiveType.PointList;
+                default:
+                    return PrimitiveType.TriangleList;
+            }
+        }
+
         public void DrawMesh(Mesh mesh, int startVertex, int endVertex, Vector3 position, Vector3 rotation, Vector3 scaling, Material materialOverride = null)
         {
             if (mesh != null)
@@ -233,50 +293,61 @@ namespace Planes3D
                 if (mesh.Radius > 0 && !Camera.IsSphereVisible(position, mesh.Radius))
                     return;
 
-                Material mat = mesh.AssignedMaterial;
+                DrawVisibleMesh(mesh, startVertex, endVertex, position, rotation, materialOverride);
+            }
+        }
 
-                if (materialOverride != null)
-                    mat = materialOverride;
+        /// <summary>
+        /// Same as DrawMesh without the frustum test, for callers that culled already (Terrain does it on job workers).
+        /// </summary>
+        public void DrawVisibleMesh(Mesh mesh, Vector3 position, Vector3 rotation, Material materialOverride)
+        {
+            DrawVisibleMesh(mesh, 0, mesh.Vertices.Length, position, rotation, materialOverride);
+        }
 
-                Matrix world = Matrix.Translation(position.X, position.Y, position.Z) *
-                               Matrix.RotationY(rotation.Y * MathUtils.DegToRad) *
-                               Matrix.RotationZ(rotation.Z * MathUtils.DegToRad) *
-                               Matrix.RotationX(rotation.X * MathUtils.DegToRad);
-                Context.SetTransform(TransformType.World, world.Items);
+        private void DrawVisibleMesh(Mesh mesh, int startVertex, int endVertex, Vector3 position, Vector3 rotation, Material materialOverride)
+        {
+            Material mat = mesh.AssignedMaterial;
 
-                PrimitiveType primitive;
+            if (materialOverride != null)
+                mat = materialOverride;
 
-                switch (mesh.Topology)
-                {
-                    case MeshTopology.Lines:
-                        primitive = PrimitiveType.LineList;
-                        break;
-                    case MeshTopology.Points:
-                        primitive = PrimitiveType.PointList;
-                        break;
-                    default:
-                        primitive = PrimitiveType.TriangleList;
-                        break;
-                }
+            SetWorldTransform(position, rotation);
 
-                if (mat != null)
-                    SetTextureStage(mat);
+            if (mat != null)
+                SetTextureStage(mat);
 
-                Context.SetRenderState(RenderState.ZEnable, mat.NoZTest ? 0 : 1);
+            Context.SetRenderState(RenderState.ZEnable, mat.NoZTest ? 0 : 1);
 
-                Context.Begin(primitive, Device.VertexFormat, mat.IsLit);
-                for (int i = startVertex; i < endVertex; i++)
-                    Context.Vertex(mesh.Vertices[i]);
-                Context.End();
+            Context.DrawPrimitive(GetPrimitiveType(mesh.Topology), mat.IsLit, mesh.Vertices, startVertex, endVertex - startVertex);
 
-                Stats.NumDrawCalls++;
-                Stats.NumTriangles += mesh.Vertices.Length / 3;
-            }
+            Stats.NumDrawCalls++;
+            Stats.NumTriangles += mesh.Vertices.Length / 3;
         }
 
         public void DrawMesh(Mesh mesh, Vector3 position, Vector3 rotation, Vector3 scaling, Material materialOverride = null)
         {
             DrawMesh(mesh, 0, mesh.Vertices.Length, position, rotation, scaling, materialOverride);
         }
+
+        /// <summary>
+        /// Draws vertices allocated with Device.AllocateTransient this frame. Meant for geometry rebuilt every frame
+        /// (animated water, particles, HUD), which would otherwise need a Mesh or per-vertex calls.
+        /// </summary>
+        public void DrawTransient(TransientVertices vertices, MeshTopology topology, Material material, Vector3 position, Vector3 rotation)
+        {
+            if (vertices.Count == 0)
+                return;
+
+            SetWorldTransform(position, rotation);
+            SetTextureStage(material);
+
+            Context.SetRenderState(RenderState.ZEnable, material.NoZTest ? 0 : 1);
+
+            Context.DrawTransient(GetPrimitiveType(topology), material.IsLit, vertices);
+
+            Stats.NumDrawCalls++;
+            Stats.NumTriangles += vertices.Count / 3;
+        }
     }
 }
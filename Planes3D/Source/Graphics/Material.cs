@@ -2,14 +2,20 @@
 using System.Collections.Generic;
 using System.Text;
 using DXSharp.D3D;
+using DXSharp.Helpers;
 using System.IO;
+using DXSharp.IO;
 using System.Drawing;
 using System.Runtime.InteropServices;
+using DXSharp.Diagnostics;
 
 namespace Planes3D
 {
     public static class TextureLoader
     {
+        static readonly LogSite badSizeSite = new LogSite(Log.Texture, LogLevel.Warning, "Bitmap {2} with size of {0}x{1} can't be used");
+        static readonly LogSite mipSite = new LogSite(Log.Texture, LogLevel.Debug, "Reading {0} mipmap of size {1}x{2}");
+
         public struct TextureDescription
         {
             public int Width;
@@ -69,7 +75,7 @@ namespace Planes3D
 
                 if(desc.Width < 8 || desc.Height < 8 || desc.Width > MaxTextureSize || desc.Height > MaxTextureSize)
                 {
-                    Log.WriteLine("Bitmap {2} with size of {0}x{1} can't be used", desc.Width, desc.Height, debugName);
+                    badSizeSite.Write(desc.Width, desc.Height, debugName);
 
                     return null;
                 }
@@ -85,7 +91,7 @@ namespace Planes3D
                     mipDesc.LinearSize = bReader.ReadUInt32();
 
                     byte[] mipData = new byte[mipDesc.LinearSize];
-                    Log.WriteLine("Reading {0} mipmap of size {1}x{2}", i, mipDesc.Width, mipDesc.Height);
+                    mipSite.Write(i, mipDesc.Width, mipDesc.Height);
 
                     strm.Read(mipData, 0, mipData.Length);
                     tex.FromPixelArray(mipData, mipDesc.Width, mipDesc.Height, 0);
@@ -99,13 +105,8 @@ namespace Planes3D
 
         public static Texture LoadFromFile(string fileName)
         {
-            if(File.Exists(fileName))
-            {
-                using (Stream strm = File.OpenRead(fileName))
-                    return LoadFromStream(fileName, strm);
-            }
-
-            return null;
+            using (Stream strm = FileSystem.Open(fileName))
+                return LoadFromStream(fileName, strm);
         }
 
         /// <summary>
@@ -136,6 +137,10 @@ namespace Planes3D
                 {
                     Console.WriteLine("Something went wrong while loading texture {0}: {1}", debugName, e.Message);
                 }
+                catch (DirectXException e)
+                {
+                    Console.WriteLine("Something went wrong while loading texture {0}: {1}", debugName, e.Message);
+                }
             }
 
             return null;
@@ -148,13 +153,8 @@ namespace Planes3D
         /// <returns></returns>
         public static Texture LoadFromImage(string fileName)
         {
-            if(File.Exists(fileName))
-            {
-                using (Stream strm = File.OpenRead(fileName))
-                    return LoadFromImageStream(fileName, strm);
-            }
-
-            return null;
+            using (Stream strm = FileSystem.Open(fileName))
+                return LoadFromImageStream(fileName, strm);
         }
     }
 
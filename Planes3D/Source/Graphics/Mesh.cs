@@ -3,6 +3,7 @@ using System.Collections.Generic;
 using System.Text;
 using DXSharp.D3D;
 using System.IO;
+using DXSharp.IO;
 
 namespace Planes3D
 {
@@ -15,13 +16,18 @@ namespace Planes3D
 
     public sealed class Mesh
     {
-        public Vertex[] Vertices;
+        public Array Vertices; // Vertex[], VertexPT[]... depending on VertexFormat
+        public int VertexFormat;
         public MeshTopology Topology;
 
         public Material AssignedMaterial;
         public float Radius;
 
-        public static Mesh FromStream(Stream strm)
+        /// <summary>
+        /// Loads SMD geometry. vertexFormat picks the layout meshes are stored and drawn with, e.g. VertexPNT.Format
+        /// for lit meshes without vertex colors - smaller layouts mean less memory and vertex bandwidth.
+        /// </summary>
+        public static Mesh FromStream(Stream strm, int vertexFormat = Vertex.Format)
         {
             if(strm != null)
             {
@@ -47,32 +53,40 @@ namespace Planes3D
                         };
                 }
 
-                return new Mesh(vert, MeshTopology.Triangles);
+                return new Mesh(vert, MeshTopology.Triangles, vertexFormat);
             }
 
             return null;
         }
 
-        public static Mesh FromFile(string fileName)
+        public static Mesh FromFile(string fileName, int vertexFormat = Vertex.Format)
         {
-            if(File.Exists(fileName))
-            {
-                using (Stream strm = File.OpenRead(fileName))
-                    return FromStream(strm);
-            }
-
-            return null;
+            using (Stream strm = FileSystem.Open(fileName))
+                return FromStream(strm, vertexFormat);
         }
 
         public Mesh(Vertex[] verts, MeshTopology topology)
+            : this(verts, topology, Vertex.Format)
+        {
+        }
+
+        public Mesh(Vertex[] verts, MeshTopology topology, int vertexFormat)
         {
             if (verts == null)
                 throw new ArgumentException("Vertices can't be null");
 
-            Vertices = verts;
             Topology = topology;
+            VertexFormat = vertexFormat;
+
+            CalculateRadius(verts);
 
-            CalculateRadius();
+            // Full layout is kept as is, everything else is converted once here
+            Vertices = vertexFormat == Vertex.Format ? verts : VertexConverter.Convert(verts, vertexFormat);
+        }
+
+        public int SizeInBytes
+        {
+            get { return Vertices.Length * VertexConverter.GetVertexSize(VertexFormat); }
         }
 
         private float MaxFromRange(float[] range)
@@ -85,14 +99,14 @@ namespace Planes3D
             return minVal;
         }
 
-        private void CalculateRadius()
+        private void CalculateRadius(Vertex[] verts)
         {
             Vector3 min = new Vector3(float.MinValue, float.MinValue, float.MinValue);
-            for(int i = 0; i < Vertices.Length; i++)
+            for(int i = 0; i < verts.Length; i++)
             {
-                min.X = Math.Max(min.X, Vertices[i].X);
-                min.Y = Math.Max(min.Y, Vertices[i].Y);
-                min.Z = Math.Max(min.Z, Vertices[i].Z);
+                min.X = Math.Max(min.X, verts[i].X);
+                min.Y = Math.Max(min.Y, verts[i].Y);
+                min.Z = Math.Max(min.Z, verts[i].Z);
             }
 
             Radius = Math.Abs(MaxFromRange(new float[] { min.X, min.Y, min.Z }));
@@ -1,6 +1,7 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Text;
+using DXSharp.D3D;
 
 namespace Planes3D
 {
@@ -13,7 +14,7 @@ namespace Planes3D
 
         public Skybox()
         {
-            mesh = Mesh.FromFile("data/geometry/skybox.smd");
+            mesh = Mesh.FromFile("data/geometry/skybox.smd", VertexPT.Format); // Unlit, only position and UV matter
 
             materials = new Material[6];
             for (int i = 0; i < 6; i++)
@@ -2,36 +2,65 @@
 using System.Collections.Generic;
 using System.Text;
 using System.Drawing;
+using System.IO;
 using DXSharp.D3D;
+using DXSharp.Diagnostics;
+using DXSharp.IO;
+using DXSharp.Jobs;
 
 namespace Planes3D
 {
     public sealed class Terrain
     {
+        static readonly LogSite buildSite = new LogSite(Log.World, LogLevel.Info, "Building terrain {0}");
+
         const float XZScale = 8.0f; // 1 pixel = 2 meters
         const float YScale = 35.0f; // 1 brightness - 2 meters, i.e 255 - 510
+        const float AmbientLight = 0.2f; // Same as the material ambient Graphics sets for lit meshes
 
         private struct FoliagePlacement
         {
             public Mesh Mesh;
+            public Material Material;
             public Vector3 Position;
         }
 
         private Mesh mesh;
+        private VertexPCT[] vertices; // Same array mesh draws from
         private Bitmap bmp;
 
-        private Mesh[] foliage;
+        // Both bushes are the same geometry with different textures, so they share the mesh and differ in material
+        private Resource<Mesh>[] foliage;
+        private Resource<Texture>[] foliageTextures;
+        private Material[] foliageMaterials;
         private List<FoliagePlacement> foliageBatches;
 
+        // Foliage visibility is tested on job workers while the scene records its draws, see BeginCulling
+        private bool[] foliageVisible;
+        private Vector3 cullPosition;
+        private bool isCulling;
+        private JobGroup cullGroup;
+        private JobRangeHandler cullHandler;
+
         public Terrain()
         {
-            foliage = new Mesh[3];
-            foliage[0] = Mesh.FromFile("data/geometry/bush08.smd");
-            foliage[0].AssignedMaterial = Material.CreateDiffuse(TextureLoader.LoadFromFile("data/textures/bush08.tex"));
-            foliage[2] = Mesh.FromFile("data/geometry/bush08.smd");
-            foliage[2].AssignedMaterial = Material.CreateDiffuse(TextureLoader.LoadFromFile("data/textures/bush05.tex"));
-            foliage[1] = Mesh.FromFile("data/geometry/tree04.smd");
-            foliage[1].AssignedMaterial = Material.CreateDiffuse(TextureLoader.LoadFromFile("data/textures/tree04.tex"));
+            foliage = new Resource<Mesh>[3];
+            foliageTextures = new Resource<Texture>[3];
+            foliageMaterials = new Material[3];
+
+            LoadFoliage(0, "data/geometry/bush08.smd", "data/textures/bush08.tex");
+            LoadFoliage(1, "data/geometry/tree04.smd", "data/textures/tree04.tex");
+            LoadFoliage(2, "data/geometry/bush08.smd", "data/textures/bush05.tex");
+
+            cullGroup = new JobGroup();
+            cullHandler = new JobRangeHandler(CullFoliage);
+        }
+
+        private void LoadFoliage(int index, string meshPath, string texturePath)
+        {
+            foliage[index] = Resources.LoadMesh(meshPath, VertexPNT.Format);
+            foliageTextures[index] = Resources.LoadTexture(texturePath);
+            foliageMaterials[index] = Material.CreateDiffuse(foliageTextures[index].Value);
         }
 
         private void CalculateNormal(ref Vertex v1, ref Vertex v2, ref Vertex v3)
@@ -55,6 +84,31 @@ namespace Planes3D
             return ret;
         }
 
+        private float GetHeight(int x, int z)
+        {
+            x = Math.Max(0, Math.Min(bmp.Width - 1, x));
+            z = Math.Max(0, Math.Min(bmp.Height - 1, z));
+
+            return ((float)bmp.GetPixel(x, z).R / 255.0f) * YScale;
+        }
+
+        // Directional light with the heightmap's normal at this vertex, what D3D lighting would give a white material
+        private byte GetBakedLight(float x, float z)
+        {
+            int px = (int)Math.Round(x / XZScale);
+            int pz = (int)Math.Round(z / XZScale);
+
+            float nx = (GetHeight(px - 1, pz) - GetHeight(px + 1, pz)) / (2 * XZScale);
+            float nz = (GetHeight(px, pz - 1) - GetHeight(px, pz + 1)) / (2 * XZScale);
+            float normalLength = (float)Math.Sqrt(nx * nx + 1 + nz * nz);
+
+            Vector3 sun = Engine.SunDirection;
+            float sunLength = (float)Math.Sqrt(sun.X * sun.X + sun.Y * sun.Y + sun.Z * sun.Z);
+            float diffuse = -(nx * sun.X + sun.Y + nz * sun.Z) / (normalLength * sunLength);
+
+            return (byte)(Math.Min(1.0f, AmbientLight + Math.Max(0.0f, diffuse)) * 255.0f);
+        }
+
         public bool CheckCollision(Vector3 worldPos, float radius)
         {
             int posX = (int)(worldPos.X / XZScale);
@@ -67,7 +121,7 @@ namespace Planes3D
 
             for(int i = 0; i < 18; i++)
             {
-                if (worldPos.Y < mesh.Vertices[vertOffset + i].Y)
+                if (worldPos.Y < vertices[vertOffset + i].Y)
                     return true;
             }
 
@@ -80,9 +134,18 @@ namespace Planes3D
             const float MinTextureThreshold = 0.4f; // In percent of tallest point
             const float TextureScale = 0.2f;
 
-            Log.WriteLine("Building terrain {0}", fileName);
+            buildSite.Write(fileName);
+
+            // GDI+ reads images lazily, copy so the stream can be closed right away
+            using (Stream strm = FileSystem.Open(fileName))
+            {
+                if (strm != null)
+                {
+                    using (Image img = Image.FromStream(strm))
+                        bmp = new Bitmap(img);
+                }
+            }
 
-            bmp = (Bitmap)Image.FromFile(fileName);
             if(bmp != null)
             {
                 int vertOffset = 0;
@@ -102,11 +165,17 @@ namespace Planes3D
 
                         // Plant foliage under some circumstances
                         if (rand.Next(0, 32) % 8 == 0)
+                        {
+                            int kind = rand.Next(0, foliage.Length);
+
                             foliageBatches.Add(new FoliagePlacement()
                             {
-                                Mesh = foliage[rand.Next(0, foliage.Length)],
+                                Mesh = foliage[kind].Value,
+                                Material = foliageMaterials[kind],
                                 Position = new Vector3(baseX, ((float)bmp.GetPixel(i, j).R / 255.0f) * YScale, baseZ)
                             });
+                        }
+
                         nextSeed = (nextSeed == 0 ? new Random() : new Random(nextSeed)).Next();
 
                         // Transform vertices
@@ -173,7 +242,8 @@ namespace Planes3D
                     }
                 }
 
-                // Adjust vertex colors to add texture-blending (i.e rock-texture on tall points)
+                // Adjust vertex colors to add texture-blending (i.e rock-texture on tall points). Alpha is the blend weight,
+                // color is the sun baked in, since the mesh isn't lit at draw time.
                 float point = GetTallestPoint(verts);
                 for(int i = 0; i < verts.Length; i++)
                 {
@@ -182,7 +252,9 @@ namespace Planes3D
                     if (verts[i].Y / point < MinTextureThreshold)
                         val = 0;
 
-                    verts[i].Diffuse = new DXSharp.D3D.Color(val, val, val, val).GetRGBA();
+                    byte light = GetBakedLight(verts[i].X, verts[i].Z);
+
+                    verts[i].Diffuse = new DXSharp.D3D.Color(light, light, light, val).GetRGBA();
                 }
 
                 // Plant some foliage
@@ -190,19 +262,67 @@ namespace Planes3D
                 const int MaxFoliage = 25;
                 int rnd = new Random().Next(MinFoliage, MaxFoliage);
 
-                mesh = new Mesh(verts, MeshTopology.Triangles);
+                // Normals are constant and the terrain combiner only reads diffuse alpha as blend weight,
+                // so position, color and UV are enough (24 instead of 36 bytes per vertex)
+                mesh = new Mesh(verts, MeshTopology.Triangles, VertexPCT.Format);
+                vertices = (VertexPCT[])mesh.Vertices;
+
                 mesh.AssignedMaterial = Material.CreateDiffuse(TextureLoader.LoadFromFile("data/textures/grass.tex"), "terrain");
+                mesh.AssignedMaterial.IsLit = false; // No normals, diffuse is taken from vertices with the light baked in
                 mesh.AssignedMaterial.Detail = TextureLoader.LoadFromFile("data/textures/ground.tex");
                 mesh.AssignedMaterial.Effect = MaterialEffect.Terrain;
+
+                foliageVisible = new bool[foliageBatches.Count];
+            }
+        }
+
+        private void CullFoliage(int start, int end)
+        {
+            Camera camera = Engine.Current.Graphics.Camera;
+
+            for (int i = start; i < end; i++)
+            {
+                FoliagePlacement placement = foliageBatches[i];
+
+                foliageVisible[i] = placement.Mesh.Radius <= 0 || camera.IsSphereVisible(cullPosition + placement.Position, placement.Mesh.Radius);
             }
         }
 
+        /// <summary>
+        /// Starts frustum culling of foliage on job workers. Camera must be final for this frame, Draw waits for the result.
+        /// </summary>
+        public void BeginCulling(Vector3 position)
+        {
+            if (foliageVisible == null || isCulling)
+                return;
+
+            cullPosition = position;
+            isCulling = true;
+
+            Engine.Current.Jobs.ParallelFor(foliageBatches.Count, 64, cullHandler, cullGroup);
+        }
+
         public void Draw(Vector3 position)
         {
-            Engine.Current.Graphics.DrawMesh(mesh, position, new Vector3(0, 0, 0), new Vector3(1, 1, 1), null);
+            Graphics graphics = Engine.Current.Graphics;
+
+            graphics.DrawMesh(mesh, position, new Vector3(0, 0, 0), new Vector3(1, 1, 1), null);
 
-            foreach (FoliagePlacement placement in foliageBatches)
-                Engine.Current.Graphics.DrawMesh(placement.Mesh, new Vector3(position.X + placement.Position.X, position.Y + placement.Position.Y, position.Z + placement.Position.Z), new Vector3(0, 0, 0), new Vector3(1, 1, 1));
+            if (foliageVisible == null)
+                return;
+
+            BeginCulling(position);
+            Engine.Current.Jobs.Wait(cullGroup);
+            isCulling = false;
+
+            for (int i = 0; i < foliageVisible.Length; i++)
+            {
+                if (!foliageVisible[i])
+                    continue;
+
+                FoliagePlacement placement = foliageBatches[i];
+                graphics.DrawVisibleMesh(placement.Mesh, cullPosition + placement.Position, new Vector3(0, 0, 0), placement.Material);
+            }
         }
     }
 }
@@ -1,18 +1,30 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Text;
-using System.Diagnostics;
+using DXSharp.Diagnostics;
 
 namespace Planes3D
 {
+    /// <summary>
+    /// Logging goes through DXSharp's asynchronous logger - declare a static readonly LogSite per message
+    /// and call Write on it, formatting happens on logger thread.
+    /// </summary>
     public sealed class Log
     {
+        public const string Engine = "Engine";
+        public const string Graphics = "Graphics";
+        public const string Texture = "Texture";
+        public const string Sound = "Sound";
+        public const string World = "World";
 
-        public static void WriteLine(string format, params object[] args)
+        public static void Initialize()
         {
-            StackFrame stack = new StackFrame(1);
+            Logger.InitializeConsole();
+        }
 
-            Console.WriteLine(string.Format("[{0}::{1}]: {2}]", stack.GetMethod().DeclaringType.Name, stack.GetMethod().Name, string.Format(format, args)));
+        public static void Shutdown()
+        {
+            Logger.Shutdown();
         }
     }
 }
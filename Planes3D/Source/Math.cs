@@ -96,6 +96,11 @@ namespace Planes3D
         {
             return a * (1.0f - val) + (b * val);
         }
+
+        public static Vector3 Lerp(Vector3 a, Vector3 b, float val)
+        {
+            return new Vector3(Lerp(a.X, b.X, val), Lerp(a.Y, b.Y, val), Lerp(a.Z, b.Z, val));
+        }
         
     }
 
@@ -3,18 +3,23 @@ using System.Collections.Generic;
 using System.Text;
 using DXSharp;
 using DXSharp.D3D;
+using DXSharp.Diagnostics;
 
 namespace Planes3D
 {
     class Program
     {
+        static readonly LogSite initSite = new LogSite(Log.Engine, LogLevel.Info, "Initializing");
 
         static void Main(string[] args)
         {
-            Log.WriteLine("Initializing");
+            Log.Initialize();
+            initSite.Write();
             
             Engine.Initialize();
             Engine.Current.RunEventLoop();
+
+            Log.Shutdown();
         }
     }
 }
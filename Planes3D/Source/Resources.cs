@@ -0,0 +1,97 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text;
+using DXSharp.D3D;
+using DXSharp.IO;
+using DXSharp.Diagnostics;
+
+namespace Planes3D
+{
+    /// <summary>
+    /// Reference to a shared resource. Value is null if it failed to load, Release has to be called either way.
+    /// </summary>
+    public struct Resource<T> where T : class
+    {
+        public ResourceHandle Handle;
+        public T Value;
+
+        public void Release()
+        {
+            if (Handle.IsValid)
+                Resources.Manager.Release(Handle);
+
+            Handle = new ResourceHandle();
+            Value = null;
+        }
+    }
+
+    /// <summary>
+    /// Meshes, textures and sounds go through here, so every file is loaded once no matter how many objects use it.
+    /// Shared meshes must not be modified - give objects their own Material and pass it to DrawMesh instead.
+    /// </summary>
+    public static class Resources
+    {
+        static readonly LogSite statsSite = new LogSite(Log.Engine, LogLevel.Info, "{0}: {1} loaded ({2} bytes), {3} hits, {4} misses, {5} failed");
+
+        const int Capacity = 1024;
+
+        public static ResourceManager Manager;
+
+        private static int meshType;
+        private static int textureType;
+        private static int soundType;
+
+        public static void Initialize()
+        {
+            Manager = new ResourceManager(Capacity);
+
+            meshType = Manager.RegisterType("Meshes", (path, format) => Mesh.FromFile(path, format), r => ((Mesh)r).SizeInBytes);
+            textureType = Manager.RegisterType("Textures", (path, unused) => TextureLoader.LoadFromFile(path), r => ((Texture)r).SizeInBytes);
+            soundType = Manager.RegisterType("Sounds", (path, unused) => SoundLoader.LoadFromFile(path), r => ((WaveBuffer)r).Clip.MemoryUsage);
+        }
+
+        private static Resource<T> Acquire<T>(int type, string path, int parameters) where T : class
+        {
+            Resource<T> ret = new Resource<T>();
+            ret.Handle = Manager.Acquire(type, path, parameters);
+            ret.Value = (T)Manager.Get(ret.Handle);
+
+            return ret;
+        }
+
+        // Same file asked for in different vertex formats is loaded once per format
+        public static Resource<Mesh> LoadMesh(string path, int vertexFormat)
+        {
+            return Acquire<Mesh>(meshType, path, vertexFormat);
+        }
+
+        public static Resource<Texture> LoadTexture(string path)
+        {
+            return Acquire<Texture>(textureType, path, 0);
+        }
+
+        public static Resource<WaveBuffer> LoadSound(string path)
+        {
+            return Acquire<WaveBuffer>(soundType, path, 0);
+        }
+
+        /// <summary>
+        /// Frees everything nobody holds a reference to, e.g. between levels.
+        /// </summary>
+        public static void Unload()
+        {
+            // Render thread may still have draws using these recorded
+            Engine.Current.Graphics.Context.Flush();
+            Manager.UnloadAll();
+        }
+
+        public static void WriteStats()
+        {
+            for (int i = 0; i < Manager.TypeCount; i++)
+            {
+                ResourceTypeStats stats = Manager.GetStats(i);
+                statsSite.Write(stats.Name, stats.Count, stats.Bytes, stats.Hits, stats.Misses, stats.Failures);
+            }
+        }
+    }
+}
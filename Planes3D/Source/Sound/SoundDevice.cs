@@ -2,8 +2,9 @@
 using System.Collections.Generic;
 using System.Text;
 using DXSharp.Sound;
+using DXSharp.Diagnostics;
 using System.IO;
-using System.Runtime.InteropServices;
+using DXSharp.IO;
 
 namespace Planes3D
 {
@@ -14,62 +15,87 @@ namespace Planes3D
 
     public static class SoundLoader
     {
-        public struct WavHeader
-        {
-            public int chunkId;
-            public int chunkSize;
-            public int format;
-            public int subchunkid;
-            public int subchunksize;
-            public short audioFormat;
-            public short numChannels;
-            public int sampleRate;
-            public int byteRate;
-            public short blockAlign;
-            public short bitsPerSample;
-            public int subchunk2Id;
-            public int subchunk2Size;
-        }
-
+        static readonly LogSite notRiffSite = new LogSite(Log.Sound, LogLevel.Warning, "Can't load wave file {0}: Not a RIFF file");
+        static readonly LogSite notWaveSite = new LogSite(Log.Sound, LogLevel.Warning, "Can't load wave file {0}: Not a WAVE file");
+        static readonly LogSite noChunksSite = new LogSite(Log.Sound, LogLevel.Warning, "Can't load wave file {0}: Missing fmt or data chunk");
+        static readonly LogSite unsupportedSite = new LogSite(Log.Sound, LogLevel.Warning, "Can't load wave file {0}: Unsupported format");
+        static readonly LogSite noStreamSite = new LogSite(Log.Sound, LogLevel.Warning, "Can't stream {0}: File not found");
+
+        const int RiffId = 0x46464952; // "RIFF"
+        const int WaveId = 0x45564157; // "WAVE"
+        const int FmtId = 0x20746D66; // "fmt "
+        const int DataId = 0x61746164; // "data"
+
+        // Walks RIFF chunks instead of assuming canonical 44-byte header, so LIST/fact chunks and
+        // extended fmt chunks written by editors don't end up in PCM data
         public static WaveBuffer LoadFromStream(string debugName, Stream strm)
         {
             if(strm != null)
             {
                 BinaryReader reader = new BinaryReader(strm);
-                WavHeader hdr = new WavHeader()
-                {
-                    chunkId = reader.ReadInt32(),
-                    chunkSize = reader.ReadInt32(),
-                    format = reader.ReadInt32(),
-                    subchunkid = reader.ReadInt32(),
-                    subchunksize = reader.ReadInt32(),
-                    audioFormat = reader.ReadInt16(),
-                    numChannels = reader.ReadInt16(),
-                    sampleRate = reader.ReadInt32(),
-                    byteRate = reader.ReadInt32(),
-                    blockAlign = reader.ReadInt16(),
-                    bitsPerSample = reader.ReadInt16(),
-                    subchunk2Id = reader.ReadInt32(),
-                    subchunk2Size = reader.ReadInt32()
-                };
-
-                if (hdr.numChannels > 2 || hdr.bitsPerSample > 16)
+
+                if (strm.Length < 12 || reader.ReadInt32() != RiffId)
                 {
-                    Log.WriteLine("Can't load wave file {0}: Unsupported format", debugName);
+                    notRiffSite.Write(debugName);
 
                     return null;
                 }
 
-                byte[] pcmData = new byte[strm.Length - strm.Position];
-                reader.Read(pcmData, 0, pcmData.Length);
+                reader.ReadInt32();
+
+                if (reader.ReadInt32() != WaveId)
+                {
+                    notWaveSite.Write(debugName);
+
+                    return null;
+                }
 
                 WaveFormat fmt = new WaveFormat();
-                fmt.BitsPerSample = (ushort)hdr.bitsPerSample;
-                fmt.BlockAlign = (ushort)hdr.blockAlign;
-                fmt.SamplesPerSec = (uint)hdr.sampleRate;
-                fmt.FormatTag = (ushort)hdr.audioFormat;
-                fmt.AvgBytesPerSec = (uint)(hdr.sampleRate * hdr.numChannels * 2);
-                fmt.Channels = (ushort)hdr.numChannels;
+                bool hasFormat = false;
+                byte[] pcmData = null;
+
+                while (pcmData == null && strm.Length - strm.Position >= 8)
+                {
+                    int id = reader.ReadInt32();
+                    long size = reader.ReadUInt32();
+                    long next = strm.Position + size + (size & 1); // Chunks are word aligned
+
+                    size = Math.Min(size, strm.Length - strm.Position);
+
+                    if (id == FmtId && size >= 16)
+                    {
+                        fmt.FormatTag = reader.ReadUInt16();
+                        fmt.Channels = reader.ReadUInt16();
+                        fmt.SamplesPerSec = reader.ReadUInt32();
+                        fmt.AvgBytesPerSec = reader.ReadUInt32();
+                        fmt.BlockAlign = reader.ReadUInt16();
+                        fmt.BitsPerSample = reader.ReadUInt16();
+                        hasFormat = true;
+                    }
+                    else if (id == DataId)
+                        pcmData = reader.ReadBytes((int)size);
+
+                    strm.Position = Math.Min(next, strm.Length);
+                }
+
+                if (!hasFormat || pcmData == null)
+                {
+                    noChunksSite.Write(debugName);
+
+                    return null;
+                }
+
+                bool isPcm = fmt.FormatTag == SoundDevice.WaveFormatPCM;
+
+                if (fmt.Channels > 2 || (!isPcm && fmt.FormatTag != SoundDevice.WaveFormatImaAdpcm) || (isPcm && fmt.BitsPerSample > 16))
+                {
+                    unsupportedSite.Write(debugName);
+
+                    return null;
+                }
+
+                if (isPcm)
+                    fmt.AvgBytesPerSec = fmt.SamplesPerSec * fmt.BlockAlign;
 
                 return new WaveBuffer(fmt, pcmData);
             }
@@ -79,57 +105,107 @@ namespace Planes3D
 
         public static WaveBuffer LoadFromFile(string fileName)
         {
-            if(File.Exists(fileName))
-            {
-                using (Stream strm = File.OpenRead(fileName))
-                    return LoadFromStream(fileName, strm);
-            }
+            using (Stream strm = FileSystem.Open(fileName))
+                return LoadFromStream(fileName, strm);
+        }
+
+        // Long sounds (music, ambience) - decoded on the fly instead of being kept in memory
+        public static AudioStream OpenStream(string fileName, bool loop)
+        {
+            if (FileSystem.Exists(fileName))
+                return AudioStream.Open(fileName, loop);
+
+            noStreamSite.Write(fileName);
 
             return null;
         }
     }
 
-    public sealed class WaveBuffer
+    public sealed class WaveBuffer : IDisposable
     {
-        private SoundBuffer buffer;
+        public readonly AudioClip Clip;
 
         public WaveBuffer(WaveFormat fmt, byte[] pcmData)
         {
-            BufferDescription desc = new BufferDescription();
-            desc.BufferBytes = (uint)pcmData.Length;
-            desc.Flags = BufferFlags.ControlDefault |BufferFlags.Software;
-            desc.Format = fmt;
+            Clip = new AudioClip(fmt, pcmData);
+        }
+
+        // Voices still playing the clip finish normally
+        public void Dispose()
+        {
+            Clip.Dispose();
+        }
+
+        public VoiceHandle Play(float gain, float pan, float pitch, int priority, bool loop)
+        {
+            return Engine.Current.Sound.Mixer.Play(Clip, gain, pan, pitch, priority, loop);
+        }
 
-            buffer = Engine.Current.Sound.Context.CreateSoundBuffer(desc);
-            IntPtr data = buffer.Lock();
-            Marshal.Copy(pcmData, 0, data, pcmData.Length);
-            buffer.Unlock();
+        public VoiceHandle Play(bool loop)
+        {
+            return Play(1.0f, 0.0f, 1.0f, 0, loop);
+        }
 
-            buffer.Play();
+        // Positional playback, move it with SoundDevice.Scene.SetEmitter
+        public EmitterHandle CreateEmitter(float gain, float minDistance, float maxDistance, int priority, bool loop)
+        {
+            return Engine.Current.Sound.Scene.AddEmitter(Clip, gain, minDistance, maxDistance, priority, loop);
         }
     }
 
     public sealed class SoundDevice
     {
+        static readonly LogSite initSite = new LogSite(Log.Sound, LogLevel.Info, "Initializing DirectSound");
+        static readonly LogSite primarySite = new LogSite(Log.Sound, LogLevel.Info, "Creating primary sound buffer...");
+        static readonly LogSite mixerSite = new LogSite(Log.Sound, LogLevel.Info, "Mixer started: {0} voices, {1}Hz, SIMD: {2}");
+
         public const int WaveFormatPCM = 1; // TODO: Move somewhere else
+        public const int WaveFormatImaAdpcm = 0x11;
+
+        public const int OutputRate = 44100;
+        public const int VoiceCount = 32;
+        const int OutputLatency = 100; // ms, 9x scheduler may oversleep mixer thread by a whole quantum
+        const int RealEmitters = 12; // Positional sounds audible at once, rest of the voices is left for 2D sounds
 
         public DirectSound Context;
+        public Mixer Mixer;
+        public AudioScene Scene;
         public float Volume;
 
         private SoundBuffer primaryBuffer;
 
         public SoundDevice()
         {
-            Log.WriteLine("Initializing DirectSound");
+            initSite.Write();
 
             Context = new DirectSound();
             Context.Initialize();
 
-            Log.WriteLine("Creating primary sound buffer...");
+            primarySite.Write();
             BufferDescription desc = new BufferDescription();
             desc.Flags = BufferFlags.PrimaryBuffer | BufferFlags.Control3D;
             
             primaryBuffer = Context.CreateSoundBuffer(desc);
+
+            Mixer = new Mixer(Context, OutputRate, VoiceCount, OutputLatency);
+            mixerSite.Write(Mixer.VoiceCount, OutputRate, Mixer.IsSimdEnabled);
+
+            Scene = new AudioScene(Mixer, RealEmitters);
+        }
+
+        /// <summary>
+        /// Moves listener to the camera and re-ranks emitters. Called once per simulation step, after objects were updated.
+        /// </summary>
+        public void Update(Camera camera, float deltaTime)
+        {
+            Vector3 fw = camera.GetForward();
+
+            Scene.SetListener(camera.Position.X, camera.Position.Y, camera.Position.Z,
+                (camera.Position.X - camera.PreviousPosition.X) / deltaTime,
+                (camera.Position.Y - camera.PreviousPosition.Y) / deltaTime,
+                (camera.Position.Z - camera.PreviousPosition.Z) / deltaTime,
+                fw.X, fw.Y, fw.Z, 0, 1, 0);
+            Scene.Update(deltaTime);
         }
     }
 }
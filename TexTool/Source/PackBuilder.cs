@@ -0,0 +1,354 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.IO;
+
+namespace TexTool
+{
+    /// <summary>
+    /// Writes .pak archives read by DXSharp's PackFile. Layout is described in DX6Sharp/PackFile.h, keep both in sync.
+    /// </summary>
+    public sealed class PackBuilder
+    {
+        const uint Magic = 0x4B505844; // "DXPK"
+        const uint Version = 1;
+        const int HeaderSize = 32;
+        const int EntrySize = 32;
+        const uint FlagLz4 = 1;
+
+        private sealed class Item
+        {
+            public string Name;
+            public string SourcePath;
+            public uint Hash;
+
+            public byte[] Payload;
+            public uint Size;
+            public uint Crc;
+            public uint Flags;
+            public uint Offset;
+            public uint NameOffset;
+        }
+
+        private Dictionary<string, Item> items = new Dictionary<string, Item>();
+
+        public int Alignment = 16; // Power of two
+        public bool Compress; // LZ4 per entry, kept only where it actually saves space
+
+        public int Count { get { return items.Count; } }
+
+        public void AddFile(string sourcePath, string name)
+        {
+            name = NormalizePath(name);
+
+            if (name.Any(c => c > 127))
+                throw new ArgumentException(string.Format("Only ASCII names can be packed: {0}", name));
+
+            // Later additions replace earlier ones, like mounting a patch pack would
+            items[name] = new Item() { Name = name, SourcePath = sourcePath, Hash = HashPath(name) };
+        }
+
+        /// <summary>
+        /// Adds every file below directory, named by its path relative to root.
+        /// </summary>
+        public void AddDirectory(string root, string directory)
+        {
+            string fullRoot = Path.GetFullPath(root).TrimEnd(Path.DirectorySeparatorChar, Path.AltDirectorySeparatorChar) + Path.DirectorySeparatorChar;
+
+            foreach (string file in Directory.GetFiles(directory, "*", SearchOption.AllDirectories))
+            {
+                string fullPath = Path.GetFullPath(file);
+
+                if (!fullPath.StartsWith(fullRoot))
+                    throw new ArgumentException(string.Format("{0} is outside of {1}", file, root));
+
+                AddFile(file, fullPath.Substring(fullRoot.Length));
+            }
+        }
+
+        public void Write(Stream strm)
+        {
+            if (Alignment <= 0 || (Alignment & (Alignment - 1)) != 0)
+                throw new InvalidOperationException("Alignment must be a power of two");
+
+            // Same order PackFile's binary search expects
+            List<Item> sorted = items.Values.OrderBy(i => i.Hash).ThenBy(i => i.Name, StringComparer.Ordinal).ToList();
+
+            long storedTotal = 0;
+            long sizeTotal = 0;
+
+            foreach (Item item in sorted)
+            {
+                byte[] data = File.ReadAllBytes(item.SourcePath);
+
+                item.Size = (uint)data.Length;
+                item.Crc = Crc32.Compute(data, 0, data.Length, 0);
+                item.Payload = data;
+                item.Flags = 0;
+
+                if (Compress && data.Length > 0)
+                {
+                    byte[] packed = Lz4.Compress(data);
+
+                    if (packed.Length < data.Length - data.Length / 8)
+                    {
+                        item.Payload = packed;
+                        item.Flags = FlagLz4;
+                    }
+                }
+
+                storedTotal += item.Payload.Length;
+                sizeTotal += item.Size;
+            }
+
+            MemoryStream names = new MemoryStream();
+
+            foreach (Item item in sorted)
+            {
+                item.NameOffset = (uint)names.Length;
+
+                byte[] name = Encoding.ASCII.GetBytes(item.Name);
+                names.Write(name, 0, name.Length);
+                names.WriteByte(0);
+            }
+
+            long offset = Align(HeaderSize + EntrySize * sorted.Count + names.Length);
+
+            foreach (Item item in sorted)
+            {
+                item.Offset = (uint)offset;
+                offset = Align(offset + item.Payload.Length);
+            }
+
+            if (offset > uint.MaxValue)
+                throw new InvalidOperationException("Pack would be larger than 4GB");
+
+            MemoryStream directory = new MemoryStream();
+            BinaryWriter dirWriter = new BinaryWriter(directory);
+
+            foreach (Item item in sorted)
+            {
+                dirWriter.Write(item.Hash);
+                dirWriter.Write(item.NameOffset);
+                dirWriter.Write(item.Offset);
+                dirWriter.Write((uint)item.Payload.Length);
+                dirWriter.Write(item.Size);
+                dirWriter.Write(item.Crc);
+                dirWriter.Write(item.Flags);
+                dirWriter.Write(0u);
+            }
+
+            names.WriteTo(directory);
+            byte[] dirBytes = directory.ToArray();
+
+            BinaryWriter writer = new BinaryWriter(strm);
+            writer.Write(Magic);
+            writer.Write(Version);
+            writer.Write((uint)sorted.Count);
+            writer.Write((uint)Alignment);
+            writer.Write((uint)(HeaderSize + EntrySize * sorted.Count)); // NamesOffset
+            writer.Write((uint)names.Length);
+            writer.Write(Crc32.Compute(dirBytes, 0, dirBytes.Length, 0));
+            writer.Write(0u);
+            writer.Write(dirBytes);
+
+            long position = HeaderSize + dirBytes.Length;
+
+            foreach (Item item in sorted)
+            {
+                writer.Write(new byte[item.Offset - position]);
+                writer.Write(item.Payload);
+
+                position = item.Offset + item.Payload.Length;
+                item.Payload = null;
+            }
+
+            writer.Write(new byte[offset - position]);
+            writer.Flush();
+
+            Console.WriteLine("Packed {0} files, {1} -> {2} bytes ({3} compressed)", sorted.Count, sizeTotal, storedTotal, sorted.Count(i => i.Flags != 0));
+        }
+
+        private long Align(long value)
+        {
+            return (value + Alignment - 1) & ~(long)(Alignment - 1);
+        }
+
+        /// <summary>
+        /// Lowercase, '/' separated, no leading "./" or "/" - must match NormalizePath in PackFile.cpp.
+        /// </summary>
+        public static string NormalizePath(string path)
+        {
+            int start = 0;
+
+            while (start + 1 < path.Length && path[start] == '.' && (path[start + 1] == '/' || path[start + 1] == '\\'))
+                start += 2;
+
+            while (start < path.Length && (path[start] == '/' || path[start] == '\\'))
+                start++;
+
+            StringBuilder ret = new StringBuilder(path.Length);
+
+            for (int i = start; i < path.Length; i++)
+            {
+                char c = path[i];
+
+                if (c == '\\')
+                    c = '/';
+                else if (c >= 'A' && c <= 'Z')
+                    c = (char)(c + ('a' - 'A'));
+
+                if (c == '/' && ret.Length > 0 && ret[ret.Length - 1] == '/')
+                    continue;
+
+                ret.Append(c);
+            }
+
+            return ret.ToString();
+        }
+
+        // FNV-1a over ASCII bytes
+        public static uint HashPath(string normalizedPath)
+        {
+            uint hash = 2166136261;
+
+            foreach (char c in normalizedPath)
+            {
+                hash ^= (byte)c;
+                hash *= 16777619;
+            }
+
+            return hash;
+        }
+    }
+
+    public static class Crc32
+    {
+        private static readonly uint[] table = BuildTable();
+
+        private static uint[] BuildTable()
+        {
+            uint[] ret = new uint[256];
+
+            for (uint i = 0; i < 256; i++)
+            {
+                uint c = i;
+
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) != 0 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+                ret[i] = c;
+            }
+
+            return ret;
+        }
+
+        public static uint Compute(byte[] data, int offset, int count, uint crc)
+        {
+            crc = ~crc;
+
+            for (int i = offset; i < offset + count; i++)
+                crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+            return ~crc;
+        }
+    }
+
+    /// <summary>
+    /// Greedy LZ4 block compressor. Ratio is a bit below the reference implementation, but the output is
+    /// standard LZ4 and decodes with Lz4Decompress in DX6Sharp.
+    /// </summary>
+    public static class Lz4
+    {
+        const int MinMatch = 4;
+        const int LastLiterals = 5; // Block always ends with at least this many literals
+        const int MatchLimit = 12; // No match may start closer than this to the end
+        const int MaxOffset = 65535;
+        const int HashBits = 16;
+
+        public static byte[] Compress(byte[] src)
+        {
+            MemoryStream dst = new MemoryStream(src.Length + src.Length / 255 + 16);
+            int[] table = new int[1 << HashBits];
+
+            for (int i = 0; i < table.Length; i++)
+                table[i] = -1;
+
+            int anchor = 0;
+            int ip = 0;
+            int matchEnd = src.Length - LastLiterals;
+            int searchEnd = src.Length - MatchLimit;
+
+            while (ip <= searchEnd)
+            {
+                uint seq = ReadUInt(src, ip);
+                int h = (int)((seq * 2654435761u) >> (32 - HashBits));
+                int candidate = table[h];
+
+                table[h] = ip;
+
+                if (candidate < 0 || ip - candidate > MaxOffset || ReadUInt(src, candidate) != seq)
+                {
+                    ip++;
+                    continue;
+                }
+
+                int length = MinMatch;
+
+                while (ip + length < matchEnd && src[candidate + length] == src[ip + length])
+                    length++;
+
+                WriteSequence(dst, src, anchor, ip - anchor, ip - candidate, length);
+
+                ip += length;
+                anchor = ip;
+            }
+
+            // Trailing literals, sequence without match
+            int literals = src.Length - anchor;
+
+            dst.WriteByte((byte)(Math.Min(literals, 15) << 4));
+            WriteLength(dst, literals);
+            dst.Write(src, anchor, literals);
+
+            return dst.ToArray();
+        }
+
+        private static void WriteSequence(MemoryStream dst, byte[] src, int literalStart, int literals, int offset, int length)
+        {
+            int matchLength = length - MinMatch;
+
+            dst.WriteByte((byte)((Math.Min(literals, 15) << 4) | Math.Min(matchLength, 15)));
+            WriteLength(dst, literals);
+            dst.Write(src, literalStart, literals);
+
+            dst.WriteByte((byte)offset);
+            dst.WriteByte((byte)(offset >> 8));
+
+            WriteLength(dst, matchLength);
+        }
+
+        // Remainder of a length that didn't fit into its 4 bits of the token
+        private static void WriteLength(MemoryStream dst, int length)
+        {
+            if (length < 15)
+                return;
+
+            length -= 15;
+
+            while (length >= 255)
+            {
+                dst.WriteByte(255);
+                length -= 255;
+            }
+
+            dst.WriteByte((byte)length);
+        }
+
+        private static uint ReadUInt(byte[] data, int offset)
+        {
+            return (uint)(data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (data[offset + 3] << 24));
+        }
+    }
+}
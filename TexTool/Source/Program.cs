@@ -99,11 +99,50 @@ namespace TexTool
             Console.ReadLine();
         }
 
+        // TexTool pack <output.pak> <root> [-lz4] [-align N] <files and directories...>
+        // Entries are named by their path relative to root, which is what the game passes to its loaders.
+        private static void BuildPack(string[] args)
+        {
+            PackBuilder builder = new PackBuilder();
+            string output = args[1];
+            string root = args[2];
+
+            for (int i = 3; i < args.Length; i++)
+            {
+                if (args[i] == "-lz4")
+                    builder.Compress = true;
+                else if (args[i] == "-align" && i + 1 < args.Length)
+                    builder.Alignment = int.Parse(args[++i]);
+                else if (Directory.Exists(Path.Combine(root, args[i])))
+                    builder.AddDirectory(root, Path.Combine(root, args[i]));
+                else if (File.Exists(Path.Combine(root, args[i])))
+                    builder.AddFile(Path.Combine(root, args[i]), args[i]);
+                else
+                {
+                    Console.WriteLine("File not found: {0}", args[i]);
+                    Environment.ExitCode = -1;
+
+                    return;
+                }
+            }
+
+            using (Stream strm = File.Create(output))
+                builder.Write(strm);
+        }
+
         static void Main(string[] args)
         {
+            if (args.Length >= 3 && args[0] == "pack")
+            {
+                BuildPack(args);
+
+                return;
+            }
+
             if(args.Length < 1)
             {
                 Console.WriteLine("Usage: TexTool <input>");
+                Console.WriteLine("       TexTool pack <output.pak> <root> [-lz4] [-align N] <files and directories...>");
                 Environment.ExitCode = -1;
 
                 return;